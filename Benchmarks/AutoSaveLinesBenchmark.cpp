@@ -0,0 +1,164 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of raw lines made by autosave on UI thread (AutoSaveLines.h).
+//Dialogues need config.h and wxWidgets core, so line here has only fields and text version
+//like AutoSaveLineKey and is formatted like Dialogue::GetRaw.
+//Every autosave edits a few lines of history step like editbox does (copy of line set to table)
+//or inserts lines, time of making lines with cache is compared with formatting all lines.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution (wxWidgets base.lib):
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote /I..\Thirdparty\wxWidgets\include /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu
+//    AutoSaveLinesBenchmark.cpp /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release base.lib zlib.lib wxregex.lib
+//Returns 1 when any cached line differs from formatted one.
+
+#include "AutoSaveLines.h"
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+struct Line
+{
+	wxString style;
+	wxString text;
+	size_t version;
+	int start, end, layer;
+};
+
+struct LineKey
+{
+	const Line *line;
+	size_t version;
+	int start, end, layer;
+	bool operator ==(const LineKey &key) const{
+		return line == key.line && version == key.version && start == key.start &&
+			end == key.end && layer == key.layer;
+	}
+	const void *GetId() const{ return line; }
+};
+
+static void GetRaw(const Line *line, wxString &raw)
+{
+	raw << L"Dialogue: " << line->layer << L"," << line->start << L"," << line->end << L","
+		<< line->style << L",,0,0,0,," << line->text << L"\r\n";
+}
+
+static void MakeKey(const Line *line, LineKey *key)
+{
+	key->line = line;
+	key->version = line->version;
+	key->start = line->start;
+	key->end = line->end;
+	key->layer = line->layer;
+}
+
+//all lines formatted like before cache
+static double FormatAll(const ChunkedArray<Line*> &lines, std::vector<wxString> *raw)
+{
+	auto start = std::chrono::steady_clock::now();
+	raw->clear();
+	raw->resize(lines.size());
+	size_t i = 0;
+	for (auto it = lines.begin(); it != lines.end(); it++){
+		GetRaw(*it, (*raw)[i++]);
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static double FormatCached(const ChunkedArray<Line*> &lines, AutoSaveLinesCache<LineKey> *cache,
+	std::vector<AutoSaveChunk> *chunks)
+{
+	auto start = std::chrono::steady_clock::now();
+	chunks->clear();
+	cache->GetChunks(lines,
+		[](Line *line, size_t i, LineKey *key){ MakeKey(line, key); },
+		[](Line *line, size_t i, wxString &raw){ GetRaw(line, raw); },
+		chunks);
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static int Check(const std::vector<wxString> &raw, const std::vector<AutoSaveChunk> &chunks)
+{
+	size_t i = 0;
+	for (const AutoSaveChunk &chunk : chunks){
+		if (chunk.start != i || chunk.lines->size() != chunk.size)
+			return 1;
+		for (const wxString &line : *chunk.lines){
+			if (i >= raw.size() || line != raw[i++])
+				return 1;
+		}
+	}
+	return (i == raw.size()) ? 0 : 1;
+}
+
+int main()
+{
+	std::mt19937 random(1234);
+	std::vector<Line*> allLines;
+	size_t version = 0;
+	auto newLine = [&](){
+		Line *line = new Line{ wxString::Format(L"Style %i", (int)(random() % 20)),
+			wxString::Format(L"{\\pos(%i,%i)}Text of line %i", (int)(random() % 1920), (int)(random() % 1080), (int)allLines.size()),
+			++version, (int)(random() % 3600000), 0, (int)(random() % 5) };
+		line->end = line->start + 2000;
+		allLines.push_back(line);
+		return line;
+	};
+	ChunkedArray<Line*> lines;
+	for (int i = 0; i < 100000; i++){
+		lines.push_back(newLine());
+	}
+	//history keeps previous steps, so changed chunks are copied
+	std::vector<ChunkedArray<Line*>> history;
+
+	int failed = 0;
+	AutoSaveLinesCache<LineKey> cache;
+	std::vector<AutoSaveChunk> chunks;
+	std::vector<wxString> raw;
+	FormatCached(lines, &cache, &chunks);
+	const size_t editCounts[] = { 0, 1, 10, 100, 1000, 10000 };
+	printf("%i lines\n", (int)lines.size());
+	printf("%-8s %-8s %12s %12s %10s\n", "edits", "kind", "all ms", "cached ms", "formatted");
+	for (int insert = 0; insert < 2; insert++){
+		for (size_t edits : editCounts){
+			for (size_t e = 0; e < edits; e++){
+				history.push_back(lines);
+				size_t pos = random() % lines.size();
+				if (insert){
+					lines.insert(lines.begin() + pos, newLine());
+				}
+				else{
+					//editbox sets changed copy of line, text of copy has new version
+					Line *copy = new Line(*lines[pos]);
+					allLines.push_back(copy);
+					copy->text << L" edited";
+					copy->version = ++version;
+					lines[pos] = copy;
+				}
+			}
+			double allTime = FormatAll(lines, &raw);
+			double cachedTime = FormatCached(lines, &cache, &chunks);
+			failed += Check(raw, chunks);
+			printf("%-8i %-8s %12.3f %12.3f %10i\n", (int)edits, insert ? "insert" : "change",
+				allTime, cachedTime, (int)cache.GetFormattedCount());
+		}
+	}
+	for (Line *line : allLines)
+		delete line;
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+--  Copyright (c) 2020, Marcin Drob
+
+--  Kainote is free software: you can redistribute it and/or modify
+--  it under the terms of the GNU General Public License as published by
+--  the Free Software Foundation, either version 3 of the License, or
+--  (at your option) any later version.
+
+--  Kainote is distributed in the hope that it will be useful,
+--  but WITHOUT ANY WARRANTY; without even the implied warranty of
+--  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+--  GNU General Public License for more details.
+
+--  You should have received a copy of the GNU General Public License
+--  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+--Check and benchmark of batched changes of subtitles made by macros (AutomationToFile.cpp).
+--Generates FX lines like karaoke templater, appends them, inserts them one after another,
+--reads them twice (second read uses cached tables) and deletes them by delete and deleterange.
+--Every step is timed by os.clock, after last step subtitles have to be the same as before.
+--Load it in Automation manager of Kainote or copy to Automation\automation\Autoload,
+--open any ASS file with dialogues and run "Batch mutation benchmark" from Automation menu.
+--Number of FX lines is set below, log ends with "FAILED" when lines were not restored.
+
+script_name = "Batch mutation benchmark"
+script_description = "Times appending, inserting, reading and deleting of many lines"
+script_author = "Marcin Drob"
+script_version = "1"
+
+local NUM_FX_LINES = 50000
+
+local function time_step(name, func)
+	local start = os.clock()
+	func()
+	aegisub.log(string.format("%-28s %12.3f\n", name, (os.clock() - start) * 1000))
+end
+
+local function benchmark(subs, sel)
+	local first_dialogue = nil
+	local dialogues = {}
+	for i = 1, #subs do
+		local line = subs[i]
+		if line.class == "dialogue" then
+			first_dialogue = first_dialogue or i
+			dialogues[#dialogues + 1] = line.text
+		end
+	end
+	if not first_dialogue then
+		aegisub.log("Script has no dialogues\n")
+		return
+	end
+	local num_lines = #subs
+	aegisub.log(string.format("%i lines, %i FX lines\n", num_lines, NUM_FX_LINES))
+	aegisub.log(string.format("%-28s %12s\n", "step", "ms"))
+
+	--one FX line for every syllable like karaoke templater
+	local template = subs[first_dialogue]
+	local fx = {}
+	for i = 1, NUM_FX_LINES do
+		local line = {}
+		for k, v in pairs(template) do line[k] = v end
+		line.effect = "fx"
+		line.comment = false
+		line.start_time = (i - 1) * 40
+		line.end_time = line.start_time + 500
+		line.text = string.format("{\\pos(%i,100)\\fad(50,50)}syl %i", i % 1920, i)
+		fx[i] = line
+	end
+
+	time_step("append", function()
+		for i = 1, NUM_FX_LINES do
+			subs.append(fx[i])
+		end
+	end)
+	time_step("set_undo_point", function()
+		aegisub.set_undo_point("Append FX lines")
+	end)
+	local read_failed = false
+	time_step("read all", function()
+		for i = num_lines + 1, #subs do
+			if subs[i].effect ~= "fx" then read_failed = true end
+		end
+	end)
+	time_step("read all again", function()
+		for i = num_lines + 1, #subs do
+			if subs[i].effect ~= "fx" then read_failed = true end
+		end
+	end)
+	time_step("delete", function()
+		local ids = {}
+		for i = num_lines + 1, #subs do
+			ids[#ids + 1] = i
+		end
+		subs.delete(ids)
+	end)
+
+	--inserts before the first dialogue, one line after another
+	time_step("insert", function()
+		for i = 1, NUM_FX_LINES do
+			subs.insert(first_dialogue + i - 1, fx[i])
+		end
+	end)
+	time_step("read inserted", function()
+		for i = first_dialogue, first_dialogue + NUM_FX_LINES - 1 do
+			if subs[i].effect ~= "fx" then read_failed = true end
+		end
+	end)
+	time_step("deleterange", function()
+		subs.deleterange(first_dialogue, first_dialogue + NUM_FX_LINES - 1)
+	end)
+	--ids of delete are not sorted, they are sorted before one pass compaction
+	time_step("append, delete reversed", function()
+		for i = 1, NUM_FX_LINES do
+			subs.append(fx[i])
+		end
+		local ids = {}
+		for i = #subs, num_lines + 1, -1 do
+			ids[#ids + 1] = i
+		end
+		subs.delete(ids)
+	end)
+
+	local failed = read_failed or #subs ~= num_lines
+	local dialogue_id = 1
+	for i = 1, #subs do
+		local line = subs[i]
+		if line.class == "dialogue" then
+			if line.text ~= dialogues[dialogue_id] then failed = true end
+			dialogue_id = dialogue_id + 1
+		end
+	end
+	aegisub.log(failed and "FAILED\n" or "ok\n")
+	aegisub.set_undo_point(script_name)
+end
+
+aegisub.register_macro(script_name, script_description, benchmark)
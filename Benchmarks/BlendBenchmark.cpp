@@ -0,0 +1,161 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of libass bitmap blending (SubtitlesBlend.cpp).
+//Every kernel is compared with the old scalar loop from SubtitlesLibass::Draw,
+//allowed difference is BLEND_TOLERANCE on every channel (kernels are expected to be exact).
+//Build from this folder in Developer Command Prompt:
+//  cl /O2 /EHsc /I..\Kainote BlendBenchmark.cpp ..\Kainote\SubtitlesBlend.cpp
+//or with GCC or Clang (kernels have their own target attributes, no -mavx2 is needed):
+//  g++ -O2 -I../Kainote BlendBenchmark.cpp ../Kainote/SubtitlesBlend.cpp
+//Returns 1 when any kernel differs more than tolerance.
+
+#include "SubtitlesBlend.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define BLEND_TOLERANCE 1
+
+//loop from SubtitlesLibass::Draw before SIMD kernels
+static void BlendRowOld(uint32_t *dstrow, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b)
+{
+	for (int x = 0; x < width; x++) {
+		const unsigned int v = src[x];
+		int rr = (r * a * v);
+		int gg = (g * a * v);
+		int bb = (b * a * v);
+		int aa = a * v;
+		uint32_t dstpix = dstrow[x];
+		unsigned int dstb = dstpix & 0xFF;
+		unsigned int dstg = (dstpix >> 8) & 0xFF;
+		unsigned int dstr = (dstpix >> 16) & 0xFF;
+		unsigned int dsta = (dstpix >> 24) & 0xFF;
+		dstb = (bb + dstb * (255 * 255 - aa)) / (255 * 255);
+		dstg = (gg + dstg * (255 * 255 - aa)) / (255 * 255);
+		dstr = (rr + dstr * (255 * 255 - aa)) / (255 * 255);
+		dsta = (aa * 255 + dsta * (255 * 255 - aa)) / (255 * 255);
+		dstrow[x] = dstb | (dstg << 8) | (dstr << 16) | (dsta << 24);
+	}
+}
+
+struct Kernel
+{
+	const char *name;
+	BlendRowFunction blendRow;
+	int maxDifference;
+};
+
+static int PixelDifference(uint32_t first, uint32_t second)
+{
+	int difference = 0;
+	for (int shift = 0; shift < 32; shift += 8){
+		int channel = abs((int)((first >> shift) & 0xFF) - (int)((second >> shift) & 0xFF));
+		if (channel > difference)
+			difference = channel;
+	}
+	return difference;
+}
+
+static void CheckRow(Kernel &kernel, const std::vector<uint32_t> &frame, const unsigned char *src,
+	int width, unsigned int a, unsigned int r, unsigned int g, unsigned int b)
+{
+	std::vector<uint32_t> expected(frame.begin(), frame.begin() + width);
+	std::vector<uint32_t> result(expected);
+	BlendRowOld(expected.data(), src, width, a, r, g, b);
+	kernel.blendRow(result.data(), src, width, a, r, g, b);
+	for (int x = 0; x < width; x++){
+		int difference = PixelDifference(expected[x], result[x]);
+		if (difference > kernel.maxDifference)
+			kernel.maxDifference = difference;
+	}
+}
+
+//every alpha of color with every mask value and every channel value of frame,
+//then random rows of all widths to check tails and skipping of transparent pixels
+static void CheckKernel(Kernel &kernel)
+{
+	std::vector<uint32_t> frame(256);
+	std::vector<unsigned char> src(256);
+	for (int i = 0; i < 256; i++){
+		frame[i] = i | ((255 - i) << 8) | (((i * 7) & 0xFF) << 16) | (((i * 13) & 0xFF) << 24);
+	}
+	std::mt19937 random(1234);
+	for (unsigned int a = 0; a < 256; a++){
+		for (unsigned int v = 0; v < 256; v++){
+			memset(src.data(), v, src.size());
+			CheckRow(kernel, frame, src.data(), 256, a, random() & 0xFF, random() & 0xFF, random() & 0xFF);
+		}
+	}
+	for (int width = 1; width <= 256; width++){
+		for (int i = 0; i < 256; i++){
+			frame[i] = random();
+			//about half of mask is transparent like in glyph bitmaps
+			src[i] = (random() & 1) ? 0 : random() & 0xFF;
+		}
+		CheckRow(kernel, frame, src.data(), width, random() & 0xFF, random() & 0xFF, random() & 0xFF, random() & 0xFF);
+	}
+}
+
+//milliseconds of blending one 1080p bitmap
+static double Benchmark(BlendRowFunction blendRow, const std::vector<unsigned char> &mask,
+	std::vector<uint32_t> &frame, int width, int height, int iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++){
+		for (int y = 0; y < height; y++){
+			blendRow(frame.data() + y * width, mask.data() + y * width, width, 200, 255, 128, 64);
+		}
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count() / iterations;
+}
+
+int main()
+{
+	BlendRowFunction best = GetBlendRowFunction();
+	std::vector<Kernel> kernels;
+	kernels.push_back({ "scalar", BlendRowScalar, 0 });
+	if (best != BlendRowScalar)
+		kernels.push_back({ "SSE2", BlendRowSSE2, 0 });
+	if (best == BlendRowAVX2)
+		kernels.push_back({ "AVX2", BlendRowAVX2, 0 });
+
+	bool failed = false;
+	for (Kernel &kernel : kernels){
+		CheckKernel(kernel);
+		bool passed = kernel.maxDifference <= BLEND_TOLERANCE;
+		printf("%-6s max difference %i, %s\n", kernel.name, kernel.maxDifference, passed ? "ok" : "FAILED");
+		failed |= !passed;
+	}
+
+	const int width = 1920, height = 1080, iterations = 50;
+	std::vector<unsigned char> mask(width * height);
+	std::vector<uint32_t> frame(width * height);
+	std::mt19937 random(4321);
+	for (size_t i = 0; i < mask.size(); i++){
+		mask[i] = (random() & 1) ? 0 : random() & 0xFF;
+		frame[i] = random();
+	}
+	printf("%-6s %.3f ms per 1920x1080 bitmap\n", "old", Benchmark(BlendRowOld, mask, frame, width, height, iterations));
+	for (Kernel &kernel : kernels){
+		printf("%-6s %.3f ms per 1920x1080 bitmap\n", kernel.name, Benchmark(kernel.blendRow, mask, frame, width, height, iterations));
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of subtitles comparison (TextCompare.h).
+//Ranges of differences are compared with the old full table from SubsGridBase::CompareTexts,
+//they have to be identical, grid highlights exactly these chars.
+//Build from this folder in Developer Command Prompt:
+//  cl /O2 /EHsc /std:c++20 /utf-8 /I..\Kainote CompareTextsBenchmark.cpp
+//Returns 1 when any pair of texts gives other ranges.
+
+#include "TextCompare.h"
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+//SubsGridBase::CompareTexts before bit-parallel rows, without check of equal texts
+static void CompareTextsOld(std::vector<int> &firstCompare, std::vector<int> &secondCompare,
+	const std::wstring &first, const std::wstring &second)
+{
+	size_t l1 = first.length(), l2 = second.length();
+	size_t w = l2 + 1;
+	std::vector<size_t> dpt((l1 + 1) * (l2 + 1), 0);
+	size_t i1, i2;
+
+	for (i1 = 1; i1 <= l1; i1++){
+		for (i2 = 1; i2 <= l2; i2++)
+		{
+			if (first[l1 - i1] == second[l2 - i2])
+			{
+				dpt[w * i1 + i2] = dpt[w * (i1 - 1) + (i2 - 1)] + 1;
+			}
+			else if (dpt[w * (i1 - 1) + i2] > dpt[w * i1 + (i2 - 1)])
+			{
+				dpt[w * i1 + i2] = dpt[w * (i1 - 1) + i2];
+			}
+			else
+			{
+				dpt[w * i1 + i2] = dpt[w * i1 + (i2 - 1)];
+			}
+		}
+	}
+
+	int sfirst = -1, ssecond = -1;
+	i1 = l1; i2 = l2;
+	for (;;){
+		if ((i1 > 0) && (i2 > 0) && (first[l1 - i1] == second[l2 - i2])){
+			if (sfirst >= 0){
+				firstCompare.push_back(sfirst);
+				firstCompare.push_back((l1 - i1) - 1);
+				sfirst = -1;
+			}
+			if (ssecond >= 0){
+				secondCompare.push_back(ssecond);
+				secondCompare.push_back((l2 - i2) - 1);
+				ssecond = -1;
+			}
+			i1--; i2--; continue;
+		}
+		else{
+			if (i1 > 0 && (i2 == 0 || dpt[w * (i1 - 1) + i2] >= dpt[w * i1 + (i2 - 1)])){
+				if (sfirst == -1){ sfirst = l1 - i1; }
+				i1--; continue;
+			}
+			else if (i2 > 0 && (i1 == 0 || dpt[w * (i1 - 1) + i2] < dpt[w * i1 + (i2 - 1)])){
+				if (ssecond == -1){ ssecond = l2 - i2; }
+				i2--; continue;
+			}
+		}
+
+		break;
+	}
+	if (sfirst >= 0){
+		firstCompare.push_back(sfirst);
+		firstCompare.push_back((l1 - i1) - 1);
+	}
+	if (ssecond >= 0){
+		secondCompare.push_back(ssecond);
+		secondCompare.push_back((l2 - i2) - 1);
+	}
+}
+
+static void CompareTextsNew(std::vector<int> &firstCompare, std::vector<int> &secondCompare,
+	const std::wstring &first, const std::wstring &second)
+{
+	CompareTextRanges(first.c_str(), first.length(), second.c_str(), second.length(), firstCompare, secondCompare);
+}
+
+static std::wstring RandomText(std::mt19937 &random, size_t length, const std::wstring &alphabet)
+{
+	std::wstring text;
+	for (size_t i = 0; i < length; i++)
+		text += alphabet[random() % alphabet.length()];
+	return text;
+}
+
+//translation of the same line, some words changed, removed or added
+static std::wstring EditText(std::mt19937 &random, const std::wstring &text, const std::wstring &alphabet)
+{
+	std::wstring edited = text;
+	int edits = 1 + random() % 6;
+	for (int i = 0; i < edits; i++){
+		size_t pos = edited.empty() ? 0 : random() % edited.length();
+		size_t length = 1 + random() % 8;
+		switch (random() % 3){
+		case 0: edited.erase(pos, length); break;
+		case 1: edited.insert(pos, RandomText(random, length, alphabet)); break;
+		default: edited.replace(pos, length, RandomText(random, length, alphabet)); break;
+		}
+	}
+	return edited;
+}
+
+static bool CheckPair(const std::wstring &first, const std::wstring &second)
+{
+	std::vector<int> oldFirst, oldSecond, newFirst, newSecond;
+	CompareTextsOld(oldFirst, oldSecond, first, second);
+	CompareTextsNew(newFirst, newSecond, first, second);
+	if (oldFirst == newFirst && oldSecond == newSecond)
+		return true;
+
+	printf("ranges differ for texts of length %i and %i\n", (int)first.length(), (int)second.length());
+	return false;
+}
+
+//milliseconds of comparing all pairs
+static double Benchmark(void(*compare)(std::vector<int> &, std::vector<int> &, const std::wstring &, const std::wstring &),
+	const std::vector<std::pair<std::wstring, std::wstring>> &pairs)
+{
+	std::vector<int> firstCompare, secondCompare;
+	auto start = std::chrono::steady_clock::now();
+	for (auto &pair : pairs){
+		firstCompare.clear();
+		secondCompare.clear();
+		compare(firstCompare, secondCompare, pair.first, pair.second);
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+int main()
+{
+	const std::wstring text = L"abcdefghijklmnopqrstuvwxyząćęłńóśźż ,.!?{}\\N";
+	//small alphabet gives a lot of equal LCS values and checks choice on ties
+	const std::wstring ties = L"ab ";
+	std::mt19937 random(1234);
+	int checked = 0, failed = 0;
+
+	//lengths around words of 64 bits
+	const size_t lengths[] = { 0, 1, 2, 31, 63, 64, 65, 127, 128, 129, 200 };
+	for (size_t firstLength : lengths){
+		for (size_t secondLength : lengths){
+			for (int i = 0; i < 20; i++){
+				const std::wstring &alphabet = (i & 1) ? ties : text;
+				failed += !CheckPair(RandomText(random, firstLength, alphabet), RandomText(random, secondLength, alphabet));
+				checked++;
+			}
+		}
+	}
+	for (int i = 0; i < 20000; i++){
+		const std::wstring &alphabet = (i & 1) ? ties : text;
+		std::wstring first = RandomText(random, random() % 300, alphabet);
+		failed += !CheckPair(first, EditText(random, first, alphabet));
+		checked++;
+	}
+	printf("%i pairs checked, %i with other ranges, %s\n", checked, failed, failed ? "FAILED" : "ok");
+
+	std::vector<std::pair<std::wstring, std::wstring>> pairs;
+	for (int i = 0; i < 20000; i++){
+		std::wstring first = RandomText(random, 40 + random() % 120, text);
+		pairs.push_back(std::make_pair(first, EditText(random, first, text)));
+	}
+	printf("%-4s %.3f ms per %i lines\n", "old", Benchmark(CompareTextsOld, pairs), (int)pairs.size());
+	printf("%-4s %.3f ms per %i lines\n", "new", Benchmark(CompareTextsNew, pairs), (int)pairs.size());
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,233 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Check and benchmark of scanning fonts usage of generated batch of episodes like FontCollector::GetAssFonts (FontsUsage.cpp).
+//Old path scans files one by one with Dialogue::ParseTags, three Replace passes and set of characters for every font,
+//new path is ScanFontsUsage of chunks of all files on 1 and all threads, merged to character sets like AddFontsUsage.
+//Dialogue and SubsFile need config of Kainote, so objects of Release x64 build of Kainote are packed to library first.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution:
+//  lib /OUT:Kainote.lib ..\obj\x64\Release\Kainote\*.obj
+//  cl /O2 /EHsc /std:c++20 /D__WXMSW__ /DUNICODE /D_UNICODE /I..\Kainote /I..\Thirdparty\wxWidgets\include
+//    /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu FontsUsageBenchmark.cpp /link /SUBSYSTEM:CONSOLE
+//    /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release Kainote.lib + Linker Input libraries of Kainote project
+//Arguments: [number of files, default 24] [number of lines in every file, default 3000].
+//Returns 1 when characters of any font differ from characters found by old scan.
+
+#include "FontsUsage.h"
+#include "SubsFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+typedef std::map<wxString, std::set<unsigned int>> FontsCharacters;
+
+//old FontCollector::GetAssFonts without logs, characters were kept for every font name
+static void OldGetAssFonts(SubsFile *subs, FontsCharacters *fontMap)
+{
+	std::map<wxString, Styles*> stylesfonts;
+	std::vector<Styles*> *styles = subs->GetStyleTable();
+	for (size_t i = 0; i < styles->size(); i++){
+		stylesfonts[(*styles)[i]->Name] = (*styles)[i];
+	}
+
+	wxString tags[] = { L"fn", L"b", L"i", L"p" };
+	for (size_t i = 0; i < subs->GetCount(); i++)
+	{
+		Dialogue *dial = subs->GetDialogue(i);
+		if (dial->IsComment){ continue; }
+		ParseData* pdata = dial->ParseTags(tags, 4, true);
+		if (!pdata){ continue; }
+
+		Styles *lstyle = stylesfonts[dial->Style];
+		wxString ifont = (lstyle) ? lstyle->Fontname : emptyString;
+		bool lastPlain = false;
+		wxString textHavingFont;
+		size_t tagsSize = pdata->tags.size();
+		for (size_t j = 0; j < tagsSize; j++)
+		{
+			TagData *tag = pdata->tags[j];
+			if (tag->tagName == L"p" || tag->tagName == L"pvector"){ continue; }
+
+			if (tag->tagName == L"plain"){
+				textHavingFont += tag->value;
+				if ((lastPlain && j < tagsSize - 1) || ifont.IsEmpty()){ continue; }
+				lastPlain = true;
+				textHavingFont.Replace(L"\\N", emptyString);
+				textHavingFont.Replace(L"\\n", emptyString);
+				textHavingFont.Replace(L"\\h", L" ");
+				std::set<unsigned int> &characters = (*fontMap)[ifont.Lower()];
+				for (size_t k = 0; k < textHavingFont.length(); k++){
+					characters.insert((unsigned int)textHavingFont[k].GetValue());
+				}
+				textHavingFont.clear();
+			}
+			else{
+				if (tag->tagName == L"fn"){
+					ifont = tag->value;
+				}
+				lastPlain = false;
+			}
+		}
+		dial->ClearParse();
+	}
+}
+
+//new scan with merge like FontCollector::AddFontsUsage
+//names are lowercase names of variant keys
+static void NewGetAssFonts(const std::vector<SubsFile *> &files, size_t numThreads, std::map<wxString, CharacterSet> *fontMap,
+	std::map<wxString, wxString> *names)
+{
+	std::vector<std::map<wxString, Styles*>> stylesFonts(files.size());
+	std::vector<FontsScanChunk> chunks;
+	for (size_t k = 0; k < files.size(); k++){
+		std::vector<Styles*> *styles = files[k]->GetStyleTable();
+		for (size_t i = 0; i < styles->size(); i++){
+			stylesFonts[k][(*styles)[i]->Name] = (*styles)[i];
+		}
+		GetFontsScanChunks(files[k], (int)k, &stylesFonts[k], &chunks);
+	}
+	ScanFontsUsage(chunks, numThreads);
+	for (auto &chunk : chunks){
+		for (auto &variant : chunk.usage.variants){
+			if (!variant.second.characters.IsEmpty()){
+				(*fontMap)[variant.first].Add(variant.second.characters);
+				(*names)[variant.first] = variant.second.name.Lower();
+			}
+		}
+	}
+}
+
+//variants are joined by name and characters out of BMP are splitted to surrogates like in old scan
+static FontsCharacters ToOldCharacters(const std::map<wxString, CharacterSet> &fontMap, std::map<wxString, wxString> &names)
+{
+	FontsCharacters result;
+	for (auto &font : fontMap){
+		std::set<unsigned int> &characters = result[names[font.first]];
+		for (auto &page : font.second.pages){
+			for (unsigned int bit = 0; bit < 256; bit++){
+				if (!page.second.test(bit))
+					continue;
+				unsigned int character = (page.first << 8) | bit;
+				if (character > 0xFFFF){
+					character -= 0x10000;
+					characters.insert(0xD800 + (character >> 10));
+					characters.insert(0xDC00 + (character & 0x3FF));
+				}
+				else
+					characters.insert(character);
+			}
+		}
+	}
+	return result;
+}
+
+static SubsFile *GenerateFile(std::mt19937 &random, size_t numLines, wxMutex *guard)
+{
+	struct StyleFont
+	{
+		const wchar_t *name;
+		const wchar_t *font;
+		bool bold;
+		bool italic;
+	};
+	const StyleFont styleFonts[] = {
+		{ L"Default", L"Arial", false, false },
+		{ L"Italics", L"Arial", false, true },
+		{ L"Sign", L"Times New Roman", true, false },
+		{ L"Song", L"Gabriola", false, false },
+		{ L"Notes", L"Segoe UI", false, false },
+	};
+	//ASCII, Polish, Japanese, emoji, escapes and drawings
+	const wchar_t *texts[] = {
+		L"Dialogue text of line\\Nin two rows",
+		L"{\\i1}Zażółć{\\i0} gęślą jaźń",
+		L"{\\fnMeiryo\\b1}か{\\k30}ら{\\k20}お{\\b0}け",
+		L"Emoji \xD83D\xDE00 and\\hhard space",
+		L"{\\p1}m 0 0 l 100 0 100 100{\\p0}Sign {\\fnComic Sans MS}text",
+		L"{\\fnSegoe UI Emoji}\xD83C\xDF38{\\fn}Back to style",
+	};
+	SubsFile *file = new SubsFile(guard);
+	for (auto &styleFont : styleFonts){
+		Styles *style = new Styles();
+		style->Name = styleFont.name;
+		style->Fontname = styleFont.font;
+		style->Bold = styleFont.bold;
+		style->Italic = styleFont.italic;
+		file->AddStyle(style);
+	}
+	for (size_t i = 0; i < numLines; i++){
+		int start = (int)(i * 1500 + random() % 1000);
+		int end = start + 500 + random() % 4000;
+		wxString line = wxString::Format(L"%s: 0,%i:%02i:%02i.%02i,%i:%02i:%02i.%02i,%s,,0,0,0,,%s %i",
+			(random() % 10) ? L"Dialogue" : L"Comment",
+			start / 3600000, (start / 60000) % 60, (start / 1000) % 60, (start / 10) % 100,
+			end / 3600000, (end / 60000) % 60, (end / 1000) % 60, (end / 10) % 100,
+			styleFonts[random() % 5].name, texts[random() % 6], (int)i);
+		file->AppendDialogue(new Dialogue(line));
+	}
+	file->EndLoad(OPEN_SUBTITLES, 0);
+	return file;
+}
+
+int main(int argc, char **argv)
+{
+	size_t numFiles = (argc > 1) ? (size_t)atoll(argv[1]) : 24;
+	size_t numLines = (argc > 2) ? (size_t)atoll(argv[2]) : 3000;
+	if (!numFiles || !numLines)
+		return 1;
+
+	std::mt19937 random(1234);
+	wxMutex guard;
+	std::vector<SubsFile *> files;
+	for (size_t i = 0; i < numFiles; i++){
+		files.push_back(GenerateFile(random, numLines, &guard));
+	}
+
+	int failed = 0;
+	size_t numThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+	printf("%i files, %i lines in every file\n", (int)numFiles, (int)numLines);
+	printf("%-10s %12s %12s\n", "path", "ms", "speedup");
+
+	FontsCharacters oldFonts;
+	auto start = std::chrono::steady_clock::now();
+	for (SubsFile *file : files){
+		OldGetAssFonts(file, &oldFonts);
+	}
+	std::chrono::duration<double, std::milli> oldTime = std::chrono::steady_clock::now() - start;
+	printf("%-10s %12.3f %12.2f\n", "old", oldTime.count(), 1.0);
+
+	size_t threadCounts[] = { 1, numThreads };
+	for (size_t threads : threadCounts){
+		std::map<wxString, CharacterSet> fontMap;
+		std::map<wxString, wxString> names;
+		start = std::chrono::steady_clock::now();
+		NewGetAssFonts(files, threads, &fontMap, &names);
+		std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+		printf("%-10s %12.3f %12.2f\n", wxString::Format(L"%i threads", (int)threads).utf8_str().data(),
+			time.count(), oldTime.count() / time.count());
+		if (ToOldCharacters(fontMap, names) != oldFonts)
+			failed = 1;
+	}
+
+	for (SubsFile *file : files){
+		delete file;
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of time to frame lookup of Provider::GetFramefromMS (FrameTimes.h).
+//Every lookup is compared with the old linear scan over CFR, VFR and broken (not sorted) timecodes.
+//Queries are start and end times of lines like grid frame display and random seeks from any frame.
+//Build from this folder in Developer Command Prompt:
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote FrameTimesBenchmark.cpp
+//Arguments: [number of queries for every timecodes set, default 10000].
+//Returns 1 when any lookup gives other frame.
+
+#include "FrameTimes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+//old linear scan from Provider::GetFramefromMS
+static int OldGetFramefromMS(const std::vector<int> &timecodes, int numFrames, int MS, int seekfrom, bool safe)
+{
+	if (MS <= 0) return 0;
+	int result = (safe) ? numFrames - 1 : numFrames;
+	for (int i = seekfrom; i < numFrames; i++)
+	{
+		if (timecodes[i] >= MS)
+		{
+			result = i;
+			break;
+		}
+	}
+	return result;
+}
+
+//new version from Provider
+static int NewGetFramefromMS(const std::vector<int> &timecodes, int numFrames, bool sorted, int MS, int seekfrom, bool safe)
+{
+	if (MS <= 0) return 0;
+	int result = (safe) ? numFrames - 1 : numFrames;
+	return FindFrameFromMS(timecodes, numFrames, MS, seekfrom, result, sorted);
+}
+
+static std::vector<int> MakeCFR(int numFrames, double fps)
+{
+	std::vector<int> timecodes(numFrames);
+	for (int i = 0; i < numFrames; i++){
+		timecodes[i] = (int)(i * 1000.0 / fps);
+	}
+	return timecodes;
+}
+
+//parts of 23.976, 29.97 and 59.94 FPS like anime openings or hybrid releases
+static std::vector<int> MakeVFR(int numFrames, std::mt19937 &random)
+{
+	const double frameDurations[] = { 1001.0 / 24.0, 1001.0 / 30.0, 1001.0 / 60.0 };
+	std::vector<int> timecodes(numFrames);
+	double time = 0;
+	int i = 0;
+	while (i < numFrames){
+		double duration = frameDurations[random() % 3];
+		int partEnd = (std::min)(numFrames, i + 100 + (int)(random() % 5000));
+		for (; i < partEnd; i++){
+			timecodes[i] = (int)time;
+			time += duration;
+		}
+	}
+	return timecodes;
+}
+
+struct Query
+{
+	int MS;
+	int seekfrom;
+	bool safe;
+};
+
+int main(int argc, char **argv)
+{
+	size_t numQueries = (argc > 1) ? (size_t)atoll(argv[1]) : 10000;
+	if (!numQueries)
+		return 1;
+
+	std::mt19937 random(1234);
+	struct TimecodesSet
+	{
+		const char *name;
+		std::vector<int> timecodes;
+	};
+	const int numFrames = 250000;
+	std::vector<TimecodesSet> sets;
+	sets.push_back(TimecodesSet{ "CFR", MakeCFR(numFrames, 24000.0 / 1001.0) });
+	sets.push_back(TimecodesSet{ "VFR", MakeVFR(numFrames, random) });
+	//a few swapped timestamps from broken container
+	std::vector<int> broken = MakeVFR(numFrames, random);
+	for (int i = 0; i < 20; i++){
+		size_t frame = 1 + random() % (numFrames - 2);
+		std::swap(broken[frame], broken[frame + 1]);
+	}
+	sets.push_back(TimecodesSet{ "broken", broken });
+
+	int failed = 0;
+	printf("%i frames, %i queries, lines and seeks\n", numFrames, (int)numQueries);
+	printf("%-8s %12s %12s %12s\n", "set", "linear ms", "search ms", "speedup");
+	for (auto &set : sets){
+		const std::vector<int> &timecodes = set.timecodes;
+		bool sorted = std::is_sorted(timecodes.begin(), timecodes.end());
+		//timecodes from video can be shorter than number of frames
+		int frames = numFrames - 10;
+		int duration = timecodes[numFrames - 1];
+		std::vector<Query> queries(numQueries);
+		for (size_t i = 0; i < numQueries; i++){
+			//a quarter are seeks from any frame, also after the end of video
+			if (i % 4 == 3)
+				queries[i] = Query{ (int)(random() % (duration + 2000)) - 100, (int)(random() % frames), (random() % 2) != 0 };
+			else{
+				int start = (int)(i * (size_t)duration / numQueries);
+				queries[i] = Query{ (i % 2) ? start + 500 + (int)(random() % 4000) : start, 0, true };
+			}
+		}
+		std::vector<int> oldResults(numQueries), newResults(numQueries);
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < numQueries; i++){
+			const Query &query = queries[i];
+			oldResults[i] = OldGetFramefromMS(timecodes, frames, query.MS, query.seekfrom, query.safe);
+		}
+		std::chrono::duration<double, std::milli> oldTime = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < numQueries; i++){
+			const Query &query = queries[i];
+			newResults[i] = NewGetFramefromMS(timecodes, frames, sorted, query.MS, query.seekfrom, query.safe);
+		}
+		std::chrono::duration<double, std::milli> newTime = std::chrono::steady_clock::now() - start;
+
+		if (oldResults != newResults)
+			failed = 1;
+
+		printf("%-8s %12.3f %12.3f %12.1f\n", set.name, oldTime.count(), newTime.count(),
+			oldTime.count() / newTime.count());
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and scaling benchmark of interning style, actor and effect (InternTable.h)
+//when dialogues are parsed in threads like SubsLoader::ParseDialoguesParallel.
+//Lines are split to one chunk per thread, every field is interned to global table under lock
+//or to table of thread which is merged after join, for 1 to 16 threads.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution (wxWidgets base.lib):
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote /I..\Thirdparty\wxWidgets\include /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu
+//    InternTableBenchmark.cpp /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release base.lib zlib.lib wxregex.lib
+//Returns 1 when any field has other text or global table is not empty after release of all lines.
+
+#include "InternTable.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//fields of dialogue that are interned
+struct ParsedLine
+{
+	TextBlock *fields[3];
+};
+
+//style, actor and effect are taken from ASS line like Dialogue::SetRawASS does
+static void ParseLines(const std::vector<wxString> &lines, size_t start, size_t end,
+	std::vector<ParsedLine> *parsed, InternTable *table)
+{
+	InternTable::Use(table);
+	for (size_t i = start; i < end; i++){
+		const wchar_t *line = lines[i].wc_str();
+		const wchar_t *lineEnd = line + lines[i].length();
+		const wchar_t *commas[9];
+		int numCommas = 0;
+		for (const wchar_t *ch = line; ch < lineEnd && numCommas < 9; ch++){
+			if (*ch == L',')
+				commas[numCommas++] = ch;
+		}
+		const int fields[] = { 3, 4, 8 };
+		for (int f = 0; f < 3; f++){
+			const wchar_t *begin = commas[fields[f] - 1] + 1;
+			wxString text(begin, commas[fields[f]] - begin);
+			(*parsed)[i].fields[f] = text.empty() ? nullptr : InternTable::Intern(text);
+		}
+	}
+	InternTable::Use(nullptr);
+}
+
+//milliseconds of parsing all lines
+static double Parse(const std::vector<wxString> &lines, std::vector<ParsedLine> *parsed, size_t numThreads, bool localTables)
+{
+	auto start = std::chrono::steady_clock::now();
+	size_t chunkSize = (lines.size() + numThreads - 1) / numThreads;
+	std::vector<std::thread> threads;
+	std::vector<InternTable> tables(numThreads);
+	for (size_t chunk = 0; chunk < lines.size(); chunk += chunkSize){
+		size_t end = (std::min)(chunk + chunkSize, lines.size());
+		InternTable *table = localTables ? &tables[threads.size()] : nullptr;
+		threads.emplace_back(ParseLines, std::cref(lines), chunk, end, parsed, table);
+	}
+	for (auto &thread : threads){
+		thread.join();
+	}
+	for (auto &table : tables){
+		table.Merge();
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+//every field has the same text like in line and every text is in global table
+static int Check(const std::vector<wxString> &lines, std::vector<ParsedLine> &parsed,
+	const std::vector<wxString> &texts)
+{
+	int failed = 0;
+	for (size_t i = 0; i < lines.size(); i++){
+		for (int f = 0; f < 3; f++){
+			TextBlock *block = parsed[i].fields[f];
+			if (block && lines[i].find(block->text.wc_str()) == wxString::npos)
+				failed++;
+		}
+	}
+	for (const wxString &text : texts){
+		TextBlock *block = InternTable::Intern(text);
+		if (block->text != text)
+			failed++;
+		InternTable::Release(block);
+	}
+	if (InternTable::GlobalSize() != texts.size())
+		failed++;
+	return failed;
+}
+
+static void Release(std::vector<ParsedLine> &parsed)
+{
+	for (auto &line : parsed){
+		for (TextBlock *block : line.fields){
+			if (block)
+				InternTable::Release(block);
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 random(1234);
+	std::vector<wxString> styles, actors, texts;
+	for (int i = 0; i < 60; i++){
+		styles.push_back(wxString::Format(L"Sign %i", i));
+		texts.push_back(styles.back());
+	}
+	for (int i = 0; i < 300; i++){
+		actors.push_back(wxString::Format(L"Actor %i", i));
+		texts.push_back(actors.back());
+	}
+	texts.push_back(L"Effect");
+	//big karaoke and typesetting scripts have hundreds of thousands of lines
+	std::vector<wxString> lines;
+	for (int i = 0; i < 400000; i++){
+		wxString line = L"Dialogue: 0,0:00:01.00,0:00:02.00,";
+		line += styles[random() % styles.size()];
+		line += L",";
+		if (random() % 3)
+			line += actors[random() % actors.size()];
+		line += (random() % 10) ? L",0,0,0,," : L",0,0,0,Effect,";
+		line += L"{\\pos(100,200)\\blur1}text of line";
+		lines.push_back(line);
+	}
+
+	int failed = 0;
+	const size_t threadCounts[] = { 1, 2, 4, 8, 12, 16 };
+	printf("%-8s %12s %12s\n", "threads", "global ms", "local ms");
+	for (size_t numThreads : threadCounts){
+		double times[2];
+		for (int local = 0; local < 2; local++){
+			std::vector<ParsedLine> parsed(lines.size());
+			times[local] = Parse(lines, &parsed, numThreads, local != 0);
+			failed += Check(lines, parsed, texts);
+			Release(parsed);
+			if (InternTable::GlobalSize() != 0)
+				failed++;
+		}
+		printf("%-8i %12.3f %12.3f\n", (int)numThreads, times[0], times[1]);
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of memory and load time of dialogue style, actor and effect
+//(StoreTextHelper.h) stored in own text blocks like before interning and interned in InternedTextHelper.
+//Fields of all lines are set like Dialogue::SetRawASS does, then lines are read like editbox
+//and automation do on not const dialogues and copied like undo history does.
+//Memory is counted by operator new of this program, peak is the highest number of allocated bytes
+//from loading to releasing of lines.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution (wxWidgets base.lib):
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote /I..\Thirdparty\wxWidgets\include /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu
+//    InternedTextBenchmark.cpp /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release base.lib zlib.lib wxregex.lib
+//Returns 1 when any field has other text or reading of interned field takes it out of interned table.
+
+#include "StoreTextHelper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <vector>
+
+static std::atomic<size_t> allocated{ 0 };
+static std::atomic<size_t> peak{ 0 };
+
+//size is kept before allocated memory, 16 bytes keep alignment of new
+void *operator new(size_t size)
+{
+	size_t *memory = (size_t *)malloc(size + 16);
+	if (!memory)
+		throw std::bad_alloc();
+	*memory = size;
+	size_t current = allocated.fetch_add(size) + size;
+	size_t highest = peak.load();
+	while (current > highest && !peak.compare_exchange_weak(highest, current)){}
+	return (char *)memory + 16;
+}
+
+void operator delete(void *pointer) noexcept
+{
+	if (!pointer)
+		return;
+	size_t *memory = (size_t *)((char *)pointer - 16);
+	allocated.fetch_sub(*memory);
+	free(memory);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+template<typename Helper>
+struct Fields
+{
+	Helper Style, Actor, Effect;
+};
+
+struct Result
+{
+	double loadTime;
+	double readTime;
+	size_t peakBytes;
+	int failed;
+};
+
+template<typename Helper>
+static Result Run(const std::vector<wxString> (&parsed)[3], bool interned)
+{
+	Result result = { 0, 0, 0, 0 };
+	size_t startBytes = allocated.load();
+	peak = startBytes;
+	{
+		std::vector<Fields<Helper>> lines(parsed[0].size());
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lines.size(); i++){
+			lines[i].Style = parsed[0][i];
+			lines[i].Actor = parsed[1][i];
+			lines[i].Effect = parsed[2][i];
+		}
+		std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - start;
+		result.loadTime = loadTime.count();
+
+		//EditBox::SetLine and automation read fields of not const dialogues
+		start = std::chrono::steady_clock::now();
+		size_t templates = 0;
+		size_t length = 0;
+		for (size_t i = 0; i < lines.size(); i++){
+			const Fields<Helper> &line = lines[i];
+			templates += line.Effect.Get().StartsWith(L"template");
+			length += strlen(line.Style.Get().mb_str(wxConvUTF8).data());
+			length += strlen(line.Actor.Get().mb_str(wxConvUTF8).data());
+		}
+		std::chrono::duration<double, std::milli> readTime = std::chrono::steady_clock::now() - start;
+		result.readTime = readTime.count();
+		if (!length && !templates)
+			result.failed++;
+
+		//undo history keeps copies of changed lines
+		std::vector<Fields<Helper>> history(lines.begin(), lines.begin() + lines.size() / 10);
+		for (size_t i = 0; i < lines.size(); i++){
+			Fields<Helper> &line = lines[i];
+			//operator -> of interned field only reads also on not const line
+			if (interned && line.Style->empty() && line.Effect->StartsWith(L"code"))
+				result.failed++;
+			if (line.Style != parsed[0][i] || line.Actor != parsed[1][i] || line.Effect != parsed[2][i])
+				result.failed++;
+			//equal interned texts share one block also after reads
+			if (interned && i > 0 && parsed[0][i] == parsed[0][i - 1] && !line.Style.SharesText(lines[i - 1].Style))
+				result.failed++;
+		}
+	}
+	result.peakBytes = peak.load() - startBytes;
+	//only buckets of global table can stay allocated
+	if (InternTable::GlobalSize() != 0)
+		result.failed++;
+	return result;
+}
+
+int main()
+{
+	std::mt19937 random(1234);
+	std::vector<wxString> styles, actors;
+	for (int i = 0; i < 60; i++){
+		styles.push_back(wxString::Format(L"Sign %i", i));
+	}
+	for (int i = 0; i < 300; i++){
+		actors.push_back(wxString::Format(L"Actor %i", i));
+	}
+	//big karaoke and typesetting scripts have hundreds of thousands of lines,
+	//text of line is not interned and is not counted here
+	const size_t numLines = 400000;
+	std::vector<wxString> parsed[3];
+	for (size_t i = 0; i < numLines; i++){
+		parsed[0].push_back(styles[random() % styles.size()]);
+		parsed[1].push_back((random() % 3) ? actors[random() % actors.size()] : wxString());
+		parsed[2].push_back((random() % 10) ? wxString() : wxString(L"template line"));
+	}
+
+	int failed = 0;
+	Result stored = Run<StoreTextHelper>(parsed, false);
+	Result interned = Run<InternedTextHelper>(parsed, true);
+	failed += stored.failed + interned.failed;
+
+	printf("%i lines\n", (int)numLines);
+	printf("%-10s %12s %12s %12s %14s\n", "fields", "load ms", "read ms", "peak MB", "bytes per line");
+	const Result *results[] = { &stored, &interned };
+	const char *names[] = { "stored", "interned" };
+	for (int i = 0; i < 2; i++){
+		printf("%-10s %12.3f %12.3f %12.3f %14.1f\n", names[i], results[i]->loadTime, results[i]->readTime,
+			results[i]->peakBytes / (1024.0 * 1024.0), (double)results[i]->peakBytes / numLines);
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of keyframe snapping of post-processor of SubsGridBase::ChangeTimes (FrameTimes.h)
+//over full script of 3 hours VFR movie.
+//Old path converts every keyframe with linear frame search like RendererFFMS2::GetFrameTimeFromTime
+//and checks all keyframes for every line, new path builds sorted index like Provider::GetKeyframesStart
+//and checks only keyframes from snapping ranges.
+//Build from this folder in Developer Command Prompt:
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote KeyframeSnapBenchmark.cpp
+//Arguments: [number of keyframes, default 4000].
+//Returns 1 when any line is snapped to other keyframe.
+
+#include "FrameTimes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define ZEROIT(a) ((a/10)*10)
+
+//post-processor options in ms
+const int LeadIn = 200;
+const int LeadOut = 300;
+const int KeyframeBeforeStart = 250;
+const int KeyframeAfterStart = 350;
+const int KeyframeBeforeEnd = 500;
+const int KeyframeAfterEnd = 800;
+
+struct Line
+{
+	int start;
+	int end;
+};
+
+static int OldGetFramefromMS(const std::vector<int> &timecodes, int MS)
+{
+	int numFrames = (int)timecodes.size();
+	if (MS <= 0) return 0;
+	for (int i = 0; i < numFrames; i++)
+	{
+		if (timecodes[i] >= MS)
+			return i;
+	}
+	return numFrames - 1;
+}
+
+static int GetMSfromFrame(const std::vector<int> &timecodes, int frame)
+{
+	if (frame < 0) { return 0; }
+	return timecodes[frame];
+}
+
+//old conversion of keyframes from SubsGridBase::ChangeTimes
+static std::vector<int> OldKeyframesStart(const std::vector<int> &keyframes, const std::vector<int> &timecodes)
+{
+	std::vector<int> keyFramesStart;
+	for (int keyMS : keyframes){
+		int frame = OldGetFramefromMS(timecodes, keyMS);
+		int prevFrameTime = GetMSfromFrame(timecodes, frame - 1);
+		int frameTime = GetMSfromFrame(timecodes, frame);
+		keyFramesStart.push_back(ZEROIT(frameTime + ((prevFrameTime - frameTime) / 2)));
+	}
+	return keyFramesStart;
+}
+
+//Provider::GetKeyframesStart
+static std::vector<int> NewKeyframesStart(const std::vector<int> &keyframes, const std::vector<int> &timecodes)
+{
+	std::vector<int> keyframesStart;
+	keyframesStart.reserve(keyframes.size());
+	int numFrames = (int)timecodes.size();
+	for (int keyMS : keyframes){
+		int frame = (keyMS <= 0) ? 0 : FindFrameFromMS(timecodes, numFrames, keyMS, 0, numFrames - 1, true);
+		int prevFrameTime = GetMSfromFrame(timecodes, frame - 1);
+		int keyFrameTime = GetMSfromFrame(timecodes, frame);
+		keyframesStart.push_back(ZEROIT(keyFrameTime + ((prevFrameTime - keyFrameTime) / 2)));
+	}
+	std::sort(keyframesStart.begin(), keyframesStart.end());
+	return keyframesStart;
+}
+
+//old loop over all keyframes from SubsGridBase::ChangeTimes
+static KeyframeSnap OldFindKeyframeSnap(const std::vector<int> &keyFramesStart, int start, int end, int oldStart, int oldEnd,
+	int startRange, int startRange1, int endRange, int endRange1)
+{
+	KeyframeSnap snap;
+	for (size_t g = 0; g < keyFramesStart.size(); g++) {
+		int keyMSS = keyFramesStart[g];
+		if (keyMSS >= startRange && keyMSS <= startRange1) {
+			if (oldStart == keyMSS) {
+				startRange = -1; startRange1 = -1; snap.startResult = INT_MAX;
+				start = oldStart;
+				snap.startRestored = true;
+			}
+			if (snap.startResult > keyMSS){
+				if (snap.startResult == INT_MAX || abs(snap.startResult - start) > abs(keyMSS - start))
+					snap.startResult = keyMSS;
+			}
+		}
+		if (keyMSS >= endRange && keyMSS <= endRange1) {
+			if (oldEnd == keyMSS) {
+				endRange = -1; endRange1 = -1; snap.endResult = -1;
+				end = oldEnd;
+				snap.endRestored = true;
+			}
+			if (snap.endResult < keyMSS && keyMSS > start) {
+				if (snap.endResult == -1 || abs(snap.endResult - end) > abs(keyMSS - end))
+					snap.endResult = keyMSS;
+			}
+		}
+	}
+	return snap;
+}
+
+typedef std::vector<int>(*BuildFunction)(const std::vector<int> &keyframes, const std::vector<int> &timecodes);
+typedef KeyframeSnap(*SnapFunction)(const std::vector<int> &keyFramesStart, int start, int end, int oldStart, int oldEnd,
+	int startRange, int startRange1, int endRange, int endRange1);
+
+//lead in, lead out and keyframes like ChangeTimes with PostprocessorOptions 1 | 2 | 8
+static double PostProcess(const std::vector<Line> &lines, const std::vector<int> &keyframes, const std::vector<int> &timecodes,
+	BuildFunction build, SnapFunction find, std::vector<KeyframeSnap> *snaps)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	std::vector<int> keyFramesStart = build(keyframes, timecodes);
+	for (size_t i = 0; i < lines.size(); i++){
+		int oldStart = lines[i].start;
+		int oldEnd = lines[i].end;
+		int start = oldStart - LeadIn;
+		int end = oldEnd + LeadOut;
+		(*snaps)[i] = find(keyFramesStart, start, end, oldStart, oldEnd,
+			start - KeyframeBeforeStart, oldStart + KeyframeAfterStart, oldEnd - KeyframeBeforeEnd, end + KeyframeAfterEnd);
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - startTime;
+	return time.count();
+}
+
+static bool SameSnaps(const std::vector<KeyframeSnap> &first, const std::vector<KeyframeSnap> &second)
+{
+	for (size_t i = 0; i < first.size(); i++){
+		if (first[i].startResult != second[i].startResult || first[i].endResult != second[i].endResult ||
+			first[i].startRestored != second[i].startRestored || first[i].endRestored != second[i].endRestored)
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	size_t numKeyframes = (argc > 1) ? (size_t)atoll(argv[1]) : 4000;
+	if (!numKeyframes)
+		return 1;
+
+	//3 hours of 23.976 FPS with parts of 29.97 FPS
+	std::mt19937 random(1234);
+	std::vector<int> timecodes;
+	double time = 0;
+	while (time < 3 * 3600000.0){
+		double duration = (random() % 4) ? 1001.0 / 24.0 : 1001.0 / 30.0;
+		for (int i = 0; i < 2000; i++){
+			timecodes.push_back((int)time);
+			time += duration;
+		}
+	}
+	int numFrames = (int)timecodes.size();
+	std::vector<int> keyframes(numKeyframes);
+	for (size_t i = 0; i < numKeyframes; i++){
+		keyframes[i] = timecodes[random() % numFrames];
+	}
+	std::sort(keyframes.begin(), keyframes.end());
+	std::vector<int> keyframesStart = NewKeyframesStart(keyframes, timecodes);
+
+	int failed = 0;
+	size_t sizes[] = { 2000, 10000, 50000 };
+	printf("%i frames, %i keyframes\n", numFrames, (int)numKeyframes);
+	printf("%-8s %12s %12s %12s\n", "lines", "old ms", "new ms", "speedup");
+	for (size_t size : sizes){
+		std::vector<Line> lines(size);
+		for (size_t i = 0; i < size; i++){
+			//every fifth line starts or ends on keyframe
+			int start = (int)(random() % (3 * 3600000 - 10000));
+			int end = start + 800 + random() % 5000;
+			if (i % 5 == 0)
+				start = keyframesStart[random() % numKeyframes];
+			else if (i % 5 == 1)
+				end = keyframesStart[random() % numKeyframes] + 800;
+			lines[i] = Line{ start, (std::max)(end, start + 10) };
+		}
+		std::vector<KeyframeSnap> oldSnaps(size), newSnaps(size);
+		double oldTime = PostProcess(lines, keyframes, timecodes, OldKeyframesStart, OldFindKeyframeSnap, &oldSnaps);
+		double newTime = PostProcess(lines, keyframes, timecodes, NewKeyframesStart, FindKeyframeSnap, &newSnaps);
+		if (!SameSnaps(oldSnaps, newSnaps))
+			failed = 1;
+
+		printf("%-8i %12.3f %12.3f %12.1f\n", (int)size, oldTime, newTime, oldTime / newTime);
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and timing harness of libass track update after one edit (LibassTrack.cpp).
+//Full path builds whole script like SubsGridBase::GetVisible and reads it by ass_read_memory,
+//incremental path is SubtitlesLibass::OpenIncremental, only changed lines are parsed again.
+//Edits change text of one line, insert or delete line or insert the same line again like SubsFile::InsertRows,
+//after every edit events of both tracks are compared. At the end incremental track is read again with duplicated lines.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution:
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote /I..\Thirdparty\libass /I..\Thirdparty\wxWidgets\include
+//    /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu LibassReloadBenchmark.cpp ..\Kainote\LibassTrack.cpp
+//    /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release libass.lib FreeType2.lib Fribidi.lib HarfBuzz.lib
+//    base.lib zlib.lib wxregex.lib
+//Arguments: [number of edits for every size, default 50].
+//Returns 1 when any event of incremental track differs from event of full reload.
+
+#include "LibassTrack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+//dialogue of grid, pointer is the key of event
+struct ScriptLine
+{
+	wxString raw;
+};
+
+static void QuietMessages(int level, const char *fmt, va_list args, void *data)
+{
+}
+
+static wxString MakeHeader()
+{
+	wxString header = L"[Script Info]\r\nScriptType: v4.00+\r\nPlayResX: 1920\r\nPlayResY: 1080\r\n\r\n"
+		L"[V4+ Styles]\r\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, "
+		L"BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, "
+		L"Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\r\n";
+	for (int i = 0; i < 20; i++){
+		header << wxString::Format(L"Style: Sign %i,Arial,48,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,"
+			L"0,0,0,0,100,100,0,0,1,2,2,2,10,10,10,1\r\n", i);
+	}
+	header << L" \r\n[Events]\r\nFormat: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+	return header;
+}
+
+static wxString MakeLine(std::mt19937 &random, size_t i)
+{
+	int start = (int)(i * 1500 % 7200000 + random() % 1000);
+	int end = start + 500 + random() % 4000;
+	const wchar_t *texts[] = {
+		L"{\\pos(960,100)\\fad(150,150)\\blur2}Sign number",
+		L"{\\k25}ka{\\k30}ra{\\k20}o{\\k40}ke",
+		L"{\\an7\\p1}m 0 0 l 100 0 100 100 0 100{\\p0}",
+		L"Dialogue text of line",
+	};
+	return wxString::Format(L"%s: %i,%i:%02i:%02i.%02i,%i:%02i:%02i.%02i,Sign %i,,0,0,0,,%s %i\r\n",
+		(random() % 10) ? L"Dialogue" : L"Comment", (int)(random() % 3),
+		start / 3600000, (start / 60000) % 60, (start / 1000) % 60, (start / 10) % 100,
+		end / 3600000, (end / 60000) % 60, (end / 1000) % 60, (end / 10) % 100,
+		(int)(random() % 20), texts[random() % 4], (int)i);
+}
+
+static double FullReload(ASS_Library *library, ASS_Track **track, const wxString &header, const std::vector<ScriptLine *> &lines)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (*track)
+		ass_free_track(*track);
+	wxString script = header;
+	for (ScriptLine *line : lines){
+		script << line->raw;
+	}
+	wxScopedCharBuffer buffer = script.mb_str(wxConvUTF8);
+	*track = ass_read_memory(library, buffer.data(), strlen(buffer), nullptr);
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static double IncrementalUpdate(LibassIncrementalTrack &incremental, ASS_Library *library, ASS_Track **track,
+	const wxString &header, const std::vector<ScriptLine *> &lines)
+{
+	auto start = std::chrono::steady_clock::now();
+	struct PendingLine
+	{
+		LibassEventKey key;
+		unsigned long long fingerprint;
+		int readOrder;
+	};
+	std::vector<PendingLine> pending;
+	bool reload = !*track || incremental.NeedsReload(&lines, header);
+	incremental.BeginUpdate();
+	int readOrder = 0;
+	for (ScriptLine *line : lines){
+		LibassEventKey key{ line, false };
+		//dialogue hashes its fields, here it's the whole line
+		unsigned long long fingerprint = 0;
+		LibassHashString(fingerprint, line->raw.wc_str(), line->raw.length());
+		if (!reload && incremental.KeepEvent(&key, fingerprint, readOrder)){
+			readOrder++;
+			continue;
+		}
+		pending.push_back(PendingLine{ key, fingerprint, readOrder++ });
+	}
+	if (reload)
+		*track = incremental.Reload(library, *track, header, &lines);
+	else
+		incremental.RemoveUnusedEvents(*track);
+	for (auto &line : pending){
+		incremental.AddEvent(*track, line.key, line.fingerprint, ((const ScriptLine *)line.key.line)->raw, line.readOrder);
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static bool EventLess(const ASS_Event &first, const ASS_Event &second)
+{
+	return first.ReadOrder < second.ReadOrder;
+}
+
+static int CompareTracks(ASS_Track *fullTrack, ASS_Track *track)
+{
+	if (!fullTrack || !track || fullTrack->n_events != track->n_events || fullTrack->n_styles != track->n_styles)
+		return 1;
+	std::vector<ASS_Event> fullEvents(fullTrack->events, fullTrack->events + fullTrack->n_events);
+	std::vector<ASS_Event> events(track->events, track->events + track->n_events);
+	std::sort(fullEvents.begin(), fullEvents.end(), EventLess);
+	std::sort(events.begin(), events.end(), EventLess);
+	for (size_t i = 0; i < events.size(); i++){
+		const ASS_Event &a = fullEvents[i], &b = events[i];
+		if (a.Start != b.Start || a.Duration != b.Duration || a.Layer != b.Layer || a.Style != b.Style ||
+			a.MarginL != b.MarginL || a.MarginR != b.MarginR || a.MarginV != b.MarginV ||
+			strcmp(a.Text ? a.Text : "", b.Text ? b.Text : ""))
+			return 1;
+		//order of incremental track has gaps after comments
+		if (i > 0 && b.ReadOrder <= events[i - 1].ReadOrder)
+			return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t numEdits = (argc > 1) ? (size_t)atoll(argv[1]) : 50;
+	if (!numEdits)
+		return 1;
+
+	ASS_Library *library = ass_library_init();
+	ass_set_message_cb(library, QuietMessages, nullptr);
+	wxString header = MakeHeader();
+
+	int failed = 0;
+	size_t sizes[] = { 1000, 10000, 50000 };
+	printf("%i edits, 70%% text changes, 10%% insertions, 10%% insertions of the same line, 10%% deletions\n", (int)numEdits);
+	printf("%-8s %14s %14s %12s\n", "lines", "full ms", "incremental ms", "speedup");
+	for (size_t size : sizes){
+		std::mt19937 random(1234);
+		std::vector<ScriptLine> storage(size + numEdits);
+		std::vector<ScriptLine *> lines;
+		for (size_t i = 0; i < size; i++){
+			storage[i].raw = MakeLine(random, i);
+			lines.push_back(&storage[i]);
+		}
+		size_t nextLine = size;
+
+		ASS_Track *fullTrack = nullptr;
+		ASS_Track *track = nullptr;
+		LibassIncrementalTrack incremental;
+		//first open reads whole script on both paths
+		FullReload(library, &fullTrack, header, lines);
+		IncrementalUpdate(incremental, library, &track, header, lines);
+		failed |= CompareTracks(fullTrack, track);
+
+		double fullTime = 0, incrementalTime = 0;
+		for (size_t edit = 0; edit < numEdits; edit++){
+			size_t i = random() % lines.size();
+			int type = random() % 10;
+			if (type == 0){
+				storage[nextLine].raw = MakeLine(random, nextLine);
+				lines.insert(lines.begin() + i, &storage[nextLine++]);
+			}
+			else if (type == 1){
+				lines.erase(lines.begin() + i);
+			}
+			else if (type == 2){
+				//one dialogue in two rows, both have to be in track
+				lines.insert(lines.begin() + i, lines[random() % lines.size()]);
+			}
+			else{
+				lines[i]->raw.Replace(L"\r\n", L" edited\r\n");
+			}
+			fullTime += FullReload(library, &fullTrack, header, lines);
+			incrementalTime += IncrementalUpdate(incremental, library, &track, header, lines);
+			failed |= CompareTracks(fullTrack, track);
+		}
+		printf("%-8i %14.3f %14.3f %12.1f\n", (int)size, fullTime / numEdits, incrementalTime / numEdits,
+			fullTime / incrementalTime);
+		//reload adds duplicated lines without KeepEvent
+		incremental.Reset();
+		IncrementalUpdate(incremental, library, &track, header, lines);
+		failed |= CompareTracks(fullTrack, track);
+		ass_free_track(fullTrack);
+		ass_free_track(track);
+	}
+	ass_library_done(library);
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,279 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Check and load-time benchmark of opening generated ASS and SRT files like SubsLoader does.
+//Old path reads file twice (encoding test and wxFFile::ReadAll), splits it by wxStringTokenizer
+//and parses every line from wxString copy, new path is OpenWrite::FileOpen with one read,
+//lines found by GetLoadedLines or TextLines and dialogues parsed straight from loaded text.
+//Dialogue needs config of Kainote, so objects of Release x64 build of Kainote are packed to library first.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution:
+//  lib /OUT:Kainote.lib ..\obj\x64\Release\Kainote\*.obj
+//  cl /O2 /EHsc /std:c++20 /D__WXMSW__ /DUNICODE /D_UNICODE /I..\Kainote /I..\Thirdparty\wxWidgets\include
+//    /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu LoadFileBenchmark.cpp /link /SUBSYSTEM:CONSOLE
+//    /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release Kainote.lib + Linker Input libraries of Kainote project
+//Arguments: [number of lines, default 100000] [folder of test files, default current folder].
+//Returns 1 when any dialogue loaded by new path differs from dialogue loaded by old path.
+
+#include "OpennWrite.h"
+#include "DialogueParser.h"
+#include "SubsDialogue.h"
+#include "config.h"
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/tokenzr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+//old OpenWrite::FileOpen, file is read again after encoding test
+static bool OldFileOpen(const wxString &filename, wxString *riddenText)
+{
+	wxFile filetest;
+	filetest.Open(filename, wxFile::read, wxS_DEFAULT);
+	wchar_t b[4];
+	filetest.Read(b, 4);
+	bool utf8 = ((static_cast <int>(b[0]) > 48000)) ? true : false;
+	if (!utf8){
+		size_t size = filetest.Length();
+		char *buff = new char[size];
+		filetest.Read(buff, size);
+		OpenWrite ow;
+		utf8 = ow.IsUTF8withoutBOM(buff, size);
+		delete[] buff;
+	}
+	filetest.Close();
+	wxFFile fileo;
+	fileo.Open(filename, L"r");
+	if (!fileo.IsOpened())
+		return false;
+	if (utf8){
+		fileo.ReadAll(riddenText);
+	}
+	else{ fileo.ReadAll(riddenText, wxConvLocal); }
+	fileo.Close();
+	return !riddenText->empty();
+}
+
+//dialogues of old SubsLoader::LoadASS
+static void OldLoadASS(const wxString &text, std::vector<Dialogue *> *dialogues)
+{
+	wxStringTokenizer tokenizer(text, L"\n", wxTOKEN_STRTOK);
+	while (tokenizer.HasMoreTokens()){
+		wxString token = tokenizer.GetNextToken().Trim(false);
+		if (token.StartsWith(L"Dial") || token.StartsWith(L"Comm"))
+			dialogues->push_back(new Dialogue(token));
+	}
+}
+
+//dialogues of SubsLoader::LoadASS for file smaller than PARALLEL_LOAD_MIN_SIZE
+static void NewLoadASS(const wxString &text, std::vector<Dialogue *> *dialogues)
+{
+	std::vector<LoadedLine> loaded;
+	GetLoadedLines(text, &loaded);
+	for (auto &loadedLine : loaded){
+		const wchar_t *line = loadedLine.line + loadedLine.trimmed;
+		size_t length = loadedLine.length - loadedLine.trimmed;
+		if (HasPrefix(line, length, L"Dial", 4) || HasPrefix(line, length, L"Comm", 4))
+			dialogues->push_back(new Dialogue(line, length));
+	}
+}
+
+//old SubsLoader::LoadSRT
+static void OldLoadSRT(const wxString &text, std::vector<Dialogue *> *dialogues)
+{
+	wxStringTokenizer tokenizer(text, L"\n", wxTOKEN_STRTOK);
+	tokenizer.GetNextToken();
+
+	wxString text1;
+	while (tokenizer.HasMoreTokens()){
+		wxString text = tokenizer.GetNextToken().Trim();
+		if (IsNumber(text)){
+			if (text1 != emptyString){
+				dialogues->push_back(new Dialogue(text1.Trim()));
+				text1 = emptyString;
+			}
+		}
+		else{ text1 << text << L"\r\n"; }
+	}
+	if (text1 != emptyString)
+		dialogues->push_back(new Dialogue(text1.Trim()));
+}
+
+static void NewLoadSRT(const wxString &text, std::vector<Dialogue *> *dialogues)
+{
+	TextLines lines(text);
+	const wchar_t *line;
+	size_t length;
+	lines.GetNextLine(&line, &length);
+
+	wxString text1;
+	while (lines.GetNextLine(&line, &length)){
+		while (length && IsTrimSpace(line[length - 1])){ length--; }
+		if (std::all_of(line, line + length, [](wchar_t ch){ return ch >= L'0' && ch <= L'9'; })){
+			if (text1 != emptyString){
+				dialogues->push_back(new Dialogue(text1.Trim()));
+				text1 = emptyString;
+			}
+		}
+		else{ text1.append(line, length) << L"\r\n"; }
+	}
+	if (text1 != emptyString)
+		dialogues->push_back(new Dialogue(text1.Trim()));
+}
+
+static wxString FormatTime(int time, bool srt)
+{
+	if (srt)
+		return wxString::Format(L"%02i:%02i:%02i,%03i", time / 3600000, (time / 60000) % 60, (time / 1000) % 60, time % 1000);
+	return wxString::Format(L"%i:%02i:%02i.%02i", time / 3600000, (time / 60000) % 60, (time / 1000) % 60, (time / 10) % 100);
+}
+
+//UTF-8 file with BOM and CRLF line ends like files saved by Kainote or Aegisub
+static bool GenerateFile(const wxString &fileName, size_t numLines, bool srt)
+{
+	const wchar_t *texts[] = {
+		L"{\\pos(960,100)\\fad(150,150)}Text of sign",
+		L"Zażółć gęślą jaźń",
+		L"{\\k25}か{\\k30}ら{\\k20}お{\\k40}け",
+		L"Two lines\\Nof dialogue",
+	};
+	std::mt19937 random(1234);
+	wxString text;
+	if (!srt){
+		text = L"[Script Info]\r\nScriptType: v4.00+\r\nPlayResX: 1920\r\nPlayResY: 1080\r\n\r\n"
+			L"[V4+ Styles]\r\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, "
+			L"BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, "
+			L"Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\r\n"
+			L"Style: Default,Arial,48,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,"
+			L"0,0,0,0,100,100,0,0,1,2,2,2,10,10,10,1\r\n\r\n[Events]\r\n"
+			L"Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+	}
+	text.reserve(text.length() + numLines * 110);
+	for (size_t i = 0; i < numLines; i++){
+		int start = (int)(i * 1500 + random() % 1000);
+		int end = start + 500 + random() % 4000;
+		const wchar_t *lineText = texts[random() % 4];
+		if (srt){
+			//SRT has no tags and new lines are real line breaks
+			wxString srtText = (lineText[0] == L'{') ? wxString(L"Text of sign") : wxString(lineText);
+			srtText.Replace(L"\\N", L"\r\n");
+			text << (i + 1) << L"\r\n" << FormatTime(start, true) << L" --> " << FormatTime(end, true) << L"\r\n"
+				<< srtText << L" " << i << L"\r\n\r\n";
+		}
+		else{
+			text << ((random() % 8) ? L"Dialogue: " : L"Comment: ") << (random() % 3) << L","
+				<< FormatTime(start, false) << L"," << FormatTime(end, false) << L",Default,"
+				<< ((random() % 3) ? wxString::Format(L"Actor %i", (int)(random() % 300)) : wxString())
+				<< L",0,0,0,," << lineText << L" " << i << L"\r\n";
+		}
+	}
+	wxFFile file(fileName, L"wb");
+	if (!file.IsOpened())
+		return false;
+	wxScopedCharBuffer buffer = text.utf8_str();
+	return file.Write("\xEF\xBB\xBF", 3) == 3 && file.Write(buffer.data(), buffer.length()) == buffer.length();
+}
+
+static int Compare(Dialogue *oldDialogue, Dialogue *dialogue)
+{
+	if (oldDialogue->Format != dialogue->Format || oldDialogue->Layer != dialogue->Layer ||
+		oldDialogue->Start.mstime != dialogue->Start.mstime || oldDialogue->End.mstime != dialogue->End.mstime ||
+		oldDialogue->MarginL != dialogue->MarginL || oldDialogue->MarginR != dialogue->MarginR ||
+		oldDialogue->MarginV != dialogue->MarginV || oldDialogue->IsComment != dialogue->IsComment ||
+		oldDialogue->Text.Get() != dialogue->Text.Get() || oldDialogue->Style.Get() != dialogue->Style.Get() ||
+		oldDialogue->Actor.Get() != dialogue->Actor.Get() || oldDialogue->Effect.Get() != dialogue->Effect.Get())
+		return 1;
+	return 0;
+}
+
+typedef void(*LoadFunction)(const wxString &text, std::vector<Dialogue *> *dialogues);
+
+//returns time of reading and parsing in milliseconds
+static double Load(const wxString &fileName, bool oldPath, LoadFunction load, std::vector<Dialogue *> *dialogues)
+{
+	auto start = std::chrono::steady_clock::now();
+	wxString text;
+	bool opened = false;
+	if (oldPath){
+		opened = OldFileOpen(fileName, &text);
+	}
+	else{
+		OpenWrite ow;
+		opened = ow.FileOpen(fileName, &text);
+	}
+	if (opened)
+		load(text, dialogues);
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+int main(int argc, char **argv)
+{
+	size_t numLines = (argc > 1) ? (size_t)atoll(argv[1]) : 100000;
+	wxString folder = ((argc > 2) ? wxString(argv[2]) : wxGetCwd()) + wxFILE_SEP_PATH;
+	if (!numLines)
+		return 1;
+
+	struct Format
+	{
+		const char *name;
+		const wchar_t *fileName;
+		LoadFunction oldLoad;
+		LoadFunction newLoad;
+	};
+	Format formats[] = {
+		{ "ASS", L"LoadFileBenchmark.ass", OldLoadASS, NewLoadASS },
+		{ "SRT", L"LoadFileBenchmark.srt", OldLoadSRT, NewLoadSRT },
+	};
+	int failed = 0;
+	printf("%i lines\n", (int)numLines);
+	printf("%-6s %10s %12s %12s %12s\n", "format", "MB", "old ms", "new ms", "speedup");
+	for (auto &format : formats){
+		wxString fileName = folder + format.fileName;
+		if (!GenerateFile(fileName, numLines, format.name[0] == 'S')){
+			failed++;
+			continue;
+		}
+		double megabytes = wxFileName::GetSize(fileName).ToDouble() / (1024.0 * 1024.0);
+		std::vector<Dialogue *> oldDialogues, dialogues;
+		double oldTime = Load(fileName, true, format.oldLoad, &oldDialogues);
+		double newTime = Load(fileName, false, format.newLoad, &dialogues);
+		printf("%-6s %10.1f %12.3f %12.3f %12.2f\n", format.name, megabytes, oldTime, newTime, oldTime / newTime);
+
+		if (oldDialogues.size() != numLines || dialogues.size() != numLines)
+			failed++;
+		else{
+			for (size_t i = 0; i < numLines; i++){
+				if (Compare(oldDialogues[i], dialogues[i])){
+					failed++;
+					break;
+				}
+			}
+		}
+		for (Dialogue *dialogue : oldDialogues){
+			delete dialogue;
+		}
+		for (Dialogue *dialogue : dialogues){
+			delete dialogue;
+		}
+		wxRemoveFile(fileName);
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
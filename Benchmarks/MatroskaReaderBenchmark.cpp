@@ -0,0 +1,311 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of reading subtitle track by MatroskaReader.
+//Generates remux like file with video, audio and ASS track, 24 fps video blocks of ~115 KB like 20 GB
+//two hours remux, subtitle blocks in block groups, one block with EBML lacing.
+//Only every other subtitle block has cue and every seventh cluster has no subtitle cue at all,
+//so frames read by cluster scan have to be all written frames and frames of cued clusters only frames of those clusters.
+//Frames are read by cluster scan, by cued clusters and then with cues id changed in seek head, so cues are not parsed.
+//Time of the second read is with file in system cache, first read after generating file is usually too.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution (wxWidgets base.lib):
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote /I..\Thirdparty\wxWidgets\include /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu
+//    MatroskaReaderBenchmark.cpp ..\Kainote\MatroskaReader.cpp
+//    /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release base.lib zlib.lib wxregex.lib
+//Arguments: [size of file in MB, default 2048] [path of generated file, default MatroskaReaderBenchmark.mkv].
+//Returns 1 when read frames differ from written ones or from frames of cued clusters.
+
+#include "MatroskaReader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static void PutId(std::string &out, unsigned int id)
+{
+	int length = (id > 0xFFFFFF) ? 4 : (id > 0xFFFF) ? 3 : (id > 0xFF) ? 2 : 1;
+	for (int i = length - 1; i >= 0; i--)
+		out += (char)((id >> (i * 8)) & 0xFF);
+}
+
+//sizes have always 8 bytes, then they can be changed in place
+static void PutSize(std::string &out, unsigned long long size)
+{
+	out += (char)0x01;
+	for (int i = 6; i >= 0; i--)
+		out += (char)((size >> (i * 8)) & 0xFF);
+}
+
+static void PutElement(std::string &out, unsigned int id, const std::string &data)
+{
+	PutId(out, id);
+	PutSize(out, data.size());
+	out += data;
+}
+
+static void PutUInt(std::string &out, unsigned int id, unsigned long long value)
+{
+	std::string data;
+	for (int i = 7; i >= 0; i--)
+		data += (char)((value >> (i * 8)) & 0xFF);
+	PutElement(out, id, data);
+}
+
+static std::string Block(unsigned long long track, int relativeTime, const std::string &data)
+{
+	std::string block;
+	block += (char)(0x80 | track);
+	block += (char)((relativeTime >> 8) & 0xFF);
+	block += (char)(relativeTime & 0xFF);
+	block += (char)0x80;
+	return block + data;
+}
+
+struct Frame
+{
+	long long start;
+	long long duration;
+	std::string data;
+};
+
+struct Cue
+{
+	unsigned long long track;
+	long long time;
+	long long clusterPosition;
+	long long relativePosition;
+};
+
+//writes file and returns written subtitle frames, cuedFrames are frames of clusters with subtitle cues
+static bool Generate(const char *path, long long fileSize, long long *cuesIdPosition, std::vector<Frame> *frames,
+	std::vector<Frame> *cuedFrames)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	std::string header;
+	std::string ebml;
+	PutElement(ebml, 0x4282, "matroska");
+	PutElement(header, 0x1A45DFA3, ebml);
+	fwrite(header.data(), 1, header.size(), file);
+
+	std::string segment;
+	PutId(segment, 0x18538067);
+	long long segmentSizePosition = header.size() + segment.size();
+	PutSize(segment, 0);
+	long long segmentStart = header.size() + segment.size();
+
+	//seek head with info, tracks and cues, position of cues is written at the end
+	std::string seekHead;
+	unsigned int seekIds[] = { 0x1549A966, 0x1654AE6B, 0x1C53BB6B };
+	std::string info;
+	PutUInt(info, 0x2AD7B1, 1000000);
+	std::string tracks;
+	const char *codecs[] = { "V_MPEG4/ISO/AVC", "A_AC3", "S_TEXT/ASS" };
+	int types[] = { 1, 2, 0x11 };
+	for (int i = 0; i < 3; i++) {
+		std::string entry;
+		PutUInt(entry, 0xD7, i + 1);
+		PutUInt(entry, 0x83, types[i]);
+		PutElement(entry, 0x86, codecs[i]);
+		PutElement(tracks, 0xAE, entry);
+	}
+	//seek head has fixed size, so positions can be counted before it's made
+	long long seekHeadSize = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		std::string seeks;
+		long long positions[] = { seekHeadSize, seekHeadSize + 12 + (long long)info.size(), 0 };
+		for (int i = 0; i < 3; i++) {
+			std::string seek;
+			std::string id;
+			PutId(id, seekIds[i]);
+			PutElement(seek, 0x53AB, id);
+			PutUInt(seek, 0x53AC, positions[i]);
+			PutElement(seeks, 0x4DBB, seek);
+		}
+		seekHead.clear();
+		PutElement(seekHead, 0x114D9B74, seeks);
+		seekHeadSize = seekHead.size();
+	}
+	//id of cues in seek head, position is after it in the next element
+	long long cuesSeekPosition = segmentStart + seekHead.find(std::string("\x1C\x53\xBB\x6B", 4));
+	long long cuesPositionInSeek = cuesSeekPosition + 4 + 10;
+	*cuesIdPosition = cuesSeekPosition;
+	segment += seekHead;
+	PutElement(segment, 0x1549A966, info);
+	PutElement(segment, 0x1654AE6B, tracks);
+	fwrite(segment.data(), 1, segment.size(), file);
+	long long pos = header.size() + segment.size();
+
+	std::vector<Cue> cues;
+	std::string videoData(115000, 'v');
+	std::string audioData(1792, 'a');
+	long long time = 0;
+	int line = 0;
+	while (pos < fileSize) {
+		//clusters of 2 seconds like mkvmerge makes for AVC
+		std::string children;
+		PutUInt(children, 0xE7, time);
+		long long clusterPosition = pos - segmentStart;
+		cues.push_back({ 1, time, clusterPosition, (long long)children.size() });
+		bool subtitleCues = (time / 2000) % 7 != 5;
+		size_t firstFrame = frames->size();
+		for (int ms = 0; ms < 2000; ms += 32) {
+			//video every 42 ms, audio every 32 ms
+			for (int video = (ms + 41) / 42 * 42; video < ms + 32 && video < 2000; video += 42) {
+				PutElement(children, 0xA3, Block(1, video, videoData));
+			}
+			PutElement(children, 0xA3, Block(2, ms, audioData));
+			if (ms % 320 == 0 && (time / 2000) % 3 != 2) {
+				Frame frame = { time + ms, 1500, "" };
+				char text[100];
+				sprintf(text, "%i,0,Default,,0,0,0,,{\\pos(640,%i)}Line %i", line, line % 720, line);
+				frame.data = text;
+				line++;
+				std::string blockGroup;
+				if (line == 100) {
+					//two laced frames, the second one starts in the middle of duration
+					Frame second = { time + ms + 750, 750, "" };
+					sprintf(text, "%i,0,Default,,0,0,0,,Laced line %i", line, line);
+					second.data = text;
+					line++;
+					frame.duration = 750;
+					std::string block;
+					block += (char)0x83;
+					block += (char)((ms >> 8) & 0xFF);
+					block += (char)(ms & 0xFF);
+					block += (char)0x06;
+					block += (char)0x01;
+					//EBML size of the first frame
+					block += (char)0x40;
+					block += (char)frame.data.size();
+					block += frame.data + second.data;
+					PutElement(blockGroup, 0xA1, block);
+					PutUInt(blockGroup, 0x9B, 1500);
+					frames->push_back(frame);
+					frames->push_back(second);
+				}
+				else {
+					PutElement(blockGroup, 0xA1, Block(3, ms, frame.data));
+					PutUInt(blockGroup, 0x9B, frame.duration);
+					frames->push_back(frame);
+				}
+				if (subtitleCues && line % 2 == 0)
+					cues.push_back({ 3, time + ms, clusterPosition, (long long)children.size() });
+				PutElement(children, 0xA0, blockGroup);
+			}
+		}
+		if (subtitleCues)
+			cuedFrames->insert(cuedFrames->end(), frames->begin() + firstFrame, frames->end());
+		std::string cluster;
+		PutElement(cluster, 0x1F43B675, children);
+		fwrite(cluster.data(), 1, cluster.size(), file);
+		pos += cluster.size();
+		time += 2000;
+	}
+
+	long long cuesPosition = pos - segmentStart;
+	std::string cuePoints;
+	for (const Cue &cue : cues) {
+		std::string positions;
+		PutUInt(positions, 0xF7, cue.track);
+		PutUInt(positions, 0xF1, cue.clusterPosition);
+		PutUInt(positions, 0xF0, cue.relativePosition);
+		std::string cuePoint;
+		PutUInt(cuePoint, 0xB3, cue.time);
+		PutElement(cuePoint, 0xB7, positions);
+		PutElement(cuePoints, 0xBB, cuePoint);
+	}
+	std::string cuesElement;
+	PutElement(cuesElement, 0x1C53BB6B, cuePoints);
+	fwrite(cuesElement.data(), 1, cuesElement.size(), file);
+	pos += cuesElement.size();
+
+	std::string number;
+	PutSize(number, pos - segmentStart);
+	fseek(file, (long)segmentSizePosition, SEEK_SET);
+	fwrite(number.data(), 1, number.size(), file);
+	number.clear();
+	for (int i = 7; i >= 0; i--)
+		number += (char)((cuesPosition >> (i * 8)) & 0xFF);
+	fseek(file, (long)cuesPositionInSeek, SEEK_SET);
+	fwrite(number.data(), 1, number.size(), file);
+	fclose(file);
+	return true;
+}
+
+static double Read(const char *path, bool cuedClustersOnly, std::vector<MatroskaFrame> *frames)
+{
+	auto start = std::chrono::steady_clock::now();
+	MatroskaReader reader;
+	frames->clear();
+	if (!reader.Open(wxString(path)) || !reader.ReadFrames(3, frames, nullptr, cuedClustersOnly))
+		frames->clear();
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static int Compare(const std::vector<Frame> &written, const std::vector<MatroskaFrame> &frames)
+{
+	if (written.size() != frames.size())
+		return 1;
+	for (size_t i = 0; i < written.size(); i++) {
+		if (written[i].start != frames[i].start || written[i].duration != frames[i].duration ||
+			written[i].data != frames[i].data)
+			return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	long long size = ((argc > 1) ? atoll(argv[1]) : 2048) * 1024 * 1024;
+	const char *path = (argc > 2) ? argv[2] : "MatroskaReaderBenchmark.mkv";
+	std::vector<Frame> written;
+	std::vector<Frame> cuedWritten;
+	long long cuesIdPosition = 0;
+	if (!Generate(path, size, &cuesIdPosition, &written, &cuedWritten)) {
+		printf("cannot write %s\n", path);
+		return 1;
+	}
+
+	int failed = 0;
+	std::vector<MatroskaFrame> frames;
+	printf("%lld MB, %i subtitle frames\n", size / (1024 * 1024), (int)written.size());
+	printf("%-14s %12s %12s\n", "read", "ms", "ms per GB");
+	double scanTime = Read(path, false, &frames);
+	failed += Compare(written, frames);
+	printf("%-14s %12.3f %12.3f\n", "cluster scan", scanTime, scanTime * 1024 * 1024 * 1024 / size);
+	double cuedTime = Read(path, true, &frames);
+	failed += Compare(cuedWritten, frames);
+	printf("%-14s %12.3f %12.3f\n", "cued clusters", cuedTime, cuedTime * 1024 * 1024 * 1024 / size);
+
+	//seek head points to unknown element, cues are not parsed
+	FILE *file = fopen(path, "r+b");
+	if (file) {
+		fseek(file, (long)(cuesIdPosition + 3), SEEK_SET);
+		fputc(0x6C, file);
+		fclose(file);
+	}
+	//without cues only cluster scan is possible
+	double noCuesTime = Read(path, true, &frames);
+	failed += Compare(written, frames);
+	printf("%-14s %12.3f %12.3f\n", "no cues", noCuesTime, noCuesTime * 1024 * 1024 * 1024 / size);
+	remove(path);
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and micro-benchmark of style and script info lookup by name (NameIndex.h).
+//Every lookup is compared with the old linear search from SubsFile::FindStyle,
+//also after adding, renaming, reordering and removing styles like SubsFile does.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution (wxWidgets base.lib):
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote /I..\Thirdparty\wxWidgets\include /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu
+//    NameIndexBenchmark.cpp /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release base.lib zlib.lib wxregex.lib
+//Returns 1 when any lookup gives other position.
+
+#include "NameIndex.h"
+#include <stdio.h>
+#include <chrono>
+#include <random>
+
+//only name is used by index
+struct NamedElement
+{
+	NamedElement(const wxString &name) : Name(name){}
+	wxString Name;
+};
+
+//SubsFile::FindStyle before name index
+static size_t FindOld(const std::vector<NamedElement*> &table, const wxString &name)
+{
+	size_t isfound = -1;
+	for (size_t j = 0; j < table.size(); j++)
+	{
+		if (name == table[j]->Name){
+			isfound = j;
+			break;
+		}
+	}
+	return isfound;
+}
+
+static int CheckNames(NameIndex<NamedElement> &index, const std::vector<NamedElement*> &table,
+	const std::vector<wxString> &names, int *checked)
+{
+	int failed = 0;
+	for (const wxString &name : names){
+		if (index.Find(table, name) != FindOld(table, name))
+			failed++;
+	}
+	*checked += names.size();
+	return failed;
+}
+
+//milliseconds of all lookups
+template<class Function>
+static double Benchmark(Function find, const std::vector<wxString> &lookups, size_t *found)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (const wxString &name : lookups){
+		if (find(name) != -1)
+			(*found)++;
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+int main()
+{
+	std::mt19937 random(1234);
+	std::vector<NamedElement*> table;
+	std::vector<wxString> names;
+	//big fansub scripts have few hundreds styles with common prefixes
+	const size_t stylesCount = 400;
+	for (size_t i = 0; i < stylesCount; i++){
+		wxString name = wxString::Format(L"Sign - episode %i - style %i", (int)(i % 13), (int)i);
+		table.push_back(new NamedElement(name));
+		names.push_back(name);
+	}
+	//duplicates and names that are not in table
+	table.push_back(new NamedElement(names[7]));
+	names.push_back(L"Default");
+	names.push_back(L"Sign - episode 1 - style 9999");
+	names.push_back(L"");
+
+	NameIndex<NamedElement> index;
+	int checked = 0;
+	int failed = CheckNames(index, table, names, &checked);
+
+	//AddStyle
+	table.push_back(new NamedElement(L"Added"));
+	index.Add(table);
+	names.push_back(L"Added");
+	failed += CheckNames(index, table, names, &checked);
+
+	//ChangeStyle of unique and duplicated name
+	wxString oldName = table[10]->Name;
+	delete table[10];
+	table[10] = new NamedElement(L"Renamed");
+	index.Replace(table, 10, oldName);
+	names.push_back(L"Renamed");
+	failed += CheckNames(index, table, names, &checked);
+	oldName = table[7]->Name;
+	delete table[7];
+	table[7] = new NamedElement(L"Renamed duplicate");
+	index.Replace(table, 7, oldName);
+	names.push_back(L"Renamed duplicate");
+	failed += CheckNames(index, table, names, &checked);
+
+	//reordering in style manager and DeleleStyle
+	std::shuffle(table.begin(), table.end(), random);
+	index.Invalidate();
+	failed += CheckNames(index, table, names, &checked);
+	delete table[20];
+	table.erase(table.begin() + 20);
+	index.Invalidate();
+	failed += CheckNames(index, table, names, &checked);
+	printf("%i lookups checked, %i with other position, %s\n", checked, failed, failed ? "FAILED" : "ok");
+
+	//grid paint looks up style of every visible line
+	std::vector<wxString> lookups;
+	for (int i = 0; i < 200000; i++){
+		lookups.push_back(names[random() % names.size()]);
+	}
+	size_t foundOld = 0, foundNew = 0;
+	double oldTime = Benchmark([&](const wxString &name){ return FindOld(table, name); }, lookups, &foundOld);
+	double newTime = Benchmark([&](const wxString &name){ return index.Find(table, name); }, lookups, &foundNew);
+	printf("%-6s %.3f ms per %i lookups in %i styles\n", "linear", oldTime, (int)lookups.size(), (int)table.size());
+	printf("%-6s %.3f ms per %i lookups in %i styles\n", "index", newTime, (int)lookups.size(), (int)table.size());
+
+	for (NamedElement *element : table)
+		delete element;
+	return (failed || foundOld != foundNew) ? 1 : 0;
+}
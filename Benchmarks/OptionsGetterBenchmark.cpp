@@ -0,0 +1,139 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and micro-benchmark of option getters from config.h.
+//config.h needs wxWidgets core, so getters before and after typed copies are copied here.
+//Typed values are compared with the old getters for every kind of stored string,
+//then getters are called like in grid paint loop which reads a few options for every line.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution (wxWidgets base.lib):
+//  cl /O2 /EHsc /std:c++20 /I..\Thirdparty\wxWidgets\include /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu
+//    OptionsGetterBenchmark.cpp /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release base.lib zlib.lib wxregex.lib
+//Returns 1 when any typed value is other than from the old getter.
+
+#include <wx/string.h>
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+static const int configSize = 300;
+
+//config getters before typed copies
+class OldConfig
+{
+public:
+	wxString stringConfig[configSize];
+	bool GetBool(int opt)
+	{
+		if (opt >= 0 && opt < configSize){
+			wxString ropt = stringConfig[opt];
+			if (ropt == L"true"){ return true; }
+		}
+		return false;
+	}
+	int GetInt(int opt)
+	{
+		if (opt >= 0 && opt < configSize)
+			return wxAtoi(stringConfig[opt]);
+
+		return 0;
+	}
+	float GetFloat(int opt)
+	{
+		if (opt >= 0 && opt < configSize){
+			double fl;
+			wxString rawfloat = stringConfig[opt];
+			if (!rawfloat.ToDouble(&fl)){ return 0.0; }
+			return fl;
+		}
+		return 0.0;
+	}
+};
+
+//config::UpdateTypedOption and getters
+class NewConfig
+{
+public:
+	void SetRawOption(int opt, const wxString &value)
+	{
+		stringConfig[opt] = value;
+		const wxString &val = stringConfig[opt];
+		boolConfig[opt] = val == L"true";
+		intConfig[opt] = wxAtoi(val);
+		double fl;
+		floatConfig[opt] = (val.ToCDouble(&fl)) ? fl : 0.f;
+	}
+	bool GetBool(int opt){ return (opt >= 0 && opt < configSize) ? boolConfig[opt] : false; }
+	int GetInt(int opt){ return (opt >= 0 && opt < configSize) ? intConfig[opt] : 0; }
+	float GetFloat(int opt){ return (opt >= 0 && opt < configSize) ? floatConfig[opt] : 0.f; }
+private:
+	wxString stringConfig[configSize];
+	bool boolConfig[configSize] = {};
+	int intConfig[configSize] = {};
+	float floatConfig[configSize] = {};
+};
+
+//milliseconds of reading options of all lines, sum is returned to not optimize calls out
+template<class Config>
+static double Benchmark(Config &config, const std::vector<int> &options, int lines, double *sum)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int line = 0; line < lines; line++){
+		for (int opt : options){
+			*sum += config.GetBool(opt) + config.GetInt(opt) + config.GetFloat(opt);
+		}
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+int main()
+{
+	//program saves options always with dot
+	const wchar_t *values[] = { L"true", L"false", L"0", L"1", L"-15", L"250", L"0.5", L"-2.25",
+		L"1e3", L"12px", L"Arial", L"", L"1,5", L"2147483647" };
+	OldConfig oldConfig;
+	NewConfig newConfig;
+	std::mt19937 random(1234);
+	for (int i = 0; i < configSize; i++){
+		wxString value = values[random() % (sizeof(values) / sizeof(values[0]))];
+		oldConfig.stringConfig[i] = value;
+		newConfig.SetRawOption(i, value);
+	}
+
+	int checked = 0, failed = 0;
+	for (int i = -1; i <= configSize; i++){
+		if (oldConfig.GetBool(i) != newConfig.GetBool(i) || oldConfig.GetInt(i) != newConfig.GetInt(i) ||
+			oldConfig.GetFloat(i) != newConfig.GetFloat(i)){
+			printf("option %i differs\n", i);
+			failed++;
+		}
+		checked++;
+	}
+	printf("%i options checked, %i with other values, %s\n", checked, failed, failed ? "FAILED" : "ok");
+
+	//grid reads about ten options for every painted line
+	std::vector<int> options;
+	for (int i = 0; i < 10; i++){
+		options.push_back(random() % configSize);
+	}
+	const int lines = 100000;
+	double oldSum = 0, newSum = 0;
+	double oldTime = Benchmark(oldConfig, options, lines, &oldSum);
+	double newTime = Benchmark(newConfig, options, lines, &newSum);
+	printf("%-6s %.3f ms per %i lines\n", "string", oldTime, lines);
+	printf("%-6s %.3f ms per %i lines\n", "typed", newTime, lines);
+	return (failed || oldSum != newSum) ? 1 : 0;
+}
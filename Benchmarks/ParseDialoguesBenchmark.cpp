@@ -0,0 +1,141 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Check and scaling benchmark of parsing dialogues of big ASS script in threads (DialogueParser.cpp)
+//like SubsLoader::LoadASS does, with Dialogue::SetRawASS and interning of style, actor and effect.
+//Old path is parsing of every line in main thread like for scripts smaller than PARALLEL_LOAD_MIN_SIZE,
+//new path is ParseDialoguesParallel for 1 to 16 threads.
+//Dialogue needs config of Kainote, so objects of Release x64 build of Kainote are packed to library first.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution:
+//  lib /OUT:Kainote.lib ..\obj\x64\Release\Kainote\*.obj
+//  cl /O2 /EHsc /std:c++20 /D__WXMSW__ /DUNICODE /D_UNICODE /I..\Kainote /I..\Thirdparty\wxWidgets\include
+//    /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu ParseDialoguesBenchmark.cpp /link /SUBSYSTEM:CONSOLE
+//    /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release Kainote.lib + Linker Input libraries of Kainote project
+//Arguments: [number of dialogues, default 400000].
+//Returns 1 when any dialogue parsed in threads differs from dialogue parsed in main thread
+//or global intern table is not empty after release of all dialogues.
+
+#include "DialogueParser.h"
+#include "SubsDialogue.h"
+#include "InternTable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+static wxString GenerateScript(size_t numLines)
+{
+	std::mt19937 random(1234);
+	wxString script = L"[Script Info]\nScriptType: v4.00+\nPlayResX: 1920\nPlayResY: 1080\n\n"
+		L"[V4+ Styles]\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, "
+		L"BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, "
+		L"Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\n";
+	for (int i = 0; i < 60; i++){
+		script << wxString::Format(L"Style: Sign %i,Arial,48,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,"
+			L"0,0,0,0,100,100,0,0,1,2,2,2,10,10,10,1\n", i);
+	}
+	script << L"\n[Events]\nFormat: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n";
+	script.reserve(script.length() + numLines * 120);
+	const wchar_t *actorPrefixes[] = { L"", L"", L"", L"[bookmark]", L"[tree_opened]" };
+	for (size_t i = 0; i < numLines; i++){
+		int start = (int)(i * 1500 + random() % 1000);
+		int end = start + 500 + random() % 4000;
+		int tag = random() % 4;
+		script << ((random() % 8) ? L"Dialogue: " : L"Comment: ") << (random() % 3) << L","
+			<< wxString::Format(L"%i:%02i:%02i.%02i,", start / 3600000, (start / 60000) % 60, (start / 1000) % 60, (start / 10) % 100)
+			<< wxString::Format(L"%i:%02i:%02i.%02i,", end / 3600000, (end / 60000) % 60, (end / 1000) % 60, (end / 10) % 100)
+			<< L"Sign " << (random() % 60) << L","
+			<< actorPrefixes[random() % 5] << ((random() % 3) ? wxString::Format(L"Actor %i", (int)(random() % 300)) : wxString()) << L","
+			<< L"0,0," << ((random() % 10) ? L"0" : L"20") << L","
+			<< ((random() % 10) ? L"" : L"template line") << L","
+			<< ((tag == 0) ? L"{\\pos(960,100)\\fad(150,150)}" : (tag == 1) ? L"{\\k25}ka{\\k30}ra{\\k20}o{\\k40}ke" : L"")
+			<< L"Text of line number " << i << L"\n";
+	}
+	return script;
+}
+
+static bool IsDialogue(const LoadedLine &loaded)
+{
+	const wchar_t *line = loaded.line + loaded.trimmed;
+	size_t length = loaded.length - loaded.trimmed;
+	return HasPrefix(line, length, L"Dialogue", 8) || HasPrefix(line, length, L"Comment", 7);
+}
+
+static int Compare(Dialogue *oldDialogue, Dialogue *dialogue)
+{
+	if (!oldDialogue || !dialogue)
+		return 1;
+	if (oldDialogue->Layer != dialogue->Layer || oldDialogue->Start.mstime != dialogue->Start.mstime ||
+		oldDialogue->End.mstime != dialogue->End.mstime || oldDialogue->MarginL != dialogue->MarginL ||
+		oldDialogue->MarginR != dialogue->MarginR || oldDialogue->MarginV != dialogue->MarginV ||
+		oldDialogue->IsComment != dialogue->IsComment || oldDialogue->treeState != dialogue->treeState ||
+		oldDialogue->GetState() != dialogue->GetState() || oldDialogue->Text.Get() != dialogue->Text.Get() ||
+		oldDialogue->Style.Get() != dialogue->Style.Get() || oldDialogue->Actor.Get() != dialogue->Actor.Get() ||
+		oldDialogue->Effect.Get() != dialogue->Effect.Get())
+		return 1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t numLines = (argc > 1) ? (size_t)atoll(argv[1]) : 400000;
+	if (!numLines)
+		return 1;
+
+	wxString script = GenerateScript(numLines);
+	std::vector<LoadedLine> loaded;
+	GetLoadedLines(script, &loaded);
+
+	int failed = 0;
+	printf("%i dialogues, %.1f MB of text\n", (int)numLines, script.length() * sizeof(wchar_t) / (1024.0 * 1024.0));
+	printf("%-10s %12s %12s\n", "threads", "ms", "speedup");
+
+	//the same as takeDialogue of SubsLoader::LoadASS when line was not parsed in thread
+	std::vector<Dialogue *> oldDialogues(loaded.size());
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < loaded.size(); i++){
+		if (IsDialogue(loaded[i]))
+			oldDialogues[i] = new Dialogue(loaded[i].line + loaded[i].trimmed, loaded[i].length - loaded[i].trimmed);
+	}
+	std::chrono::duration<double, std::milli> oldTime = std::chrono::steady_clock::now() - start;
+	printf("%-10s %12.3f %12.2f\n", "main", oldTime.count(), 1.0);
+
+	size_t threadCounts[] = { 1, 2, 4, 8, 12, 16 };
+	for (size_t numThreads : threadCounts){
+		for (auto &loadedLine : loaded){
+			loadedLine.dialogue = nullptr;
+		}
+		start = std::chrono::steady_clock::now();
+		ParseDialoguesParallel(loaded, numThreads);
+		std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+		printf("%-10i %12.3f %12.2f\n", (int)numThreads, time.count(), oldTime.count() / time.count());
+
+		int lineFailed = 0;
+		for (size_t i = 0; i < loaded.size(); i++){
+			if (oldDialogues[i] || loaded[i].dialogue)
+				lineFailed |= Compare(oldDialogues[i], loaded[i].dialogue);
+			delete loaded[i].dialogue;
+		}
+		failed += lineFailed;
+	}
+	for (Dialogue *dialogue : oldDialogues){
+		delete dialogue;
+	}
+	if (InternTable::GlobalSize() != 0)
+		failed++;
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
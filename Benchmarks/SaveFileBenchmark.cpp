@@ -0,0 +1,158 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Check and throughput benchmark of saving subtitles (OpennWrite.cpp) like SubsGridBase::SaveFile does,
+//every dialogue is taken by Dialogue::GetRaw and written to file.
+//Old path writes every line with OpenWrite::PartFileWrite, new path converts lines to UTF-8 buffer
+//with SafeFileWrite and replaces target file by SafeFileClose.
+//Dialogue needs config of Kainote, so objects of Release x64 build of Kainote are packed to library first.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution:
+//  lib /OUT:Kainote.lib ..\obj\x64\Release\Kainote\*.obj
+//  cl /O2 /EHsc /std:c++20 /D__WXMSW__ /DUNICODE /D_UNICODE /I..\Kainote /I..\Thirdparty\wxWidgets\include
+//    /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu SaveFileBenchmark.cpp /link /SUBSYSTEM:CONSOLE
+//    /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release Kainote.lib + Linker Input libraries of Kainote project
+//Arguments: [number of dialogues, default 400000] [folder of test files, default current folder].
+//Returns 1 when files saved by both paths differ or lone surrogates are not written as U+FFFD.
+
+#include "OpennWrite.h"
+#include "SubsDialogue.h"
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string ReadBytes(const wxString &fileName)
+{
+	std::string bytes;
+	wxFFile file(fileName, L"rb");
+	if (!file.IsOpened())
+		return bytes;
+	bytes.resize((size_t)file.Length());
+	if (file.Read(&bytes[0], bytes.size()) != bytes.size())
+		bytes.clear();
+	return bytes;
+}
+
+static double SaveOld(const wxString &fileName, const wxString &header, const std::vector<Dialogue *> &dialogues)
+{
+	auto start = std::chrono::steady_clock::now();
+	{
+		OpenWrite ow(fileName, true);
+		ow.PartFileWrite(header);
+		wxString raw;
+		for (Dialogue *dialogue : dialogues){
+			dialogue->GetRaw(&raw);
+			ow.PartFileWrite(raw);
+			raw.Empty();
+		}
+		ow.CloseFile();
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static double SaveNew(const wxString &fileName, const wxString &header, const std::vector<Dialogue *> &dialogues, bool *saved)
+{
+	auto start = std::chrono::steady_clock::now();
+	OpenWrite ow;
+	*saved = ow.SafeFileOpen(fileName);
+	if (*saved){
+		ow.SafeFileWrite(header);
+		wxString raw;
+		raw.reserve(1024);
+		for (Dialogue *dialogue : dialogues){
+			dialogue->GetRaw(&raw);
+			ow.SafeFileWrite(raw);
+			raw.Empty();
+		}
+		*saved = ow.SafeFileClose();
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+int main(int argc, char **argv)
+{
+	size_t numLines = (argc > 1) ? (size_t)atoll(argv[1]) : 400000;
+	wxString folder = ((argc > 2) ? wxString(argv[2]) : wxGetCwd()) + wxFILE_SEP_PATH;
+	if (!numLines)
+		return 1;
+
+	//ASCII, Polish, Japanese and emoji from surrogate pairs
+	const wchar_t *texts[] = {
+		L"{\\pos(960,100)\\fad(150,150)}Text of sign",
+		L"Zażółć gęślą jaźń",
+		L"{\\k25}か{\\k30}ら{\\k20}お{\\k40}け",
+		L"Emoji \xD83D\xDE00 in line",
+	};
+	std::mt19937 random(1234);
+	std::vector<Dialogue *> dialogues;
+	dialogues.reserve(numLines);
+	for (size_t i = 0; i < numLines; i++){
+		int start = (int)(i * 1500 + random() % 1000);
+		int end = start + 500 + random() % 4000;
+		wxString line = wxString::Format(L"Dialogue: 0,%i:%02i:%02i.%02i,%i:%02i:%02i.%02i,Sign %i,Actor %i,0,0,0,,%s %i",
+			start / 3600000, (start / 60000) % 60, (start / 1000) % 60, (start / 10) % 100,
+			end / 3600000, (end / 60000) % 60, (end / 1000) % 60, (end / 10) % 100,
+			(int)(random() % 60), (int)(random() % 300), texts[random() % 4], (int)i);
+		dialogues.push_back(new Dialogue(line));
+	}
+	wxString header = L"[Script Info]\r\nScriptType: v4.00+\r\n \r\n[Events]\r\n"
+		L"Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+
+	int failed = 0;
+	wxString oldName = folder + L"SaveFileBenchmarkOld.ass";
+	wxString newName = folder + L"SaveFileBenchmarkNew.ass";
+	double oldTime = SaveOld(oldName, header, dialogues);
+	bool saved = false;
+	double newTime = SaveNew(newName, header, dialogues, &saved);
+	std::string oldBytes = ReadBytes(oldName);
+	std::string newBytes = ReadBytes(newName);
+	if (!saved || oldBytes.empty() || oldBytes != newBytes)
+		failed++;
+
+	//the second save replaces existing file
+	newTime = (newTime + SaveNew(newName, header, dialogues, &saved)) / 2;
+	if (!saved || ReadBytes(newName) != oldBytes)
+		failed++;
+
+	//lone high and low surrogates between valid pair
+	wxString surrogates = L"a";
+	surrogates << wxUniChar(0xD800) << L"b" << wxUniChar(0xDC00) << L"c\xD83D\xDE00";
+	OpenWrite ow;
+	if (!ow.SafeFileOpen(newName))
+		failed++;
+	ow.SafeFileWrite(surrogates.wc_str(), surrogates.length());
+	if (!ow.SafeFileClose() || ReadBytes(newName) != "\xEF\xBB\xBF" "a\xEF\xBF\xBD" "b\xEF\xBF\xBD" "c\xF0\x9F\x98\x80")
+		failed++;
+
+	double megabytes = newBytes.size() / (1024.0 * 1024.0);
+	printf("%i lines, %.1f MB\n", (int)numLines, megabytes);
+	printf("%-10s %12s %12s\n", "path", "ms", "MB/s");
+	printf("%-10s %12.3f %12.1f\n", "old", oldTime, megabytes * 1000.0 / oldTime);
+	printf("%-10s %12.3f %12.1f\n", "new", newTime, megabytes * 1000.0 / newTime);
+
+	for (Dialogue *dialogue : dialogues){
+		delete dialogue;
+	}
+	wxRemoveFile(oldName);
+	wxRemoveFile(newName);
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Check and benchmark of latency and memory of undo history steps (SubsFile.cpp) against script size.
+//Every step copies one random dialogue, changes its text and calls SubsFile::SaveUndo like editbox does.
+//Old path is the history before ChunkedArray, where every step copied the whole table of dialogues,
+//new path is SubsFile with dialogues in chunks shared between steps.
+//Memory is counted by operator new of this program, it's the growth of history after all steps.
+//Dialogue and SubsFile need config of Kainote, so objects of Release x64 build of Kainote are packed to library first.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution:
+//  lib /OUT:Kainote.lib ..\obj\x64\Release\Kainote\*.obj
+//  cl /O2 /EHsc /std:c++20 /D__WXMSW__ /DUNICODE /D_UNICODE /I..\Kainote /I..\Thirdparty\wxWidgets\include
+//    /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu SaveUndoBenchmark.cpp /link /SUBSYSTEM:CONSOLE
+//    /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release Kainote.lib + Linker Input libraries of Kainote project
+//Arguments: [number of history steps, default 300].
+//Returns 1 when lines after edits or after undo of all steps have other text than expected.
+
+#include "SubsFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <set>
+#include <vector>
+
+static std::atomic<size_t> allocated{ 0 };
+
+//size is kept before allocated memory, 16 bytes keep alignment of new
+void *operator new(size_t size)
+{
+	size_t *memory = (size_t *)malloc(size + 16);
+	if (!memory)
+		throw std::bad_alloc();
+	*memory = size;
+	allocated.fetch_add(size);
+	return (char *)memory + 16;
+}
+
+void operator delete(void *pointer) noexcept
+{
+	if (!pointer)
+		return;
+	size_t *memory = (size_t *)((char *)pointer - 16);
+	allocated.fetch_sub(*memory);
+	free(memory);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+//old File from SubsFile.h, copy of it copied all tables
+class OldFile
+{
+public:
+	std::vector<Dialogue*> dialogues;
+	std::vector<Styles*> styles;
+	std::vector<SInfo*> sinfo;
+	std::vector<Dialogue*> deleteDialogues;
+	std::set<int> Selections;
+	int activeLine = 0;
+	OldFile *Copy()
+	{
+		OldFile *file = new OldFile();
+		file->dialogues = dialogues;
+		file->styles = styles;
+		file->sinfo = sinfo;
+		file->Selections = Selections;
+		file->activeLine = activeLine;
+		return file;
+	}
+	void Clear()
+	{
+		for (Dialogue *dial : deleteDialogues){
+			delete dial;
+		}
+	}
+};
+
+struct Result
+{
+	double averageUs;
+	double maxUs;
+	size_t bytesPerStep;
+	int failed;
+};
+
+static wxString MakeLine(size_t i)
+{
+	return wxString::Format(L"Dialogue: 0,0:%02i:%02i.%02i,0:%02i:%02i.%02i,Default,,0,0,0,,"
+		L"{\\k25}ka{\\k30}ra{\\k20}o{\\k40}ke line %i",
+		(int)(i / 60) % 60, (int)(i % 60), 0, (int)(i / 60) % 60, (int)(i % 60), 50, (int)i);
+}
+
+static Result RunOld(size_t numLines, const std::vector<size_t> &edits)
+{
+	Result result = { 0, 0, 0, 0 };
+	std::vector<OldFile*> undo;
+	OldFile *subs = new OldFile();
+	for (size_t i = 0; i < numLines; i++){
+		Dialogue *dial = new Dialogue(MakeLine(i));
+		subs->dialogues.push_back(dial);
+		subs->deleteDialogues.push_back(dial);
+	}
+	subs->Selections.insert(0);
+	undo.push_back(subs);
+	subs = subs->Copy();
+
+	size_t startBytes = allocated.load();
+	double sum = 0;
+	for (size_t step = 0; step < edits.size(); step++){
+		size_t i = edits[step];
+		Dialogue *dial = subs->dialogues[i]->Copy();
+		subs->deleteDialogues.push_back(dial);
+		subs->dialogues[i] = dial;
+		dial->Text << L" edited";
+		auto start = std::chrono::steady_clock::now();
+		subs->activeLine = (int)i;
+		undo.push_back(subs);
+		subs = subs->Copy();
+		std::chrono::duration<double, std::micro> time = std::chrono::steady_clock::now() - start;
+		sum += time.count();
+		result.maxUs = (std::max)(result.maxUs, time.count());
+	}
+	result.averageUs = sum / edits.size();
+	result.bytesPerStep = (allocated.load() - startBytes) / edits.size();
+
+	subs->Clear();
+	delete subs;
+	for (OldFile *file : undo){
+		file->Clear();
+		delete file;
+	}
+	return result;
+}
+
+static Result RunNew(size_t numLines, const std::vector<size_t> &edits)
+{
+	Result result = { 0, 0, 0, 0 };
+	wxMutex guard;
+	SubsFile *file = new SubsFile(&guard);
+	for (size_t i = 0; i < numLines; i++){
+		file->AppendDialogue(new Dialogue(MakeLine(i)));
+	}
+	file->InsertSelection(0);
+	file->EndLoad(OPEN_SUBTITLES, 0);
+
+	size_t startBytes = allocated.load();
+	double sum = 0;
+	std::vector<size_t> editCounts(numLines, 0);
+	for (size_t step = 0; step < edits.size(); step++){
+		size_t i = edits[step];
+		Dialogue *dial = file->CopyDialogue(i);
+		dial->Text << L" edited";
+		editCounts[i]++;
+		auto start = std::chrono::steady_clock::now();
+		file->SaveUndo(EDITBOX_LINE_EDITION, (int)i, (int)i);
+		std::chrono::duration<double, std::micro> time = std::chrono::steady_clock::now() - start;
+		sum += time.count();
+		result.maxUs = (std::max)(result.maxUs, time.count());
+	}
+	result.averageUs = sum / edits.size();
+	result.bytesPerStep = (allocated.load() - startBytes) / edits.size();
+
+	//every edit added one suffix, undo of all steps gives lines after loading
+	for (size_t i = 0; i < numLines; i++){
+		wxString expected = MakeLine(i).AfterLast(L',');
+		for (size_t e = 0; e < editCounts[i]; e++){
+			expected << L" edited";
+		}
+		if (file->GetDialogue(i)->Text != expected)
+			result.failed = 1;
+	}
+	while (!file->Undo()){}
+	for (size_t i = 0; i < numLines; i++){
+		if (file->GetDialogue(i)->Text != MakeLine(i).AfterLast(L','))
+			result.failed = 1;
+	}
+	delete file;
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	size_t numSteps = (argc > 1) ? (size_t)atoll(argv[1]) : 300;
+	if (!numSteps)
+		return 1;
+
+	int failed = 0;
+	size_t sizes[] = { 1000, 5000, 20000, 100000 };
+	printf("%i history steps\n", (int)numSteps);
+	printf("%-8s %-6s %14s %14s %16s\n", "lines", "path", "average us", "max us", "bytes per step");
+	for (size_t numLines : sizes){
+		std::mt19937 random(1234);
+		std::vector<size_t> edits(numSteps);
+		for (size_t &edit : edits){
+			edit = random() % numLines;
+		}
+		Result oldResult = RunOld(numLines, edits);
+		Result newResult = RunNew(numLines, edits);
+		failed += newResult.failed;
+		printf("%-8i %-6s %14.2f %14.2f %16i\n", (int)numLines, "old",
+			oldResult.averageUs, oldResult.maxUs, (int)oldResult.bytesPerStep);
+		printf("%-8i %-6s %14.2f %14.2f %16i\n", (int)numLines, "new",
+			newResult.averageUs, newResult.maxUs, (int)newResult.bytesPerStep);
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of spectrum lines of the whole track (SpectrumFFT.cpp),
+//like AudioSpectrum makes cache of every line for one thread.
+//Old path is the recursive GFFT butterflies with twiddles counted by recurrence,
+//new path is SpectrumFFT with scalar, SSE2 and AVX2 stages, processor has to support AVX2.
+//Every line is compared with old one, allowed difference is FFT_TOLERANCE of the biggest magnitude of line.
+//Build from this folder in Developer Command Prompt:
+//  cl /O2 /EHsc /I..\Kainote /I..\Kainote\GFFT SpectrumFFTBenchmark.cpp ..\Kainote\GFFT\SpectrumFFT.cpp
+//or with GCC or Clang (kernels have their own target attributes, no -mavx2 is needed):
+//  g++ -O2 -I../Kainote -I../Kainote/GFFT SpectrumFFTBenchmark.cpp ../Kainote/GFFT/SpectrumFFT.cpp
+//Arguments: [minutes of 48 kHz audio, default 30] [overlaps, default 1].
+//Returns 1 when any line differs more than tolerance.
+
+#include "SpectrumFFT.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <utility>
+#include <vector>
+
+#define FFT_TOLERANCE 1e-4f
+#define PI 3.1415926535897932384626433832795f
+
+//old GFFT from GFFT.cpp, sin and cos of twiddle steps are series counted for every stage
+template<unsigned M, unsigned N, unsigned B, unsigned A>
+struct SinCosSeries {
+	static double value() {
+		return 1 - (A*PI / B)*(A*PI / B) / M / (M + 1)
+			*SinCosSeries<M + 2, N, B, A>::value();
+	}
+};
+
+template<unsigned N, unsigned B, unsigned A>
+struct SinCosSeries<N, N, B, A> {
+	static double value() { return 1.; }
+};
+
+template<unsigned B, unsigned A>
+struct Sin {
+	static float value() {
+		return (A*PI / B)*SinCosSeries<2, 24, B, A>::value();
+	}
+};
+
+template<unsigned N>
+class DanielsonLanczos {
+	DanielsonLanczos<N / 2> next;
+public:
+	void apply(float* data) {
+		next.apply(data);
+		next.apply(data + N);
+
+		float wtemp, tempr, tempi, wr, wi, wpr, wpi;
+		wtemp = -Sin<N, 1>::value();
+		wpr = -2.0*wtemp*wtemp;
+		wpi = -Sin<N, 2>::value();
+		wr = 1.0;
+		wi = 0.0;
+		for (unsigned i = 0; i < N; i += 2) {
+			tempr = data[i + N] * wr - data[i + N + 1] * wi;
+			tempi = data[i + N] * wi + data[i + N + 1] * wr;
+			data[i + N] = data[i] - tempr;
+			data[i + N + 1] = data[i + 1] - tempi;
+			data[i] += tempr;
+			data[i + 1] += tempi;
+
+			wtemp = wr;
+			wr += wr*wpr - wi*wpi;
+			wi += wi*wpr + wtemp*wpi;
+		}
+	}
+};
+
+template<>
+class DanielsonLanczos<4> {
+public:
+	void apply(float* data) {
+		float tr = data[2];
+		float ti = data[3];
+		data[2] = data[0] - tr;
+		data[3] = data[1] - ti;
+		data[0] += tr;
+		data[1] += ti;
+		tr = data[6];
+		ti = data[7];
+		data[6] = data[5] - ti;
+		data[7] = tr - data[4];
+		data[4] += tr;
+		data[5] += ti;
+
+		tr = data[4];
+		ti = data[5];
+		data[4] = data[0] - tr;
+		data[5] = data[1] - ti;
+		data[0] += tr;
+		data[1] += ti;
+		tr = data[6];
+		ti = data[7];
+		data[6] = data[2] - tr;
+		data[7] = data[3] - ti;
+		data[2] += tr;
+		data[3] += ti;
+	}
+};
+
+template<unsigned P>
+class GFFT {
+	DanielsonLanczos<P> recursion;
+public:
+	void scramble(float* data, unsigned long nn) {
+		unsigned long n, m, j, i;
+
+		// reverse-binary reindexing
+		n = nn << 1;
+		j = 1;
+		for (i = 1; i < n; i += 2) {
+			if (j > i) {
+				std::swap(data[j - 1], data[i - 1]);
+				std::swap(data[j], data[i]);
+			}
+			m = nn;
+			while (m >= 2 && j > m) {
+				j -= m;
+				m >>= 1;
+			}
+			j += m;
+		};
+	}
+	void fft(float* data) {
+		scramble(data, P);
+		recursion.apply(data);
+	}
+};
+
+//all lines of track, every one has line_length magnitudes
+static double OldLines(const std::vector<short> &samples, int overlaps, std::vector<float> *lines)
+{
+	SpectrumFFT transform(SPECTRUM_WINDOW_NONE, FFTStageScalar);
+	GFFT<line_length> gfft;
+	std::vector<float> output(doublelen);
+	unsigned long offset = doublelen / overlaps;
+	auto start = std::chrono::steady_clock::now();
+	size_t line = 0;
+	for (size_t sample = 0; sample + doublelen <= samples.size(); sample += offset) {
+		transform.LoadSamples(&samples[sample], output.data());
+		gfft.fft(output.data());
+		transform.SplitRealOutput(output.data());
+		SpectrumFFT::GetMagnitudes(output.data(), &(*lines)[line * line_length]);
+		line++;
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static double NewLines(const std::vector<short> &samples, int overlaps, FFTStageFunction stage, std::vector<float> *lines)
+{
+	SpectrumFFT transform(SPECTRUM_WINDOW_NONE, stage);
+	std::vector<float> output(doublelen);
+	unsigned long offset = doublelen / overlaps;
+	auto start = std::chrono::steady_clock::now();
+	size_t line = 0;
+	for (size_t sample = 0; sample + doublelen <= samples.size(); sample += offset) {
+		transform.Transform(&samples[sample], output.data());
+		SpectrumFFT::GetMagnitudes(output.data(), &(*lines)[line * line_length]);
+		line++;
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+static int Compare(const std::vector<float> &oldLines, const std::vector<float> &lines)
+{
+	int failed = 0;
+	for (size_t line = 0; line < oldLines.size(); line += line_length) {
+		float biggest = 1.f;
+		for (size_t i = 0; i < line_length; i++) {
+			if (oldLines[line + i] > biggest)
+				biggest = oldLines[line + i];
+		}
+		for (size_t i = 0; i < line_length; i++) {
+			if (fabsf(oldLines[line + i] - lines[line + i]) > biggest * FFT_TOLERANCE) {
+				failed = 1;
+				break;
+			}
+		}
+	}
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	int minutes = (argc > 1) ? atoi(argv[1]) : 30;
+	int overlaps = (argc > 2) ? atoi(argv[2]) : 1;
+	if (minutes < 1 || overlaps < 1)
+		return 1;
+
+	//a few tones with noise, like speech over music
+	std::mt19937 random(1234);
+	std::normal_distribution<float> noise(0.f, 800.f);
+	std::vector<short> samples((size_t)minutes * 60 * 48000);
+	for (size_t i = 0; i < samples.size(); i++) {
+		float t = (float)i / 48000.f;
+		float value = 6000.f * sinf(2.f * PI * 220.f * t) + 3000.f * sinf(2.f * PI * 1250.f * t) +
+			1500.f * sinf(2.f * PI * (3000.f + 500.f * sinf(t)) * t) + noise(random);
+		samples[i] = (short)(value > 32767.f ? 32767.f : value < -32768.f ? -32768.f : value);
+	}
+	size_t numLines = (samples.size() - doublelen) / (doublelen / overlaps) + 1;
+	std::vector<float> oldLines(numLines * line_length);
+	std::vector<float> lines(numLines * line_length);
+
+	int failed = 0;
+	printf("%i minutes, %i overlaps, %i lines\n", minutes, overlaps, (int)numLines);
+	printf("%-10s %12s %14s\n", "path", "ms", "us per line");
+	double oldTime = OldLines(samples, overlaps, &oldLines);
+	printf("%-10s %12.3f %14.3f\n", "GFFT", oldTime, oldTime * 1000.0 / numLines);
+	struct Stage{ const char *name; FFTStageFunction function; };
+	Stage stages[] = {
+		{ "scalar", FFTStageScalar },
+		{ "SSE2", FFTStageSSE2 },
+		{ "AVX2", FFTStageAVX2 },
+	};
+	for (const Stage &stage : stages) {
+		double time = NewLines(samples, overlaps, stage.function, &lines);
+		failed += Compare(oldLines, lines);
+		printf("%-10s %12.3f %14.3f\n", stage.name, time, time * 1000.0 / numLines);
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,358 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of spelling of whole generated file like SpellChecker::SpellWord (SpellWordCache.h).
+//Dictionary is generated to temp folder, words of file repeat like in real subtitles.
+//Old path has one lock held while hunspell spells and forgets words by walking the whole cache,
+//new path spells without lock of cache and forgets all letter cases of word at once.
+//Last test checks visible lines on main thread while background thread spells the whole file.
+//Build from this folder in Developer Command Prompt:
+//  cl /O2 /EHsc /std:c++20 /DHUNSPELL_STATIC /I..\Kainote /I..\Thirdparty\Hunspell\msvc /I..\Thirdparty\Hunspell\src\hunspell
+//    SpellCheckBenchmark.cpp ..\Thirdparty\Hunspell\src\hunspell\affentry.cxx ..\Thirdparty\Hunspell\src\hunspell\affixmgr.cxx
+//    ..\Thirdparty\Hunspell\src\hunspell\csutil.cxx ..\Thirdparty\Hunspell\src\hunspell\dictmgr.cxx
+//    ..\Thirdparty\Hunspell\src\hunspell\filemgr.cxx ..\Thirdparty\Hunspell\src\hunspell\hashmgr.cxx
+//    ..\Thirdparty\Hunspell\src\hunspell\hunspell.cxx ..\Thirdparty\Hunspell\src\hunspell\hunzip.cxx
+//    ..\Thirdparty\Hunspell\src\hunspell\phonet.cxx ..\Thirdparty\Hunspell\src\hunspell\replist.cxx
+//    ..\Thirdparty\Hunspell\src\hunspell\suggestmgr.cxx
+//Arguments: [number of lines, default 20000] [size of cache, default 200000].
+//Returns 1 when any word gets other verdict than spelled without cache or added word is not forgotten.
+
+#include "SpellWordCache.h"
+#include <hunspell.hxx>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#define SPELLCHECKER_CACHE_SIZE 200000
+
+//generated words are ASCII, so UTF-8 dictionary gets the same bytes
+static std::string ToUtf8(std::wstring_view word)
+{
+	return std::string(word.begin(), word.end());
+}
+
+//old SpellChecker::SpellWord and ForgetWord, wxString made for every entry by IsSameAs is std::wstring here
+class OldSpellChecker
+{
+public:
+	OldSpellChecker(const std::string &aff, const std::string &dic, size_t _cacheSize)
+		: hunspell(aff.c_str(), dic.c_str()), cacheSize(_cacheSize){}
+	bool SpellWord(std::wstring_view key)
+	{
+		std::lock_guard<std::mutex> lock(spellLock);
+		auto it = checkedWords.find(key);
+		if (it != checkedWords.end()){
+			checkedWordsOrder.splice(checkedWordsOrder.begin(), checkedWordsOrder, it->second);
+			return it->second->second;
+		}
+
+		bool correct = (hunspell.spell(ToUtf8(key).c_str()) == 1);
+		Insert(key, correct);
+		return correct;
+	}
+	void AddWord(std::wstring_view word)
+	{
+		std::lock_guard<std::mutex> lock(spellLock);
+		hunspell.add(ToUtf8(word).c_str());
+		ForgetWord(word);
+	}
+	void ForgetWord(std::wstring_view word)
+	{
+		for (auto it = checkedWordsOrder.begin(); it != checkedWordsOrder.end();){
+			std::wstring entry(it->first);
+			if (entry.length() == word.length() && std::equal(entry.begin(), entry.end(), word.begin(),
+				[](wchar_t a, wchar_t b){ return towlower(a) == towlower(b); })){
+				checkedWords.erase(it->first);
+				it = checkedWordsOrder.erase(it);
+				continue;
+			}
+			++it;
+		}
+	}
+	void Insert(std::wstring_view word, bool correct)
+	{
+		if (checkedWords.size() >= cacheSize){
+			checkedWords.erase(checkedWordsOrder.back().first);
+			checkedWordsOrder.pop_back();
+		}
+		checkedWordsOrder.emplace_front(std::wstring(word), correct);
+		checkedWords[checkedWordsOrder.front().first] = checkedWordsOrder.begin();
+	}
+private:
+	Hunspell hunspell;
+	std::mutex spellLock;
+	size_t cacheSize;
+	std::list<std::pair<std::wstring, bool>> checkedWordsOrder;
+	std::unordered_map<std::wstring_view, std::list<std::pair<std::wstring, bool>>::iterator> checkedWords;
+};
+
+//new SpellChecker::SpellWord, AddWord and RemoveWords
+class NewSpellChecker
+{
+public:
+	NewSpellChecker(const std::string &aff, const std::string &dic, size_t cacheSize)
+		: hunspell(aff.c_str(), dic.c_str()), checkedWords(cacheSize){}
+	bool SpellWord(std::wstring_view key)
+	{
+		bool correct = false;
+		int version;
+		if (checkedWords.Find(key, &correct, &version))
+			return correct;
+
+		{
+			std::lock_guard<std::mutex> lock(hunspellLock);
+			correct = (hunspell.spell(ToUtf8(key).c_str()) == 1);
+		}
+		checkedWords.Add(key, correct, version);
+		return correct;
+	}
+	void AddWord(std::wstring_view word)
+	{
+		{
+			std::lock_guard<std::mutex> lock(hunspellLock);
+			hunspell.add(ToUtf8(word).c_str());
+		}
+		checkedWords.Forget(word);
+	}
+	void ForgetWord(std::wstring_view word) { checkedWords.Forget(word); }
+	void Insert(std::wstring_view word, bool correct)
+	{
+		bool found;
+		int version = 0;
+		checkedWords.Find(word, &found, &version);
+		checkedWords.Add(word, correct, version);
+	}
+
+private:
+	Hunspell hunspell;
+	std::mutex hunspellLock;
+	SpellWordCache checkedWords;
+};
+
+//words of lines are separated by spaces and punctuation like in CheckText
+template<class Checker>
+static void CheckLines(Checker &checker, const std::vector<std::wstring> &lines, size_t start, size_t end,
+	std::vector<char> *verdicts)
+{
+	for (size_t i = start; i < end; i++){
+		const std::wstring &line = lines[i];
+		size_t wordStart = 0;
+		for (size_t k = 0; k <= line.length(); k++){
+			if (k < line.length() && iswalpha(line[k]))
+				continue;
+			if (k > wordStart){
+				bool correct = checker.SpellWord(std::wstring_view(line.data() + wordStart, k - wordStart));
+				if (verdicts)
+					verdicts->push_back(correct);
+			}
+			wordStart = k + 1;
+		}
+	}
+}
+
+//hunspell without cache
+struct UncachedChecker
+{
+	UncachedChecker(const std::string &aff, const std::string &dic) : hunspell(aff.c_str(), dic.c_str()){}
+	bool SpellWord(std::wstring_view key) { return hunspell.spell(ToUtf8(key).c_str()) == 1; }
+	Hunspell hunspell;
+};
+
+static double Milliseconds(std::chrono::steady_clock::time_point start)
+{
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	return time.count();
+}
+
+//main thread checks visible lines again and again like grid on paint while background thread spells the file
+template<class Checker>
+static void CheckWithBackground(Checker &checker, const std::vector<std::wstring> &lines, double *averageUs, double *maxUs)
+{
+	const size_t visibleLines = 40;
+	CheckLines(checker, lines, 0, visibleLines, nullptr);
+	std::atomic<bool> done{ false };
+	std::thread background([&](){
+		CheckLines(checker, lines, visibleLines, lines.size(), nullptr);
+		done = true;
+	});
+	double sum = 0;
+	*maxUs = 0;
+	size_t passes = 0;
+	while (!done || !passes){
+		auto start = std::chrono::steady_clock::now();
+		CheckLines(checker, lines, 0, visibleLines, nullptr);
+		double time = Milliseconds(start) * 1000.0;
+		sum += time;
+		*maxUs = (std::max)(*maxUs, time);
+		passes++;
+	}
+	background.join();
+	*averageUs = sum / passes;
+}
+
+static std::wstring GenerateWord(std::mt19937 &random)
+{
+	const wchar_t *syllables[] = { L"ka", L"no", L"te", L"pi", L"ra", L"zu", L"mo", L"se", L"li", L"wa", L"do", L"gre", L"sta", L"ch", L"rz" };
+	std::wstring word;
+	size_t numSyllables = 1 + random() % 5;
+	for (size_t i = 0; i < numSyllables; i++){
+		word += syllables[random() % 15];
+	}
+	return word;
+}
+
+int main(int argc, char **argv)
+{
+	size_t numLines = (argc > 1) ? (size_t)atoll(argv[1]) : 20000;
+	size_t cacheSize = (argc > 2) ? (size_t)atoll(argv[2]) : SPELLCHECKER_CACHE_SIZE;
+	if (!numLines || !cacheSize)
+		return 1;
+
+	//vocabulary with every seventh word misspelled
+	std::mt19937 random(1234);
+	std::vector<std::wstring> vocabulary;
+	std::vector<std::wstring> dictionary;
+	for (size_t i = 0; i < 30000; i++){
+		std::wstring word = GenerateWord(random) + GenerateWord(random);
+		vocabulary.push_back(word);
+		if (i % 7)
+			dictionary.push_back(word);
+	}
+	std::filesystem::path folder = std::filesystem::temp_directory_path();
+	std::string aff = (folder / "SpellCheckBenchmark.aff").string();
+	std::string dic = (folder / "SpellCheckBenchmark.dic").string();
+	{
+		std::ofstream affFile(aff, std::ios::binary);
+		affFile << "SET UTF-8\nTRY aeiouknptrzmsldwgch\n";
+		std::ofstream dicFile(dic, std::ios::binary);
+		dicFile << dictionary.size() << "\n";
+		for (auto &word : dictionary){
+			dicFile << ToUtf8(word) << "\n";
+		}
+	}
+
+	//frequent words are at the beginning of vocabulary, some words start lines or are shouted
+	std::vector<std::wstring> lines;
+	for (size_t i = 0; i < numLines; i++){
+		std::wstring line;
+		size_t numWords = 4 + random() % 9;
+		for (size_t k = 0; k < numWords; k++){
+			double position = (double)random() / random.max();
+			std::wstring word = vocabulary[(size_t)(position * position * position * (vocabulary.size() - 1))];
+			if (k == 0 || random() % 10 == 0)
+				word[0] = towupper(word[0]);
+			else if (random() % 50 == 0){
+				for (auto &ch : word){ ch = towupper(ch); }
+			}
+			line += word;
+			line += (random() % 8) ? L" " : L", ";
+		}
+		line.back() = L'.';
+		lines.push_back(line);
+	}
+
+	int failed = 0;
+	printf("%i lines, cache of %i words\n", (int)numLines, (int)cacheSize);
+	printf("%-10s %12s %12s\n", "path", "first ms", "again ms");
+
+	std::vector<char> uncachedVerdicts, oldVerdicts, newVerdicts;
+	UncachedChecker uncached(aff, dic);
+	auto start = std::chrono::steady_clock::now();
+	CheckLines(uncached, lines, 0, lines.size(), &uncachedVerdicts);
+	double uncachedTime = Milliseconds(start);
+	printf("%-10s %12.3f %12.3f\n", "uncached", uncachedTime, uncachedTime);
+
+	OldSpellChecker oldChecker(aff, dic, cacheSize);
+	NewSpellChecker newChecker(aff, dic, cacheSize);
+	start = std::chrono::steady_clock::now();
+	CheckLines(oldChecker, lines, 0, lines.size(), &oldVerdicts);
+	double oldFirst = Milliseconds(start);
+	start = std::chrono::steady_clock::now();
+	CheckLines(oldChecker, lines, 0, lines.size(), nullptr);
+	printf("%-10s %12.3f %12.3f\n", "old", oldFirst, Milliseconds(start));
+	start = std::chrono::steady_clock::now();
+	CheckLines(newChecker, lines, 0, lines.size(), &newVerdicts);
+	double newFirst = Milliseconds(start);
+	start = std::chrono::steady_clock::now();
+	CheckLines(newChecker, lines, 0, lines.size(), &newVerdicts);
+	printf("%-10s %12.3f %12.3f\n", "new", newFirst, Milliseconds(start));
+	//new verdicts have first and second check
+	if (oldVerdicts != uncachedVerdicts || newVerdicts.size() != uncachedVerdicts.size() * 2 ||
+		!std::equal(uncachedVerdicts.begin(), uncachedVerdicts.end(), newVerdicts.begin()) ||
+		!std::equal(uncachedVerdicts.begin(), uncachedVerdicts.end(), newVerdicts.begin() + uncachedVerdicts.size()))
+		failed = 1;
+
+	//first word of vocabulary is misspelled, in three letter cases has to be correct after adding it
+	std::wstring added = vocabulary[0];
+	std::wstring capitalized = added;
+	capitalized[0] = towupper(capitalized[0]);
+	std::wstring shouted = added;
+	for (auto &ch : shouted){ ch = towupper(ch); }
+	for (auto *word : { &added, &capitalized, &shouted }){
+		if (oldChecker.SpellWord(*word) || newChecker.SpellWord(*word))
+			failed = 1;
+	}
+	oldChecker.AddWord(added);
+	newChecker.AddWord(added);
+	for (auto *word : { &added, &capitalized, &shouted }){
+		if (!oldChecker.SpellWord(*word) || !newChecker.SpellWord(*word))
+			failed = 1;
+	}
+
+	//forgetting of words from full cache like AddWord and RemoveWords
+	const size_t numForgotten = 200;
+	for (size_t i = 0; i < cacheSize; i++){
+		std::wstring word = GenerateWord(random) + std::to_wstring(i);
+		oldChecker.Insert(word, true);
+		newChecker.Insert(word, true);
+	}
+	printf("\n%-10s %12s\n", "forget", "ms");
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < numForgotten; i++){
+		oldChecker.ForgetWord(vocabulary[i]);
+	}
+	double oldForget = Milliseconds(start);
+	printf("%-10s %12.3f\n", "old", oldForget);
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < numForgotten; i++){
+		newChecker.ForgetWord(vocabulary[i]);
+	}
+	double newForget = Milliseconds(start);
+	printf("%-10s %12.3f %12.1f\n", "new", newForget, oldForget / newForget);
+
+	//cold caches, so background thread spells words that are not cached
+	printf("\n%-10s %12s %12s\n", "visible", "avg us", "max us");
+	double averageUs, maxUs;
+	{
+		OldSpellChecker checker(aff, dic, cacheSize);
+		CheckWithBackground(checker, lines, &averageUs, &maxUs);
+		printf("%-10s %12.3f %12.3f\n", "old", averageUs, maxUs);
+	}
+	{
+		NewSpellChecker checker(aff, dic, cacheSize);
+		CheckWithBackground(checker, lines, &averageUs, &maxUs);
+		printf("%-10s %12.3f %12.3f\n", "new", averageUs, maxUs);
+	}
+
+	std::filesystem::remove(aff);
+	std::filesystem::remove(dic);
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and benchmark of tag parsing (TagParser.h) on typesetting lines with 50 and more tags.
+//Every parse is compared with the old Dialogue::ParseTags which compared every tag name as text
+//and allocated every tag, for tag lists of visuals, resampling and font collector.
+//Parse with index is measured like Dialogue::ParseTags on mouse move, index is built once and
+//parse data is cleared and filled again, and like ParseTagsCopy with new index on every parse.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution (wxWidgets base.lib):
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote /I..\Thirdparty\wxWidgets\include /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu
+//    TagParseBenchmark.cpp ..\Kainote\TagParser.cpp
+//    /link /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release base.lib zlib.lib wxregex.lib
+//Returns 1 when any parse gives other tags.
+
+#include "TagParser.h"
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+struct OldTag
+{
+	wxString tagName;
+	wxString value;
+	bool multiValue;
+	unsigned int startTextPos;
+};
+
+//Dialogue::ParseTags before tag index, tags are deleted by caller
+static void OldParseTags(const wxString &text, wxString *tags, size_t ntags, bool plainText,
+	std::vector<OldTag*> *parseData)
+{
+	wxString txt = text;
+	size_t pos = 0;
+	size_t plainStart = 0;
+	bool hasDrawing = false;
+	size_t len = txt.length();
+	bool tagsBlock = false;
+	double tmpValue;
+	if (len < 1){ return; }
+	while (pos < len){
+		wxUniChar ch = txt[pos];
+		if (ch == L'}'){ tagsBlock = false; plainStart = pos + 1; }
+		else if (ch == L'{' || pos >= len - 1){
+			tagsBlock = true;
+			if (pos >= len - 1){ pos++; }
+			if ((plainText || hasDrawing) && plainStart + 1 <= pos){
+				parseData->push_back(new OldTag{ (hasDrawing) ? L"pvector" : L"plain",
+					txt.SubString(plainStart, pos - 1), false, (unsigned int)plainStart });
+			}
+		}
+		else if (tagsBlock && ch == L'\\'){
+			pos++;
+			int slashPos = txt.find(L'\\', pos);
+			int bracketPos = txt.find(L'}', pos);
+			int tagEnd = (slashPos == -1 && bracketPos == -1) ? len :
+				(slashPos == -1) ? bracketPos : (bracketPos == -1) ? slashPos :
+				(bracketPos < slashPos) ? bracketPos : slashPos;
+			wxString tag = txt.SubString(pos, tagEnd - 1);
+			if (tag.EndsWith(L")")){ tag.RemoveLast(); }
+			for (size_t i = 0; i < ntags; i++){
+				wxString tagName = tags[i];
+				int tagLen = tagName.length();
+				if (tag.StartsWith(tagName)){
+					wxUniChar firstValueChar = tag[tagLen];
+					if (firstValueChar == L'(' || wxIsdigit(firstValueChar) || tagName == L"fn" ||
+						firstValueChar == L'.' || firstValueChar == L'-' || firstValueChar == L'+'){
+
+						OldTag *newTag = new OldTag{ tagName, wxString(), false, (unsigned int)(pos + tagLen) };
+						wxString tagValue = tag.Mid(tagLen);
+						if (tagName == L"p"){
+							hasDrawing = (tagValue.Trim().Trim(false) == L"0") ? false : true;
+							newTag->value = tagValue;
+						}
+						else if (tag[tagLen] == L'('){
+							newTag->startTextPos++;
+							newTag->value = tagValue.After(L'(').BeforeFirst(L')');
+							newTag->multiValue = true;
+						}
+						else{
+							if (tagName != L"fn" && !tagValue.ToCDouble(&tmpValue)){
+								wxString newTagValue;
+								for (const auto & ch : tagValue){
+									if (!wxIsdigit(ch) && ch != L'.' && ch != L'-' && ch != L'+')
+										break;
+									newTagValue += ch;
+								}
+								tagValue = newTagValue;
+							}
+							newTag->value = tagValue;
+						}
+						parseData->push_back(newTag);
+						pos = tagEnd - 1;
+						break;
+					}
+				}
+			}
+		}
+		pos++;
+	}
+}
+
+static void DeleteTags(std::vector<OldTag*> *parseData)
+{
+	for (OldTag *tag : *parseData)
+		delete tag;
+	parseData->clear();
+}
+
+static int Compare(const std::vector<OldTag*> &oldTags, const ParseData &data)
+{
+	if (oldTags.size() != data.tags.size())
+		return 1;
+	for (size_t i = 0; i < oldTags.size(); i++){
+		const OldTag *oldTag = oldTags[i];
+		const TagData *tag = data.tags[i];
+		if (oldTag->tagName != tag->tagName || oldTag->value != tag->value ||
+			oldTag->startTextPos != tag->startTextPos || oldTag->multiValue != tag->multiValue)
+			return 1;
+	}
+	return 0;
+}
+
+//sign with a few blocks of tags, transforms, clip and drawing, every block has about 20 tags
+static wxString MakeLine(std::mt19937 &random)
+{
+	wxString line;
+	int blocks = 3 + random() % 3;
+	for (int b = 0; b < blocks; b++){
+		line << L"{\\an7\\pos(" << (int)(random() % 1920) << L"," << (int)(random() % 1080) << L")";
+		line << L"\\fnArial Black\\fs" << (int)(20 + random() % 60) << L"\\fscx" << (int)(80 + random() % 40);
+		line << L"\\fscy" << (int)(80 + random() % 40) << L"\\fsp" << (int)(random() % 5) - 2;
+		line << L"\\bord" << (int)(random() % 5) << L"\\xbord1.5\\ybord-0.5\\shad0\\xshad2\\yshad+2";
+		line << L"\\1c&H" << (int)(random() % 0xFFFFFF) << L"&\\3c&H000000&\\4a&H80&\\b1\\i0";
+		line << L"\\blur" << (int)(random() % 3) << L".5\\be1\\frz" << (int)(random() % 360);
+		line << L"\\fad(120,240)\\t(0,500,\\fscx120\\fscy120)\\clip(0,0,1280,720)\\org(640,360)";
+		line << L"\\frx0\\fry0\\fax0.1\\kf20\\q2\\unknowntag\\";
+		line << L"}" << L"Sign text " << b;
+		if (random() % 2){
+			line << L"{\\p1}m 0 0 l 100 0 100 100 0 100 b 10 20 30 40 50 60{\\p0}";
+		}
+	}
+	return line;
+}
+
+int main()
+{
+	std::mt19937 random(1234);
+	std::vector<wxString> lines;
+	for (int i = 0; i < 2000; i++){
+		lines.push_back(MakeLine(random));
+	}
+	size_t tagsInLines = 0;
+	for (const wxString &line : lines){
+		TagIndex index;
+		index.Build(line);
+		tagsInLines += index.tags.size();
+	}
+	//tag lists of Visuals::GetTextExtents, SubsGrid::ResizeSubs and FontCollector
+	wxString visualTags[] = { L"p", L"fscx", L"fscy", L"fsp", L"fs", L"fn",
+		L"bord", L"xbord", L"ybord", L"b", L"i", L"shad", L"xshad", L"yshad" };
+	wxString resampleTags[] = { L"pos", L"move", L"bord", L"shad", L"org", L"fsp", L"fscx",
+		L"fs", L"clip", L"iclip", L"p", L"xbord", L"ybord", L"xshad", L"yshad" };
+	wxString fontTags[] = { L"fn", L"b", L"i", L"p" };
+	struct TagList{ const char *name; wxString *tags; size_t ntags; bool plainText; };
+	TagList tagLists[] = {
+		{ "visuals", visualTags, 14, true },
+		{ "resample", resampleTags, 15, false },
+		{ "fonts", fontTags, 4, true },
+	};
+
+	int failed = 0;
+	printf("%i lines, %.1f tags per line\n", (int)lines.size(), (double)tagsInLines / lines.size());
+	printf("%-10s %12s %12s %12s\n", "tags", "old ms", "cached ms", "copy ms");
+	const int repeats = 20;
+	for (const TagList &list : tagLists){
+		std::vector<TagIndex> indexes(lines.size());
+		std::vector<OldTag*> oldTags;
+		ParseData data;
+		for (size_t i = 0; i < lines.size(); i++){
+			OldParseTags(lines[i], list.tags, list.ntags, list.plainText, &oldTags);
+			indexes[i].Build(lines[i], i);
+			data.Clear();
+			ParseTextTags(lines[i], indexes[i], list.tags, list.ntags, list.plainText, &data);
+			failed += Compare(oldTags, data);
+			DeleteTags(&oldTags);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++){
+			for (const wxString &line : lines){
+				OldParseTags(line, list.tags, list.ntags, list.plainText, &oldTags);
+				DeleteTags(&oldTags);
+			}
+		}
+		std::chrono::duration<double, std::milli> oldTime = std::chrono::steady_clock::now() - start;
+
+		//like ParseTags of the same dialogues, index is valid and tags are reused
+		std::vector<ParseData> lineData(lines.size());
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++){
+			for (size_t i = 0; i < lines.size(); i++){
+				if (!indexes[i].IsBuiltFor(i))
+					indexes[i].Build(lines[i], i);
+				lineData[i].Clear();
+				ParseTextTags(lines[i], indexes[i], list.tags, list.ntags, list.plainText, &lineData[i]);
+			}
+		}
+		std::chrono::duration<double, std::milli> cachedTime = std::chrono::steady_clock::now() - start;
+
+		//like ParseTagsCopy, new index and new parse data every time
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++){
+			for (const wxString &line : lines){
+				TagIndex index;
+				index.Build(line);
+				ParseData copyData;
+				ParseTextTags(line, index, list.tags, list.ntags, list.plainText, &copyData);
+			}
+		}
+		std::chrono::duration<double, std::milli> copyTime = std::chrono::steady_clock::now() - start;
+		printf("%-10s %12.3f %12.3f %12.3f\n", list.name, oldTime.count(), cachedTime.count(), copyTime.count());
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Check and benchmark of measuring text of visuals with TextExtentsCache (TextExtentsCache.cpp).
+//Old path is Visuals::GetTextExtents before the cache, it created DC and HFONT on every call,
+//new path keeps fonts, advances of characters and sizes of strings in TextExtentsCache.
+//Texts are measured with spacing 0 (whole string) and with spacing (every character), for more styles than cached fonts,
+//so sizes are checked for new fonts, cached fonts and fonts created again after eviction.
+//Styles need config of Kainote, so objects of Release x64 build of Kainote are packed to library first.
+//Build from this folder in x64 Developer Command Prompt after Release build of solution:
+//  lib /OUT:Kainote.lib ..\obj\x64\Release\Kainote\*.obj
+//  cl /O2 /EHsc /std:c++20 /D__WXMSW__ /DUNICODE /D_UNICODE /I..\Kainote /I..\Thirdparty\wxWidgets\include
+//    /I..\Thirdparty\wxWidgets\lib\vc_lib\mswu TextExtentsBenchmark.cpp /link /SUBSYSTEM:CONSOLE
+//    /LIBPATH:..\bin\x64\Release /LIBPATH:..\x64\Release Kainote.lib + Linker Input libraries of Kainote project
+//Arguments: [number of passes over all styles and texts, default 200].
+//Returns 1 when any size differs from size measured by old path.
+
+#include "TextExtentsCache.h"
+#include "Styles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <tchar.h>
+#include <chrono>
+#include <vector>
+
+struct TextExtents
+{
+	float width = 0, height = 0, descent = 0, extlead = 0;
+	bool operator == (const TextExtents &extents) const{
+		return width == extents.width && height == extents.height &&
+			descent == extents.descent && extlead == extents.extlead;
+	}
+};
+
+//old Visuals::GetTextExtents without scaling, DC is released with DeleteDC instead of DeleteObject
+static bool OldGetTextExtents(const wxString &text, Styles *style, float spacing, TextExtents *extents)
+{
+	float fontsize = style->GetFontSizeDouble() * 32;
+	size_t thetextlen = text.length();
+	const wchar_t* thetext = text.wc_str();
+
+	SIZE sz;
+	HDC thedc = CreateCompatibleDC(0);
+	if (!thedc) return false;
+	SetMapMode(thedc, MM_TEXT);
+
+	LOGFONTW lf;
+	ZeroMemory(&lf, sizeof(lf));
+	lf.lfHeight = (LONG)fontsize;
+	lf.lfWeight = style->Bold ? FW_BOLD : FW_NORMAL;
+	lf.lfItalic = style->Italic;
+	lf.lfUnderline = style->Underline;
+	lf.lfStrikeOut = style->StrikeOut;
+	lf.lfCharSet = wxAtoi(style->Encoding);
+	lf.lfOutPrecision = OUT_TT_PRECIS;
+	lf.lfClipPrecision = CLIP_DEFAULT_PRECIS;
+	lf.lfQuality = ANTIALIASED_QUALITY;
+	lf.lfPitchAndFamily = DEFAULT_PITCH | FF_DONTCARE;
+	_tcsncpy(lf.lfFaceName, style->Fontname.wc_str(), 32);
+
+	HFONT thefont = CreateFontIndirect(&lf);
+	if (!thefont){
+		DeleteDC(thedc);
+		return false;
+	}
+	HGDIOBJ oldfont = SelectObject(thedc, thefont);
+
+	if (spacing != 0) {
+		extents->width = 0;
+		for (size_t i = 0; i < thetextlen; i++) {
+			GetTextExtentPoint32(thedc, &thetext[i], 1, &sz);
+			extents->width += sz.cx + spacing;
+			extents->height = sz.cy;
+		}
+	}
+	else {
+		GetTextExtentPoint32(thedc, thetext, (int)thetextlen, &sz);
+		extents->width = sz.cx;
+		extents->height = sz.cy;
+	}
+
+	TEXTMETRIC tm;
+	GetTextMetrics(thedc, &tm);
+	extents->descent = tm.tmDescent;
+	extents->extlead = tm.tmExternalLeading;
+
+	SelectObject(thedc, oldfont);
+	DeleteDC(thedc);
+	DeleteObject(thefont);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	int numPasses = (argc > 1) ? atoi(argv[1]) : 200;
+	if (numPasses < 1)
+		return 1;
+
+	//4 fonts * 3 sizes * 2 weights gives 24 styles, more than TEXT_EXTENTS_CACHE_FONTS
+	const wchar_t *fontNames[] = { L"Arial", L"Times New Roman", L"Segoe UI", L"Gabriola" };
+	const double fontSizes[] = { 20, 48, 72.5 };
+	std::vector<Styles *> styles;
+	for (const wchar_t *fontName : fontNames){
+		for (double fontSize : fontSizes){
+			for (int bold = 0; bold < 2; bold++){
+				Styles *style = new Styles();
+				style->Fontname = fontName;
+				style->SetFontSizeDouble(fontSize);
+				style->Bold = bold != 0;
+				style->Italic = fontSize == 48;
+				style->Underline = fontSize == 72.5 && bold;
+				style->Encoding = L"1";
+				styles.push_back(style);
+			}
+		}
+	}
+	//ASCII with kerning pairs, Polish, Japanese, surrogate pair and one character
+	const wchar_t *texts[] = {
+		L"AVATAR To Wa Ty Yo",
+		L"Zażółć gęślą jaźń",
+		L"からおけ の テキスト",
+		L"Emoji \xD83D\xDE00 text",
+		L"W",
+	};
+	//spacing in 1/32 of pixel like Visuals::GetTextExtents
+	const float spacings[] = { 0, 2.f * 32, -1.5f * 32 };
+
+	const size_t numTexts = sizeof(texts) / sizeof(texts[0]);
+	const size_t numSpacings = sizeof(spacings) / sizeof(spacings[0]);
+	size_t numCalls = (size_t)numPasses * styles.size() * numTexts * numSpacings;
+	printf("%i passes, %i styles, %i calls\n", numPasses, (int)styles.size(), (int)numCalls);
+	printf("%-10s %12s %12s\n", "path", "ms", "speedup");
+
+	//order of styles visits every style once per pass so fonts are evicted and created again by cache,
+	//while texts of one style are measured one after another like on mouse moves of visuals
+	std::vector<TextExtents> oldExtents;
+	oldExtents.reserve(numCalls);
+	int failed = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < numPasses; pass++){
+		for (Styles *style : styles){
+			for (const wchar_t *text : texts){
+				for (float spacing : spacings){
+					TextExtents extents;
+					if (!OldGetTextExtents(text, style, spacing, &extents))
+						failed = 1;
+					oldExtents.push_back(extents);
+				}
+			}
+		}
+	}
+	std::chrono::duration<double, std::milli> oldTime = std::chrono::steady_clock::now() - start;
+	printf("%-10s %12.3f %12.2f\n", "old", oldTime.count(), 1.0);
+
+	TextExtentsCache cache;
+	size_t mismatches = 0;
+	size_t numExtents = 0;
+	start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < numPasses; pass++){
+		for (Styles *style : styles){
+			for (const wchar_t *text : texts){
+				for (float spacing : spacings){
+					TextExtents extents;
+					if (!cache.GetTextExtents(text, style, spacing,
+						&extents.width, &extents.height, &extents.descent, &extents.extlead))
+						failed = 1;
+					if (!(extents == oldExtents[numExtents])){
+						if (!mismatches){
+							printf("first mismatch: %s %.1f \"%s\" spacing %.1f, width %.1f / %.1f, height %.1f / %.1f\n",
+								style->Fontname.utf8_str().data(), style->GetFontSizeDouble(),
+								wxString(text).utf8_str().data(), spacing,
+								extents.width, oldExtents[numExtents].width,
+								extents.height, oldExtents[numExtents].height);
+						}
+						mismatches++;
+					}
+					numExtents++;
+				}
+			}
+		}
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	printf("%-10s %12.3f %12.2f\n", "cache", time.count(), oldTime.count() / time.count());
+
+	//texts of first style repeated, every call is a hit, sizes are the same as first texts of old path
+	TextExtents hotExtents;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < numCalls; i++){
+		size_t j = i % (numTexts * numSpacings);
+		cache.GetTextExtents(texts[j / numSpacings], styles[0], spacings[j % numSpacings],
+			&hotExtents.width, &hotExtents.height, &hotExtents.descent, &hotExtents.extlead);
+		if (!(hotExtents == oldExtents[j]))
+			mismatches++;
+	}
+	time = std::chrono::steady_clock::now() - start;
+	printf("%-10s %12.3f %12.2f\n", "hot cache", time.count(), oldTime.count() / time.count());
+
+	if (mismatches){
+		printf("%i sizes differ\n", (int)mismatches);
+		failed = 1;
+	}
+	for (Styles *style : styles){
+		delete style;
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+//Standalone check and micro-benchmark of conversions between keys and ids of visible lines (VisibleLinesIndex.h).
+//Every conversion is compared with the old linear scans from SubsFile::GetElementById,
+//GetElementByKey and GetKeyFromPos, also after folding and unfolding trees like SubsFile::OpenCloseTree does.
+//Build from this folder in Developer Command Prompt:
+//  cl /O2 /EHsc /std:c++20 /I..\Kainote VisibleLinesIndexBenchmark.cpp
+//Arguments: [number of queries for every size, default 20000].
+//Returns 1 when any conversion gives other line.
+
+#include "VisibleLinesIndex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+//only visibility is used by index, lines are pointers like dialogues
+struct Line
+{
+	unsigned char isVisible;
+};
+
+//old linear scans from SubsFile
+static size_t OldGetElementById(const std::vector<Line*> &lines, size_t id)
+{
+	size_t countid = -1;
+	for (size_t i = 0; i < lines.size(); i++){
+		if (lines[i]->isVisible)
+			countid++;
+
+		if (countid == id){
+			return i;
+		}
+	}
+	return -1;
+}
+
+static size_t OldGetElementByKey(const std::vector<Line*> &lines, size_t key)
+{
+	if (key >= lines.size())
+		return -1;
+
+	size_t countid = 0;
+	for (size_t i = 0; i < lines.size(); i++){
+		if (i == key){
+			return countid;
+		}
+		if (lines[i]->isVisible)
+			countid++;
+	}
+	return -1;
+}
+
+static size_t OldGetKeyFromPos(const std::vector<Line*> &lines, size_t position, size_t numOfLines)
+{
+	size_t visibleLines = 0;
+	for (size_t i = position; i < lines.size(); i++){
+		if (numOfLines == visibleLines)
+			return i;
+
+		if (lines[i]->isVisible)
+			visibleLines++;
+	}
+	return -1;
+}
+
+//new versions from SubsFile
+static size_t NewGetElementByKey(const VisibleLinesIndex &index, size_t size, size_t key)
+{
+	return (key >= size) ? -1 : index.CountBefore(key);
+}
+
+static size_t NewGetKeyFromPos(const VisibleLinesIndex &index, size_t size, size_t position, size_t numOfLines)
+{
+	if (position >= size)
+		return -1;
+
+	if (!numOfLines)
+		return position;
+
+	size_t lastVisibleId = index.CountBefore(position) + numOfLines - 1;
+	size_t lastVisibleKey = index.FindKey(lastVisibleId);
+	if (lastVisibleKey == -1 || lastVisibleKey + 1 >= size)
+		return -1;
+
+	return lastVisibleKey + 1;
+}
+
+enum{
+	BY_ID,
+	BY_KEY,
+	FROM_POS,
+	FOLD
+};
+
+struct Query
+{
+	int type;
+	size_t value;
+	size_t count;
+};
+
+int main(int argc, char **argv)
+{
+	size_t numQueries = (argc > 1) ? (size_t)atoll(argv[1]) : 20000;
+	if (!numQueries)
+		return 1;
+
+	int failed = 0;
+	size_t sizes[] = { 1000, 10000, 50000, 200000 };
+	printf("%i queries, every 50th folds or unfolds tree of 20 lines\n", (int)numQueries);
+	printf("%-8s %12s %12s %12s\n", "lines", "linear ms", "index ms", "speedup");
+	for (size_t size : sizes){
+		std::mt19937 random(1234);
+		std::vector<Line> storage(size);
+		std::vector<Line*> lines(size);
+		//a quarter of lines is in closed trees
+		for (size_t i = 0; i < size; i++){
+			storage[i].isVisible = ((i / 20) % 4 != 3);
+			lines[i] = &storage[i];
+		}
+		std::vector<Query> queries(numQueries);
+		for (size_t i = 0; i < numQueries; i++){
+			int type = (i % 50 == 49) ? FOLD : random() % 3;
+			queries[i] = Query{ type, random() % size, 1 + random() % 60 };
+		}
+
+		std::vector<size_t> oldResults(numQueries), newResults(numQueries);
+		std::vector<unsigned char> visibility(size);
+		for (size_t i = 0; i < size; i++){
+			visibility[i] = storage[i].isVisible;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t q = 0; q < numQueries; q++){
+			const Query &query = queries[q];
+			if (query.type == BY_ID)
+				oldResults[q] = OldGetElementById(lines, query.value / 2);
+			else if (query.type == BY_KEY)
+				oldResults[q] = OldGetElementByKey(lines, query.value);
+			else if (query.type == FROM_POS)
+				oldResults[q] = OldGetKeyFromPos(lines, query.value, query.count);
+			else{
+				size_t tree = query.value / 20 * 20;
+				for (size_t i = tree; i < tree + 20 && i < size; i++){
+					lines[i]->isVisible = !lines[i]->isVisible;
+				}
+			}
+		}
+		std::chrono::duration<double, std::milli> oldTime = std::chrono::steady_clock::now() - start;
+
+		for (size_t i = 0; i < size; i++){
+			storage[i].isVisible = visibility[i];
+		}
+		VisibleLinesIndex index;
+		start = std::chrono::steady_clock::now();
+		index.Rebuild(lines, [](const Line *line){ return line->isVisible != 0; });
+		for (size_t q = 0; q < numQueries; q++){
+			const Query &query = queries[q];
+			if (query.type == BY_ID)
+				newResults[q] = index.FindKey(query.value / 2);
+			else if (query.type == BY_KEY)
+				newResults[q] = NewGetElementByKey(index, size, query.value);
+			else if (query.type == FROM_POS)
+				newResults[q] = NewGetKeyFromPos(index, size, query.value, query.count);
+			else{
+				size_t tree = query.value / 20 * 20;
+				for (size_t i = tree; i < tree + 20 && i < size; i++){
+					lines[i]->isVisible = !lines[i]->isVisible;
+					index.Update(i, lines[i]->isVisible != 0);
+				}
+			}
+		}
+		std::chrono::duration<double, std::milli> newTime = std::chrono::steady_clock::now() - start;
+
+		for (size_t q = 0; q < numQueries; q++){
+			if (oldResults[q] != newResults[q]){
+				failed = 1;
+				break;
+			}
+		}
+		printf("%-8i %12.3f %12.3f %12.1f\n", (int)size, oldTime.count(), newTime.count(),
+			oldTime.count() / newTime.count());
+	}
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
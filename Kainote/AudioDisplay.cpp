@@ -36,6 +36,7 @@
 #include <process.h>
 #include <wx/filename.h>
 #include <vector>
+#include <algorithm>
 #include "UtilsWindows.h"
 
 
@@ -114,6 +115,13 @@ AudioDisplay::AudioDisplay(wxWindow *parent)
 		}
 	}, 7654);
 	ChangeOptions();
+	//window is set in spectrum threads, it needs new spectrum
+	Options.AddOptionListener(AUDIO_SPECTRUM_WINDOW, this, [=]() {
+		wxCriticalSectionLocker lock(mutex);
+		if (spectrumRenderer){ delete spectrumRenderer; spectrumRenderer = nullptr; }
+		needImageUpdateWeak = false;
+		Refresh(false);
+	});
 	Bind(EVENT_UPDATE_SCROLLBAR, [=](wxThreadEvent &evt) {
 		UpdateScrollbar();
 	});
@@ -129,6 +137,7 @@ AudioDisplay::AudioDisplay(wxWindow *parent)
 //////////////
 // Destructor
 AudioDisplay::~AudioDisplay() {
+	Options.RemoveOptionListeners(this);
 	if (UpdateTimerHandle) {
 		
 		stopPlayThread = true;
@@ -2162,27 +2171,13 @@ int AudioDisplay::GetBoundarySnap(int ms, int rangeX, bool shiftHeld, bool start
 	if (shiftHeld) snapKey = !snapKey;
 
 	if (snapKey && drawKeyframes) {
-		const wxArrayInt& keyFrames = provider->GetKeyframes();
-		size_t timecodesSize = provider->GetTimecodes().size();
-		long long keyMS;
-
-		for (unsigned int i = 0; i < keyFrames.Count(); i++) {
-			keyMS = keyFrames[i];
-			int keyX = GetXAtMS(keyMS);
-			if (keyX >= 0 && keyX < w) {
-				int frameTime = 0;
-				if (timecodesSize < 1){
-					//there is nothing to do when video is not loaded
-					//put half of frame 23.976FPS
-					frameTime = keyMS - 21;
-				}
-				else{
-					int frame = provider->GetFramefromMS(keyMS);
-					int prevFrameTime = provider->GetMSfromFrame(frame - 1);
-					frameTime = keyMS + ((prevFrameTime - keyMS) / 2);
-				}
-				boundaries.Add(ZEROIT(frameTime/*-halfframe*/));
-			}
+		//only keyframes from snapping range are taken from sorted index
+		const std::vector<int>& keyframesStart = provider->GetKeyframesStart();
+		auto it = std::lower_bound(keyframesStart.begin(), keyframesStart.end(), ms - rangeMS);
+		for (; it != keyframesStart.end() && *it <= ms + rangeMS; it++) {
+			int keyX = GetXAtMS(*it);
+			if (keyX >= 0 && keyX < w)
+				boundaries.Add(*it);
 		}
 	}
 
@@ -0,0 +1,150 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AudioPeaks.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char peaksMagic[8] = { 'K', 'A', 'I', 'P', 'E', 'A', 'K', 'S' };
+static const int peaksVersion = 1;
+
+void AudioPeaks::AddSamples(const short *samples, long long count)
+{
+	if (m_levels.empty())
+		m_levels.resize(1);
+
+	std::vector<Peak> &peaks = m_levels[0];
+	for (long long i = 0; i < count; i++) {
+		short value = samples[i];
+		if (value < m_current.min) m_current.min = value;
+		if (value > m_current.max) m_current.max = value;
+		if (++m_currentCount == AUDIO_PEAKS_BLOCK) {
+			peaks.push_back(m_current);
+			m_current = { 32767, -32768 };
+			m_currentCount = 0;
+		}
+	}
+	m_sampleCount += count;
+}
+
+void AudioPeaks::Finish()
+{
+	if (m_levels.empty())
+		m_levels.resize(1);
+
+	if (m_currentCount) {
+		m_levels[0].push_back(m_current);
+		m_current = { 32767, -32768 };
+		m_currentCount = 0;
+	}
+	BuildLevels();
+	m_ready.store(true, std::memory_order_release);
+}
+
+void AudioPeaks::BuildLevels()
+{
+	m_levels.resize(1);
+	while (m_levels.back().size() > 1) {
+		const std::vector<Peak> &previous = m_levels.back();
+		std::vector<Peak> next((previous.size() + 3) / 4, Peak{ 32767, -32768 });
+		for (size_t i = 0; i < previous.size(); i++) {
+			Peak &peak = next[i >> 2];
+			if (previous[i].min < peak.min) peak.min = previous[i].min;
+			if (previous[i].max > peak.max) peak.max = previous[i].max;
+		}
+		m_levels.push_back(std::move(next));
+	}
+}
+
+void AudioPeaks::GetMinMax(long long first, long long last, short *minValue, short *maxValue) const
+{
+	short minimum = 32767, maximum = -32768;
+	size_t level = 0;
+	//takes blocks from both sides till range is aligned to next level
+	while (first < last && level < m_levels.size()) {
+		const std::vector<Peak> &peaks = m_levels[level];
+		while (first < last && (first & 3)) {
+			const Peak &peak = peaks[first++];
+			if (peak.min < minimum) minimum = peak.min;
+			if (peak.max > maximum) maximum = peak.max;
+		}
+		while (first < last && (last & 3)) {
+			const Peak &peak = peaks[--last];
+			if (peak.min < minimum) minimum = peak.min;
+			if (peak.max > maximum) maximum = peak.max;
+		}
+		first >>= 2;
+		last >>= 2;
+		level++;
+	}
+	*minValue = minimum;
+	*maxValue = maximum;
+}
+
+bool AudioPeaks::Load(const wxString &path, long long sampleCount)
+{
+	FILE *fp = _wfopen(path.wc_str(), L"rb");
+	if (!fp)
+		return false;
+
+	char magic[8];
+	int version = 0, blockSize = 0;
+	long long savedSampleCount = 0, blockCount = 0;
+	bool good = fread(magic, 1, 8, fp) == 8 && !memcmp(magic, peaksMagic, 8) &&
+		fread(&version, sizeof(int), 1, fp) == 1 && version == peaksVersion &&
+		fread(&blockSize, sizeof(int), 1, fp) == 1 && blockSize == AUDIO_PEAKS_BLOCK &&
+		fread(&savedSampleCount, sizeof(long long), 1, fp) == 1 && savedSampleCount == sampleCount &&
+		fread(&blockCount, sizeof(long long), 1, fp) == 1 &&
+		blockCount == (sampleCount + AUDIO_PEAKS_BLOCK - 1) / AUDIO_PEAKS_BLOCK;
+
+	if (good) {
+		m_levels.resize(1);
+		m_levels[0].resize(blockCount);
+		good = fread(m_levels[0].data(), sizeof(Peak), blockCount, fp) == (size_t)blockCount;
+	}
+	fclose(fp);
+	if (!good) {
+		m_levels.clear();
+		return false;
+	}
+	m_sampleCount = sampleCount;
+	BuildLevels();
+	m_ready.store(true, std::memory_order_release);
+	return true;
+}
+
+bool AudioPeaks::Save(const wxString &path) const
+{
+	if (!IsReady())
+		return false;
+
+	FILE *fp = _wfopen(path.wc_str(), L"wb");
+	if (!fp)
+		return false;
+
+	long long blockCount = GetBlockCount();
+	bool good = fwrite(peaksMagic, 1, 8, fp) == 8 &&
+		fwrite(&peaksVersion, sizeof(int), 1, fp) == 1;
+	int blockSize = AUDIO_PEAKS_BLOCK;
+	good = good && fwrite(&blockSize, sizeof(int), 1, fp) == 1 &&
+		fwrite(&m_sampleCount, sizeof(long long), 1, fp) == 1 &&
+		fwrite(&blockCount, sizeof(long long), 1, fp) == 1 &&
+		fwrite(m_levels[0].data(), sizeof(Peak), blockCount, fp) == (size_t)blockCount;
+	fclose(fp);
+	if (!good)
+		_wremove(path.wc_str());
+
+	return good;
+}
@@ -0,0 +1,55 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <vector>
+#include <atomic>
+
+//min and max of 16 bit mono samples from audio cache
+//level 0 keeps peaks of AUDIO_PEAKS_BLOCK samples, every next level joins 4 peaks of previous one
+//peaks are added by audio loading thread and used after IsReady returns true
+#define AUDIO_PEAKS_BLOCK 256
+
+class AudioPeaks
+{
+public:
+	AudioPeaks() {};
+	//samples have to be added in the same order as they are in audio cache
+	void AddSamples(const short *samples, long long count);
+	//ends last block, builds next levels and sets ready
+	void Finish();
+	bool IsReady() const { return m_ready.load(std::memory_order_acquire); }
+	long long GetSampleCount() const { return m_sampleCount; }
+	long long GetBlockCount() const { return (m_levels.empty()) ? 0 : m_levels[0].size(); }
+	//min and max of blocks from first to last (last excluded)
+	void GetMinMax(long long first, long long last, short *minValue, short *maxValue) const;
+	//sampleCount is number of samples in audio cache, peaks of other cache are not loaded
+	bool Load(const wxString &path, long long sampleCount);
+	bool Save(const wxString &path) const;
+private:
+	struct Peak
+	{
+		short min;
+		short max;
+	};
+	void BuildLevels();
+	std::vector<std::vector<Peak>> m_levels;
+	Peak m_current = { 32767, -32768 };
+	int m_currentCount = 0;
+	long long m_sampleCount = 0;
+	std::atomic<bool> m_ready{ false };
+};
@@ -32,9 +32,8 @@
 
 
 const unsigned int orgsubcachelen = 16;//original subcache length when overlaps = 1
-static unsigned int subcachelen = orgsubcachelen;//orgsubcachelen * overlaps
-static unsigned int overlaps = 1;// number of overlaps used in FFT
 
+//block of orgsubcachelen * overlaps lines, every block covers the same time for all overlaps
 class SpectrumCache{
 private:
 	std::vector<CacheLine> data;
@@ -44,54 +43,40 @@ public:
 	{
 
 		// This check ought to be redundant
-		if (i >= start && i-start < subcachelen)
+		if (i >= start && i - start < data.size())
 			return data[(i-start)];
 		else{
 			return null_line;}
 	}
 
-	SpectrumCache(){};
+	SpectrumCache(unsigned long _block, int _overlaps)
+		: block(_block)
+		, overlaps(_overlaps)
+		, start(_block * orgsubcachelen * _overlaps)
+	{}
 
-	void CreateCache(FFT *fft, unsigned long _start)
+	void CreateCache(FFT *fft)
 	{
-		// Add an upper limit to number of overlaps or trust user to do sane things?
-		// Any limit should probably be a function of subcachelen
-
-		// First fill the data vector with blanks
-		// Both start and end are included in the range stored, so we have end-start+1 elements
-		if (data.size() < subcachelen){
-			data.resize(subcachelen, null_line); 
-		}
-
-		start = _start;
-		//test it
+		unsigned int subcachelen = orgsubcachelen * overlaps;
+		data.resize(subcachelen, null_line);
 		unsigned int overlap_offset = doublelen / overlaps;
 
-		//long long sample=start;
-		long long fftStart = start;
-		fftStart = (fftStart * doublelen) / (overlaps);
-		long long sample = fftStart;
-		//float scale_factor = 10 / sqrt(2 * (float)(doublelen));
+		long long sample = ((long long)start * doublelen) / overlaps;
 
 		for (unsigned long i = 0; i < subcachelen; ++i) {
-			// Start sample number of the next line calculated
 			// line_length is half of the number of samples used to calculate a line, since half of the output from
 			// a Fourier transform of real data is redundant, and not interesting for the purpose of creating
 			// a frequenmcy/power spectrum.
-			
-			//sample = fftStart + (i / orgsubcachelen * doublelen) + (i % overlaps * overlap_offset);
 			fft->Transform(sample);
-
-			CacheLine &line = data[i];
-
-			for (size_t j = 0; j < line_length; ++j) {
-				int g = (j * 2) + 1;
-				line[j] = /*log10( */sqrt(fft->output[j * 2] * fft->output[j * 2] + fft->output[g] * fft->output[g])/* * scale_factor + 1)*/;
-			}
-						
-			sample = fftStart += overlap_offset;
+			fft->GetMagnitudes(data[i].data());
+			sample += overlap_offset;
 		}
-		
+		ready = true;
+	}
+
+	size_t GetLinesCount()
+	{
+		return orgsubcachelen * overlaps;
 	}
 	
 	static void SetLineLength()
@@ -102,7 +87,11 @@ public:
 	~SpectrumCache()
 	{
 	}
-	unsigned long start = -1;
+	unsigned long block;
+	int overlaps;
+	unsigned long start;
+	//set by spectrum thread, read after thread completes its job
+	bool ready = false;
 	static CacheLine null_line;
 };
 
@@ -114,8 +103,9 @@ AudioSpectrum::AudioSpectrum(Provider *_provider)
 {
 	provider = _provider;
 	power_scale = 1;
-	AudioThreads = new AudioSpectrumMultiThreading(provider, &sub_caches);
+	AudioThreads = new AudioSpectrumMultiThreading(provider);
 	SpectrumCache::SetLineLength();
+	lastBlock = (unsigned long)(provider->GetNumSamples() / (orgsubcachelen * doublelen));
 	//SetupSpectrum();
 	ChangeColours();
 	minband = 0;//Options.GetInt(_T("Audio Spectrum Cutoff"));
@@ -127,15 +117,83 @@ AudioSpectrum::AudioSpectrum(Provider *_provider)
 AudioSpectrum::~AudioSpectrum()
 {
 	delete AudioThreads;
-	for (size_t i = 0; i < sub_caches.size(); ++i){
-		delete sub_caches[i];
+	for (SpectrumCache *block : blocks){
+		delete block;
 	}
 }
 
 void AudioSpectrum::SetupSpectrum(int _overlaps)
 {
 	overlaps = _overlaps;
-	subcachelen = orgsubcachelen * overlaps;
+}
+
+static inline unsigned long long BlockKey(int overlaps, unsigned long block)
+{
+	return ((unsigned long long)overlaps << 32) | block;
+}
+
+void AudioSpectrum::RemoveBlock(std::list<SpectrumCache*>::iterator it)
+{
+	SpectrumCache *block = *it;
+	blocksIndex.erase(BlockKey(block->overlaps, block->block));
+	cachedLines -= block->GetLinesCount();
+	blocks.erase(it);
+	delete block;
+}
+
+void AudioSpectrum::GetBlocks(int blocksOverlaps, unsigned long startBlock, unsigned long endBlock, std::vector<SpectrumCache*> &result)
+{
+	AudioThreads->StopPrefetch();
+	//blocks that prefetch did not compute
+	for (auto it = blocks.begin(); it != blocks.end();){
+		auto next = std::next(it);
+		if (!(*it)->ready)
+			RemoveBlock(it);
+		it = next;
+	}
+
+	result.clear();
+	std::vector<SpectrumCache*> missing;
+	for (unsigned long i = startBlock; i <= endBlock; i++){
+		auto found = blocksIndex.find(BlockKey(blocksOverlaps, i));
+		if (found != blocksIndex.end()){
+			blocks.splice(blocks.begin(), blocks, found->second);
+			result.push_back(*found->second);
+			continue;
+		}
+		SpectrumCache *block = new SpectrumCache(i, blocksOverlaps);
+		blocks.push_front(block);
+		blocksIndex[BlockKey(blocksOverlaps, i)] = blocks.begin();
+		cachedLines += block->GetLinesCount();
+		result.push_back(block);
+		missing.push_back(block);
+	}
+	if (missing.size())
+		AudioThreads->CreateCache(missing);
+
+	//needed blocks are on the front and are never removed
+	while (cachedLines > SPECTRUM_CACHE_LINES && blocks.size() > result.size()){
+		RemoveBlock(std::prev(blocks.end()));
+	}
+}
+
+void AudioSpectrum::PrefetchBlocks(int blocksOverlaps, unsigned long startBlock, unsigned long endBlock, std::vector<SpectrumCache*> &missing)
+{
+	if (endBlock > lastBlock)
+		endBlock = lastBlock;
+
+	for (unsigned long i = startBlock; i <= endBlock; i++){
+		if (cachedLines >= SPECTRUM_CACHE_LINES)
+			break;
+		if (blocksIndex.find(BlockKey(blocksOverlaps, i)) != blocksIndex.end())
+			continue;
+		SpectrumCache *block = new SpectrumCache(i, blocksOverlaps);
+		//added on the end, they are the first to remove
+		blocks.push_back(block);
+		blocksIndex[BlockKey(blocksOverlaps, i)] = std::prev(blocks.end());
+		cachedLines += block->GetLinesCount();
+		missing.push_back(block);
+	}
 }
 
 void AudioSpectrum::RenderRange(long long range_start, long long range_end, unsigned char *img, int imgwidth, int imgpitch, int imgheight, int percent)
@@ -147,37 +205,27 @@ void AudioSpectrum::RenderRange(long long range_start, long long range_end, unsi
 		newOverlaps = 24;
 	}
 	
-	if(newOverlaps != overlaps){ 
-		for (size_t i = 0; i < sub_caches.size(); ++i){
-			sub_caches[i]->start = -1;
-		}
-		SetupSpectrum(newOverlaps);
-	}
+	//blocks of other overlaps stay in cache for next zoom change
+	SetupSpectrum(newOverlaps);
+	unsigned int subcachelen = orgsubcachelen * overlaps;
 	unsigned long first_line = (unsigned long)(overlaps * range_start / doublelen);
 	unsigned long last_line = (unsigned long)(overlaps * range_end / doublelen);
 	unsigned long startcache = first_line / subcachelen;
 	unsigned long endcache = last_line / subcachelen;
 
-	size_t size = sub_caches.size();
-	size_t neededsize = (endcache - startcache) + AudioThreads->numThreads;
-	if (size < neededsize){
-		sub_caches.resize((neededsize * 3), 0);
-		for (int i = size; i < neededsize * 3; i++)
-			sub_caches[i] = new SpectrumCache();
-	}
-
 	int last_imgcol_rendered = -1;
 	float factor = pow(line_length, 1.f / (imgheight - 1));
 	// Some scaling constants
 	const int maxpower = (1 << (16 - 1)) * 256;
 
 	const double upscale = power_scale * 16384 / line_length;
-	AudioThreads->CreateCache(startcache, endcache);
+	std::vector<SpectrumCache*> rangeBlocks;
+	GetBlocks(overlaps, startcache, endcache, rangeBlocks);
 
 	// Note that here "lines" are actually bands of power data
 	unsigned long sampleRange = (last_line - first_line + 1);
-	unsigned long subcache = AudioThreads->lastCachePosition;
-	SpectrumCache *cache = sub_caches[subcache];
+	size_t subcache = 0;
+	SpectrumCache *cache = rangeBlocks[subcache];
 	for (unsigned long i = first_line, k = 0; i <= last_line; ++i, ++k) {
 		// Handle horizontal compression and don't unneededly re-render columns
 		int imgcol = imgwidth * k / sampleRange;
@@ -186,8 +234,7 @@ void AudioSpectrum::RenderRange(long long range_start, long long range_end, unsi
 		//size_t subcache = i / subcachelen;
 		if (i % subcachelen == 0 && k>0){
 			subcache++; 
-			if (subcache >= sub_caches.size()){ subcache = 0; }
-			cache = sub_caches[subcache]; 
+			cache = rangeBlocks[subcache]; 
 		}
 		CacheLine &line=cache->GetLine(i);
 
@@ -261,14 +308,21 @@ void AudioSpectrum::RenderRange(long long range_start, long long range_end, unsi
 #undef WRITE_PIXEL
 
 	}
-	
+	//blocks of next and previous view, scrolling uses them without waiting
+	unsigned long rangeBlocksCount = endcache - startcache + 1;
+	std::vector<SpectrumCache*> prefetched;
+	PrefetchBlocks(overlaps, endcache + 1, endcache + rangeBlocksCount, prefetched);
+	if (startcache > 0)
+		PrefetchBlocks(overlaps, (startcache > rangeBlocksCount) ? startcache - rangeBlocksCount : 0, startcache - 1, prefetched);
+	if (prefetched.size())
+		AudioThreads->Prefetch(prefetched);
 }
 
 void AudioSpectrum::CreateRange(std::vector<int> &output, std::vector<int> &intensities, long long timeStart, long long timeEnd, wxPoint frequency, int peek)
 {
 	wxCriticalSectionLocker locker(CritSec);
-	overlaps = 1;
-	subcachelen = 16;
+	//it always uses lines without overlaps
+	unsigned int subcachelen = orgsubcachelen;
 	int sampleRate = provider->GetSampleRate();
 	long long range_start = timeStart * sampleRate / 1000;
 	long long range_end = timeEnd * sampleRate / 1000;
@@ -283,30 +337,22 @@ void AudioSpectrum::CreateRange(std::vector<int> &output, std::vector<int> &inte
 	if (indexEnd < indexStart)
 		indexEnd = indexStart;
 	
-	size_t size = sub_caches.size();
-	size_t neededsize = (endcache - startcache) + AudioThreads->numThreads;
-	if (size < neededsize){
-		sub_caches.resize((neededsize * 3), 0);
-		for (int i = size; i < neededsize * 3; i++)
-			sub_caches[i] = new SpectrumCache();
-	}
-
 	const int maxpower = (1 << (16 - 1)) * 100;
 	const double upscale = 16384 / line_length;
-	AudioThreads->CreateCache(startcache, endcache);
+	std::vector<SpectrumCache*> rangeBlocks;
+	GetBlocks(1, startcache, endcache, rangeBlocks);
 
 	// Note that here "lines" are actually bands of power data
 	long long lasttime = -1;
-	unsigned long subcache = AudioThreads->lastCachePosition;
-	SpectrumCache *cache = sub_caches[subcache];
+	size_t subcache = 0;
+	SpectrumCache *cache = rangeBlocks[subcache];
 	//long long g = range_start;
 	int lastintensity = 0;
 	int lastintensitytime = 0;
 	for (unsigned long i = first_line; i <= last_line; ++i) {
 		if (i % subcachelen == 0 && i > first_line){
 			subcache++;
-			if (subcache >= sub_caches.size()){ subcache = 0; }
-			cache = sub_caches[subcache];
+			cache = rangeBlocks[subcache];
 		}
 		CacheLine &line = cache->GetLine(i);
 		long long lli = i;
@@ -380,9 +426,8 @@ void AudioSpectrum::ChangeColours()
 
 }
 
-AudioSpectrumMultiThreading::AudioSpectrumMultiThreading(Provider *provider, std::vector<SpectrumCache*> *_sub_caches)
+AudioSpectrumMultiThreading::AudioSpectrumMultiThreading(Provider *provider)
 {
-	sub_caches = _sub_caches;
 	sthread = this; 
 	SYSTEM_INFO sysinfo;
 	GetSystemInfo(&sysinfo);
@@ -393,19 +438,19 @@ AudioSpectrumMultiThreading::AudioSpectrumMultiThreading(Provider *provider, std
 	threads = new HANDLE[numThreads];
 	eventCacheCopleted = new HANDLE[numThreads];
 	eventMakeCache = new HANDLE[numThreads];
+	int windowType = Options.GetInt(AUDIO_SPECTRUM_WINDOW);
 	for (int i = 0; i < numThreads; i++){
 		eventCacheCopleted[i] = CreateEvent(0, FALSE, FALSE, 0);
 		eventMakeCache[i] = CreateEvent(0, FALSE, FALSE, 0);
-		ffttable[i].Set(provider);
+		ffttable[i].Set(provider, windowType);
 		threads[i] = (HANDLE)_beginthreadex(0, 0, AudioProc, new int(i), 0, 0);
 	}
 }
 
 AudioSpectrumMultiThreading::~AudioSpectrumMultiThreading()
 {
-	if (ffttable) 
-		delete[] ffttable;
 	if (threads){
+		StopPrefetch();
 		SetEvent(eventKillSelf);
 		WaitForMultipleObjects(numThreads, threads, TRUE, 20000);
 		for (int i = 0; i < numThreads; i++){
@@ -418,45 +463,47 @@ AudioSpectrumMultiThreading::~AudioSpectrumMultiThreading()
 		delete[] eventMakeCache;
 		delete[] eventCacheCopleted;
 	}
+	if (ffttable) 
+		delete[] ffttable;
 }
 
-void AudioSpectrumMultiThreading::CreateCache(unsigned long _start, unsigned long _end)
+void AudioSpectrumMultiThreading::StartJob(std::vector<SpectrumCache*> &blocks)
 {
-	if (_start == start && end == _end && (*sub_caches)[lastCachePosition]->start == _start){ return; }
-	if (_start < end && start < _end){
-		long newPosition = lastCachePosition - (start - _start);
-		size_t subcachessize = sub_caches->size();
-		if (newPosition < 0){ lastCachePosition = newPosition + subcachessize; }
-		else if (newPosition >= subcachessize){ lastCachePosition = newPosition - subcachessize; }
-		else(lastCachePosition = newPosition);
-	}
-	else{
-		FindCache(_start * subcachelen, _end * subcachelen);
-	}
-	start = _start;
-	end = _end;
-	len = ((end - start) / numThreads) + 1;
-	//if ((*sub_caches)[lastCachePosition]->start == _start * subcachelen &&)
+	jobBlocks = blocks;
+	nextBlock = 0;
+	cancelJob = false;
 	for (int i = 0; i < numThreads; i++)
 		SetEvent(eventMakeCache[i]);
+}
 
+void AudioSpectrumMultiThreading::WaitForJob()
+{
 	WaitForMultipleObjects(numThreads, eventCacheCopleted, TRUE, INFINITE);
+	jobBlocks.clear();
 }
 
-void AudioSpectrumMultiThreading::FindCache(unsigned long _start, unsigned long _end)
+void AudioSpectrumMultiThreading::CreateCache(std::vector<SpectrumCache*> &blocks)
 {
-	for (size_t i = 0; i < sub_caches->size(); i++){
-		SpectrumCache *cache = (*sub_caches)[i];
-		if (cache->start == _start){
-			lastCachePosition = i;
-			break;
-		}
-		else if (_end == cache->start){
-			long currentstart = i - ((len -1) * numThreads) - 1;
-			lastCachePosition = (currentstart < 0) ? sub_caches->size() + currentstart : currentstart;
-			break;
-		}
-	}
+	StopPrefetch();
+	StartJob(blocks);
+	WaitForJob();
+}
+
+void AudioSpectrumMultiThreading::Prefetch(std::vector<SpectrumCache*> &blocks)
+{
+	StopPrefetch();
+	StartJob(blocks);
+	prefetching = true;
+}
+
+void AudioSpectrumMultiThreading::StopPrefetch()
+{
+	if (!prefetching)
+		return;
+
+	cancelJob = true;
+	WaitForJob();
+	prefetching = false;
 }
 
 unsigned int __stdcall AudioSpectrumMultiThreading::AudioProc(void* num)
@@ -477,20 +524,14 @@ void AudioSpectrumMultiThreading::AudioPorocessing(int numOfTread)
 	while (1){
 		DWORD wait_result = WaitForMultipleObjects(sizeof(events_to_wait) / sizeof(HANDLE), events_to_wait, FALSE, INFINITE);
 		if (wait_result == WAIT_OBJECT_0 + 0){
-			unsigned long threadStart = start + len * numOfTread;
-			unsigned long startcache = lastCachePosition + (len * numOfTread);
-			bool audioSet = false;
-			size_t sssize = sub_caches->size();
-			for (unsigned long i = threadStart; i < threadStart + len; i++){
-				unsigned long currentCache = i/* / overlaps*/ * subcachelen;
-				if (startcache >= sssize){
-					startcache -= sssize;
-				}
-				if ((*sub_caches)[startcache]->start != currentCache){
-					if (!audioSet){ SetAudio(i, len - (i - threadStart), &cfft); audioSet = true; }
-					(*sub_caches)[startcache]->CreateCache(&cfft, currentCache);
-				}
-				startcache++;
+			//every thread takes next free block till all are done
+			while (!cancelJob){
+				size_t i = nextBlock++;
+				if (i >= jobBlocks.size())
+					break;
+				SpectrumCache *block = jobBlocks[i];
+				SetAudio(block, &cfft);
+				block->CreateCache(&cfft);
 			}
 			SetEvent(complete);
 		}
@@ -500,19 +541,11 @@ void AudioSpectrumMultiThreading::AudioPorocessing(int numOfTread)
 	}
 }
 
-void AudioSpectrumMultiThreading::SetAudio(unsigned long _start, int _len, FFT *fft)
+void AudioSpectrumMultiThreading::SetAudio(SpectrumCache *block, FFT *fft)
 {
-	if (_len < 1){
-		assert(false);
-	}
-	//size_t samplestart = (_start * subcachelen) * doublelen;
-	//size_t offset = (doublelen / overlaps) ;
-	//size_t sampleend = ((_start + _len - 1) * subcachelen) * doublelen;
-	//sampleend += ((subcachelen-1) * doublelen);
-	long long samplestart = ((_start /*/ overlaps*/) * orgsubcachelen) * doublelen;
-	long long offset = (doublelen / overlaps);
-	long long sampleend = (((_start + _len - 1) /*/ overlaps*/) * orgsubcachelen) * doublelen;
-	sampleend += /*((overlaps - 1) * offset) + */((subcachelen - 1) * offset/*doublelen*/);
+	long long offset = (doublelen / block->overlaps);
+	long long samplestart = ((long long)block->start * doublelen) / block->overlaps;
+	long long sampleend = samplestart + ((block->GetLinesCount() - 1) * offset);
 
 	fft->SetAudio(samplestart, (sampleend - samplestart) + doublelen);
 }
@@ -40,6 +40,9 @@
 //#include <stdint.h>
 #include "GFFT/GFFT.h"
 #include "Provider.h"
+#include <list>
+#include <unordered_map>
+#include <atomic>
 
 
 class SpectrumCache;
@@ -47,6 +50,9 @@ class AudioSpectrumMultiThreading;
 
 typedef std::vector<float> CacheLine;
 
+//limit of lines kept in spectrum cache, every line has line_length floats
+#define SPECTRUM_CACHE_LINES 32768
+
 
 class AudioSpectrum {
 	friend class SpectrumThread;
@@ -61,10 +67,21 @@ private:
 	int minband; // smallest frequency band displayed
 	int maxband; // largest frequency band displayed
 	bool nonlinear = true;
+	int overlaps = 1;
 	wxCriticalSection CritSec;
 	void SetupSpectrum(int overlaps = 1);
-	std::vector<SpectrumCache*> sub_caches;
+	//blocks of all used overlaps keyed by overlaps and block number, front is the most recently used
+	std::list<SpectrumCache*> blocks;
+	std::unordered_map<unsigned long long, std::list<SpectrumCache*>::iterator> blocksIndex;
+	size_t cachedLines = 0;
+	//last block that contains audio
+	unsigned long lastBlock = 0;
 	AudioSpectrumMultiThreading *AudioThreads;
+	//returns blocks from startBlock to endBlock, computes blocks that are not in cache
+	void GetBlocks(int blocksOverlaps, unsigned long startBlock, unsigned long endBlock, std::vector<SpectrumCache*> &result);
+	//adds blocks that are not in cache to compute them in background
+	void PrefetchBlocks(int blocksOverlaps, unsigned long startBlock, unsigned long endBlock, std::vector<SpectrumCache*> &missing);
+	void RemoveBlock(std::list<SpectrumCache*>::iterator it);
 public:
 	AudioSpectrum(Provider *_provider);
 	~AudioSpectrum();
@@ -79,20 +96,25 @@ public:
 class AudioSpectrumMultiThreading
 {
 public:
-	AudioSpectrumMultiThreading(Provider *provider, std::vector<SpectrumCache*> *_sub_caches);
+	AudioSpectrumMultiThreading(Provider *provider);
 	~AudioSpectrumMultiThreading();
-	//void SetCache(unsigned int _overlaps){overlaps = _overlaps; }
-	void CreateCache(unsigned long _start, unsigned long _end);
-	unsigned long start=0, end=0, lastCachePosition = 0;
-	void FindCache(unsigned long _start, unsigned long _end);
+	//computes blocks and waits till all of them are ready
+	void CreateCache(std::vector<SpectrumCache*> &blocks);
+	//computes blocks in background, StopPrefetch has to be called before blocks are used or removed
+	void Prefetch(std::vector<SpectrumCache*> &blocks);
+	//stops prefetching, blocks that are not ready were not computed
+	void StopPrefetch();
 	int numThreads;
 private:
 	static unsigned int __stdcall AudioProc(void* cls);
 	void AudioPorocessing(int numOfTread);
-	void SetAudio(unsigned long start, int len, FFT *fft);
-	std::vector<SpectrumCache*> *sub_caches;
-	unsigned long len;
-	//unsigned int overlaps;
+	void SetAudio(SpectrumCache *block, FFT *fft);
+	void StartJob(std::vector<SpectrumCache*> &blocks);
+	void WaitForJob();
+	std::vector<SpectrumCache*> jobBlocks;
+	std::atomic<size_t> nextBlock{ 0 };
+	std::atomic<bool> cancelJob{ false };
+	bool prefetching = false;
 	FFT *ffttable = nullptr;
 	HANDLE *threads=nullptr;
 	HANDLE *eventCacheCopleted = nullptr;
@@ -0,0 +1,164 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ChunkedArray.h"
+#include <wx/string.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+//raw lines of one chunk, they are never changed after they are made,
+//so they are shared by autosave records and autosave thread
+typedef std::shared_ptr<const std::vector<wxString>> AutoSaveLinesPtr;
+
+//range of dialogues table which is shared between history steps until one of its lines is changed
+struct AutoSaveChunk
+{
+	const void *id;
+	size_t start;
+	size_t size;
+	//the same pointer in two records means the same lines
+	AutoSaveLinesPtr lines;
+};
+
+//raw lines of chunks from the previous autosave, used only on UI thread.
+//Key has everything that raw line depends on and GetId with address of element,
+//line with the same key is not formatted again. Chunk with the same id and keys shares lines
+//with previous autosave, changed chunk is compared line by line. Chunk made by change or insertion
+//has new id, its lines are found by element in previous chunks that were between the same kept chunks.
+//Making keys is cheap, so autosave formats only lines changed since previous autosave.
+template<typename Key>
+class AutoSaveLinesCache
+{
+public:
+	//makeKey(element, index, Key *key) and makeRaw(element, index, wxString &raw)
+	template<typename T, typename MakeKey, typename MakeRaw>
+	void GetChunks(const ChunkedArray<T> &elements, MakeKey makeKey, MakeRaw makeRaw,
+		std::vector<AutoSaveChunk> *chunks)
+	{
+		size_t numChunks = elements.GetChunksCount();
+		std::vector<CachedChunk> newCache(numChunks);
+		//index of chunk in previous cache, NOT_FOUND for new chunks
+		std::vector<size_t> previousIndex(numChunks);
+		for (size_t c = 0; c < numChunks; c++){
+			size_t start = elements.GetChunkStart(c);
+			CachedChunk &cached = newCache[c];
+			cached.id = elements.GetChunkId(c);
+			cached.keys.resize(elements.GetChunkSize(c));
+			for (size_t i = 0; i < cached.keys.size(); i++){
+				makeKey(elements[start + i], start + i, &cached.keys[i]);
+			}
+			auto it = cacheIndex.find(cached.id);
+			previousIndex[c] = (it != cacheIndex.end()) ? it->second : NOT_FOUND;
+		}
+
+		formatted = 0;
+		size_t lastFound = NOT_FOUND;
+		for (size_t c = 0; c < numChunks; c++){
+			CachedChunk &cached = newCache[c];
+			size_t start = elements.GetChunkStart(c);
+			size_t size = cached.keys.size();
+			const CachedChunk *previous = (previousIndex[c] != NOT_FOUND) ? &cache[previousIndex[c]] : nullptr;
+			if (previous && previous->keys == cached.keys){
+				cached.lines = previous->lines;
+				lastFound = previousIndex[c];
+				continue;
+			}
+			if (previous){
+				lastFound = previousIndex[c];
+			}
+			else{
+				//every new chunk between the same kept chunks uses one table of their previous lines
+				if (c == 0 || previousIndex[c - 1] != NOT_FOUND){
+					size_t nextFound = NOT_FOUND;
+					for (size_t n = c + 1; n < numChunks && nextFound == NOT_FOUND; n++){
+						nextFound = previousIndex[n];
+					}
+					size_t from = (lastFound == NOT_FOUND) ? 0 : lastFound + 1;
+					size_t to = (nextFound == NOT_FOUND) ? cache.size() : nextFound;
+					//chunks were moved, lines can be anywhere
+					if (from > to){
+						from = 0;
+						to = cache.size();
+					}
+					previousLines.clear();
+					for (size_t p = from; p < to; p++){
+						const CachedChunk &chunk = cache[p];
+						for (size_t i = 0; i < chunk.keys.size(); i++){
+							previousLines[chunk.keys[i].GetId()] = PreviousLine{ &chunk.keys[i], &(*chunk.lines)[i] };
+						}
+					}
+				}
+			}
+			std::shared_ptr<std::vector<wxString>> lines = std::make_shared<std::vector<wxString>>(size);
+			for (size_t i = 0; i < size; i++){
+				const Key &key = cached.keys[i];
+				if (previous){
+					if (i < previous->keys.size() && previous->keys[i] == key){
+						(*lines)[i] = (*previous->lines)[i];
+						continue;
+					}
+				}
+				else{
+					auto it = previousLines.find(key.GetId());
+					if (it != previousLines.end() && *it->second.key == key){
+						(*lines)[i] = *it->second.raw;
+						continue;
+					}
+				}
+				makeRaw(elements[start + i], start + i, (*lines)[i]);
+				formatted++;
+			}
+			cached.lines = lines;
+		}
+
+		chunks->reserve(chunks->size() + numChunks);
+		cacheIndex.clear();
+		for (size_t c = 0; c < numChunks; c++){
+			chunks->push_back(AutoSaveChunk{ newCache[c].id, elements.GetChunkStart(c),
+				newCache[c].keys.size(), newCache[c].lines });
+			cacheIndex[newCache[c].id] = c;
+		}
+		cache.swap(newCache);
+		previousLines.clear();
+	}
+	//needed when options of raw lines were changed
+	void Clear(){
+		cache.clear();
+		cacheIndex.clear();
+	}
+	//number of lines formatted by last GetChunks
+	size_t GetFormattedCount() const{ return formatted; }
+private:
+	static const size_t NOT_FOUND = (size_t)-1;
+	struct CachedChunk
+	{
+		const void *id;
+		std::vector<Key> keys;
+		AutoSaveLinesPtr lines;
+	};
+	struct PreviousLine
+	{
+		const Key *key;
+		const wxString *raw;
+	};
+	//chunks in order of elements
+	std::vector<CachedChunk> cache;
+	std::unordered_map<const void*, size_t> cacheIndex;
+	std::unordered_map<const void*, PreviousLine> previousLines;
+	size_t formatted = 0;
+};
@@ -16,6 +16,8 @@
 #include "AutoSaveOpen.h"
 #include "KainoteFrame.h"
 #include "KaiStaticBoxSizer.h"
+#include "AutoSaveWriter.h"
+#include "OpennWrite.h"
 #include <wx/dir.h>
 #include <wx/tokenzr.h>
 
@@ -142,6 +144,10 @@ void AutoSaveOpen::GenerateList()
 		wxString fileName = wxString(data.cFileName);
 		wxString ext;
 		wxString rest = fileName.BeforeLast(L'.', &ext);
+		//journal is shown as another version of subtitles
+		if (ext == L"journal") {
+			rest = rest.BeforeLast(L'.', &ext);
+		}
 		wxString fileNum;
 		wxString rest1 = rest.BeforeLast(L'_', &fileNum);
 		wxString tabNum;
@@ -239,6 +245,23 @@ void AutoSaveOpen::OnOkClick(wxCommandEvent& evt)
 	auto it = verList->find(item->name);
 	if (it != verList->end()) {
 		wxString filePath = Options.pathfull + L"\\Subs\\" + it->second;
+		if (filePath.EndsWith(L".journal")) {
+			//last complete record is restored to normal subtitles file
+			wxString text;
+			if (!AutoSaveWriter::ReadJournal(filePath, &text)) {
+				KaiLog(_("Wczytywanie autozapisu nie powiodło się"));
+				return;
+			}
+			filePath = Options.pathfull + L"\\Subs\\Restored\\" + it->second.BeforeLast(L'.');
+			OpenWrite ow;
+			if (!ow.SafeFileOpen(filePath)) {
+				return;
+			}
+			ow.SafeFileWrite(text);
+			if (!ow.SafeFileClose()) {
+				return;
+			}
+		}
 		Kai->OpenFile(filePath);
 		EndModal(wxOK);
 		return;
@@ -0,0 +1,382 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AutoSaveWriter.h"
+#include "OpennWrite.h"
+#include <wx/tokenzr.h>
+#include <unordered_map>
+#include <algorithm>
+
+#define JOURNAL_MAGIC L"[Kainote Autosave Journal]"
+
+AutoSaveWriter::~AutoSaveWriter()
+{
+	Stop();
+}
+
+bool AutoSaveWriter::NeedsNewJournal(SubsFile *file, const AutoSaveData &data)
+{
+	if (!journalRecord || journalFailed || journalFile != file)
+		return true;
+	//tab was moved or renamed
+	if (journalBaseName != data.baseName)
+		return true;
+	//translation mode changes raw text of every line
+	if (journalTlmodeOn != data.tlmodeOn || journalTranslated != data.translated ||
+		journalShowOriginal != data.showOriginalOnVideo || journalTlStyle != data.tlStyle)
+		return true;
+
+	return journalRecords >= AUTOSAVE_JOURNAL_MAX_RECORDS || journalLines > file->GetCount() * 2;
+}
+
+bool AutoSaveLineKey::operator ==(const AutoSaveLineKey &key) const
+{
+	return dial == key.dial && textVersions[0] == key.textVersions[0] &&
+		textVersions[1] == key.textVersions[1] && textVersions[2] == key.textVersions[2] &&
+		textVersions[3] == key.textVersions[3] && textVersions[4] == key.textVersions[4] &&
+		start == key.start && end == key.end && startFrame == key.startFrame && endFrame == key.endFrame &&
+		layer == key.layer && position == key.position && marginL == key.marginL &&
+		marginR == key.marginR && marginV == key.marginV && format == key.format &&
+		state == key.state && treeState == key.treeState && nonDialogue == key.nonDialogue &&
+		isComment == key.isComment;
+}
+
+void AutoSaveWriter::GetLines(File *subs, AutoSaveData *data)
+{
+	//every line depends on these options
+	if (linesSubsFormat != data->subsFormat || linesTlmodeOn != data->tlmodeOn ||
+		linesTranslated != data->translated || linesShowOriginal != data->showOriginalOnVideo ||
+		linesTlStyle != data->tlStyle){
+		linesCache.Clear();
+		linesSubsFormat = data->subsFormat;
+		linesTlmodeOn = data->tlmodeOn;
+		linesTranslated = data->translated;
+		linesShowOriginal = data->showOriginalOnVideo;
+		linesTlStyle = data->tlStyle;
+	}
+	linesCache.GetChunks(subs->dialogues,
+		[data](Dialogue *dial, size_t i, AutoSaveLineKey *key){ GetLineKey(dial, i, key, data); },
+		[data](Dialogue *dial, size_t i, wxString &raw){ GetRawLine(dial, i, raw, data); },
+		&data->chunks);
+}
+
+void AutoSaveWriter::Start(SubsFile *file, AutoSaveData *data, bool journal)
+{
+	if (thread.joinable())
+		thread.join();
+
+	working.store(true, std::memory_order_release);
+	thread = std::thread(&AutoSaveWriter::Write, this, file, data, journal);
+}
+
+void AutoSaveWriter::Stop()
+{
+	if (thread.joinable())
+		thread.join();
+
+	delete journalRecord;
+	journalRecord = nullptr;
+	journalFile = nullptr;
+	journalFailed = false;
+	linesCache.Clear();
+}
+
+void AutoSaveWriter::Write(SubsFile *file, AutoSaveData *data, bool journal)
+{
+	bool newJournal = !data->path.empty();
+	bool succeeded = false;
+	size_t written = 0;
+	OpenWrite ow;
+	if (!journal){
+		if (ow.SafeFileOpen(data->path)){
+			ow.SafeFileWrite(data->header);
+			for (const AutoSaveChunk &chunk : data->chunks){
+				for (const wxString &raw : *chunk.lines){
+					ow.SafeFileWrite(raw);
+				}
+			}
+			succeeded = ow.SafeFileClose();
+		}
+	}
+	else if (newJournal){
+		if (ow.SafeFileOpen(data->path)){
+			ow.SafeFileWrite(JOURNAL_MAGIC L"\r\n");
+			written = WriteRecord(ow, data, nullptr);
+			succeeded = ow.SafeFileClose();
+		}
+	}
+	else if (ow.SafeFileAppend(journalPath)){
+		written = WriteRecord(ow, data, journalRecord);
+		succeeded = ow.SafeFileClose();
+	}
+
+	AutoSaveData *released = data;
+	if (!journal){
+		delete journalRecord;
+		journalRecord = nullptr;
+	}
+	else if (!succeeded){
+		//partly written record can't be followed by other records
+		journalFailed = true;
+	}
+	else{
+		//lines are kept to find changes in the next autosave
+		released = journalRecord;
+		journalRecord = data;
+		journalFile = file;
+		if (newJournal){
+			journalPath = data->path;
+			journalBaseName = data->baseName;
+			journalRecords = 0;
+			journalLines = 0;
+			journalFailed = false;
+		}
+		journalHeader = data->header;
+		journalTlStyle = data->tlStyle;
+		journalTlmodeOn = data->tlmodeOn;
+		journalTranslated = data->translated;
+		journalShowOriginal = data->showOriginalOnVideo;
+		journalRecords++;
+		journalLines += written;
+	}
+	delete released;
+	working.store(false, std::memory_order_release);
+}
+
+size_t AutoSaveWriter::WriteRecord(OpenWrite &ow, AutoSaveData *data, AutoSaveData *previous)
+{
+	wxString text;
+	text << L"Record: " << data->GetLinesCount() << L"\r\n";
+	if (!previous || data->header != journalHeader){
+		text << L"Header: " << CountLines(data->header) << L"\r\n" << data->header;
+	}
+	ow.SafeFileWrite(text);
+
+	//every chunk of previous record
+	std::unordered_map<const void*, const AutoSaveChunk*> previousChunks;
+	if (previous){
+		previousChunks.reserve(previous->chunks.size());
+		for (const AutoSaveChunk &chunk : previous->chunks){
+			previousChunks[chunk.id] = &chunk;
+		}
+	}
+
+	size_t written = 0;
+	size_t keepFrom = 0;
+	size_t keepCount = 0;
+	auto writeKeep = [&](){
+		if (!keepCount)
+			return;
+		text.Empty();
+		text << L"Keep: " << keepFrom << L" " << keepCount << L"\r\n";
+		ow.SafeFileWrite(text);
+		keepCount = 0;
+	};
+	for (const AutoSaveChunk &chunk : data->chunks){
+		size_t size = chunk.size;
+		const std::vector<wxString> &lines = *chunk.lines;
+		auto it = previousChunks.find(chunk.id);
+		//the same chunk can have lines changed in place or memory of released chunk,
+		//lines not changed since previous record are shared with it
+		if (it != previousChunks.end() && it->second->size == size &&
+			(it->second->lines == chunk.lines || lines == *it->second->lines)){
+			//neighbouring chunks not changed by insertions are joined
+			if (keepCount && keepFrom + keepCount == it->second->start){
+				keepCount += size;
+			}
+			else{
+				writeKeep();
+				keepFrom = it->second->start;
+				keepCount = size;
+			}
+			continue;
+		}
+		writeKeep();
+		text.Empty();
+		text << L"Lines: " << size << L"\r\n";
+		ow.SafeFileWrite(text);
+		for (size_t i = 0; i < size; i++){
+			//in translation mode one dialogue can have two lines
+			text.Empty();
+			text << CountLines(lines[i]) << L"\r\n";
+			ow.SafeFileWrite(text);
+			ow.SafeFileWrite(lines[i]);
+		}
+		written += size;
+	}
+	writeKeep();
+	ow.SafeFileWrite(L"End\r\n");
+	return written;
+}
+
+void AutoSaveWriter::GetRawLine(Dialogue *dial, size_t i, wxString &raw, const AutoSaveData *data)
+{
+	if (data->tlmodeOn){
+		bool hasTextTl = dial->TextTl != emptyString;
+		if (!data->translated && (hasTextTl || dial->IsDoubtful())){
+			dial->GetRaw(&raw, false, data->tlStyle, !data->showOriginalOnVideo);
+			dial->GetRaw(&raw, true);
+		}
+		else{
+			dial->GetRaw(&raw, hasTextTl);
+		}
+	}
+	else{
+		if (data->subsFormat == SRT){
+			raw << int(i + 1) << L"\r\n";
+		}
+		dial->GetRaw(&raw);
+	}
+}
+
+void AutoSaveWriter::GetLineKey(Dialogue *dial, size_t i, AutoSaveLineKey *key, const AutoSaveData *data)
+{
+	key->dial = dial;
+	key->textVersions[0] = dial->Text.GetVersion();
+	key->textVersions[1] = dial->TextTl.GetVersion();
+	key->textVersions[2] = dial->Style.GetVersion();
+	key->textVersions[3] = dial->Actor.GetVersion();
+	key->textVersions[4] = dial->Effect.GetVersion();
+	key->start = dial->Start.mstime;
+	key->end = dial->End.mstime;
+	key->startFrame = dial->Start.orgframe;
+	key->endFrame = dial->End.orgframe;
+	key->layer = dial->Layer;
+	key->position = (data->subsFormat == SRT) ? i : 0;
+	key->marginL = dial->MarginL;
+	key->marginR = dial->MarginR;
+	key->marginV = dial->MarginV;
+	key->format = dial->Format;
+	key->state = dial->GetState();
+	key->treeState = dial->treeState;
+	key->nonDialogue = dial->NonDialogue;
+	key->isComment = dial->IsComment;
+}
+
+size_t AutoSaveWriter::CountLines(const wxString &text)
+{
+	size_t count = 0;
+	for (wxString::const_iterator it = text.begin(); it != text.end(); it++){
+		if (*it == L'\n')
+			count++;
+	}
+	return count;
+}
+
+bool AutoSaveWriter::ReadJournal(const wxString &path, wxString *text)
+{
+	OpenWrite ow;
+	wxString journal;
+	if (!ow.FileOpen(path, &journal))
+		return false;
+
+	//text is read without \r
+	wxArrayString lines = wxStringTokenize(journal, L"\n", wxTOKEN_RET_EMPTY_ALL);
+	size_t numLines = lines.GetCount();
+	if (!numLines || lines[0] != JOURNAL_MAGIC)
+		return false;
+
+	wxString header;
+	std::vector<wxString> dialogues;
+	bool hasRecord = false;
+	size_t pos = 1;
+	wxString rest;
+	//reads number after prefix, returns false when line doesn't start with it
+	auto readNumber = [&](const wchar_t *prefix, unsigned long *number) -> bool{
+		wxString value;
+		if (pos >= numLines || !lines[pos].StartsWith(prefix, &value))
+			return false;
+		return value.BeforeFirst(L' ', &rest).ToULong(number);
+	};
+	//takes given number of lines, false when journal ends before
+	auto readLines = [&](unsigned long count, wxString *result) -> bool{
+		if (pos + count > numLines)
+			return false;
+		for (unsigned long i = 0; i < count; i++){
+			*result << lines[pos++] << L"\r\n";
+		}
+		return true;
+	};
+
+	unsigned long recordSize;
+	while (readNumber(L"Record: ", &recordSize)){
+		pos++;
+		wxString recordHeader = header;
+		std::vector<wxString> recordDialogues;
+		recordDialogues.reserve(recordSize);
+		bool valid = false;
+		while (pos < numLines){
+			unsigned long count;
+			if (lines[pos] == L"End"){
+				pos++;
+				valid = recordDialogues.size() == recordSize;
+				break;
+			}
+			else if (readNumber(L"Header: ", &count)){
+				pos++;
+				recordHeader.Empty();
+				if (!readLines(count, &recordHeader))
+					break;
+			}
+			else if (readNumber(L"Keep: ", &count)){
+				unsigned long keepCount;
+				if (!rest.ToULong(&keepCount) || count + keepCount > dialogues.size())
+					break;
+				recordDialogues.insert(recordDialogues.end(),
+					dialogues.begin() + count, dialogues.begin() + count + keepCount);
+				pos++;
+			}
+			else if (readNumber(L"Lines: ", &count)){
+				pos++;
+				bool linesValid = true;
+				for (unsigned long i = 0; i < count; i++){
+					unsigned long rawLines;
+					if (pos >= numLines || !lines[pos].ToULong(&rawLines)){
+						linesValid = false;
+						break;
+					}
+					pos++;
+					wxString raw;
+					if (!readLines(rawLines, &raw)){
+						linesValid = false;
+						break;
+					}
+					recordDialogues.push_back(raw);
+				}
+				if (!linesValid)
+					break;
+			}
+			else{
+				break;
+			}
+		}
+		//broken record, previous one is the last that can be restored
+		if (!valid)
+			break;
+
+		header = recordHeader;
+		dialogues.swap(recordDialogues);
+		hasRecord = true;
+	}
+	if (!hasRecord)
+		return false;
+
+	text->Empty();
+	*text << header;
+	for (auto &dialogue : dialogues){
+		*text << dialogue;
+	}
+	return true;
+}
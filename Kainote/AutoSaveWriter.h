@@ -0,0 +1,122 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "SubsFile.h"
+#include "AutoSaveLines.h"
+#include <wx/string.h>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+class OpenWrite;
+
+//after this number of appended autosaves journal is written from begining to new file
+#define AUTOSAVE_JOURNAL_MAX_RECORDS 64
+
+//everything that raw line of dialogue depends on, the same key means the same raw line.
+//Versions of texts change with every change of text, so texts are not compared
+struct AutoSaveLineKey
+{
+	const Dialogue *dial;
+	size_t textVersions[5];
+	int start, end, startFrame, endFrame, layer;
+	//position is used only in SRT where raw line has its number
+	size_t position;
+	short marginL, marginR, marginV;
+	char format, state, treeState;
+	bool nonDialogue, isComment;
+	bool operator ==(const AutoSaveLineKey &key) const;
+	const void *GetId() const{ return dial; }
+};
+
+//everything that autosave needs, taken on UI thread,
+//autosave thread doesn't touch dialogues which can be changed in place by UI
+struct AutoSaveData
+{
+	//chunks with raw text of every dialogue made by GetLines
+	std::vector<AutoSaveChunk> chunks;
+	//script info and styles, empty in other formats than ASS
+	wxString header;
+	wxString tlStyle;
+	//path without number and extension
+	wxString baseName;
+	//empty when lines are appended to last journal
+	wxString path;
+	char subsFormat = ASS;
+	bool tlmodeOn = false;
+	bool translated = false;
+	bool showOriginalOnVideo = true;
+	size_t GetLinesCount() const{ return chunks.empty() ? 0 : chunks.back().start + chunks.back().size; }
+};
+
+//writes autosaves on its own thread, UI thread only makes raw lines and header.
+//Raw lines are kept from the previous autosave, UI thread formats only changed lines.
+//Journal contains records of autosaves, every record has only chunks of dialogues
+//changed since previous record, other chunks are copied from it by "Keep" entries.
+//Chunk is kept only when it has the same lines like in previous record,
+//tree state or editing state of line can be changed without copy of chunk.
+//Record is valid when it ends with "End" line, broken record at the end of file is skipped.
+class AutoSaveWriter
+{
+public:
+	AutoSaveWriter(){};
+	~AutoSaveWriter();
+	bool IsWorking(){ return working.load(std::memory_order_acquire); }
+	//call only when it's not working, checks if journal has to be written to new file
+	bool NeedsNewJournal(SubsFile *file, const AutoSaveData &data);
+	//makes raw lines of current history step, call it on UI thread before Start,
+	//lines that were not changed since previous call are taken from it
+	void GetLines(File *subs, AutoSaveData *data);
+	//takes data and deletes it when it's not needed
+	void Start(SubsFile *file, AutoSaveData *data, bool journal);
+	//waits for thread and releases last journal record,
+	//has to be called before file is deleted
+	void Stop();
+	//converts journal to subtitles text, returns false when it has no valid record
+	static bool ReadJournal(const wxString &path, wxString *text);
+private:
+	void Write(SubsFile *file, AutoSaveData *data, bool journal);
+	//returns number of written dialogues
+	size_t WriteRecord(OpenWrite &ow, AutoSaveData *data, AutoSaveData *previous);
+	static void GetRawLine(Dialogue *dial, size_t i, wxString &raw, const AutoSaveData *data);
+	static void GetLineKey(Dialogue *dial, size_t i, AutoSaveLineKey *key, const AutoSaveData *data);
+	static size_t CountLines(const wxString &text);
+
+	std::thread thread;
+	std::atomic<bool> working{ false };
+	//used only on UI thread, lines are formatted with options of the previous autosave
+	AutoSaveLinesCache<AutoSaveLineKey> linesCache;
+	wxString linesTlStyle;
+	char linesSubsFormat = ASS;
+	bool linesTlmodeOn = false;
+	bool linesTranslated = false;
+	bool linesShowOriginal = true;
+	//last journal record, all fields are used only when thread is not working
+	SubsFile *journalFile = nullptr;
+	AutoSaveData *journalRecord = nullptr;
+	wxString journalPath;
+	wxString journalBaseName;
+	wxString journalHeader;
+	wxString journalTlStyle;
+	bool journalTlmodeOn = false;
+	bool journalTranslated = false;
+	bool journalShowOriginal = true;
+	int journalRecords = 0;
+	//dialogues written since journal start
+	size_t journalLines = 0;
+	bool journalFailed = false;
+};
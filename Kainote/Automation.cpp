@@ -817,6 +817,10 @@ namespace Auto{
 		ps->ShowDialog(StrDisplay());
 		wxThread::ExitCode code = call.Wait();
 		bool failed = (int)code == 1;
+		//dialogues inserted by macro are put to file before it's used
+		subsobj->FlushPendingDialogues();
+		//macro changes file outside of SubsFile
+		c->grid->file->InvalidateIndexes();
 
 		if (ps->lpd->cancelled || failed){
 			SAFE_DELETE(subsobj);
@@ -63,6 +63,11 @@ namespace Auto{
 
 	AutoToFile::~AutoToFile()
 	{
+		FlushPendingDialogues();
+		if (linesCacheRef != LUA_NOREF){
+			luaL_unref(L, LUA_REGISTRYINDEX, linesCacheRef);
+			linesCacheRef = LUA_NOREF;
+		}
 		if (spectrum){
 			delete spectrum;
 			spectrum = NULL;
@@ -77,6 +82,148 @@ namespace Auto{
 		lua_error(L);
 	}
 
+	size_t AutoToFile::DialoguesCount(File *Subs)
+	{
+		return Subs->dialogues.size() + laf->pendingDialogues.size();
+	}
+
+	Dialogue *AutoToFile::GetDialogue(File *Subs, size_t i)
+	{
+		size_t pendingSize = laf->pendingDialogues.size();
+		if (i < laf->pendingPosition || !pendingSize)
+			return Subs->dialogues[i];
+		if (i < laf->pendingPosition + pendingSize)
+			return laf->pendingDialogues[i - laf->pendingPosition];
+		return Subs->dialogues[i - pendingSize];
+	}
+
+	void AutoToFile::InsertDialogue(File *Subs, size_t i, Dialogue *dial)
+	{
+		if (pendingDialogues.size() && i == pendingPosition + pendingDialogues.size()){
+			pendingDialogues.push_back(dial);
+			return;
+		}
+		FlushPendingDialogues();
+		if (i >= Subs->dialogues.size()){
+			Subs->dialogues.push_back(dial);
+			return;
+		}
+		pendingPosition = i;
+		pendingDialogues.push_back(dial);
+	}
+
+	void AutoToFile::FlushPendingDialogues()
+	{
+		if (pendingDialogues.empty())
+			return;
+
+		file->dialogues.insert(file->dialogues.begin() + pendingPosition, pendingDialogues.begin(), pendingDialogues.end());
+		pendingDialogues.clear();
+	}
+
+	//removes sorted ids from table in one pass, offset is id of first element
+	template<typename T>
+	static void EraseIds(std::vector<T> &table, std::vector<int>::const_iterator first, 
+		std::vector<int>::const_iterator last, int offset)
+	{
+		if (first == last)
+			return;
+		size_t write = *first - offset;
+		for (size_t read = write; read < table.size(); read++){
+			if (first != last && *first - offset == read){
+				first++;
+				continue;
+			}
+			table[write++] = table[read];
+		}
+		table.resize(write);
+	}
+
+	void AutoToFile::DeleteLines(File *Subs, const std::vector<int> &ids)
+	{
+		int sinfo = Subs->sinfo.size();
+		int styles = sinfo + Subs->styles.size();
+		auto firstStyle = std::lower_bound(ids.begin(), ids.end(), sinfo);
+		auto firstDialogue = std::lower_bound(firstStyle, ids.end(), styles);
+		EraseIds(Subs->sinfo, ids.begin(), firstStyle, 0);
+		EraseIds(Subs->styles, firstStyle, firstDialogue, sinfo);
+		if (firstDialogue == ids.end())
+			return;
+
+		//ranges of following ids
+		std::vector<std::pair<int, int>> ranges;
+		for (auto it = firstDialogue; it != ids.end(); it++){
+			int id = *it - styles;
+			if (ranges.size() && ranges.back().second == id)
+				ranges.back().second++;
+			else
+				ranges.push_back(std::make_pair(id, id + 1));
+		}
+		//a few ranges are erased from chunks, unchanged chunks are still shared with undo history
+		//otherwise whole table is compacted at once
+		if (ranges.size() * ChunkedArray<Dialogue*>::CHUNK_SIZE < Subs->dialogues.size()){
+			for (size_t i = ranges.size(); i-- > 0;){
+				Subs->dialogues.erase(Subs->dialogues.begin() + ranges[i].first, Subs->dialogues.begin() + ranges[i].second);
+			}
+		}
+		else{
+			std::vector<Dialogue*> dialogues;
+			Subs->dialogues.ToVector(&dialogues);
+			EraseIds(dialogues, firstDialogue, ids.end(), styles);
+			Subs->dialogues.Assign(dialogues);
+		}
+	}
+
+	//copies fields of table at index, nested tables are new and empty
+	static void CopyLineTable(lua_State *L, int index)
+	{
+		if (index < 0)
+			index = lua_gettop(L) + index + 1;
+		lua_newtable(L);
+		lua_pushnil(L);
+		while (lua_next(L, index)){
+			if (lua_istable(L, -1)){
+				lua_pop(L, 1);
+				lua_newtable(L);
+			}
+			lua_pushvalue(L, -2);
+			lua_insert(L, -2);
+			lua_settable(L, -4);
+		}
+	}
+
+	bool AutoToFile::PushCachedLine(lua_State *L, Dialogue *dial)
+	{
+		if (linesCacheRef == LUA_NOREF)
+			return false;
+
+		lua_rawgeti(L, LUA_REGISTRYINDEX, linesCacheRef);
+		lua_pushlightuserdata(L, dial);
+		lua_rawget(L, -2);
+		if (!lua_istable(L, -1)){
+			lua_pop(L, 2);
+			return false;
+		}
+		//script can change returned table, cached one stays untouched
+		CopyLineTable(L, -1);
+		lua_replace(L, -3);
+		lua_pop(L, 1);
+		return true;
+	}
+
+	void AutoToFile::CacheLine(lua_State *L, Dialogue *dial)
+	{
+		if (linesCacheRef == LUA_NOREF){
+			lua_newtable(L);
+			linesCacheRef = luaL_ref(L, LUA_REGISTRYINDEX);
+		}
+		lua_rawgeti(L, LUA_REGISTRYINDEX, linesCacheRef);
+		lua_pushlightuserdata(L, dial);
+		CopyLineTable(L, -3);
+		lua_rawset(L, -3);
+		lua_pop(L, 1);
+	}
+
 
 
 
@@ -89,10 +236,16 @@ namespace Auto{
 		}
 		int sinfo = Subs->sinfo.size();
 		int styles = sinfo + Subs->styles.size();
-		int dials = styles + Subs->dialogues.size();
+		int dials = styles + DialoguesCount(Subs);
 		if (i < 0 || i >= dials){
 			return false;
 		}
+		Dialogue *cachedDialogue = NULL;
+		if (i >= styles){
+			cachedDialogue = GetDialogue(Subs, i - styles);
+			if (laf->PushCachedLine(L, cachedDialogue))
+				return true;
+		}
 
 		lua_newtable(L);
 		if (i < sinfo){
@@ -198,7 +351,7 @@ namespace Auto{
 		else if (i < dials)
 		{
 			//to jest odczyt więc nie kopiujemy
-			Dialogue *adial = Subs->dialogues[i - styles];
+			Dialogue *adial = cachedDialogue;
 
 			lua_pushstring(L, "[Events]");
 			lua_setfield(L, -2, "section");
@@ -220,9 +373,9 @@ namespace Auto{
 			lua_pushnumber(L, adial->End.mstime);
 			lua_setfield(L, -2, "end_time");
 
-			lua_pushstring(L, adial->Style->mb_str(wxConvUTF8).data());
+			lua_pushstring(L, adial->Style.Get().mb_str(wxConvUTF8).data());
 			lua_setfield(L, -2, "style");
-			lua_pushstring(L, adial->Actor->mb_str(wxConvUTF8).data());
+			lua_pushstring(L, adial->Actor.Get().mb_str(wxConvUTF8).data());
 			lua_setfield(L, -2, "actor");
 
 			lua_pushnumber(L, (int)adial->MarginL);
@@ -234,13 +387,13 @@ namespace Auto{
 			lua_pushnumber(L, (int)adial->MarginV);
 			lua_setfield(L, -2, "margin_b");
 
-			lua_pushstring(L, adial->Effect->mb_str(wxConvUTF8).data());
+			lua_pushstring(L, adial->Effect.Get().mb_str(wxConvUTF8).data());
 			lua_setfield(L, -2, "effect");
 
 			bool isTl = false;
 			const char * text = (isTl = adial->TextTl != L"") ? 
-				adial->TextTl->mb_str(wxConvUTF8).data() : 
-				adial->Text->mb_str(wxConvUTF8).data();
+				adial->TextTl.Get().mb_str(wxConvUTF8).data() : 
+				adial->Text.Get().mb_str(wxConvUTF8).data();
 			lua_pushstring(L, text);
 			lua_setfield(L, -2, "text");
 
@@ -255,6 +408,8 @@ namespace Auto{
 
 
 		lua_setfield(L, -2, "class");
+		if (cachedDialogue)
+			laf->CacheLine(L, cachedDialogue);
 		return true;
 	}
 
@@ -469,7 +624,7 @@ namespace Auto{
 
 			if (strcmp(idx, "n") == 0) {
 				// get number of items
-				lua_pushnumber(L, Subs->dialogues.size() + Subs->sinfo.size() + Subs->styles.size());
+				lua_pushnumber(L, DialoguesCount(Subs) + Subs->sinfo.size() + Subs->styles.size());
 				return 1;
 
 			}
@@ -578,6 +733,7 @@ namespace Auto{
 				// insert
 				SubsEntry *e = LuaToLine(L);
 				if (!e){ return 0; }
+				laf->FlushPendingDialogues();
 				int i = n - 1;
 				int sinfo = Subs->sinfo.size();
 				int styles = sinfo + Subs->styles.size();
@@ -640,7 +796,7 @@ namespace Auto{
 			return 0;
 		}
 
-		lua_pushnumber(L, Subs->dialogues.size() + Subs->sinfo.size() + Subs->styles.size());
+		lua_pushnumber(L, DialoguesCount(Subs) + Subs->sinfo.size() + Subs->styles.size());
 		return 1;
 	}
 
@@ -652,7 +808,7 @@ namespace Auto{
 		}
 		lua_pushinteger(L, (int)Subs->sinfo.size());
 		lua_pushinteger(L, (int)Subs->styles.size());
-		lua_pushinteger(L, (int)Subs->dialogues.size());
+		lua_pushinteger(L, (int)DialoguesCount(Subs));
 
 		return 3;
 	}
@@ -664,6 +820,7 @@ namespace Auto{
 			return 0;
 		}
 		laf->CheckAllowModify();
+		laf->FlushPendingDialogues();
 
 		// get number of items to delete
 		int itemcount = lua_gettop(L);
@@ -698,19 +855,8 @@ namespace Auto{
 			}
 		}
 		std::sort(ids.begin(), ids.end());
-
-		for (int i = ids.size() - 1; i >= 0; i--)
-		{
-			if (ids[i] < sinfo){
-				Subs->sinfo.erase(Subs->sinfo.begin() + ids[i]);
-			}
-			else if (ids[i] < styles){
-				Subs->styles.erase(Subs->styles.begin() + (ids[i] - sinfo));
-			}
-			else if (ids[i] < dials){
-				Subs->dialogues.erase(Subs->dialogues.begin() + (ids[i] - styles));
-			}
-		}
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		DeleteLines(Subs, ids);
 
 		return 0;
 	}
@@ -729,6 +875,7 @@ namespace Auto{
 			return 0;
 		}
 
+		laf->FlushPendingDialogues();
 		int a = lua_tointeger(L, 1), b = lua_tointeger(L, 2);
 		int sinfo = Subs->sinfo.size();
 		int styles = sinfo + Subs->styles.size();
@@ -741,19 +888,13 @@ namespace Auto{
 		if (b < a) return 0;
 		a--; b--;
 
-
-
-		for (int i = b; i >= a; i--){
-			if (i < sinfo){
-				Subs->sinfo.erase(Subs->sinfo.begin() + i);
-			}
-			else if (i < styles){
-				Subs->styles.erase(Subs->styles.begin() + (i - sinfo));
-			}
-			else{
-				Subs->dialogues.erase(Subs->dialogues.begin() + (i - styles));
-			}
-		}
+		//every table is erased at once
+		if (b >= styles)
+			Subs->dialogues.erase(Subs->dialogues.begin() + ((std::max)(a, styles) - styles), Subs->dialogues.begin() + ((std::min)(b, dials - 1) - styles + 1));
+		if (a < styles && b >= sinfo)
+			Subs->styles.erase(Subs->styles.begin() + ((std::max)(a, sinfo) - sinfo), Subs->styles.begin() + ((std::min)(b, styles - 1) - sinfo + 1));
+		if (a < sinfo)
+			Subs->sinfo.erase(Subs->sinfo.begin() + a, Subs->sinfo.begin() + (std::min)(b, sinfo - 1) + 1);
 		return 0;
 	}
 
@@ -786,7 +927,11 @@ namespace Auto{
 			if (e->lclass == L"dialogue"){
 				Dialogue *dial = e->adial->Copy();
 				Subs->deleteDialogues.push_back(dial);
-				Subs->dialogues.push_back(dial);
+				//lines inserted at the end are still the last ones
+				if (laf->pendingDialogues.size() && laf->pendingPosition == Subs->dialogues.size())
+					laf->pendingDialogues.push_back(dial);
+				else
+					Subs->dialogues.push_back(dial);
 			}
 			SAFE_DELETE(e);
 		}
@@ -812,7 +957,7 @@ namespace Auto{
 
 		int start = int(lua_tonumber(L, 1) - 1);
 
-		if (start<0 || start>(int)(Subs->sinfo.size() + Subs->styles.size() + Subs->dialogues.size()))
+		if (start<0 || start>(int)(Subs->sinfo.size() + Subs->styles.size() + DialoguesCount(Subs)))
 		{
 			lua_pushstring(L, "Out of range line index");
 			lua_error(L);
@@ -827,8 +972,7 @@ namespace Auto{
 			int sinfo = Subs->sinfo.size();
 			int stylsize = Subs->styles.size();
 			int styles = sinfo + stylsize;
-			int dialsize = Subs->dialogues.size();
-			int dials = styles + dialsize;
+			int dialsize = DialoguesCount(Subs);
 
 			if (e->lclass == L"info")
 			{
@@ -851,8 +995,7 @@ namespace Auto{
 				int newStart = start - styles;
 				if (newStart < 0) { newStart = 0; }
 				Dialogue *dial = e->adial->Copy(false, newStart >= dialsize);
-				if (newStart >= dialsize){ Subs->dialogues.push_back(dial); }
-				else{ Subs->dialogues.insert(Subs->dialogues.begin() + newStart, dial); }
+				laf->InsertDialogue(Subs, newStart, dial);
 				Subs->deleteDialogues.push_back(dial);
 			}
 			else{
@@ -965,7 +1108,7 @@ namespace Auto{
 			set_field(L, "start_time", e->adial->Start.mstime);
 			set_field(L, "end_time", e->adial->End.mstime);
 			set_field(L, "tag", "k");
-			set_field(L, "text", e->adial->Text->mb_str(wxConvUTF8).data());
+			set_field(L, "text", e->adial->Text.Get().mb_str(wxConvUTF8).data());
 			set_field(L, "text_stripped", ktext_stripped.mb_str(wxConvUTF8).data());
 			lua_rawseti(L, -2, kcount++);
 		}
@@ -990,7 +1133,7 @@ namespace Auto{
 			return 0;
 		}
 		size_t i = check_uint(L, 2);
-		if (i >= Subs->dialogues.size() + Subs->sinfo.size() + Subs->styles.size()) {
+		if (i >= DialoguesCount(Subs) + Subs->sinfo.size() + Subs->styles.size()) {
 			lua_pushnil(L);
 			return 1;
 		}
@@ -1000,6 +1143,12 @@ namespace Auto{
 		return 2;
 	}
 
+	int AutoToFile::LuaSetUndoPoint(lua_State *L)
+	{
+		laf->FlushPendingDialogues();
+		return 0;
+	}
+
 	int AutoToFile::LuaGetScriptResolution(lua_State *L)
 	{
 		int w, h;
@@ -59,6 +59,8 @@ namespace Auto{
 		static bool LineToLua(lua_State *L, int i); 
 		static SubsEntry *LuaToLine(lua_State *L);
 		void Cancel();
+		//puts inserted dialogues to file, has to be called before file is used outside of macro
+		void FlushPendingDialogues();
 	
 	private:
 		File *file;
@@ -69,6 +71,21 @@ namespace Auto{
 		char subsFormat = ASS;
 		void CheckAllowModify(); // throws an error if modification is disallowed
 
+		//dialogues inserted one after another are kept here and put to file at once
+		//pendingPosition is index in dialogues table where they will be inserted
+		std::vector<Dialogue*> pendingDialogues;
+		size_t pendingPosition = 0;
+		//registry reference to table of dialogues converted to lua, keys are dialogue pointers
+		//dialogues are never changed in place while macro runs, every change makes a new copy
+		int linesCacheRef = LUA_NOREF;
+		static size_t DialoguesCount(File *Subs);
+		static Dialogue *GetDialogue(File *Subs, size_t i);
+		void InsertDialogue(File *Subs, size_t i, Dialogue *dial);
+		//ids have to be sorted and unique
+		static void DeleteLines(File *Subs, const std::vector<int> &ids);
+		bool PushCachedLine(lua_State *L, Dialogue *dial);
+		void CacheLine(lua_State *L, Dialogue *dial);
+
 			// keep a cursor of last accessed item to avoid walking over the entire file on every access
 		//void InitScriptInfoIfNeeded();
 
@@ -86,7 +103,7 @@ namespace Auto{
 
 		static int LuaParseKaraokeData(lua_State *L);
 		static int LuaGetScriptResolution(lua_State *L);
-		static int LuaSetUndoPoint(lua_State *L) {return 0;};
+		static int LuaSetUndoPoint(lua_State *L);
 		//static int LuaGenerateFFT(lua_State *L);
 		static int LuaGetFreqencyReach(lua_State *L);
 		static File* GetSubs(lua_State* L);
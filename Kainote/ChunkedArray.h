@@ -0,0 +1,352 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <iterator>
+#include <algorithm>
+
+//Array of small values (pointers) divided into chunks shared between copies.
+//Copy of array copies only chunk pointers, change of element copies only chunk
+//that contains it and is used by other copy (copy on write).
+//It's made for undo history where every history step was a copy of the whole table.
+//Interface is similar to std::vector, but non const operator[] returns proxy
+//and iterators are read only, for sorting use ToVector and Assign.
+template<typename T>
+class ChunkedArray
+{
+	typedef std::vector<T> Chunk;
+	typedef std::shared_ptr<Chunk> ChunkPtr;
+public:
+	//appended elements fill chunks up to this size,
+	//inserted elements can grow chunk up to twice of this size before it's splitted
+	static constexpr size_t CHUNK_SIZE = 256;
+
+	class reference
+	{
+		friend class ChunkedArray;
+		ChunkedArray *owner;
+		size_t index;
+		reference(ChunkedArray *_owner, size_t _index) : owner(_owner), index(_index){}
+	public:
+		operator T() const{ return owner->Get(index); }
+		T operator->() const{ return owner->Get(index); }
+		reference &operator=(const T &value){ owner->Set(index, value); return *this; }
+		reference &operator=(const reference &ref){ owner->Set(index, ref.owner->Get(ref.index)); return *this; }
+	};
+
+	class const_iterator
+	{
+		friend class ChunkedArray;
+		const ChunkedArray *owner = nullptr;
+		size_t index = 0;
+		size_t chunk = 0;
+		size_t offset = 0;
+		const_iterator(const ChunkedArray *_owner, size_t _index) : owner(_owner), index(_index){ Locate(); }
+		void Locate(){
+			if (index < owner->count){
+				chunk = owner->FindChunk(index);
+				offset = index - owner->starts[chunk];
+			}
+			else{
+				chunk = owner->chunks.size();
+				offset = 0;
+			}
+		}
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const T *pointer;
+		typedef T reference;
+
+		const_iterator(){}
+		T operator*() const{ return (*owner->chunks[chunk])[offset]; }
+		T operator[](difference_type n) const{ return owner->Get(index + n); }
+		const_iterator &operator++(){
+			index++;
+			offset++;
+			if (chunk < owner->chunks.size() && offset >= owner->chunks[chunk]->size()){
+				chunk++;
+				offset = 0;
+			}
+			return *this;
+		}
+		const_iterator operator++(int){ const_iterator tmp = *this; ++(*this); return tmp; }
+		const_iterator &operator--(){
+			index--;
+			if (offset > 0 && chunk < owner->chunks.size()){
+				offset--;
+			}
+			else{
+				Locate();
+			}
+			return *this;
+		}
+		const_iterator operator--(int){ const_iterator tmp = *this; --(*this); return tmp; }
+		const_iterator &operator+=(difference_type n){ index += n; Locate(); return *this; }
+		const_iterator &operator-=(difference_type n){ index -= n; Locate(); return *this; }
+		const_iterator operator+(difference_type n) const{ const_iterator tmp = *this; return tmp += n; }
+		const_iterator operator-(difference_type n) const{ const_iterator tmp = *this; return tmp -= n; }
+		difference_type operator-(const const_iterator &it) const{ return (difference_type)index - (difference_type)it.index; }
+		bool operator==(const const_iterator &it) const{ return index == it.index; }
+		bool operator!=(const const_iterator &it) const{ return index != it.index; }
+		bool operator<(const const_iterator &it) const{ return index < it.index; }
+		bool operator>(const const_iterator &it) const{ return index > it.index; }
+		bool operator<=(const const_iterator &it) const{ return index <= it.index; }
+		bool operator>=(const const_iterator &it) const{ return index >= it.index; }
+		size_t GetIndex() const{ return index; }
+	};
+	typedef const_iterator iterator;
+
+	ChunkedArray(){}
+	ChunkedArray(const ChunkedArray &ca){ *this = ca; }
+	ChunkedArray &operator=(const ChunkedArray &ca){
+		chunks = ca.chunks;
+		starts = ca.starts;
+		count = ca.count;
+		lastChunk = 0;
+		return *this;
+	}
+
+	size_t size() const{ return count; }
+	bool empty() const{ return count == 0; }
+	T operator[](size_t i) const{ return Get(i); }
+	reference operator[](size_t i){ return reference(this, i); }
+	T front() const{ return Get(0); }
+	T back() const{ return Get(count - 1); }
+	const_iterator begin() const{ return const_iterator(this, 0); }
+	const_iterator end() const{ return const_iterator(this, count); }
+
+	T Get(size_t i) const{
+		size_t c = FindChunk(i);
+		return (*chunks[c])[i - starts[c]];
+	}
+	void Set(size_t i, const T &value){
+		size_t c = FindChunk(i);
+		Detach(c);
+		(*chunks[c])[i - starts[c]] = value;
+	}
+	void push_back(const T &value){
+		if (chunks.empty() || chunks.back()->size() >= CHUNK_SIZE){
+			ChunkPtr chunk = std::make_shared<Chunk>();
+			chunk->reserve(CHUNK_SIZE);
+			starts.push_back(count);
+			chunks.push_back(chunk);
+		}
+		else{
+			Detach(chunks.size() - 1);
+		}
+		chunks.back()->push_back(value);
+		count++;
+	}
+	void insert(const_iterator pos, const T &value){
+		InsertRange(pos.index, &value, &value + 1);
+	}
+	void insert(const_iterator pos, size_t num, const T &value){
+		if (!num)
+			return;
+		std::vector<T> values(num, value);
+		InsertRange(pos.index, values.begin(), values.end());
+	}
+	template<typename InputIt>
+	void insert(const_iterator pos, InputIt first, InputIt last){
+		InsertRange(pos.index, first, last);
+	}
+	void erase(const_iterator pos){
+		Erase(pos.index, pos.index + 1);
+	}
+	void erase(const_iterator first, const_iterator last){
+		Erase(first.index, last.index);
+	}
+	void clear(){
+		chunks.clear();
+		starts.clear();
+		count = 0;
+		lastChunk = 0;
+	}
+	//Copies all elements to vector, for operations that need random access iterators like sort
+	void ToVector(std::vector<T> *table) const{
+		table->clear();
+		table->reserve(count);
+		for (size_t i = 0; i < chunks.size(); i++){
+			table->insert(table->end(), chunks[i]->begin(), chunks[i]->end());
+		}
+	}
+	//Replaces all elements, old chunks stays untouched for other copies
+	void Assign(const std::vector<T> &table){
+		clear();
+		InsertRange(0, table.begin(), table.end());
+	}
+	//Estimated memory used by this copy, chunks shared with other copies are divided by number of owners
+	size_t GetMemoryUsage() const{
+		size_t usage = sizeof(ChunkedArray) + chunks.capacity() * sizeof(ChunkPtr) + starts.capacity() * sizeof(size_t);
+		for (size_t i = 0; i < chunks.size(); i++){
+			size_t owners = chunks[i].use_count();
+			usage += (sizeof(Chunk) + chunks[i]->capacity() * sizeof(T)) / (owners ? owners : 1);
+		}
+		return usage;
+	}
+	//Returns true when chunk of element i is used by other copy
+	bool IsShared(size_t i) const{
+		return chunks[FindChunk(i)].use_count() > 1;
+	}
+	//shared chunks are never changed, the same chunk id in two copies means the same elements
+	size_t GetChunksCount() const{ return chunks.size(); }
+	const void *GetChunkId(size_t c) const{ return chunks[c].get(); }
+	size_t GetChunkStart(size_t c) const{ return starts[c]; }
+	size_t GetChunkSize(size_t c) const{ return chunks[c]->size(); }
+
+private:
+	std::vector<ChunkPtr> chunks;
+	//index of first element of every chunk
+	std::vector<size_t> starts;
+	size_t count = 0;
+	//last found chunk, most of the loops read elements one after another
+	mutable std::atomic<size_t> lastChunk{ 0 };
+
+	size_t FindChunk(size_t i) const{
+		size_t last = lastChunk.load(std::memory_order_relaxed);
+		if (last < chunks.size()){
+			if (i >= starts[last] && i < starts[last] + chunks[last]->size())
+				return last;
+			last++;
+			if (last < chunks.size() && i >= starts[last] && i < starts[last] + chunks[last]->size()){
+				lastChunk.store(last, std::memory_order_relaxed);
+				return last;
+			}
+		}
+		size_t found = (std::upper_bound(starts.begin(), starts.end(), i) - starts.begin()) - 1;
+		lastChunk.store(found, std::memory_order_relaxed);
+		return found;
+	}
+	void Detach(size_t c){
+		if (chunks[c].use_count() > 1){
+			ChunkPtr copy = std::make_shared<Chunk>();
+			copy->reserve((std::max)(chunks[c]->size(), CHUNK_SIZE));
+			copy->assign(chunks[c]->begin(), chunks[c]->end());
+			chunks[c] = copy;
+		}
+	}
+	void UpdateStarts(size_t from){
+		starts.resize(chunks.size());
+		if (from > chunks.size())
+			from = chunks.size();
+		size_t start = (from > 0) ? starts[from - 1] + chunks[from - 1]->size() : 0;
+		for (size_t i = from; i < chunks.size(); i++){
+			starts[i] = start;
+			start += chunks[i]->size();
+		}
+		count = start;
+	}
+	//splits elements to chunks of similar size, not bigger than CHUNK_SIZE
+	void MakeChunks(const std::vector<T> &elements, std::vector<ChunkPtr> *result){
+		size_t total = elements.size();
+		if (!total)
+			return;
+		if (total <= CHUNK_SIZE * 2){
+			ChunkPtr chunk = std::make_shared<Chunk>();
+			chunk->reserve((std::max)(total, CHUNK_SIZE));
+			chunk->assign(elements.begin(), elements.end());
+			result->push_back(chunk);
+			return;
+		}
+		size_t numChunks = (total + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		size_t pos = 0;
+		for (size_t i = 0; i < numChunks; i++){
+			size_t chunkSize = (total - pos) / (numChunks - i);
+			ChunkPtr chunk = std::make_shared<Chunk>();
+			chunk->reserve(CHUNK_SIZE);
+			chunk->assign(elements.begin() + pos, elements.begin() + pos + chunkSize);
+			result->push_back(chunk);
+			pos += chunkSize;
+		}
+	}
+	template<typename InputIt>
+	void InsertRange(size_t pos, InputIt first, InputIt last){
+		if (first == last)
+			return;
+		if (pos > count)
+			pos = count;
+		size_t c;
+		size_t offset;
+		if (chunks.empty()){
+			c = 0;
+			offset = 0;
+		}
+		else if (pos == count){
+			c = chunks.size() - 1;
+			offset = chunks[c]->size();
+		}
+		else{
+			c = FindChunk(pos);
+			offset = pos - starts[c];
+		}
+		std::vector<T> elements;
+		if (!chunks.empty()){
+			Chunk &chunk = *chunks[c];
+			elements.reserve(chunk.size() + std::distance(first, last));
+			elements.insert(elements.end(), chunk.begin(), chunk.begin() + offset);
+			elements.insert(elements.end(), first, last);
+			elements.insert(elements.end(), chunk.begin() + offset, chunk.end());
+		}
+		else{
+			elements.assign(first, last);
+		}
+		std::vector<ChunkPtr> newChunks;
+		MakeChunks(elements, &newChunks);
+		if (!chunks.empty())
+			chunks.erase(chunks.begin() + c);
+		chunks.insert(chunks.begin() + c, newChunks.begin(), newChunks.end());
+		UpdateStarts(c);
+	}
+	void Erase(size_t from, size_t to){
+		if (to > count)
+			to = count;
+		if (from >= to)
+			return;
+		size_t firstChunk = FindChunk(from);
+		size_t lastChunkToErase = FindChunk(to - 1);
+		//from last to first, starts of chunks before erased one stays valid
+		for (size_t c = lastChunkToErase + 1; c-- > firstChunk;){
+			size_t chunkStart = starts[c];
+			size_t chunkSize = chunks[c]->size();
+			size_t eraseFrom = (from > chunkStart) ? from - chunkStart : 0;
+			size_t eraseTo = (std::min)(to - chunkStart, chunkSize);
+			if (eraseFrom == 0 && eraseTo == chunkSize){
+				chunks.erase(chunks.begin() + c);
+			}
+			else{
+				Detach(c);
+				chunks[c]->erase(chunks[c]->begin() + eraseFrom, chunks[c]->begin() + eraseTo);
+			}
+		}
+		//merge small chunk with neighbour to avoid fragmentation
+		if (firstChunk > 0)
+			firstChunk--;
+		for (size_t k = firstChunk; k < firstChunk + 2 && k + 1 < chunks.size(); k++){
+			if (chunks[k]->size() + chunks[k + 1]->size() <= CHUNK_SIZE){
+				Detach(k);
+				chunks[k]->insert(chunks[k]->end(), chunks[k + 1]->begin(), chunks[k + 1]->end());
+				chunks.erase(chunks.begin() + k + 1);
+				break;
+			}
+		}
+		UpdateStarts(0);
+	}
+};
@@ -0,0 +1,87 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+//functions with SIMD kernels are marked with instruction set they use,
+//GCC and Clang compile them for it without flags for whole file, MSVC allows intrinsics everywhere
+#ifdef _MSC_VER
+#define CPU_TARGET_SSE2
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_SSE2 __attribute__((target("sse2")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+inline void CpuId(int info[4], int leaf, int subleaf = 0)
+{
+#ifdef _MSC_VER
+	__cpuidex(info, leaf, subleaf);
+#else
+	unsigned int eax, ebx, ecx, edx;
+	__cpuid_count(leaf, subleaf, eax, ebx, ecx, edx);
+	info[0] = (int)eax;
+	info[1] = (int)ebx;
+	info[2] = (int)ecx;
+	info[3] = (int)edx;
+#endif
+}
+
+//extended control register 0, bits of registers saved by system
+inline unsigned long long CpuXCR0()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+//instruction sets checked before SIMD kernels are chosen, callers keep the result
+inline bool CpuHasSSE2()
+{
+	int info[4];
+	CpuId(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+}
+
+inline bool CpuHasAVX2()
+{
+	int info[4];
+	CpuId(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	//AVX and OSXSAVE, system have to save YMM registers too
+	CpuId(info, 1);
+	const int avxBits = (1 << 27) | (1 << 28);
+	if ((info[2] & avxBits) != avxBits)
+		return false;
+
+	if ((CpuXCR0() & 6) != 6)
+		return false;
+
+	CpuId(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
@@ -25,11 +25,18 @@
 
 Demux::~Demux()
 {
-	if (indexer)
-		Close();
+	Close();
 }
 
 bool Demux::Open(const wxString& filename)
+{
+	if (reader.Open(filename))
+		return true;
+
+	return OpenFFMS2(filename);
+}
+
+bool Demux::OpenFFMS2(const wxString& filename)
 {
 	FFMS_Init(0, 1);
 	char errmsg[1024];
@@ -48,12 +55,12 @@ bool Demux::Open(const wxString& filename)
 
 void Demux::Close()
 {
-	if (attachments.size()) {
-		for (auto attachment : attachments) {
-			FFMS_FreeAttachment(&attachment);
-		}
-		attachments.clear();
+	fonts.clear();
+	reader.Close();
+	for (auto attachment : attachments) {
+		FFMS_FreeAttachment(&attachment);
 	}
+	attachments.clear();
 
 	if (indexer) {
 		FFMS_CancelIndexing(indexer);
@@ -61,34 +68,68 @@ void Demux::Close()
 	}
 }
 
+//returns name of codec the same like in FFMS2 or empty string when it's not supported
+static wxString GetCodecName(const wxString& codecID)
+{
+	if (codecID == L"S_TEXT/ASS" || codecID == L"S_ASS")
+		return L"ass";
+	if (codecID == L"S_TEXT/SSA" || codecID == L"S_SSA")
+		return L"ssa";
+	if (codecID == L"S_TEXT/UTF8")
+		return L"subrip";
+	if (codecID == L"S_TEXT/ASCII")
+		return L"text";
+	return emptyString;
+}
+
 bool Demux::GetSubtitles(SubsGrid* target)
 {
-	int numTracks = FFMS_GetNumTracksI(indexer);
-	int trackToRead = -1;
+	const std::vector<MatroskaTrack>& tracks = reader.GetTracks();
+	//track number in Matroska or track index in FFMS2
+	unsigned long long trackToRead = 0;
+	bool picked = false;
 	wxArrayString trackNameList;
-	wxArrayInt trackList;
-	for (int i = 0; i < numTracks; i++){
-		if (FFMS_GetTrackTypeI(indexer, i) == FFMS_TYPE_SUBTITLE) {
+	std::vector<unsigned long long> trackList;
+	wxArrayString codecList;
+	if (indexer) {
+		int numTracks = FFMS_GetNumTracksI(indexer);
+		for (int i = 0; i < numTracks; i++) {
+			if (FFMS_GetTrackTypeI(indexer, i) != FFMS_TYPE_SUBTITLE)
+				continue;
 			wxString codecName = wxString(FFMS_GetSubtitleFormat(indexer, i), wxConvUTF8);
 			wxString trackName = wxString(FFMS_GetTrackName(indexer, i), wxConvUTF8);
 			wxString trackLanguage = wxString(FFMS_GetTrackLanguage(indexer, i), wxConvUTF8);
-			if (codecName == L"ass" || codecName == L"ssa" || codecName == L"subrip" || 
+			if (codecName == L"ass" || codecName == L"ssa" || codecName == L"subrip" ||
 				codecName == L"srt" || codecName == L"text") {
-				trackList.Add(i);
+				trackList.push_back(i);
+				codecList.Add(codecName);
 				trackNameList.Add(wxString::Format(L"%i ", i) + trackName + L" (" + trackLanguage + L", " + codecName + L")");
 			}
 		}
 	}
+	for (auto& track : tracks){
+		if (track.type != MATROSKA_TRACK_SUBTITLE)
+			continue;
+		wxString codecName = GetCodecName(track.codec);
+		if (!codecName.empty()) {
+			trackList.push_back(track.number);
+			codecList.Add(codecName);
+			trackNameList.Add(wxString::Format(L"%llu ", track.number) + track.name + L" (" + track.language + L", " + codecName + L")");
+		}
+	}
+	wxString codecName;
 	// No tracks found
-	if (trackList.Count() == 0) {
+	if (trackList.size() == 0) {
 		Close();
 		KaiMessageBox(_("Plik nie ma żadnej ścieżki z napisami."));
 		return false;
 	}
 
 	// Only one track found
-	else if (trackList.Count() == 1) {
+	else if (trackList.size() == 1) {
 		trackToRead = trackList[0];
+		codecName = codecList[0];
+		picked = true;
 	}
 
 	// Pick a track
@@ -100,13 +141,23 @@ bool Demux::GetSubtitles(SubsGrid* target)
 			return false;
 		}
 		trackToRead = trackList[tracks.GetIntSelection()];
+		codecName = codecList[tracks.GetIntSelection()];
+		picked = true;
 	}
 
 	// Picked track
-	if (trackToRead != -1) {
+	if (picked) {
 		// to force saving to show choose name dialog
 		target->originalFormat = -1;
-		wxString codecName = wxString(FFMS_GetSubtitleFormat(indexer, trackToRead), wxConvUTF8);
+		std::string codecPrivate;
+		if (indexer) {
+			const char* privData = FFMS_GetSubtitleExtradata(indexer, trackToRead);
+			if (privData)
+				codecPrivate = privData;
+		}
+		else {
+			codecPrivate = reader.GetTrack(trackToRead)->codecPrivate;
+		}
 		if (codecName == L"ass")
 			codecType = 0;
 		else if (codecName == L"ssa")
@@ -116,9 +167,24 @@ bool Demux::GetSubtitles(SubsGrid* target)
 
 		progress = new ProgressSink(target->GetParent(), _("Odczyt napisów z pliku Matroska."));
 		progress->SetAndRunTask([=]() {
-			FFMS_GetSubtitles(indexer, trackToRead, GetSubtitles, (void*)this);
+			std::vector<MatroskaFrame> frames;
+			bool succeeded = true;
+			if (indexer) {
+				indexerFrames = &frames;
+				FFMS_GetSubtitles(indexer, trackToRead, GetSubtitlesFFMS2, (void*)this);
+				indexerFrames = nullptr;
+			}
+			else {
+				succeeded = reader.ReadFrames(trackToRead, &frames, [=](int percent) {
+					progress->Progress(percent);
+					return progress->WasCancelled();
+				});
+			}
 			if (progress->WasCancelled()) {
-				subtitleList.clear();
+				return 0;
+			}
+			if (!succeeded) {
+				KaiLog(_("Nie można odczytać ścieżki napisów, kompresja lub szyfrowanie nie jest obsługiwane."));
 				return 0;
 			}
 			target->Clearing();
@@ -127,8 +193,7 @@ bool Demux::GetSubtitles(SubsGrid* target)
 			// Read private data if it's ASS/SSA
 			if (codecType < 2) {
 				// Read raw data
-				const char* privData = FFMS_GetSubtitleExtradata(indexer, trackToRead);
-				wxString privString(privData, wxConvUTF8);
+				wxString privString = wxString::FromUTF8(codecPrivate.c_str());
 
 				// Load into file
 				int type = 0;
@@ -153,15 +218,14 @@ bool Demux::GetSubtitles(SubsGrid* target)
 			}
 
 
-			for (unsigned int i = 0; i < subtitleList.size(); i++) {
-				target->AddLine(new Dialogue(subtitleList[i]));
+			for (auto& frame : frames) {
+				target->AddLine(new Dialogue(GetSubtitleLine(frame)));
 			}
 			const wxString& matrix = target->GetSInfo(L"YCbCr Matrix");
 			if ((matrix == emptyString || matrix == L"None") && codecType < 1) 
 				target->AddSInfo(L"YCbCr Matrix", L"TV.601");
 
 			target->file->EndLoad(OPEN_SUBTITLES, 0, true);
-			subtitleList.clear();
 
 			return 1;
 		});
@@ -176,9 +240,11 @@ bool Demux::GetSubtitles(SubsGrid* target)
 
 void Demux::GetFontList(wxArrayString* list)
 {
-	int numTracks = FFMS_GetNumTracksI(indexer);
-	for (size_t i = 0; i < numTracks; i++){
-		if (FFMS_GetTrackTypeI(indexer, i) == FFMS_TYPE_ATTACHMENT) {
+	if (indexer) {
+		int numTracks = FFMS_GetNumTracksI(indexer);
+		for (int i = 0; i < numTracks; i++) {
+			if (FFMS_GetTrackTypeI(indexer, i) != FFMS_TYPE_ATTACHMENT)
+				continue;
 			FFMS_Attachment* attachment = FFMS_GetAttachment(indexer, i);
 			wxString mimetype(attachment->Mimetype, wxConvUTF8);
 			if (mimetype == L"font/ttf" || mimetype == L"font/otf" ||
@@ -190,22 +256,42 @@ void Demux::GetFontList(wxArrayString* list)
 				FFMS_FreeAttachment(&attachment);
 			}
 		}
+		return;
+	}
+	const std::vector<MatroskaAttachment>& attachments = reader.GetAttachments();
+	for (size_t i = 0; i < attachments.size(); i++){
+		const wxString& mimetype = attachments[i].mimetype;
+		if (mimetype == L"font/ttf" || mimetype == L"font/otf" ||
+			mimetype == L"application/x-truetype-font" || mimetype == L"application/vnd.ms-opentype") {
+			list->Add(attachments[i].name);
+			fonts.push_back(i);
+		}
 	}
 }
 
 bool Demux::SaveFont(int i, const wxString& path, wxZipOutputStream* zip)
 {
-	if (i >= attachments.size())
-		return false;
+	std::string data;
+	if (indexer) {
+		if (i >= attachments.size())
+			return false;
+		data.assign((const char*)attachments[i]->Data, attachments[i]->DataSize);
+	}
+	else {
+		if (i >= fonts.size())
+			return false;
+		//font data is read from file only here
+		if (!reader.ReadAttachment(fonts[i], &data))
+			return false;
+	}
 
-	FFMS_Attachment* attachment = attachments[i];
 	bool isgood = true;
 
 	if (zip) {
 		wxString fn = path.AfterLast(L'\\');
 		try {
 			isgood = zip->PutNextEntry(fn);
-			zip->Write((void*)attachment->Data, attachment->DataSize);
+			zip->Write((void*)data.data(), data.size());
 		}
 		catch (...)
 		{
@@ -217,7 +303,7 @@ bool Demux::SaveFont(int i, const wxString& path, wxZipOutputStream* zip)
 		wxFile file;
 		file.Create(path, true, wxS_DEFAULT);
 		if (file.IsOpened()) {
-			file.Write((void*)attachment->Data, attachment->DataSize);
+			file.Write((void*)data.data(), data.size());
 			file.Close();
 		}
 		else { isgood = false; }
@@ -226,16 +312,15 @@ bool Demux::SaveFont(int i, const wxString& path, wxZipOutputStream* zip)
 	return isgood;
 }
 
-int __stdcall Demux::GetSubtitles(long long Start, long long Duration, long long Total, const char* Line, void* ICPrivate)
+wxString Demux::GetSubtitleLine(const MatroskaFrame& frame)
 {
-	Demux* demux = (Demux*)ICPrivate;
-	wxString blockString(Line, wxConvUTF8);
+	wxString blockString = wxString::FromUTF8(frame.data.data(), frame.data.size());
 
 	// Get start and end times
 	SubsTime subStart, subEnd;
-	int startTime = Start;
-	int endTime = startTime + Duration;
-	if (demux->codecType < 2) {
+	int startTime = frame.start;
+	int endTime = startTime + frame.duration;
+	if (codecType < 2) {
 		startTime += 5;
 		endTime += 5;
 		startTime = ZEROIT(startTime);
@@ -243,10 +328,9 @@ int __stdcall Demux::GetSubtitles(long long Start, long long Duration, long long
 	}
 	subStart.NewTime(startTime);
 	subEnd.NewTime(endTime);
-	//wxLogMessage(subStart.GetASSFormated() + "-" + subEnd.GetASSFormated() + ": " + blockString);
 
 	// Process SSA/ASS
-	if (demux->codecType < 2) {
+	if (codecType < 2) {
 		// Get order number
 		int pos = blockString.Find(L",");
 		wxString orderString = blockString.Left(pos);
@@ -272,10 +356,17 @@ int __stdcall Demux::GetSubtitles(long long Start, long long Duration, long long
 	else {
 		blockString = subStart.raw(SRT) + L" --> " + subEnd.raw(SRT) + L"\r\n" + blockString;
 	}
+	return blockString;
+}
 
-	// Insert into vector
-	demux->subtitleList.push_back(blockString);
-
+int __stdcall Demux::GetSubtitlesFFMS2(long long Start, long long Duration, long long Total, const char* Line, void* ICPrivate)
+{
+	Demux* demux = (Demux*)ICPrivate;
+	MatroskaFrame frame;
+	frame.start = Start;
+	frame.duration = Duration;
+	frame.data = Line;
+	demux->indexerFrames->push_back(std::move(frame));
 
 	int prog = ((double(Start)) / double(Total)) * 100;
 	demux->progress->Progress(prog);
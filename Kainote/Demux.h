@@ -20,6 +20,7 @@
 #include <wx/arrstr.h>
 #include <wx/msw/winundef.h>
 #include <wx/zipstrm.h>
+#include "MatroskaReader.h"
 #include "include/ffms.h"
 #include <vector>
 
@@ -37,10 +38,16 @@ public:
 	bool SaveFont(int i, const wxString& path, wxZipOutputStream* zip = nullptr);
 
 private:
-	static int __stdcall GetSubtitles(long long Start, long long Duration, long long Total, const char* Line, void* ICPrivate);
+	wxString GetSubtitleLine(const MatroskaFrame& frame);
+	//other containers than Matroska, like OGM, are still read by FFMS2 indexer
+	bool OpenFFMS2(const wxString& filename);
+	static int __stdcall GetSubtitlesFFMS2(long long Start, long long Duration, long long Total, const char* Line, void* ICPrivate);
+	MatroskaReader reader;
+	//indices of font attachments
+	std::vector<size_t> fonts;
 	FFMS_Indexer* indexer = nullptr;
 	std::vector<FFMS_Attachment*> attachments;
+	std::vector<MatroskaFrame>* indexerFrames = nullptr;
 	ProgressSink* progress = nullptr;
 	int codecType = 0;
-	std::vector<wxString> subtitleList;
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "DialogueParser.h"
+#include "SubsDialogue.h"
+#include "InternTable.h"
+#include <algorithm>
+#include <thread>
+
+void GetLoadedLines(const wxString &text, std::vector<LoadedLine> *loaded)
+{
+	loaded->reserve(text.length() / 80);
+	TextLines lines(text);
+	const wchar_t *line;
+	size_t length;
+	while (lines.GetNextLine(&line, &length)){
+		size_t trimmed = 0;
+		while (trimmed < length && IsTrimSpace(line[trimmed])){ trimmed++; }
+		loaded->push_back(LoadedLine{ line, length, trimmed, nullptr });
+	}
+}
+
+//parses only lines that are ASS dialogues, other lines have to be parsed in main thread
+//style, actor and effect are interned to table of thread without lock
+static void ParseDialogues(LoadedLine *loaded, size_t count, InternTable *table)
+{
+	InternTable::Use(table);
+	for (size_t i = 0; i < count; i++){
+		const wchar_t *line = loaded[i].line + loaded[i].trimmed;
+		size_t length = loaded[i].length - loaded[i].trimmed;
+		if (!HasPrefix(line, length, L"Dialogue", 8) && !HasPrefix(line, length, L"Comment", 7))
+			continue;
+
+		Dialogue *dialogue = new Dialogue();
+		if (dialogue->SetRawASS(line, length))
+			loaded[i].dialogue = dialogue;
+		else
+			delete dialogue;
+	}
+	InternTable::Use(nullptr);
+}
+
+void ParseDialoguesParallel(std::vector<LoadedLine> &loaded, size_t numThreads)
+{
+	numThreads = (std::min)(numThreads, loaded.size());
+	if (!numThreads)
+		return;
+
+	size_t chunkSize = (loaded.size() + numThreads - 1) / numThreads;
+	std::vector<std::thread> threads;
+	std::vector<InternTable> tables(numThreads);
+	threads.reserve(numThreads);
+	for (size_t start = 0; start < loaded.size(); start += chunkSize){
+		size_t count = (std::min)(chunkSize, loaded.size() - start);
+		threads.emplace_back(ParseDialogues, loaded.data() + start, count, &tables[threads.size()]);
+	}
+	for (auto &thread : threads){
+		thread.join();
+	}
+	for (auto &table : tables){
+		table.Merge();
+	}
+}
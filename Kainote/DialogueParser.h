@@ -0,0 +1,80 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <vector>
+
+class Dialogue;
+
+//line of loaded file, dialogue is set when it was parsed in thread
+struct LoadedLine
+{
+	const wchar_t *line;
+	size_t length;
+	//number of whitespaces on the line start
+	size_t trimmed;
+	Dialogue *dialogue;
+};
+
+//works like wxStringTokenizer with "\n" and wxTOKEN_STRTOK
+//but returns lines as pointers to loaded text without copying them
+class TextLines
+{
+public:
+	TextLines(const wxString &text)
+		: pos(text.wc_str())
+		, end(text.wc_str() + text.length())
+	{}
+	bool GetNextLine(const wchar_t **line, size_t *length)
+	{
+		while (pos < end && *pos == L'\n')
+			pos++;
+		*line = pos;
+		if (pos >= end){
+			*length = 0;
+			return false;
+		}
+		const wchar_t *lineEnd = wmemchr(pos, L'\n', end - pos);
+		if (!lineEnd)
+			lineEnd = end;
+		*length = lineEnd - pos;
+		pos = lineEnd;
+		return true;
+	}
+private:
+	const wchar_t *pos;
+	const wchar_t *end;
+};
+
+//used by loader of lines and Dialogue::SetRawASS, so both trim and match the same way
+inline bool IsTrimSpace(wchar_t ch)
+{
+	return ch < 127 && wxIsspace(ch);
+}
+
+inline bool HasPrefix(const wchar_t *line, size_t length, const wchar_t *prefix, size_t prefixLength)
+{
+	return length >= prefixLength && !wmemcmp(line, prefix, prefixLength);
+}
+
+//finds all lines of text with number of whitespaces on start, text has to live as long as lines
+void GetLoadedLines(const wxString &text, std::vector<LoadedLine> *loaded);
+
+//parses Dialogue and Comment lines in numThreads threads, every thread gets one chunk of lines,
+//style, actor and effect are interned to table of thread and merged to global table after join.
+//Lines which are not ASS dialogues keep null dialogue and have to be parsed in main thread
+void ParseDialoguesParallel(std::vector<LoadedLine> &loaded, size_t numThreads);
@@ -2163,6 +2163,9 @@ void TextEditor::Replace(int start, int end, const wxString &rep)
 void TextEditor::CheckText()
 {
 	if (MText == emptyString) { errors.SetEmpty(); return; }
+	//line can be already checked on grid or in background
+	if (!hasRTL && !isRTL && EB->GetCheckedErrors(MText, SpellCheckerOnOff, &errors, &misspells))
+		return;
 	errors.clear();
 	misspells.clear();
 	errors.Init2((hasRTL || isRTL)? RTLText : MText, SpellCheckerOnOff, EB->GetFormat(), &misspells);
@@ -431,8 +431,8 @@ void EditBox::SetLine(int Row, bool setaudio, bool save, bool nochangeline, bool
 		MarginVEdit->SetInt(line->MarginV);
 		EffectEdit->ChangeValue(line->Effect);
 		TextEdit->SetState((!line->IsComment) ? 0 : 
-			(line->Effect->StartsWith(L"template")) ? 2 : 
-			(line->Effect->StartsWith(L"code")) ? 3 : 1);
+			(line->Effect.Get().StartsWith(L"template")) ? 2 : 
+			(line->Effect.Get().StartsWith(L"code")) ? 3 : 1);
 		SetTextWithTags();
 
 		if (DoubtfulTL->IsShown()) {
@@ -956,8 +956,8 @@ void EditBox::OnCommit(wxCommandEvent& event)
 	Send(EDITBOX_LINE_EDITION, false, false, Visual != 0);
 	if (event.GetId() == ID_COMMENT){
 		TextEdit->SetState((!line->IsComment) ? 0 : 
-			(line->Effect->StartsWith(L"template")) ? 2 : 
-			(line->Effect->StartsWith(L"code")) ? 3 : 1, true);
+			(line->Effect.Get().StartsWith(L"template")) ? 2 : 
+			(line->Effect.Get().StartsWith(L"code")) ? 3 : 1, true);
 	}
 	if (Visual){
 		tab->video->SetVisual(true);
@@ -1115,6 +1115,28 @@ int EditBox::GetFormat()
 	return grid->subsFormat;
 }
 
+bool EditBox::GetCheckedErrors(const wxString &text, bool spellchecker, TextData *errors, std::vector<MisspellData> *misspells)
+{
+	if (!grid || currentLine < 0 || (size_t)currentLine >= grid->SpellErrors.size())
+		return false;
+
+	const TextData &checked = grid->SpellErrors[currentLine];
+	if (!checked.isInit || !checked.hasMisspells || checked.spellchecker != spellchecker)
+		return false;
+
+	Dialogue *dial = grid->GetDialogue(currentLine);
+	if (!dial)
+		return false;
+
+	const wxString &checkedText = (grid->hasTLMode && dial->TextTl != emptyString) ? dial->TextTl : dial->Text;
+	if (text != checkedText)
+		return false;
+
+	*errors = checked;
+	*misspells = checked.misspells;
+	return true;
+}
+
 //dummy tlmode is used on preview when 
 void EditBox::SetTlMode(bool tl, bool dummyTlMode /*= false*/)
 {
@@ -146,6 +146,8 @@ public:
 	bool SetFont(const wxFont &font);
 	void OnAccelerator(wxCommandEvent& event);
 	int GetFormat();
+	//copies errors of current line checked on grid when it has the same text
+	bool GetCheckedErrors(const wxString &text, bool spellchecker, TextData *errors, std::vector<MisspellData> *misspells);
 
 	wxBoxSizer* BoxSizer1 = nullptr;
 
@@ -34,6 +34,8 @@
 #include <wx/dir.h>
 #include <wx/regex.h>
 #include <ShlObj.h>
+#include <thread>
+
 
 wxDEFINE_EVENT(EVT_APPEND_MESSAGE, wxThreadEvent);
 wxDEFINE_EVENT(EVT_ENABLE_BUTTONS, wxThreadEvent);
@@ -563,129 +565,111 @@ FontCollector::~FontCollector()
 		fcd->Destroy();
 };
 
-void FontCollector::GetAssFonts(SubsFile *subs, int tab)
+static void AppendCharacter(wxString &text, unsigned int character)
 {
-	std::map<wxString, Styles*> stylesfonts;
-
-	std::vector<Styles*> * styles = subs->GetStyleTable();
+	if (character > 0xFFFF){
+		character -= 0x10000;
+		text << (wchar_t)(0xD800 + (character >> 10)) << (wchar_t)(0xDC00 + (character & 0x3FF));
+	}
+	else{
+		text << (wchar_t)character;
+	}
+}
 
-	for (size_t i = 0; i < styles->size(); i++)
-	{
-		Styles *style = (*styles)[i];
-		wxString fn = style->Fontname;
-		bool bold = style->Bold;
-		bool italic = style->Italic;
-		wxString fnl = fn.Lower() << (int)bold << (int)italic;
-		int iresult = facenames.Index(fn, false);
-		if (iresult == -1){
-			FontLogContent *nflc = notFindFontsLog[fn];
-			if (!nflc){
-				nflc = new FontLogContent(_("Nie znaleziono czcionki \"") + fn + L"\".\n", true);
-				notFindFontsLog[fn] = nflc;
-			}
-			nflc->SetStyle(tab, style->Name);
-			//continue;
-		}
-		else
+void FontCollector::GetAssFonts(const std::vector<std::pair<SubsFile*, int>> &files)
+{
+	//styles are checked here, lines of every file are splitted to chunks
+	std::vector<std::map<wxString, Styles*>> stylesFonts(files.size());
+	std::vector<FontsScanChunk> chunks;
+	for (size_t k = 0; k < files.size(); k++){
+		SubsFile *subs = files[k].first;
+		int tab = files[k].second;
+		std::vector<Styles*> * styles = subs->GetStyleTable();
+
+		for (size_t i = 0; i < styles->size(); i++)
 		{
-			if (!(foundFonts.find(fnl) != foundFonts.end())){
-				foundFonts[fnl] = new SubsFont(fn, logFonts[iresult], (int)bold, italic);
+			Styles *style = (*styles)[i];
+			wxString fn = style->Fontname;
+			bool bold = style->Bold;
+			bool italic = style->Italic;
+			wxString fnl = GetFontKey(fn, (int)bold, (int)italic);
+			int iresult = FindFaceName(fn);
+			if (iresult == -1){
+				FontLogContent *nflc = notFindFontsLog[fn];
+				if (!nflc){
+					nflc = new FontLogContent(_("Nie znaleziono czcionki \"") + fn + L"\".\n", true);
+					notFindFontsLog[fn] = nflc;
+				}
+				nflc->SetStyle(tab, style->Name);
+				//continue;
 			}
-			FontLogContent *flc = findFontsLog[fn];
-			if (!flc){
-				flc = new FontLogContent(wxString::Format(_("Znaleziono czcionkę \"%s\"\n"), fn));
-				findFontsLog[fn] = flc;
+			else
+			{
+				if (!(foundFonts.find(fnl) != foundFonts.end())){
+					foundFonts[fnl] = new SubsFont(fn, logFonts[iresult], (int)bold, italic);
+				}
+				FontLogContent *flc = findFontsLog[fn];
+				if (!flc){
+					flc = new FontLogContent(wxString::Format(_("Znaleziono czcionkę \"%s\"\n"), fn));
+					findFontsLog[fn] = flc;
+				}
+				flc->SetStyle(tab, style->Name);
 			}
-			flc->SetStyle(tab, style->Name);
+			stylesFonts[k][style->Name] = style;
+
 		}
-		stylesfonts[style->Name] = style;
 
+		GetFontsScanChunks(subs, tab, &stylesFonts[k], &chunks);
 	}
 
-	wxString tags[] = { L"fn", L"b", L"i", L"p" };
+	ScanFontsUsage(chunks, std::thread::hardware_concurrency());
 
-	for (size_t i = 0; i < subs->GetCount(); i++)
-	{
-		Dialogue *dial = subs->GetDialogue(i);
-		if (dial->IsComment){ continue; }
-		ParseData* pdata = dial->ParseTags(tags, 4, true);
-		if (!pdata){ continue; }
-
-		const wxString &text = dial->GetTextNoCopy();
-
-		Styles *lstyle = stylesfonts[dial->Style];
-
-		wxString ifont = (lstyle) ? lstyle->Fontname : emptyString;
-		int bold = (lstyle) ? (int)lstyle->Bold : 0;
-		int italic = (lstyle) ? (int)lstyle->Italic : 0;
-		bool newFont = false;
-		bool lastPlain = false;
-		wxString textHavingFont;
-		size_t tagsSize = pdata->tags.size();
+	//merged in order of tabs and lines, logs are the same like from one thread
+	for (auto &chunk : chunks){
+		AddFontsUsage(chunk.usage, chunk.tab);
+	}
+}
 
-		for (size_t j = 0; j < tagsSize; j++)
-		{
-			TagData *tag = pdata->tags[j];
-			if (tag->tagName == L"p" || tag->tagName == L"pvector"){ continue; }
-
-			if (tag->tagName == L"plain"){
-				textHavingFont += tag->value;
-				if ((lastPlain && j < tagsSize - 1) || ifont.IsEmpty()){ continue; }
-				lastPlain = true;
-				wxString fnl = ifont.Lower() << bold << italic;
-				int iresult = facenames.Index(ifont, false);
-				if (iresult == -1){
-					FontLogContent *nflc = notFindFontsLog[ifont];
-					if (!nflc){
-						nflc = new FontLogContent(_("Nie znaleziono czcionki \"") + ifont + L"\".\n", true);
-						notFindFontsLog[ifont] = nflc;
-					}
-					if (newFont){
-						nflc->SetLine(tab, i);
-					}
-				}
-				else
-				{
-					if (!(foundFonts.find(fnl) != foundFonts.end())){
-						foundFonts[fnl] = new SubsFont(ifont, logFonts[iresult], bold, (italic != 0));
-					}
-					if (newFont){
-						FontLogContent *flc = findFontsLog[ifont];
-						if (!flc){
-							flc = new FontLogContent(wxString::Format(_("Znaleziono czcionkę \"%s\"\n"), ifont));
-							findFontsLog[ifont] = flc;
-						}
-						flc->SetLine(tab, i);
-						newFont = false;
-					}
-				}
-				//we add all texts to check if even not found font is even needed
-				//when is not needed leave only info cause not inform on the end.
-				textHavingFont.Replace(L"\\N", emptyString);
-				textHavingFont.Replace(L"\\n", emptyString);
-				textHavingFont.Replace(L"\\h", L" ");
-				PutChars(textHavingFont, ifont);
-				textHavingFont.clear();
+void FontCollector::AddFontsUsage(FontsUsage &usage, int tab)
+{
+	for (auto &variant : usage.variants){
+		const wxString &ifont = variant.second.name;
+		if (!variant.second.characters.IsEmpty()){
+			FontMap[variant.first].Add(variant.second.characters);
+			usedFonts.insert(ifont.Lower());
+		}
+		int iresult = FindFaceName(ifont);
+		if (iresult == -1){
+			FontLogContent *nflc = notFindFontsLog[ifont];
+			if (!nflc){
+				nflc = new FontLogContent(_("Nie znaleziono czcionki \"") + ifont + L"\".\n", true);
+				notFindFontsLog[ifont] = nflc;
 			}
-			else{
-				if (tag->tagName == L"fn"){
-					ifont = tag->value;
-					newFont = true;
-				}
-				else if (tag->tagName == L"b"){
-					bold = wxAtoi(tag->value);
-				}
-				else if (tag->tagName == L"i"){
-					italic = wxAtoi(tag->value);
-				}
-				lastPlain = false;
+		}
+		else if (!(foundFonts.find(variant.first) != foundFonts.end())){
+			foundFonts[variant.first] = new SubsFont(ifont, logFonts[iresult], 
+				variant.second.bold, (variant.second.italic != 0));
+		}
+	}
+	for (auto &fontLine : usage.fontLines){
+		const wxString &ifont = fontLine.first;
+		if (FindFaceName(ifont) == -1){
+			FontLogContent *nflc = notFindFontsLog[ifont];
+			if (!nflc){
+				nflc = new FontLogContent(_("Nie znaleziono czcionki \"") + ifont + L"\".\n", true);
+				notFindFontsLog[ifont] = nflc;
 			}
-
-
+			nflc->SetLine(tab, fontLine.second);
+		}
+		else{
+			FontLogContent *flc = findFontsLog[ifont];
+			if (!flc){
+				flc = new FontLogContent(wxString::Format(_("Znaleziono czcionkę \"%s\"\n"), ifont));
+				findFontsLog[ifont] = flc;
+			}
+			flc->SetLine(tab, fontLine.second);
 		}
-		dial->ClearParse();
 	}
-
 }
 
 bool FontCollector::AddFont(const wxString &string)
@@ -695,8 +679,8 @@ bool FontCollector::AddFont(const wxString &string)
 
 void FontCollector::CheckOrCopyFonts()
 {
+	SetFontFolders();
 	if (!(operation & CHECK_FONTS) && (fontSizes.size() < 1 || reloadFonts)){
-		fontfolder = wxGetOSDirectory() + L"\\fonts\\";
 		wxString seekpath = fontfolder + L"*";
 
 		fontSizes.clear();
@@ -717,10 +701,7 @@ void FontCollector::CheckOrCopyFonts()
 		}
 		FindClose(h);
 
-		WCHAR appDataPath[MAX_PATH];
-		
-		if (SUCCEEDED(SHGetFolderPath(nullptr, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE, nullptr, 0, appDataPath))){
-			fontFolderLocal = wxString(appDataPath) + L"\\Microsoft\\Windows\\Fonts\\";
+		if (!fontFolderLocal.empty()){
 			wxString localPath = fontFolderLocal + L"*";
 			WIN32_FIND_DATAW data1;
 			HANDLE h1 = FindFirstFileW(localPath.wc_str(), &data1);
@@ -744,28 +725,31 @@ void FontCollector::CheckOrCopyFonts()
 	int notFound = 0;
 	int notCopied = 0;
 
-	if (facenames.size() < 1 || reloadFonts){ EnumerateFonts(); }
-	
+	if (facenamesIndex.empty() || reloadFonts){ EnumerateFonts(); }
 
+	wxArrayString folders;
+	folders.Add(fontfolder);
+	if (!fontFolderLocal.empty())
+		folders.Add(fontFolderLocal);
+	int parsedFonts = fontDatabase.Refresh(folders);
+	if (parsedFonts > 0){
+		SubsTime processTime(sw.Time());
+		SendMessageD(wxString::Format(_("Odczytano znaki %i nowych plików czcionek, upłynęło %sms.\n\n"), 
+			parsedFonts, processTime.GetFormatted(SRT)), fcd->normal);
+	}
+
+	std::vector<std::pair<SubsFile*, int>> files;
 	if (operation & ON_ALL_TABS){
 		Notebook * tabs = Notebook::GetTabs();
 		size_t tabsSize = tabs->Size();
-		//HANDLE *threads = new HANDLE[tabsSize];
-
 		for (size_t i = 0; i < tabsSize; i++){
-			GetAssFonts(tabs->Page(i)->grid->file, i);
-			//std::tuple<FontCollector*, SubsFile*, int*> *data = 
-				//new std::tuple<FontCollector *, SubsFile *, int*>(this, tabs->Page(i)->grid->file, new int(i));
-			
-			//threads[i] = CreateThread(nullptr, 0, (LPTHREAD_START_ROUTINE)ThreadFunction, data, 0, 0);
-			
+			files.push_back(std::make_pair(tabs->Page(i)->grid->file, (int)i));
 		}
-		//WaitForMultipleObjects(tabsSize, threads, TRUE, INFINITE);
-		//delete[] threads;
 	}
 	else{
-		GetAssFonts(Notebook::GetTab()->grid->file, Notebook::GetTabs()->iter);
+		files.push_back(std::make_pair(Notebook::GetTab()->grid->file, Notebook::GetTabs()->iter));
 	}
+	GetAssFonts(files);
 
 	bool allglyphs = CheckPathAndGlyphs(&found, &notFound, &notCopied);
 	if (notFound == -1) {
@@ -779,8 +763,7 @@ void FontCollector::CheckOrCopyFonts()
 		cur->second->DoLog(this);
 	}
 	for (auto cur = notFindFontsLog.begin(); cur != notFindFontsLog.end(); cur++){
-		CharMap &ch = FontMap[cur->first];
-		if (!ch.size()){
+		if (usedFonts.find(cur->first.Lower()) == usedFonts.end()){
 			cur->second->AppendWarnings(
 				wxString::Format(_("Czcionka \"%s\" należy do stylu,\nktóry nie jest wykorzystywany."), 
 				cur->first));
@@ -932,6 +915,7 @@ void FontCollector::ClearTables()
 {
 	currentTextPosition = 0;
 	FontMap.clear();
+	usedFonts.clear();
 	for (auto cur = notFindFontsLog.begin(); cur != notFindFontsLog.end(); cur++)
 		delete cur->second;
 	notFindFontsLog.clear();
@@ -983,20 +967,9 @@ void FontCollector::CloseZip()
 	}
 }
 
-void FontCollector::PutChars(const wxString &txt, const wxString &fn)
-{
-	CharMap &ch = FontMap[fn];
-
-	for (size_t i = 0; i < txt.length(); i++){
-		if (!(ch.find(txt[i]) != ch.end())){
-			ch.insert(txt[i]);
-		}
-	}
-}
-
 void FontCollector::EnumerateFonts()
 {
-	facenames.clear();
+	facenamesIndex.clear();
 	logFonts.clear();
 	LOGFONTW lf;
 	lf.lfCharSet = DEFAULT_CHARSET;
@@ -1005,13 +978,32 @@ void FontCollector::EnumerateFonts()
 	memcpy(lf.lfFaceName, L"\0", LF_FACESIZE);
 	EnumFontFamiliesEx(dc, &lf, (FONTENUMPROCW)[](const LOGFONT *lf, const TEXTMETRIC *mt, DWORD style, LPARAM lParam) -> int {
 		FontCollector * fc = reinterpret_cast<FontCollector*>(lParam);
-		fc->facenames.push_back(lf->lfFaceName);
+		//first face like in case insensitive search of array
+		fc->facenamesIndex.emplace(wxString(lf->lfFaceName).Lower().ToStdWstring(), fc->logFonts.size());
 		fc->logFonts.push_back(*lf);
 		return 1;
 	}, (LPARAM)this, 0);
 	::DeleteDC(dc);
 }
 
+int FontCollector::FindFaceName(const wxString &name)
+{
+	auto it = facenamesIndex.find(name.Lower().ToStdWstring());
+	if (it == facenamesIndex.end())
+		return -1;
+	return (int)it->second;
+}
+
+void FontCollector::SetFontFolders()
+{
+	fontfolder = wxGetOSDirectory() + L"\\fonts\\";
+	fontFolderLocal.clear();
+	WCHAR appDataPath[MAX_PATH];
+	if (SUCCEEDED(SHGetFolderPath(nullptr, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE, nullptr, 0, appDataPath))){
+		fontFolderLocal = wxString(appDataPath) + L"\\Microsoft\\Windows\\Fonts\\";
+	}
+}
+
 bool FontCollector::CheckPathAndGlyphs(int *found, int *notFound, int *notCopied)
 {
 	bool allfound = true;
@@ -1028,6 +1020,7 @@ bool FontCollector::CheckPathAndGlyphs(int *found, int *notFound, int *notCopied
 		bool isNewFont = lastfn != fn;
 		lastfn = fn;
 		SubsFont *font = it->second;
+		const wxString &fnl = it->first;
 		FontLogContent *flc = findFontsLog[fn];
 		if (!flc){
 			flc = new FontLogContent(wxString::Format(_("Znaleziono czcionkę \"%s\"."), fn));
@@ -1035,8 +1028,7 @@ bool FontCollector::CheckPathAndGlyphs(int *found, int *notFound, int *notCopied
 		}
 		it++;
 		//skip not used font before it make any other messages
-		CharMap &ch = FontMap[fn];
-		if (!ch.size()){
+		if (usedFonts.find(fn.Lower()) == usedFonts.end()){
 			if(isNewFont)
 				flc->AppendWarnings(wxString::Format(_("Czcionka \"%s\" należy do stylu,\nktóry nie jest wykorzystywany.%s"), fn, (copyFonts) ? _("\nNie zostanie skopiowana.") : emptyString));
 			
@@ -1057,17 +1049,30 @@ bool FontCollector::CheckPathAndGlyphs(int *found, int *notFound, int *notCopied
 		else if (font->fakeItalic){
 			flc->AppendWarnings(wxString::Format(_("Czcionka \"%s\" nie ma kursywy."), fn));
 		}
-		if (isNewFont){
+		//every bold and italic variant is checked with its own characters
+		auto characters = FontMap.find(fnl);
+		if (characters != FontMap.end()){
 			wxString text;
 			wxString missing;
+			//font from database is checked without GDI, surrogate pairs are joined by CharacterSet::AddText,
+			//so characters out of BMP are checked as whole code points
+			const FontFace *face = fontDatabase.FindFace(fn, font->bold, font->italic != 0);
 			
-			for (auto character = ch.begin(); character != ch.end(); character++)
+			for (auto &page : characters->second.pages)
 			{
-				const auto &achar = (*character);
-				if (achar != 65279)
-					text << achar;
+				for (unsigned int j = 0; j < 256; j++){
+					if (!page.second.test(j))
+						continue;
+					unsigned int character = (page.first << 8) | j;
+					if (character == 65279)
+						continue;
+					if (!face)
+						AppendCharacter(text, character);
+					else if (!face->HasCharacter(character))
+						AppendCharacter(missing, character);
+				}
 			}
-			if (!FontEnum.CheckGlyphsExists(dc, text, missing))
+			if (!face && !FontEnum.CheckGlyphsExists(dc, text, missing))
 			{
 				flc->AppendWarnings(wxString::Format(_("Nie można sprawdzić znaków czcionki \"%s\"."), fn));
 			}
@@ -20,15 +20,19 @@
 #include "MappedButton.h"
 #include "KaiTextCtrl.h"
 #include "KaiDialog.h"
+#include "FontDatabase.h"
+#include "FontsUsage.h"
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 
 #include <wx/zipstrm.h>
 #include <wx/thread.h>
 #include <wx/stopwatch.h>
 
 class SubsFile;
+class Styles;
 
 class SubsFont{
 public:
@@ -157,7 +161,8 @@ public:
 	void StartCollect(int operation);
 	void ShowDialog(wxWindow *parent);
 	void SendMessageD(const wxString &string, const wxColour &col);
-	void GetAssFonts(SubsFile *subs, int tab);
+	//files with numbers of tabs, lines are scanned on all cores
+	void GetAssFonts(const std::vector<std::pair<SubsFile*, int>> &files);
 
 	FontCollectorDialog *fcd;
 	enum{
@@ -170,13 +175,18 @@ public:
 	};
 	int currentTextPosition = 0;
 private:
-	typedef std::set<wxUniChar> CharMap;
-	std::map<wxString, CharMap> FontMap;
-	void PutChars(const wxString &txt, const wxString &fn);
+	//characters of font variants, keys like in foundFonts
+	std::map<wxString, CharacterSet> FontMap;
+	//lowercase names of fonts that have any characters
+	std::set<wxString> usedFonts;
+	void AddFontsUsage(FontsUsage &usage, int tab);
 	
 	bool CheckPathAndGlyphs(int *found, int *notfound, int *notcopied);
 	bool SaveFont(const wxString &fontname, FontLogContent *flc);
 	void EnumerateFonts();
+	//returns index of GDI font or -1, name is not case sensitive
+	int FindFaceName(const wxString &name);
+	void SetFontFolders();
 	bool AddFont(const wxString &string);
 	void CopyMKVFontsFromTab(const wxString &path);
 	void ClearTables();
@@ -184,7 +194,9 @@ private:
 	bool CreateZip();
 	void CloseZip();
 
-	wxArrayString facenames;
+	//lowercase face names to index of logFonts
+	std::unordered_map<std::wstring, size_t> facenamesIndex;
+	FontDatabase fontDatabase;
 	wxArrayString fontnames;
 	std::vector<LOGFONTW> logFonts;
 	std::map<wxString, FontLogContent*> notFindFontsLog;
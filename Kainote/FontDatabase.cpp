@@ -0,0 +1,482 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "FontDatabase.h"
+#include "Config.h"
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <windows.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SFNT_NAMES_H
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_IDS_H
+
+static const char databaseMagic[4] = { 'K', 'F', 'D', 'B' };
+//pages of 256 characters to the last Unicode character 0x10FFFF
+static const unsigned int maxPagesCount = 0x1100;
+
+bool FontFace::HasCharacter(unsigned int character) const
+{
+	unsigned int page = character >> 8;
+	auto it = std::lower_bound(pages.begin(), pages.end(), page);
+	if (it == pages.end() || *it != page)
+		return false;
+
+	size_t word = (it - pages.begin()) * 4 + ((character & 0xFF) >> 6);
+	return ((coverage[word] >> (character & 63)) & 1) != 0;
+}
+
+namespace {
+	//FreeType reads from file only tables that are needed,
+	//file is opened by wide path cause FT_New_Face cannot open unicode paths
+	unsigned long StreamRead(FT_Stream stream, unsigned long offset, unsigned char *buffer, unsigned long count)
+	{
+		FILE *fp = (FILE*)stream->descriptor.pointer;
+		if (_fseeki64(fp, offset, SEEK_SET) != 0)
+			return count ? 0 : 1;
+		if (!count)
+			return 0;
+		return (unsigned long)fread(buffer, 1, count, fp);
+	}
+
+	void StreamClose(FT_Stream stream)
+	{
+	}
+
+	void AddName(FontFace *face, const std::wstring &name)
+	{
+		if (name.empty())
+			return;
+		wxString lowerName = wxString(name).Lower();
+		std::wstring key = lowerName.ToStdWstring();
+		if (std::find(face->names.begin(), face->names.end(), key) == face->names.end())
+			face->names.push_back(key);
+	}
+
+	void ReadNames(FT_Face ftFace, FontFace *face)
+	{
+		FT_UInt count = FT_Get_Sfnt_Name_Count(ftFace);
+		for (FT_UInt i = 0; i < count; i++){
+			FT_SfntName name;
+			if (FT_Get_Sfnt_Name(ftFace, i, &name))
+				continue;
+			//GDI uses only family and full names from Windows platform
+			if (name.platform_id != TT_PLATFORM_MICROSOFT ||
+				(name.name_id != TT_NAME_ID_FONT_FAMILY && name.name_id != TT_NAME_ID_FULL_NAME))
+				continue;
+			if (name.encoding_id != TT_MS_ID_UNICODE_CS && name.encoding_id != TT_MS_ID_SYMBOL_CS &&
+				name.encoding_id != TT_MS_ID_UCS_4)
+				continue;
+			//UTF-16 big endian
+			std::wstring text;
+			for (FT_UInt j = 0; j + 1 < name.string_len; j += 2){
+				text += (wchar_t)((name.string[j] << 8) | name.string[j + 1]);
+			}
+			AddName(face, text);
+		}
+		//Type 1 and bitmap fonts have no name table
+		if (face->names.empty() && ftFace->family_name){
+			wxString family(ftFace->family_name, wxConvLocal);
+			AddName(face, family.ToStdWstring());
+			if (ftFace->style_name){
+				wxString style(ftFace->style_name, wxConvLocal);
+				AddName(face, (family + L" " + style).ToStdWstring());
+			}
+		}
+	}
+
+	void ReadCoverage(FT_Face ftFace, FontFace *face)
+	{
+		std::vector<unsigned int> characters;
+		bool symbol = false;
+		if (FT_Select_Charmap(ftFace, FT_ENCODING_UNICODE)){
+			if (FT_Select_Charmap(ftFace, FT_ENCODING_MS_SYMBOL))
+				return;
+			symbol = true;
+		}
+		FT_UInt glyph = 0;
+		FT_ULong character = FT_Get_First_Char(ftFace, &glyph);
+		while (glyph){
+			characters.push_back(character);
+			//GDI maps symbol fonts characters from 0xF000 to ascii range
+			if (symbol && (character & 0xFF00) == 0xF000)
+				characters.push_back(character & 0xFF);
+			character = FT_Get_Next_Char(ftFace, character, &glyph);
+		}
+		std::sort(characters.begin(), characters.end());
+		for (unsigned int ch : characters){
+			unsigned int page = ch >> 8;
+			if (face->pages.empty() || face->pages.back() != page){
+				face->pages.push_back(page);
+				face->coverage.resize(face->coverage.size() + 4, 0);
+			}
+			size_t word = (face->pages.size() - 1) * 4 + ((ch & 0xFF) >> 6);
+			face->coverage[word] |= 1ULL << (ch & 63);
+		}
+	}
+
+	void ParseFile(FT_Library library, FontFile *file)
+	{
+		file->faces.clear();
+		FILE *fp = _wfopen(file->path.c_str(), L"rb");
+		if (!fp)
+			return;
+
+		FT_StreamRec stream;
+		memset(&stream, 0, sizeof(stream));
+		stream.size = (unsigned long)file->size;
+		stream.descriptor.pointer = fp;
+		stream.read = StreamRead;
+		stream.close = StreamClose;
+		FT_Open_Args args;
+		memset(&args, 0, sizeof(args));
+		args.flags = FT_OPEN_STREAM;
+		args.stream = &stream;
+
+		FT_Long numFaces = 1;
+		for (FT_Long i = 0; i < numFaces; i++){
+			FT_Face ftFace;
+			if (FT_Open_Face(library, &args, i, &ftFace))
+				break;
+			numFaces = ftFace->num_faces;
+			FontFace face;
+			face.index = i;
+			face.italic = (ftFace->style_flags & FT_STYLE_FLAG_ITALIC) != 0;
+			face.weight = (ftFace->style_flags & FT_STYLE_FLAG_BOLD) ? 700 : 400;
+			TT_OS2 *os2 = (TT_OS2*)FT_Get_Sfnt_Table(ftFace, FT_SFNT_OS2);
+			if (os2 && os2->version != 0xFFFF && os2->usWeightClass){
+				face.weight = os2->usWeightClass;
+				//some old fonts use values from 1 to 9
+				if (face.weight < 10)
+					face.weight *= 100;
+			}
+			ReadNames(ftFace, &face);
+			ReadCoverage(ftFace, &face);
+			FT_Done_Face(ftFace);
+			if (!face.names.empty())
+				file->faces.push_back(std::move(face));
+		}
+		fclose(fp);
+	}
+
+	//plain binary writing, numbers in native order cause database is used only on one machine
+	template<typename T>
+	void Write(std::string &buffer, T value)
+	{
+		buffer.append((const char*)&value, sizeof(T));
+	}
+
+	void WriteString(std::string &buffer, const std::wstring &text)
+	{
+		Write<unsigned int>(buffer, (unsigned int)text.size());
+		buffer.append((const char*)text.data(), text.size() * sizeof(wchar_t));
+	}
+
+	class Reader
+	{
+	public:
+		Reader(const std::string &_buffer) : buffer(_buffer) {}
+		template<typename T>
+		bool Read(T *value)
+		{
+			if (pos + sizeof(T) > buffer.size())
+				return false;
+			memcpy(value, buffer.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		}
+		bool ReadString(std::wstring *text)
+		{
+			unsigned int length;
+			if (!Read(&length) || (buffer.size() - pos) / sizeof(wchar_t) < length)
+				return false;
+			text->assign((const wchar_t*)(buffer.data() + pos), length);
+			pos += length * sizeof(wchar_t);
+			return true;
+		}
+		template<typename T>
+		bool ReadVector(std::vector<T> *table, unsigned int count)
+		{
+			if ((buffer.size() - pos) / sizeof(T) < count)
+				return false;
+			table->resize(count);
+			if (count)
+				memcpy(table->data(), buffer.data() + pos, count * sizeof(T));
+			pos += count * sizeof(T);
+			return true;
+		}
+	private:
+		const std::string &buffer;
+		size_t pos = 0;
+	};
+
+	wxString GetDatabasePath()
+	{
+		return Options.pathfull + L"\\Config\\FontDatabase.bin";
+	}
+}
+
+bool FontDatabase::IsFontFile(const wxString &name)
+{
+	wxString ext = name.AfterLast(L'.').Lower();
+	return ext == L"ttf" || ext == L"ttc" || ext == L"otf" || ext == L"otc" ||
+		ext == L"pfb" || ext == L"fon";
+}
+
+int FontDatabase::Refresh(const wxArrayString &folders)
+{
+	if (!loaded){
+		Load();
+		loaded = true;
+	}
+
+	std::unordered_map<std::wstring, size_t> oldFiles;
+	for (size_t i = 0; i < files.size(); i++){
+		oldFiles[wxString(files[i].path).Lower().ToStdWstring()] = i;
+	}
+
+	std::vector<FontFile> newFiles;
+	std::vector<size_t> changed;
+	bool anyFolder = false;
+	for (size_t i = 0; i < folders.size(); i++){
+		wxString folder = folders[i];
+		if (!folder.EndsWith(L"\\"))
+			folder << L"\\";
+		WIN32_FIND_DATAW data;
+		HANDLE h = FindFirstFileW((folder + L"*").wc_str(), &data);
+		if (h == INVALID_HANDLE_VALUE)
+			continue;
+
+		anyFolder = true;
+		do{
+			if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY || !IsFontFile(data.cFileName))
+				continue;
+
+			FontFile file;
+			file.path = (folder + data.cFileName).ToStdWstring();
+			file.modified = ((long long)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+			file.size = ((long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+			auto it = oldFiles.find(wxString(file.path).Lower().ToStdWstring());
+			if (it != oldFiles.end()){
+				FontFile &old = files[it->second];
+				if (old.modified == file.modified && old.size == file.size){
+					file.faces = std::move(old.faces);
+					newFiles.push_back(std::move(file));
+					oldFiles.erase(it);
+					continue;
+				}
+				oldFiles.erase(it);
+			}
+			changed.push_back(newFiles.size());
+			newFiles.push_back(std::move(file));
+		} while (FindNextFileW(h, &data));
+		FindClose(h);
+	}
+	if (!anyFolder)
+		return -1;
+
+	//removed files stay in oldFiles
+	bool modified = !changed.empty() || !oldFiles.empty();
+	files = std::move(newFiles);
+	if (!changed.empty()){
+		std::vector<FontFile*> toParse;
+		for (size_t i : changed)
+			toParse.push_back(&files[i]);
+		ParseFiles(toParse);
+	}
+	BuildIndex();
+	if (modified)
+		Save();
+
+	return changed.size();
+}
+
+void FontDatabase::ParseFiles(std::vector<FontFile*> &toParse)
+{
+	//every thread has its own FreeType library, faces cannot share it between threads
+	std::atomic<size_t> next(0);
+	auto parse = [&toParse, &next]() {
+		FT_Library library;
+		if (FT_Init_FreeType(&library))
+			return;
+		size_t i;
+		while ((i = next++) < toParse.size()){
+			ParseFile(library, toParse[i]);
+		}
+		FT_Done_FreeType(library);
+	};
+
+	size_t numThreads = (std::min)((size_t)std::thread::hardware_concurrency(), toParse.size());
+	if (numThreads < 2){
+		parse();
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; i++){
+		threads.emplace_back(parse);
+	}
+	for (auto &thread : threads){
+		thread.join();
+	}
+}
+
+void FontDatabase::BuildIndex()
+{
+	namesIndex.clear();
+	for (size_t i = 0; i < files.size(); i++){
+		const std::vector<FontFace> &faces = files[i].faces;
+		for (size_t j = 0; j < faces.size(); j++){
+			for (auto &name : faces[j].names){
+				namesIndex[name].push_back(std::make_pair(i, j));
+			}
+		}
+	}
+}
+
+const FontFace *FontDatabase::FindFace(const wxString &name, int weight, bool italic, wxString *path) const
+{
+	auto it = namesIndex.find(name.Lower().ToStdWstring());
+	if (it == namesIndex.end())
+		return nullptr;
+
+	//italic is more important than weight like in GDI
+	const FontFace *best = nullptr;
+	size_t bestFile = 0;
+	int bestDistance = INT_MAX;
+	for (auto &indices : it->second){
+		const FontFace &face = files[indices.first].faces[indices.second];
+		int distance = abs(face.weight - weight) + ((face.italic != italic) ? 1000 : 0);
+		if (distance < bestDistance){
+			bestDistance = distance;
+			best = &face;
+			bestFile = indices.first;
+		}
+	}
+	if (best && path)
+		*path = files[bestFile].path;
+	return best;
+}
+
+size_t FontDatabase::GetFacesCount() const
+{
+	size_t count = 0;
+	for (auto &file : files)
+		count += file.faces.size();
+	return count;
+}
+
+void FontDatabase::Clear()
+{
+	files.clear();
+	namesIndex.clear();
+	loaded = false;
+}
+
+bool FontDatabase::Load()
+{
+	files.clear();
+	wxFile file;
+	wxString path = GetDatabasePath();
+	if (!wxFileExists(path) || !file.Open(path))
+		return false;
+
+	std::string buffer;
+	buffer.resize(file.Length());
+	if (buffer.empty() || file.Read(&buffer[0], buffer.size()) != buffer.size())
+		return false;
+
+	Reader reader(buffer);
+	char magic[4];
+	int version = 0;
+	unsigned int filesCount = 0;
+	if (!reader.Read(&magic) || memcmp(magic, databaseMagic, 4) != 0 ||
+		!reader.Read(&version) || version != FONT_DATABASE_VERSION || !reader.Read(&filesCount))
+		return false;
+
+	std::vector<FontFile> loadedFiles(filesCount);
+	for (auto &fontFile : loadedFiles){
+		unsigned int facesCount = 0;
+		if (!reader.ReadString(&fontFile.path) || !reader.Read(&fontFile.modified) ||
+			!reader.Read(&fontFile.size) || !reader.Read(&facesCount))
+			return false;
+		for (unsigned int i = 0; i < facesCount; i++){
+			FontFace face;
+			unsigned char italic = 0;
+			unsigned int namesCount = 0, pagesCount = 0;
+			if (!reader.Read(&face.index) || !reader.Read(&face.weight) || !reader.Read(&italic) ||
+				!reader.Read(&namesCount))
+				return false;
+			face.italic = italic != 0;
+			face.names.resize(namesCount);
+			for (auto &name : face.names){
+				if (!reader.ReadString(&name))
+					return false;
+			}
+			//bigger count can be only in broken database, it would also overflow count of coverage words
+			if (!reader.Read(&pagesCount) || pagesCount > maxPagesCount || !reader.ReadVector(&face.pages, pagesCount) ||
+				!reader.ReadVector(&face.coverage, pagesCount * 4))
+				return false;
+			fontFile.faces.push_back(std::move(face));
+		}
+	}
+	files = std::move(loadedFiles);
+	return true;
+}
+
+bool FontDatabase::Save()
+{
+	std::string buffer;
+	buffer.append(databaseMagic, 4);
+	Write<int>(buffer, FONT_DATABASE_VERSION);
+	Write<unsigned int>(buffer, (unsigned int)files.size());
+	for (auto &fontFile : files){
+		WriteString(buffer, fontFile.path);
+		Write(buffer, fontFile.modified);
+		Write(buffer, fontFile.size);
+		Write<unsigned int>(buffer, (unsigned int)fontFile.faces.size());
+		for (auto &face : fontFile.faces){
+			Write(buffer, face.index);
+			Write(buffer, face.weight);
+			Write<unsigned char>(buffer, face.italic ? 1 : 0);
+			Write<unsigned int>(buffer, (unsigned int)face.names.size());
+			for (auto &name : face.names)
+				WriteString(buffer, name);
+			Write<unsigned int>(buffer, (unsigned int)face.pages.size());
+			buffer.append((const char*)face.pages.data(), face.pages.size() * sizeof(unsigned int));
+			buffer.append((const char*)face.coverage.data(), face.coverage.size() * sizeof(unsigned long long));
+		}
+	}
+
+	//written to temporary file first, broken database would be parsed again from start
+	wxString path = GetDatabasePath();
+	wxString tmpPath = path + L".tmp";
+	wxFile file;
+	if (!file.Create(tmpPath, true))
+		return false;
+	bool succeeded = file.Write(buffer.data(), buffer.size()) == buffer.size();
+	file.Close();
+	if (!succeeded || !wxRenameFile(tmpPath, path, true)){
+		wxRemoveFile(tmpPath);
+		return false;
+	}
+	return true;
+}
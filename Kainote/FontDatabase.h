@@ -0,0 +1,75 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+#define FONT_DATABASE_VERSION 1
+
+//one face of font file, collections have more than one
+struct FontFace
+{
+	//index of face in collection
+	int index = 0;
+	int weight = 400;
+	bool italic = false;
+	//family and full names in all languages
+	std::vector<std::wstring> names;
+	//sorted numbers of 256 characters pages, every page has 4 words of coverage bits
+	std::vector<unsigned int> pages;
+	std::vector<unsigned long long> coverage;
+	bool HasCharacter(unsigned int character) const;
+};
+
+struct FontFile
+{
+	std::wstring path;
+	long long modified = 0;
+	long long size = 0;
+	//empty when file cannot be read by FreeType
+	std::vector<FontFace> faces;
+};
+
+//names and characters of all fonts from fonts folders read by FreeType
+//saved in config folder, on refresh only new and changed files are parsed
+//doesn't use GDI, can be used from any thread but not from two at once
+class FontDatabase
+{
+public:
+	FontDatabase() {};
+	~FontDatabase() {};
+	//returns number of parsed files, -1 when no folder can be read
+	int Refresh(const wxArrayString &folders);
+	//weight like in LOGFONT, face with the nearest style is returned
+	const FontFace *FindFace(const wxString &name, int weight, bool italic, wxString *path = nullptr) const;
+	size_t GetFacesCount() const;
+	void Clear();
+private:
+	bool Load();
+	bool Save();
+	void BuildIndex();
+	static void ParseFiles(std::vector<FontFile*> &toParse);
+	static bool IsFontFile(const wxString &name);
+
+	std::vector<FontFile> files;
+	//lowercase names to file and face indices
+	std::unordered_map<std::wstring, std::vector<std::pair<size_t, size_t>>> namesIndex;
+	bool loaded = false;
+};
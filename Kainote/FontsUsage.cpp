@@ -0,0 +1,172 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "FontsUsage.h"
+#include "SubsFile.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#define FONTS_SCAN_CHUNK_LINES 512
+
+void CharacterSet::Add(unsigned int character)
+{
+	pages[character >> 8].set(character & 0xFF);
+}
+
+void CharacterSet::Add(const CharacterSet &other)
+{
+	for (auto &page : other.pages){
+		pages[page.first] |= page.second;
+	}
+}
+
+void CharacterSet::AddText(const wxString &text)
+{
+	const wchar_t *txt = text.wc_str();
+	size_t len = text.length();
+	for (size_t i = 0; i < len; i++){
+		wchar_t ch = txt[i];
+		if (ch == L'\\' && i + 1 < len){
+			wchar_t next = txt[i + 1];
+			if (next == L'N' || next == L'n'){
+				i++;
+				continue;
+			}
+			if (next == L'h'){
+				Add(L' ');
+				i++;
+				continue;
+			}
+		}
+		//surrogate pairs are added as one character
+		if (ch >= 0xD800 && ch <= 0xDBFF && i + 1 < len && txt[i + 1] >= 0xDC00 && txt[i + 1] <= 0xDFFF){
+			Add(0x10000 + ((ch - 0xD800) << 10) + (txt[i + 1] - 0xDC00));
+			i++;
+			continue;
+		}
+		Add(ch);
+	}
+}
+
+wxString GetFontKey(const wxString &name, int bold, int italic)
+{
+	return name.Lower() << bold << italic;
+}
+
+static void ScanLines(SubsFile *subs, size_t start, size_t end, 
+	const std::map<wxString, Styles*> *stylesFonts, FontsUsage *usage)
+{
+	wxString tags[] = { L"fn", L"b", L"i", L"p" };
+
+	for (size_t i = start; i < end; i++)
+	{
+		Dialogue *dial = subs->GetDialogue(i);
+		if (dial->IsComment){ continue; }
+		//UI can parse the same lines, so parse data of dialogue is not used here
+		ParseData parsed;
+		dial->ParseTagsCopy(&parsed, tags, 4, true);
+		ParseData* pdata = &parsed;
+
+		auto styleIt = stylesFonts->find(dial->Style);
+		Styles *lstyle = (styleIt != stylesFonts->end()) ? styleIt->second : nullptr;
+
+		wxString ifont = (lstyle) ? lstyle->Fontname : emptyString;
+		int bold = (lstyle) ? (int)lstyle->Bold : 0;
+		int italic = (lstyle) ? (int)lstyle->Italic : 0;
+		bool newFont = false;
+		wxString textHavingFont;
+		size_t tagsSize = pdata->tags.size();
+
+		for (size_t j = 0; j < tagsSize; j++)
+		{
+			TagData *tag = pdata->tags[j];
+			if (tag->tagName == L"p" || tag->tagName == L"pvector"){ continue; }
+
+			if (tag->tagName == L"plain"){
+				//text without font waits for the first font
+				textHavingFont += tag->value;
+				if (ifont.IsEmpty()){ continue; }
+				wxString fnl = GetFontKey(ifont, bold, italic);
+				auto it = usage->variants.find(fnl);
+				if (it == usage->variants.end()){
+					it = usage->variants.emplace(fnl, FontsUsage::Variant()).first;
+					it->second.name = ifont;
+					it->second.bold = bold;
+					it->second.italic = italic;
+				}
+				if (newFont){
+					usage->fontLines.push_back(std::make_pair(ifont, (int)i));
+					newFont = false;
+				}
+				//we add all texts to check if even not found font is even needed
+				//when is not needed leave only info cause not inform on the end.
+				it->second.characters.AddText(textHavingFont);
+				textHavingFont.clear();
+			}
+			else{
+				if (tag->tagName == L"fn"){
+					ifont = tag->value;
+					newFont = true;
+				}
+				else if (tag->tagName == L"b"){
+					bold = wxAtoi(tag->value);
+				}
+				else if (tag->tagName == L"i"){
+					italic = wxAtoi(tag->value);
+				}
+			}
+		}
+	}
+}
+
+void GetFontsScanChunks(SubsFile *subs, int tab, const std::map<wxString, Styles*> *stylesFonts, std::vector<FontsScanChunk> *chunks)
+{
+	size_t count = subs->GetCount();
+	for (size_t start = 0; start < count; start += FONTS_SCAN_CHUNK_LINES){
+		FontsScanChunk chunk;
+		chunk.subs = subs;
+		chunk.tab = tab;
+		chunk.start = start;
+		chunk.end = (std::min)(start + FONTS_SCAN_CHUNK_LINES, count);
+		chunk.stylesFonts = stylesFonts;
+		chunks->push_back(std::move(chunk));
+	}
+}
+
+void ScanFontsUsage(std::vector<FontsScanChunk> &chunks, size_t numThreads)
+{
+	std::atomic<size_t> next(0);
+	auto scan = [&chunks, &next]() {
+		size_t i;
+		while ((i = next++) < chunks.size()){
+			FontsScanChunk &chunk = chunks[i];
+			ScanLines(chunk.subs, chunk.start, chunk.end, chunk.stylesFonts, &chunk.usage);
+		}
+	};
+	numThreads = (std::min)(numThreads, chunks.size());
+	if (numThreads < 2){
+		scan();
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; i++){
+		threads.emplace_back(scan);
+	}
+	for (auto &thread : threads){
+		thread.join();
+	}
+}
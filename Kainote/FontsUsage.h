@@ -0,0 +1,74 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <bitset>
+#include <map>
+#include <vector>
+
+class SubsFile;
+class Styles;
+
+//characters used with one font, 256 bits for every used page of characters
+class CharacterSet
+{
+public:
+	void Add(unsigned int character);
+	void Add(const CharacterSet &other);
+	//skips \N and \n, \h is added as space
+	void AddText(const wxString &text);
+	bool IsEmpty() const { return pages.empty(); }
+	std::map<unsigned int, std::bitset<256>> pages;
+};
+
+//fonts found in part of lines of one tab
+struct FontsUsage
+{
+	struct Variant
+	{
+		wxString name;
+		int bold;
+		int italic;
+		CharacterSet characters;
+	};
+	//keys are lowercase names with bold and italic
+	std::map<wxString, Variant> variants;
+	//fonts set by \fn and number of line
+	std::vector<std::pair<wxString, int>> fontLines;
+};
+
+//key of font variant, lowercase name with bold and italic
+wxString GetFontKey(const wxString &name, int bold, int italic);
+
+//part of lines of one file scanned by one thread, stylesFonts are styles of file by name
+struct FontsScanChunk
+{
+	SubsFile *subs;
+	int tab;
+	size_t start;
+	size_t end;
+	const std::map<wxString, Styles*> *stylesFonts;
+	FontsUsage usage;
+};
+
+//splits lines of file to chunks added to the end of chunks
+void GetFontsScanChunks(SubsFile *subs, int tab, const std::map<wxString, Styles*> *stylesFonts, std::vector<FontsScanChunk> *chunks);
+
+//chunks of all files are taken by numThreads threads one by one, every chunk fills its own usage,
+//so merging them in order of chunks gives the same result like one thread.
+//Dialogues are not changed, parse data of lines are made on stack of thread
+void ScanFontsUsage(std::vector<FontsScanChunk> &chunks, size_t numThreads);
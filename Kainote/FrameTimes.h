@@ -0,0 +1,82 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <limits.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+//first frame from seekfrom that is not earlier than MS, notFound when every frame is earlier.
+//Some frames can be skipped when timecodes are read, so only numFrames first timecodes are searched.
+//Binary search needs timecodes that are not decreasing, broken ones are searched linearly like before
+inline int FindFrameFromMS(const std::vector<int> &timecodes, int numFrames, int MS, int seekfrom, int notFound, bool sorted)
+{
+	int numTimecodes = (std::min)(numFrames, (int)timecodes.size());
+	if (seekfrom < 0) { seekfrom = 0; }
+	if (seekfrom >= numTimecodes) { return notFound; }
+
+	auto begin = timecodes.begin() + seekfrom;
+	auto end = timecodes.begin() + numTimecodes;
+	auto it = (sorted) ? std::lower_bound(begin, end, MS) :
+		std::find_if(begin, end, [MS](int timecode) { return timecode >= MS; });
+	return (it != end) ? (int)(it - timecodes.begin()) : notFound;
+}
+
+//nearest keyframes found for one line by post-processor of SubsGridBase::ChangeTimes,
+//restored start or end was on keyframe before lead in or lead out and has to get old time back
+struct KeyframeSnap
+{
+	int startResult = INT_MAX;
+	int endResult = -1;
+	bool startRestored = false;
+	bool endRestored = false;
+};
+
+//keyframesStart has to be sorted, only keyframes from start and end ranges are checked
+inline KeyframeSnap FindKeyframeSnap(const std::vector<int> &keyframesStart, int start, int end, int oldStart, int oldEnd,
+	int startRange, int startRange1, int endRange, int endRange1)
+{
+	KeyframeSnap snap;
+	auto keyIt = std::lower_bound(keyframesStart.begin(), keyframesStart.end(), (std::min)(startRange, endRange));
+	int lastKeyMSS = (std::max)(startRange1, endRange1);
+	for (; keyIt != keyframesStart.end() && *keyIt <= lastKeyMSS; keyIt++) {
+		int keyMSS = *keyIt;
+		if (keyMSS >= startRange && keyMSS <= startRange1) {
+			if (oldStart == keyMSS) {
+				startRange = -1; startRange1 = -1; snap.startResult = INT_MAX;
+				start = oldStart;
+				snap.startRestored = true;
+			}
+			if (snap.startResult > keyMSS) {
+				if (snap.startResult == INT_MAX || abs(snap.startResult - start) > abs(keyMSS - start))
+					snap.startResult = keyMSS;
+			}
+		}
+		if (keyMSS >= endRange && keyMSS <= endRange1) {
+			if (oldEnd == keyMSS) {
+				endRange = -1; endRange1 = -1; snap.endResult = -1;
+				end = oldEnd;
+				snap.endRestored = true;
+			}
+			if (snap.endResult < keyMSS && keyMSS > start) {
+				if (snap.endResult == -1 || abs(snap.endResult - end) > abs(keyMSS - end))
+					snap.endResult = keyMSS;
+			}
+		}
+	}
+	return snap;
+}
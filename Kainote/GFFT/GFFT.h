@@ -15,28 +15,28 @@
 
 #pragma once
 
-template<typename T>
-class AbstractFFT;
+#include "SpectrumFFT.h"
 
 class Provider;
 
-const unsigned long line_length = 1 << 10; // number of frequency components per line (half of number of samples)
-const unsigned long doublelen = line_length * 2;
-
+//real input of doublelen samples is transformed as complex FFT of line_length points
+//output keeps complex values of first line_length frequencies
 class FFT
 {
 public:
 	FFT(){};
 	~FFT();
-	void Set(Provider *_prov);
+	void Set(Provider *_prov, int windowType = SPECTRUM_WINDOW_NONE);
 	void Transform(long long whre);
 	float Get(int i);
+	//magnitudes of line_length frequencies from last transform
+	void GetMagnitudes(float *magnitudes);
 	void SetAudio(long long from, long long to);
 	float * output;
 private:
 	Provider *prov;
 	short * input;
-	AbstractFFT<float>* gfft;
+	SpectrumFFT transform;
 	long long inputSize = 0;
 	long long from = 0;
 	//size_t lastend = 0;
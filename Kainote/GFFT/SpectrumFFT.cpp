@@ -0,0 +1,219 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SpectrumFFT.h"
+#include "../CpuFeatures.h"
+#include <math.h>
+#include <utility>
+
+#define SPECTRUM_PI 3.1415926535897932384626433832795
+
+void FFTStageScalar(float *data, unsigned long points, unsigned long half, const float *twiddles)
+{
+	const float *wr = twiddles;
+	const float *wi = twiddles + half * 2;
+	for (unsigned long block = 0; block < points * 2; block += half * 4) {
+		float *a = data + block;
+		float *b = a + half * 2;
+		for (unsigned long j = 0; j < half * 2; j += 2) {
+			float tr = b[j] * wr[j] + b[j + 1] * wi[j];
+			float ti = b[j + 1] * wr[j + 1] + b[j] * wi[j + 1];
+			b[j] = a[j] - tr;
+			b[j + 1] = a[j + 1] - ti;
+			a[j] += tr;
+			a[j + 1] += ti;
+		}
+	}
+}
+
+//two complex points in one register
+CPU_TARGET_SSE2 void FFTStageSSE2(float *data, unsigned long points, unsigned long half, const float *twiddles)
+{
+	if (half < 2) {
+		FFTStageScalar(data, points, half, twiddles);
+		return;
+	}
+	const float *wr = twiddles;
+	const float *wi = twiddles + half * 2;
+	for (unsigned long block = 0; block < points * 2; block += half * 4) {
+		float *a = data + block;
+		float *b = a + half * 2;
+		for (unsigned long j = 0; j < half * 2; j += 4) {
+			__m128 vb = _mm_loadu_ps(b + j);
+			__m128 swapped = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(2, 3, 0, 1));
+			__m128 t = _mm_add_ps(_mm_mul_ps(vb, _mm_loadu_ps(wr + j)), _mm_mul_ps(swapped, _mm_loadu_ps(wi + j)));
+			__m128 va = _mm_loadu_ps(a + j);
+			_mm_storeu_ps(b + j, _mm_sub_ps(va, t));
+			_mm_storeu_ps(a + j, _mm_add_ps(va, t));
+		}
+	}
+}
+
+//four complex points in one register
+CPU_TARGET_AVX2 void FFTStageAVX2(float *data, unsigned long points, unsigned long half, const float *twiddles)
+{
+	if (half < 4) {
+		FFTStageSSE2(data, points, half, twiddles);
+		return;
+	}
+	const float *wr = twiddles;
+	const float *wi = twiddles + half * 2;
+	for (unsigned long block = 0; block < points * 2; block += half * 4) {
+		float *a = data + block;
+		float *b = a + half * 2;
+		for (unsigned long j = 0; j < half * 2; j += 8) {
+			__m256 vb = _mm256_loadu_ps(b + j);
+			__m256 swapped = _mm256_permute_ps(vb, _MM_SHUFFLE(2, 3, 0, 1));
+			__m256 t = _mm256_add_ps(_mm256_mul_ps(vb, _mm256_loadu_ps(wr + j)), _mm256_mul_ps(swapped, _mm256_loadu_ps(wi + j)));
+			__m256 va = _mm256_loadu_ps(a + j);
+			_mm256_storeu_ps(b + j, _mm256_sub_ps(va, t));
+			_mm256_storeu_ps(a + j, _mm256_add_ps(va, t));
+		}
+	}
+}
+
+FFTStageFunction GetFFTStageFunction()
+{
+	static const FFTStageFunction stage = CpuHasAVX2() ? FFTStageAVX2 :
+		CpuHasSSE2() ? FFTStageSSE2 : FFTStageScalar;
+	return stage;
+}
+
+SpectrumFFT::SpectrumFFT(int windowType, FFTStageFunction stageFunction)
+	: stage(stageFunction)
+{
+	//reverse-binary reindexing
+	for (unsigned long i = 0, j = 0; i < line_length; i++) {
+		if (j > i) {
+			swaps.push_back(i);
+			swaps.push_back(j);
+		}
+		unsigned long bit = line_length >> 1;
+		while (bit && (j & bit)) {
+			j ^= bit;
+			bit >>= 1;
+		}
+		j |= bit;
+	}
+
+	//W^j = e^(-i*PI*j/half) like recursion of GFFT
+	stageTwiddles.resize((line_length - 1) * 4);
+	for (unsigned long half = 1; half < line_length; half <<= 1) {
+		float *wr = &stageTwiddles[(half - 1) * 4];
+		float *wi = wr + half * 2;
+		for (unsigned long j = 0; j < half; j++) {
+			double angle = SPECTRUM_PI * (double)j / (double)half;
+			wr[j * 2] = wr[j * 2 + 1] = (float)cos(angle);
+			wi[j * 2] = (float)sin(angle);
+			wi[j * 2 + 1] = (float)-sin(angle);
+		}
+	}
+
+	//W^k = e^(-i*PI*k/line_length)
+	twiddles.resize(doublelen);
+	for (unsigned long k = 0; k < line_length; k++) {
+		double angle = SPECTRUM_PI * (double)k / (double)line_length;
+		twiddles[k * 2] = (float)cos(angle);
+		twiddles[k * 2 + 1] = (float)-sin(angle);
+	}
+
+	if (windowType == SPECTRUM_WINDOW_HANN || windowType == SPECTRUM_WINDOW_BLACKMAN) {
+		window.resize(doublelen);
+		double sum = 0;
+		for (unsigned long i = 0; i < doublelen; i++) {
+			double phase = 2.0 * SPECTRUM_PI * (double)i / (double)doublelen;
+			window[i] = (windowType == SPECTRUM_WINDOW_HANN) ?
+				(float)(0.5 - 0.5 * cos(phase)) :
+				(float)(0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase));
+			sum += window[i];
+		}
+		//keeps spectrum as bright as without window
+		float gain = (float)(doublelen / sum);
+		for (unsigned long i = 0; i < doublelen; i++) {
+			window[i] *= gain;
+		}
+	}
+}
+
+void SpectrumFFT::Transform(const short *samples, float *output) const
+{
+	LoadSamples(samples, output);
+	ComplexTransform(output);
+	SplitRealOutput(output);
+}
+
+void SpectrumFFT::LoadSamples(const short *samples, float *output) const
+{
+	const float *windowData = window.empty() ? nullptr : window.data();
+	for (unsigned long i = 0; i < doublelen; i += 8) {
+		__m128i packed = _mm_loadu_si128((const __m128i *)(samples + i));
+		__m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+		__m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+		if (windowData) {
+			low = _mm_mul_ps(low, _mm_loadu_ps(windowData + i));
+			high = _mm_mul_ps(high, _mm_loadu_ps(windowData + i + 4));
+		}
+		_mm_storeu_ps(output + i, low);
+		_mm_storeu_ps(output + i + 4, high);
+	}
+}
+
+void SpectrumFFT::ComplexTransform(float *data) const
+{
+	for (size_t i = 0; i < swaps.size(); i += 2) {
+		unsigned long first = swaps[i] * 2, second = swaps[i + 1] * 2;
+		std::swap(data[first], data[second]);
+		std::swap(data[first + 1], data[second + 1]);
+	}
+	for (unsigned long half = 1; half < line_length; half <<= 1) {
+		stage(data, line_length, half, &stageTwiddles[(half - 1) * 4]);
+	}
+}
+
+//X[k] = E[k] + W^k * O[k], E = (Z[k] + conj(Z[M - k])) / 2, O = (Z[k] - conj(Z[M - k])) / 2i
+void SpectrumFFT::SplitRealOutput(float *output) const
+{
+	float re0 = output[0], im0 = output[1];
+	output[0] = re0 + im0;
+	output[1] = 0.f;
+	for (unsigned long k = 1; k <= line_length / 2; k++) {
+		unsigned long m = line_length - k;
+		float ar = output[k * 2], ai = output[k * 2 + 1];
+		float br = output[m * 2], bi = output[m * 2 + 1];
+		//E and O for k, for m both are conjugated
+		float er = (ar + br) * 0.5f, ei = (ai - bi) * 0.5f;
+		float odr = (ai + bi) * 0.5f, odi = (br - ar) * 0.5f;
+		float wr = twiddles[k * 2], wi = twiddles[k * 2 + 1];
+		float tr = odr * wr - odi * wi, ti = odr * wi + odi * wr;
+		output[k * 2] = er + tr;
+		output[k * 2 + 1] = ei + ti;
+		wr = twiddles[m * 2]; wi = twiddles[m * 2 + 1];
+		tr = odr * wr + odi * wi; ti = odr * wi - odi * wr;
+		output[m * 2] = er + tr;
+		output[m * 2 + 1] = -ei + ti;
+	}
+}
+
+void SpectrumFFT::GetMagnitudes(const float *output, float *magnitudes)
+{
+	for (unsigned long j = 0; j < line_length; j += 4) {
+		__m128 first = _mm_loadu_ps(output + j * 2);
+		__m128 second = _mm_loadu_ps(output + j * 2 + 4);
+		__m128 re = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 im = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 sum = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+		_mm_storeu_ps(magnitudes + j, _mm_sqrt_ps(sum));
+	}
+}
@@ -0,0 +1,67 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+const unsigned long line_length = 1 << 10; // number of frequency components per line (half of number of samples)
+const unsigned long doublelen = line_length * 2;
+
+enum {
+	SPECTRUM_WINDOW_NONE = 0,
+	SPECTRUM_WINDOW_HANN,
+	SPECTRUM_WINDOW_BLACKMAN
+};
+
+//butterflies of one stage of radix-2 FFT on interleaved complex data,
+//every block of 2 * half points is made from its two halves.
+//twiddles has 2 * half real parts of twiddles, every one twice, and then 2 * half imaginary parts as -im, im,
+//so complex multiply is two multiplies of the same layout, all versions give the same result
+typedef void(*FFTStageFunction)(float *data, unsigned long points, unsigned long half, const float *twiddles);
+
+void FFTStageScalar(float *data, unsigned long points, unsigned long half, const float *twiddles);
+void FFTStageSSE2(float *data, unsigned long points, unsigned long half, const float *twiddles);
+void FFTStageAVX2(float *data, unsigned long points, unsigned long half, const float *twiddles);
+
+//chooses the fastest version supported by processor, checked only once
+FFTStageFunction GetFFTStageFunction();
+
+//spectrum line of doublelen real samples, they are transformed as complex FFT of line_length points.
+//Twiddles of every stage are computed once, so butterflies of stage don't depend on each other
+class SpectrumFFT
+{
+public:
+	SpectrumFFT(int windowType = SPECTRUM_WINDOW_NONE, FFTStageFunction stageFunction = GetFFTStageFunction());
+	//output needs doublelen floats, it gets complex values of first line_length frequencies
+	void Transform(const short *samples, float *output) const;
+	//even samples are used as real and odd as imaginary part of complex input
+	void LoadSamples(const short *samples, float *output) const;
+	//complex FFT of line_length points with negative exponent
+	void ComplexTransform(float *data) const;
+	//counts frequencies of real input from its complex transform
+	void SplitRealOutput(float *output) const;
+	static void GetMagnitudes(const float *output, float *magnitudes);
+private:
+	FFTStageFunction stage;
+	//pairs of points swapped by bit reversal
+	std::vector<unsigned long> swaps;
+	//stage with half points starts at 4 * (half - 1)
+	std::vector<float> stageTwiddles;
+	//cos and sin for every frequency of real transform
+	std::vector<float> twiddles;
+	//empty when window is not used
+	std::vector<float> window;
+};
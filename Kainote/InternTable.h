@@ -0,0 +1,147 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+//text with number of owners in one allocation, interned texts are never changed
+//and are kept in table of texts until the last owner releases them
+struct TextBlock
+{
+	TextBlock(const wxString &_text, bool _interned = false) : text(_text), interned(_interned){}
+	//unique number of every block and every change of text in place
+	static size_t NewVersion()
+	{
+		static std::atomic<size_t> lastVersion{ 0 };
+		return ++lastVersion;
+	}
+	wxString text;
+	std::atomic<size_t> references{ 1 };
+	size_t version = NewVersion();
+	bool interned;
+};
+
+//table of interned texts, global one is used under lock.
+//Threads that parse a lot of dialogues at once use their own tables without lock,
+//Merge moves their texts to global table after threads end.
+//Text can have more than one block when it was interned by other thread before merge,
+//global table points to only one of them
+class InternTable
+{
+public:
+	InternTable(){}
+	InternTable(const InternTable &) = delete;
+	~InternTable(){ Merge(); }
+	//texts interned on this thread go to table until Use(nullptr)
+	static void Use(InternTable *table){ threadTable = table; }
+	//call it when no thread uses table
+	void Merge()
+	{
+		if (texts.empty())
+			return;
+
+		std::lock_guard<std::mutex> lock(GlobalMutex());
+		auto &globalTexts = GlobalTexts();
+		for (auto &text : texts){
+			TextBlock *block = text.second;
+			//other owners of texts found in global table keep their own block
+			auto it = globalTexts.insert(std::make_pair(text.first, block)).first;
+			//reference of this table
+			if (block->references.fetch_sub(1) == 1){
+				if (it->second == block)
+					globalTexts.erase(it);
+				delete block;
+			}
+		}
+		texts.clear();
+	}
+	//finds equal text in table of this thread or in global table or adds it there,
+	//returned block has reference of caller
+	static TextBlock *Intern(const wxString &txt)
+	{
+		if (threadTable){
+			auto &texts = threadTable->texts;
+			auto it = texts.find(Key(txt));
+			if (it != texts.end()){
+				it->second->references++;
+				return it->second;
+			}
+			TextBlock *newBlock = new TextBlock(txt, true);
+			//one reference for caller and one for table
+			newBlock->references++;
+			//key points to text of block, it lives as long as block is in table
+			texts.insert(std::make_pair(Key(newBlock->text), newBlock));
+			return newBlock;
+		}
+		std::lock_guard<std::mutex> lock(GlobalMutex());
+		auto &globalTexts = GlobalTexts();
+		auto it = globalTexts.find(Key(txt));
+		if (it != globalTexts.end()){
+			it->second->references++;
+			return it->second;
+		}
+		TextBlock *newBlock = new TextBlock(txt, true);
+		globalTexts.insert(std::make_pair(Key(newBlock->text), newBlock));
+		return newBlock;
+	}
+	static void Release(TextBlock *block)
+	{
+		//other owners can't release it to zero at the same time
+		size_t references = block->references.load();
+		while (references > 1){
+			if (block->references.compare_exchange_weak(references, references - 1))
+				return;
+		}
+		//the last owner removes block from table under lock, so no one can find it there in the meantime
+		std::lock_guard<std::mutex> lock(GlobalMutex());
+		if (block->references.fetch_sub(1) == 1){
+			auto &globalTexts = GlobalTexts();
+			auto it = globalTexts.find(Key(block->text));
+			if (it != globalTexts.end() && it->second == block)
+				globalTexts.erase(it);
+			delete block;
+		}
+	}
+	//number of texts in global table
+	static size_t GlobalSize()
+	{
+		std::lock_guard<std::mutex> lock(GlobalMutex());
+		return GlobalTexts().size();
+	}
+
+private:
+	static std::wstring_view Key(const wxString &text)
+	{
+		return std::wstring_view(text.wc_str(), text.length());
+	}
+	static std::mutex &GlobalMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+	//table is never deleted, dialogues can be released after static objects destruction
+	static std::unordered_map<std::wstring_view, TextBlock*> &GlobalTexts()
+	{
+		static auto *globalTexts = new std::unordered_map<std::wstring_view, TextBlock*>();
+		return *globalTexts;
+	}
+	static inline thread_local InternTable *threadTable = nullptr;
+	std::unordered_map<std::wstring_view, TextBlock*> texts;
+};
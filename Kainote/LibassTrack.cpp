@@ -0,0 +1,159 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LibassTrack.h"
+#include <string.h>
+
+bool LibassIncrementalTrack::KeepEvent(LibassEventKey *key, unsigned long long fingerprint, int readOrder)
+{
+	auto it = events.find(*key);
+	while (it != events.end() && it->second.claimed == generation){
+		key->occurrence++;
+		it = events.find(*key);
+	}
+	if (it == events.end()){
+		//placeholder reserves key for next rows, it's removed by RemoveUnusedEvents and added again by AddEvent
+		events.emplace(*key, LibassEvent{ 0, -1, readOrder, generation - 1, generation });
+		return false;
+	}
+	it->second.claimed = generation;
+	//changed line stays with old generation and is removed
+	if (it->second.fingerprint != fingerprint)
+		return false;
+
+	it->second.readOrder = readOrder;
+	it->second.generation = generation;
+	return true;
+}
+
+ASS_Track *LibassIncrementalTrack::Reload(ASS_Library *library, ASS_Track *track, const wxString &header, const void *owner)
+{
+	Reset();
+	if (track)
+		ass_free_track(track);
+
+	wxScopedCharBuffer buffer = header.mb_str(wxConvUTF8);
+	track = ass_read_memory(library, buffer.data(), strlen(buffer), nullptr);
+	if (!track)
+		return nullptr;
+
+	trackHeader = header;
+	trackOwner = owner;
+	active = true;
+	return track;
+}
+
+void LibassIncrementalTrack::RemoveUnusedEvents(ASS_Track *track)
+{
+	int numEvents = track->n_events;
+	//-1 means removed, after compaction new event id
+	std::vector<int> newIds(numEvents, 0);
+	bool anyRemoved = false;
+	if (maskEventId >= 0){
+		newIds[maskEventId] = -1;
+		maskEventId = -1;
+		anyRemoved = true;
+	}
+	for (auto it = events.begin(); it != events.end();){
+		if (it->second.generation != generation){
+			if (it->second.eventId >= 0){
+				newIds[it->second.eventId] = -1;
+				anyRemoved = true;
+			}
+			it = events.erase(it);
+		}
+		else
+			it++;
+	}
+	if (anyRemoved)
+		RemoveEvents(track, newIds);
+	//kept lines can change order when lines were inserted before them
+	for (auto &event : events){
+		if (event.second.eventId >= 0)
+			track->events[event.second.eventId].ReadOrder = event.second.readOrder;
+	}
+}
+
+void LibassIncrementalTrack::RemoveEvents(ASS_Track *track, std::vector<int> &newIds)
+{
+	int j = 0;
+	for (int i = 0; i < track->n_events; i++){
+		if (newIds[i] < 0){
+			ass_free_event(track, i);
+			continue;
+		}
+		if (i != j)
+			track->events[j] = track->events[i];
+
+		newIds[i] = j++;
+	}
+	track->n_events = j;
+	for (auto &event : events){
+		if (event.second.eventId >= 0)
+			event.second.eventId = newIds[event.second.eventId];
+	}
+	if (maskEventId >= 0)
+		maskEventId = newIds[maskEventId];
+}
+
+void LibassIncrementalTrack::AddEvent(ASS_Track *track, LibassEventKey key, unsigned long long fingerprint, const wxString &rawLine, int readOrder)
+{
+	//after reload rows were not checked by KeepEvent, rows with the same dialogue are found here
+	auto it = events.find(key);
+	while (it != events.end() && it->second.generation == generation){
+		key.occurrence++;
+		it = events.find(key);
+	}
+	//event from earlier update would stay in track as ghost line
+	if (it != events.end()){
+		if (it->second.eventId >= 0){
+			std::vector<int> newIds(track->n_events, 0);
+			newIds[it->second.eventId] = -1;
+			it->second.eventId = -1;
+			RemoveEvents(track, newIds);
+		}
+		events.erase(it);
+	}
+	int eventId = ProcessLine(track, rawLine, readOrder);
+	events.emplace(key, LibassEvent{ fingerprint, eventId, readOrder, generation, generation });
+}
+
+void LibassIncrementalTrack::AddMask(ASS_Track *track, const wxString &mask, int readOrder)
+{
+	maskEventId = ProcessLine(track, mask, readOrder);
+}
+
+void LibassIncrementalTrack::Reset()
+{
+	events.clear();
+	trackHeader.clear();
+	trackOwner = nullptr;
+	maskEventId = -1;
+	active = false;
+}
+
+int LibassIncrementalTrack::ProcessLine(ASS_Track *track, const wxString &rawLine, int readOrder)
+{
+	int numEvents = track->n_events;
+	wxScopedCharBuffer buffer = rawLine.mb_str(wxConvUTF8);
+	ass_process_data(track, buffer.data(), strlen(buffer));
+	//comments do not create events
+	if (track->n_events <= numEvents)
+		return -1;
+
+	int eventId = track->n_events - 1;
+	track->events[eventId].ReadOrder = readOrder;
+	return eventId;
+}
@@ -0,0 +1,105 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <libass/ass.h>
+}
+
+//key of event in libass track, line is dialogue and tl is used for translation in TL mode,
+//one dialogue can be in more rows after SubsFile::InsertRows, occurrence is number of row with the same dialogue
+struct LibassEventKey
+{
+	const void *line;
+	bool tl;
+	int occurrence = 0;
+	bool operator ==(const LibassEventKey &key) const{
+		return line == key.line && tl == key.tl && occurrence == key.occurrence;
+	}
+};
+
+struct LibassEventKeyHash
+{
+	size_t operator()(const LibassEventKey &key) const{
+		return std::hash<const void *>()(key.line) ^ (size_t)key.tl ^ ((size_t)key.occurrence << 1);
+	}
+};
+
+//64 bit even in 32 bit build, fingerprint is the only check if line changed
+inline void LibassHashCombine(unsigned long long &seed, unsigned long long value)
+{
+	seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+//FNV-1a of characters
+inline void LibassHashString(unsigned long long &seed, const wchar_t *text, size_t length)
+{
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < length; i++){
+		hash = (hash ^ (unsigned long long)text[i]) * 0x100000001b3ULL;
+	}
+	LibassHashCombine(seed, hash);
+}
+
+struct LibassEvent
+{
+	//hash of all values written by GetRaw, pointer can be reused after delete
+	unsigned long long fingerprint;
+	int eventId;
+	int readOrder;
+	//update that kept or added event
+	unsigned int generation;
+	//update that gave key to row, next rows with the same dialogue get next occurrence
+	unsigned int claimed;
+};
+
+//events of libass track that are updated line by line, header and styles stay in track.
+//Every update starts with BeginUpdate, lines that are not kept or added till the next update
+//are removed by RemoveUnusedEvents, whole track is read again only when header or owner changes
+class LibassIncrementalTrack
+{
+public:
+	void BeginUpdate(){ if (++generation == 0) generation = 1; }
+	bool NeedsReload(const void *owner, const wxString &header) const{
+		return !active || owner != trackOwner || header != trackHeader;
+	}
+	//returns true when line with the same fingerprint is in track, it's kept with new read order.
+	//Key gets the first occurrence not used by earlier rows of this update
+	bool KeepEvent(LibassEventKey *key, unsigned long long fingerprint, int readOrder);
+	//frees old track and reads header to new one, returns null when libass can't read it
+	ASS_Track *Reload(ASS_Library *library, ASS_Track *track, const wxString &header, const void *owner);
+	//removes lines not kept in this update and sets read order of kept ones
+	void RemoveUnusedEvents(ASS_Track *track);
+	//key gets next occurrence when it's used by event of this update, old event of key is removed from track
+	void AddEvent(ASS_Track *track, LibassEventKey key, unsigned long long fingerprint, const wxString &rawLine, int readOrder);
+	//clip mask of vector clip, it's removed on every update
+	void AddMask(ASS_Track *track, const wxString &mask, int readOrder);
+	void Reset();
+private:
+	static int ProcessLine(ASS_Track *track, const wxString &rawLine, int readOrder);
+	//frees events with new id -1, moves the rest and changes ids of events to new ones
+	void RemoveEvents(ASS_Track *track, std::vector<int> &newIds);
+	std::unordered_map<LibassEventKey, LibassEvent, LibassEventKeyHash> events;
+	wxString trackHeader;
+	const void *trackOwner = nullptr;
+	unsigned int generation = 0;
+	int maskEventId = -1;
+	bool active = false;
+};
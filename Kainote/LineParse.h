@@ -46,12 +46,18 @@ public:
 	wxArrayInt errors;
 	bool isInit = false;
 	bool badWraps = false;
+	//misspells for text editor, background check fills it when tags are not replaced
+	std::vector<MisspellData> misspells;
+	bool hasMisspells = false;
+	bool spellchecker = false;
 	void clear() {
 		errors.Clear(); 
 		isInit = false;
 		chars = 0;
 		wraps.clear();
 		badWraps = false;
+		misspells.clear();
+		hasMisspells = false;
 	};
 	size_t size() { return errors.GetCount(); }
 	//void insert(_wxArraywxArrayInt *it, size_t n, const _wxArraywxArrayInt &val) { errors.insert(it, n, val); }
@@ -65,6 +71,8 @@ public:
 		chars = 0;
 		wraps = L"0/";
 		badWraps = false;
+		misspells.clear();
+		hasMisspells = false;
 	}
 	int GetCPS(Dialogue *line) const;
 	wxString GetStrippedWraps();
@@ -0,0 +1,774 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "MatroskaReader.h"
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+#include <algorithm>
+
+//ids of elements with their length markers
+enum {
+	EBML_HEADER = 0x1A45DFA3,
+	EBML_DOC_TYPE = 0x4282,
+	MKV_SEGMENT = 0x18538067,
+	MKV_SEEK_HEAD = 0x114D9B74,
+	MKV_SEEK = 0x4DBB,
+	MKV_SEEK_ID = 0x53AB,
+	MKV_SEEK_POSITION = 0x53AC,
+	MKV_INFO = 0x1549A966,
+	MKV_TIMECODE_SCALE = 0x2AD7B1,
+	MKV_TRACKS = 0x1654AE6B,
+	MKV_TRACK_ENTRY = 0xAE,
+	MKV_TRACK_NUMBER = 0xD7,
+	MKV_TRACK_TYPE = 0x83,
+	MKV_CODEC_ID = 0x86,
+	MKV_CODEC_PRIVATE = 0x63A2,
+	MKV_NAME = 0x536E,
+	MKV_LANGUAGE = 0x22B59C,
+	MKV_DEFAULT_DURATION = 0x23E383,
+	MKV_CONTENT_ENCODINGS = 0x6D80,
+	MKV_CONTENT_ENCODING = 0x6240,
+	MKV_CONTENT_ENCODING_SCOPE = 0x5032,
+	MKV_CONTENT_ENCODING_TYPE = 0x5033,
+	MKV_CONTENT_COMPRESSION = 0x5034,
+	MKV_CONTENT_COMP_ALGO = 0x4254,
+	MKV_CONTENT_COMP_SETTINGS = 0x4255,
+	MKV_CONTENT_ENCRYPTION = 0x5035,
+	MKV_ATTACHMENTS = 0x1941A469,
+	MKV_ATTACHED_FILE = 0x61A7,
+	MKV_FILE_NAME = 0x466E,
+	MKV_FILE_MIME_TYPE = 0x4660,
+	MKV_FILE_DATA = 0x465C,
+	MKV_CUES = 0x1C53BB6B,
+	MKV_CUE_POINT = 0xBB,
+	MKV_CUE_TRACK_POSITIONS = 0xB7,
+	MKV_CUE_TRACK = 0xF7,
+	MKV_CUE_CLUSTER_POSITION = 0xF1,
+	MKV_CLUSTER = 0x1F43B675,
+	MKV_CLUSTER_TIMECODE = 0xE7,
+	MKV_CLUSTER_POSITION = 0xA7,
+	MKV_CLUSTER_PREV_SIZE = 0xAB,
+	MKV_SILENT_TRACKS = 0x5854,
+	MKV_SIMPLE_BLOCK = 0xA3,
+	MKV_BLOCK_GROUP = 0xA0,
+	MKV_BLOCK = 0xA1,
+	MKV_BLOCK_DURATION = 0x9B,
+	MKV_ENCRYPTED_BLOCK = 0xAF,
+	EBML_VOID = 0xEC,
+	EBML_CRC32 = 0xBF,
+};
+
+bool MatroskaReader::Open(const wxString &filename)
+{
+	Close();
+	if (!file.Open(filename, wxFile::read))
+		return false;
+
+	fileSize = file.Length();
+	Element header;
+	if (!ReadElement(0, &header) || header.id != EBML_HEADER) {
+		Close();
+		return false;
+	}
+	wxString docType;
+	for (long long pos = header.dataStart; pos < header.End();) {
+		Element child;
+		if (!ReadElement(pos, &child))
+			break;
+		if (child.id == EBML_DOC_TYPE)
+			docType = ReadString(child);
+		pos = child.End();
+	}
+	if (docType != L"matroska" && docType != L"webm") {
+		Close();
+		return false;
+	}
+
+	Element segment;
+	long long pos = header.End();
+	while (ReadElement(pos, &segment) && segment.id != MKV_SEGMENT && !segment.unknownSize) {
+		pos = segment.End();
+	}
+	if (segment.id != MKV_SEGMENT) {
+		Close();
+		return false;
+	}
+	segmentStart = segment.dataStart;
+	segmentEnd = segment.End();
+
+	//headers are before first cluster, seek head points to the rest
+	Element element;
+	pos = segmentStart;
+	while (pos < segmentEnd && ReadElement(pos, &element)) {
+		if (element.id == MKV_CLUSTER) {
+			firstCluster = pos;
+			break;
+		}
+		ParseLevel1(element);
+		if (element.unknownSize)
+			break;
+		pos = element.End();
+	}
+	//without seek head cues and attachments after clusters can be found only by skipping clusters
+	if (!seekHeadFound && firstCluster >= 0) {
+		while (pos < segmentEnd && ReadElement(pos, &element) && !element.unknownSize) {
+			if (element.id != MKV_CLUSTER)
+				ParseLevel1(element);
+			pos = element.End();
+		}
+	}
+	return tracks.size() > 0;
+}
+
+void MatroskaReader::Close()
+{
+	if (file.IsOpened())
+		file.Close();
+	fileSize = 0;
+	segmentStart = segmentEnd = 0;
+	firstCluster = -1;
+	seekHeadFound = false;
+	timecodeScale = 1000000;
+	tracks.clear();
+	attachments.clear();
+	cuedClusters.clear();
+	parsedElements.clear();
+	readBufferStart = -1;
+	readBufferSize = 0;
+}
+
+const MatroskaTrack *MatroskaReader::GetTrack(unsigned long long number)
+{
+	for (auto &track : tracks) {
+		if (track.number == number)
+			return &track;
+	}
+	return nullptr;
+}
+
+bool MatroskaReader::ReadFrames(unsigned long long trackNumber, std::vector<MatroskaFrame> *frames, std::function<bool(int)> progress,
+	bool cuedClustersOnly)
+{
+	const MatroskaTrack *track = GetTrack(trackNumber);
+	if (!track || track->encrypted || (track->compression != -1 && track->compression != 0 && track->compression != 3))
+		return false;
+
+	if (cuedClustersOnly) {
+		std::vector<long long> clusters;
+		for (auto &cue : cuedClusters) {
+			if (cue.first == trackNumber)
+				clusters.push_back(cue.second);
+		}
+		if (clusters.size()) {
+			size_t firstFrame = frames->size();
+			bool canceled = false;
+			if (ReadCuedClusters(*track, clusters, frames, progress, &canceled))
+				return true;
+			if (canceled)
+				return false;
+			//cues point to other elements, frames are read again by cluster scan
+			frames->resize(firstFrame);
+		}
+	}
+
+	//every cluster is read, blocks of other tracks are skipped by size
+	long long pos = (firstCluster >= 0) ? firstCluster : segmentStart;
+	Element element;
+	while (pos < segmentEnd && ReadElement(pos, &element)) {
+		if (element.id == MKV_CLUSTER) {
+			pos = ReadCluster(element, *track, frames);
+			if (progress && progress(Progress(pos)))
+				return false;
+		}
+		else if (element.unknownSize)
+			break;
+		else
+			pos = element.End();
+	}
+	return true;
+}
+
+bool MatroskaReader::ReadAttachment(size_t i, std::string *data)
+{
+	if (i >= attachments.size())
+		return false;
+
+	Element element;
+	element.dataStart = attachments[i].dataPosition;
+	element.size = attachments[i].dataSize;
+	*data = ReadData(element);
+	return data->size() == (size_t)element.size;
+}
+
+bool MatroskaReader::ReadAt(long long pos, void *buffer, size_t length)
+{
+	if (pos < 0 || pos + (long long)length > fileSize)
+		return false;
+
+	if (length > sizeof(readBuffer)) {
+		return file.Seek(pos) != wxInvalidOffset && file.Read(buffer, length) == (ssize_t)length;
+	}
+	if (readBufferStart < 0 || pos < readBufferStart || pos + (long long)length > readBufferStart + (long long)readBufferSize) {
+		readBufferStart = -1;
+		if (file.Seek(pos) == wxInvalidOffset)
+			return false;
+		ssize_t numRead = file.Read(readBuffer, sizeof(readBuffer));
+		if (numRead < (ssize_t)length)
+			return false;
+		readBufferStart = pos;
+		readBufferSize = numRead;
+	}
+	memcpy(buffer, readBuffer + (pos - readBufferStart), length);
+	return true;
+}
+
+//reads number from memory, returns false when it's longer than data
+static bool ParseVint(const unsigned char *data, size_t size, size_t *pos, unsigned long long *value, int *length)
+{
+	if (*pos >= size || !data[*pos])
+		return false;
+
+	int vintLength = 1;
+	while (!(data[*pos] & (0x80 >> (vintLength - 1)))) { vintLength++; }
+	if (*pos + vintLength > size)
+		return false;
+
+	unsigned long long result = data[*pos] & (0xFF >> vintLength);
+	for (int i = 1; i < vintLength; i++) {
+		result = (result << 8) | data[*pos + i];
+	}
+	*pos += vintLength;
+	*value = result;
+	*length = vintLength;
+	return true;
+}
+
+//sizes of frames of block data from pos, without lacing it's one frame with the rest of block
+static bool ParseLacing(const unsigned char *data, size_t size, size_t *pos, int lacing, std::vector<size_t> *sizes)
+{
+	if (!lacing) {
+		sizes->push_back(size - *pos);
+		return true;
+	}
+	if (*pos >= size)
+		return false;
+
+	size_t count = data[(*pos)++] + 1;
+	//fixed lacing, all frames have the same size
+	if (lacing == 2) {
+		if ((size - *pos) % count)
+			return false;
+		sizes->assign(count, (size - *pos) / count);
+		return true;
+	}
+	//sizes of all frames but the last one are stored
+	size_t lacedSize = 0;
+	long long frameSize = 0;
+	for (size_t i = 0; i + 1 < count; i++) {
+		if (lacing == 1) {
+			//Xiph lacing, size is sum of bytes ended by byte other than 255
+			unsigned char byte;
+			frameSize = 0;
+			do {
+				if (*pos >= size)
+					return false;
+				byte = data[(*pos)++];
+				frameSize += byte;
+			} while (byte == 255);
+		}
+		else {
+			//EBML lacing, next sizes are signed differences of previous size
+			unsigned long long value;
+			int length;
+			if (!ParseVint(data, size, pos, &value, &length))
+				return false;
+			frameSize = (i == 0) ? (long long)value : frameSize + (long long)value - ((1LL << (7 * length - 1)) - 1);
+			if (frameSize < 0)
+				return false;
+		}
+		sizes->push_back((size_t)frameSize);
+		lacedSize += (size_t)frameSize;
+	}
+	if (lacedSize > size - *pos)
+		return false;
+	sizes->push_back(size - *pos - lacedSize);
+	return true;
+}
+
+bool MatroskaReader::ReadVint(long long *pos, unsigned long long *value, int *length)
+{
+	unsigned char bytes[8];
+	if (!ReadAt(*pos, bytes, 1) || !bytes[0])
+		return false;
+
+	int vintLength = 1;
+	while (!(bytes[0] & (0x80 >> (vintLength - 1)))) { vintLength++; }
+	if (vintLength > 1 && !ReadAt(*pos, bytes, vintLength))
+		return false;
+
+	unsigned long long result = bytes[0] & (0xFF >> vintLength);
+	for (int i = 1; i < vintLength; i++) {
+		result = (result << 8) | bytes[i];
+	}
+	*pos += vintLength;
+	*value = result;
+	*length = vintLength;
+	return true;
+}
+
+bool MatroskaReader::ReadElement(long long pos, Element *element, unsigned long long *blockTrack)
+{
+	//id, size and track number of block are read at once
+	unsigned char bytes[20];
+	if (pos < 0 || pos >= fileSize)
+		return false;
+	size_t bytesSize = (size_t)(std::min)((long long)sizeof(bytes), fileSize - pos);
+	if (!ReadAt(pos, bytes, bytesSize))
+		return false;
+
+	//ids are kept with length marker
+	int idLength = 1;
+	while (idLength <= 4 && !(bytes[0] & (0x80 >> (idLength - 1)))) { idLength++; }
+	if (idLength > 4 || (size_t)idLength > bytesSize)
+		return false;
+
+	unsigned int id = 0;
+	for (int i = 0; i < idLength; i++) {
+		id = (id << 8) | bytes[i];
+	}
+	size_t offset = idLength;
+	unsigned long long size;
+	int sizeLength;
+	if (!ParseVint(bytes, bytesSize, &offset, &size, &sizeLength))
+		return false;
+
+	if (blockTrack) {
+		*blockTrack = 0;
+		int trackLength;
+		size_t trackOffset = offset;
+		if (id == MKV_SIMPLE_BLOCK || id == MKV_BLOCK)
+			ParseVint(bytes, bytesSize, &trackOffset, blockTrack, &trackLength);
+	}
+	pos += offset;
+	element->id = id;
+	element->dataStart = pos;
+	//all bits set means unknown size
+	element->unknownSize = (size == (1ULL << (7 * sizeLength)) - 1);
+	long long end = (segmentEnd > 0) ? segmentEnd : fileSize;
+	if (element->unknownSize || size > (unsigned long long)(end - pos))
+		element->size = (std::max)(0LL, end - pos);
+	else
+		element->size = (long long)size;
+	return true;
+}
+
+unsigned long long MatroskaReader::ReadUInt(const Element &element)
+{
+	unsigned char bytes[8];
+	if (element.size < 1 || element.size > 8 || !ReadAt(element.dataStart, bytes, element.size))
+		return 0;
+
+	unsigned long long result = 0;
+	for (long long i = 0; i < element.size; i++) {
+		result = (result << 8) | bytes[i];
+	}
+	return result;
+}
+
+std::string MatroskaReader::ReadData(const Element &element)
+{
+	std::string result;
+	if (element.size <= 0)
+		return result;
+
+	result.resize(element.size);
+	if (!ReadAt(element.dataStart, &result[0], element.size))
+		result.clear();
+	return result;
+}
+
+wxString MatroskaReader::ReadString(const Element &element)
+{
+	std::string data = ReadData(element);
+	//strings can be padded with zeros
+	return wxString::FromUTF8(data.c_str());
+}
+
+void MatroskaReader::ParseLevel1(const Element &element)
+{
+	if (std::find(parsedElements.begin(), parsedElements.end(), element.dataStart) != parsedElements.end())
+		return;
+
+	parsedElements.push_back(element.dataStart);
+	switch (element.id) {
+	case MKV_SEEK_HEAD: ParseSeekHead(element); break;
+	case MKV_INFO: ParseInfo(element); break;
+	case MKV_TRACKS: ParseTracks(element); break;
+	case MKV_ATTACHMENTS: ParseAttachments(element); break;
+	case MKV_CUES: ParseCues(element); break;
+	default: break;
+	}
+}
+
+void MatroskaReader::ParseSeekHead(const Element &seekHead)
+{
+	seekHeadFound = true;
+	for (long long pos = seekHead.dataStart; pos < seekHead.End();) {
+		Element seek;
+		if (!ReadElement(pos, &seek))
+			break;
+		pos = seek.End();
+		if (seek.id != MKV_SEEK)
+			continue;
+
+		unsigned int id = 0;
+		long long position = -1;
+		for (long long childPos = seek.dataStart; childPos < seek.End();) {
+			Element child;
+			if (!ReadElement(childPos, &child))
+				break;
+			if (child.id == MKV_SEEK_ID) {
+				std::string idData = ReadData(child);
+				for (unsigned char ch : idData) { id = (id << 8) | ch; }
+			}
+			else if (child.id == MKV_SEEK_POSITION) {
+				position = ReadUInt(child);
+			}
+			childPos = child.End();
+		}
+		if (position < 0 || (id != MKV_SEEK_HEAD && id != MKV_INFO && id != MKV_TRACKS &&
+			id != MKV_ATTACHMENTS && id != MKV_CUES))
+			continue;
+
+		Element element;
+		if (ReadElement(segmentStart + position, &element) && element.id == id)
+			ParseLevel1(element);
+	}
+}
+
+void MatroskaReader::ParseInfo(const Element &info)
+{
+	for (long long pos = info.dataStart; pos < info.End();) {
+		Element child;
+		if (!ReadElement(pos, &child))
+			break;
+		if (child.id == MKV_TIMECODE_SCALE) {
+			timecodeScale = ReadUInt(child);
+			if (!timecodeScale)
+				timecodeScale = 1000000;
+		}
+		pos = child.End();
+	}
+}
+
+void MatroskaReader::ParseTracks(const Element &tracksElement)
+{
+	for (long long pos = tracksElement.dataStart; pos < tracksElement.End();) {
+		Element entry;
+		if (!ReadElement(pos, &entry))
+			break;
+		pos = entry.End();
+		if (entry.id != MKV_TRACK_ENTRY)
+			continue;
+
+		MatroskaTrack track;
+		for (long long childPos = entry.dataStart; childPos < entry.End();) {
+			Element child;
+			if (!ReadElement(childPos, &child))
+				break;
+			switch (child.id) {
+			case MKV_TRACK_NUMBER: track.number = ReadUInt(child); break;
+			case MKV_TRACK_TYPE: track.type = (int)ReadUInt(child); break;
+			case MKV_CODEC_ID: track.codec = ReadString(child); break;
+			case MKV_CODEC_PRIVATE: track.codecPrivate = ReadData(child); break;
+			case MKV_NAME: track.name = ReadString(child); break;
+			case MKV_LANGUAGE: track.language = ReadString(child); break;
+			case MKV_DEFAULT_DURATION: track.defaultDuration = ReadUInt(child); break;
+			case MKV_CONTENT_ENCODINGS: ParseContentEncodings(child, &track); break;
+			default: break;
+			}
+			childPos = child.End();
+		}
+		if (track.number)
+			tracks.push_back(track);
+	}
+}
+
+void MatroskaReader::ParseContentEncodings(const Element &encodings, MatroskaTrack *track)
+{
+	for (long long pos = encodings.dataStart; pos < encodings.End();) {
+		Element encoding;
+		if (!ReadElement(pos, &encoding))
+			break;
+		pos = encoding.End();
+		if (encoding.id != MKV_CONTENT_ENCODING)
+			continue;
+
+		int scope = 1;
+		int type = 0;
+		int algorithm = -1;
+		std::string settings;
+		for (long long childPos = encoding.dataStart; childPos < encoding.End();) {
+			Element child;
+			if (!ReadElement(childPos, &child))
+				break;
+			if (child.id == MKV_CONTENT_ENCODING_SCOPE)
+				scope = (int)ReadUInt(child);
+			else if (child.id == MKV_CONTENT_ENCODING_TYPE)
+				type = (int)ReadUInt(child);
+			else if (child.id == MKV_CONTENT_ENCRYPTION)
+				type = 1;
+			else if (child.id == MKV_CONTENT_COMPRESSION) {
+				//zlib is default algorithm
+				algorithm = 0;
+				for (long long compPos = child.dataStart; compPos < child.End();) {
+					Element compression;
+					if (!ReadElement(compPos, &compression))
+						break;
+					if (compression.id == MKV_CONTENT_COMP_ALGO)
+						algorithm = (int)ReadUInt(compression);
+					else if (compression.id == MKV_CONTENT_COMP_SETTINGS)
+						settings = ReadData(compression);
+					compPos = compression.End();
+				}
+			}
+			childPos = child.End();
+		}
+		//only encodings of frames matter here
+		if (!(scope & 1))
+			continue;
+		if (type == 1) {
+			track->encrypted = true;
+		}
+		else {
+			track->compression = (algorithm < 0) ? 0 : algorithm;
+			track->compressionSettings = settings;
+		}
+	}
+}
+
+void MatroskaReader::ParseAttachments(const Element &attachmentsElement)
+{
+	for (long long pos = attachmentsElement.dataStart; pos < attachmentsElement.End();) {
+		Element attachedFile;
+		if (!ReadElement(pos, &attachedFile))
+			break;
+		pos = attachedFile.End();
+		if (attachedFile.id != MKV_ATTACHED_FILE)
+			continue;
+
+		MatroskaAttachment attachment;
+		for (long long childPos = attachedFile.dataStart; childPos < attachedFile.End();) {
+			Element child;
+			if (!ReadElement(childPos, &child))
+				break;
+			if (child.id == MKV_FILE_NAME)
+				attachment.name = ReadString(child);
+			else if (child.id == MKV_FILE_MIME_TYPE)
+				attachment.mimetype = ReadString(child);
+			else if (child.id == MKV_FILE_DATA) {
+				attachment.dataPosition = child.dataStart;
+				attachment.dataSize = child.size;
+			}
+			childPos = child.End();
+		}
+		attachments.push_back(attachment);
+	}
+}
+
+void MatroskaReader::ParseCues(const Element &cues)
+{
+	for (long long pos = cues.dataStart; pos < cues.End();) {
+		Element cuePoint;
+		if (!ReadElement(pos, &cuePoint))
+			break;
+		pos = cuePoint.End();
+		if (cuePoint.id != MKV_CUE_POINT)
+			continue;
+
+		for (long long childPos = cuePoint.dataStart; childPos < cuePoint.End();) {
+			Element positions;
+			if (!ReadElement(childPos, &positions))
+				break;
+			childPos = positions.End();
+			if (positions.id != MKV_CUE_TRACK_POSITIONS)
+				continue;
+
+			unsigned long long track = 0;
+			long long clusterPosition = -1;
+			for (long long positionPos = positions.dataStart; positionPos < positions.End();) {
+				Element child;
+				if (!ReadElement(positionPos, &child))
+					break;
+				if (child.id == MKV_CUE_TRACK)
+					track = ReadUInt(child);
+				else if (child.id == MKV_CUE_CLUSTER_POSITION)
+					clusterPosition = segmentStart + ReadUInt(child);
+				positionPos = child.End();
+			}
+			if (track && clusterPosition >= segmentStart)
+				cuedClusters.push_back(std::make_pair(track, clusterPosition));
+		}
+	}
+}
+
+bool MatroskaReader::ReadCuedClusters(const MatroskaTrack &track, std::vector<long long> &clusters, std::vector<MatroskaFrame> *frames,
+	std::function<bool(int)> progress, bool *canceled)
+{
+	std::sort(clusters.begin(), clusters.end());
+	clusters.erase(std::unique(clusters.begin(), clusters.end()), clusters.end());
+
+	//every block of cued cluster is read, muxers don't have to make one cue per block
+	for (long long clusterPosition : clusters) {
+		Element cluster;
+		if (!ReadElement(clusterPosition, &cluster) || cluster.id != MKV_CLUSTER)
+			return false;
+		ReadCluster(cluster, track, frames);
+		if (progress && progress(Progress(clusterPosition))) {
+			*canceled = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MatroskaReader::ReadBlock(const Element &element, long long clusterTime, const MatroskaTrack &track, std::vector<MatroskaFrame> *frames)
+{
+	Element block = element;
+	Element durationElement;
+	bool hasDuration = false;
+	if (element.id == MKV_BLOCK_GROUP) {
+		bool hasBlock = false;
+		for (long long pos = element.dataStart; pos < element.End();) {
+			Element child;
+			if (!ReadElement(pos, &child))
+				break;
+			if (child.id == MKV_BLOCK) {
+				block = child;
+				hasBlock = true;
+			}
+			else if (child.id == MKV_BLOCK_DURATION) {
+				durationElement = child;
+				hasDuration = true;
+			}
+			pos = child.End();
+		}
+		if (!hasBlock)
+			return false;
+	}
+	else if (element.id != MKV_SIMPLE_BLOCK)
+		return false;
+
+	//track is checked before block data is read
+	long long trackPos = block.dataStart;
+	unsigned long long trackNumber;
+	int length;
+	if (!ReadVint(&trackPos, &trackNumber, &length) || trackNumber != track.number)
+		return false;
+
+	std::string data = ReadData(block);
+	const unsigned char *bytes = (const unsigned char *)data.data();
+	size_t pos = length;
+	if (data.size() < pos + 3)
+		return false;
+
+	short relativeTime = (short)((bytes[pos] << 8) | bytes[pos + 1]);
+	int lacing = (bytes[pos + 2] >> 1) & 3;
+	pos += 3;
+	std::vector<size_t> sizes;
+	if (!ParseLacing(bytes, data.size(), &pos, lacing, &sizes))
+		return false;
+
+	long long time = (long long)((double)(clusterTime + relativeTime) * timecodeScale / 1000000.0);
+	//duration of block is shared by all its frames, default duration is for one frame
+	long long duration = hasDuration ? (long long)((double)ReadUInt(durationElement) * timecodeScale / 1000000.0) :
+		(long long)(track.defaultDuration * sizes.size() / 1000000);
+	for (size_t i = 0; i < sizes.size(); i++) {
+		MatroskaFrame frame;
+		frame.data = data.substr(pos, sizes[i]);
+		pos += sizes[i];
+		if (!DecodeFrame(track, &frame.data))
+			return false;
+		frame.start = time + duration * (long long)i / (long long)sizes.size();
+		frame.duration = duration / (long long)sizes.size();
+		frames->push_back(std::move(frame));
+	}
+	return true;
+}
+
+bool MatroskaReader::DecodeFrame(const MatroskaTrack &track, std::string *data)
+{
+	if (track.compression == 3) {
+		data->insert(0, track.compressionSettings);
+	}
+	else if (track.compression == 0) {
+		wxMemoryInputStream input(data->data(), data->size());
+		wxZlibInputStream zlib(input, wxZLIB_ZLIB);
+		std::string output;
+		char buffer[4096];
+		while (!zlib.Eof()) {
+			zlib.Read(buffer, sizeof(buffer));
+			size_t numRead = zlib.LastRead();
+			if (!numRead)
+				break;
+			output.append(buffer, numRead);
+		}
+		if (zlib.GetLastError() != wxSTREAM_NO_ERROR && zlib.GetLastError() != wxSTREAM_EOF)
+			return false;
+		data->swap(output);
+	}
+	return true;
+}
+
+long long MatroskaReader::ReadCluster(const Element &cluster, const MatroskaTrack &track, std::vector<MatroskaFrame> *frames)
+{
+	long long clusterTime = 0;
+	long long pos = cluster.dataStart;
+	while (pos < cluster.End()) {
+		Element child;
+		unsigned long long blockTrack;
+		if (!ReadElement(pos, &child, &blockTrack))
+			return cluster.End();
+		if (cluster.unknownSize && !IsClusterChild(child.id))
+			return pos;
+
+		if (child.id == MKV_CLUSTER_TIMECODE) {
+			clusterTime = ReadUInt(child);
+		}
+		//blocks of other tracks are skipped with header that was read with element
+		else if ((child.id == MKV_SIMPLE_BLOCK && blockTrack == track.number) || child.id == MKV_BLOCK_GROUP) {
+			ReadBlock(child, clusterTime, track, frames);
+		}
+		pos = child.End();
+	}
+	return pos;
+}
+
+bool MatroskaReader::IsClusterChild(unsigned int id)
+{
+	return id == MKV_CLUSTER_TIMECODE || id == MKV_SIMPLE_BLOCK || id == MKV_BLOCK_GROUP ||
+		id == MKV_CLUSTER_POSITION || id == MKV_CLUSTER_PREV_SIZE || id == MKV_SILENT_TRACKS ||
+		id == MKV_ENCRYPTED_BLOCK || id == EBML_VOID || id == EBML_CRC32;
+}
+
+int MatroskaReader::Progress(long long pos)
+{
+	long long length = segmentEnd - segmentStart;
+	if (length <= 0)
+		return 0;
+	long long percent = ((pos - segmentStart) * 100) / length;
+	return (int)(std::min)(100LL, (std::max)(0LL, percent));
+}
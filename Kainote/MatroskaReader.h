@@ -0,0 +1,131 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <wx/file.h>
+#include <vector>
+#include <string>
+#include <functional>
+
+#define MATROSKA_TRACK_SUBTITLE 0x11
+
+struct MatroskaTrack
+{
+	unsigned long long number = 0;
+	int type = 0;
+	wxString codec;
+	wxString name;
+	wxString language = L"eng";
+	std::string codecPrivate;
+	//in nanoseconds, used when block has no duration
+	unsigned long long defaultDuration = 0;
+	//-1 none, 0 zlib, 3 header stripping, other values are not supported
+	int compression = -1;
+	std::string compressionSettings;
+	bool encrypted = false;
+};
+
+struct MatroskaAttachment
+{
+	wxString name;
+	wxString mimetype;
+	//data is read only when it's needed
+	long long dataPosition = 0;
+	long long dataSize = 0;
+};
+
+//block of one track, times in milliseconds
+struct MatroskaFrame
+{
+	long long start = 0;
+	long long duration = 0;
+	std::string data;
+};
+
+//reads Matroska elements directly from file
+//only headers, attachments, cues and blocks of chosen track are read
+//video is never indexed
+class MatroskaReader
+{
+public:
+	MatroskaReader() {};
+	~MatroskaReader() { Close(); };
+	bool Open(const wxString &filename);
+	void Close();
+	const std::vector<MatroskaTrack> &GetTracks() { return tracks; }
+	const std::vector<MatroskaAttachment> &GetAttachments() { return attachments; }
+	const MatroskaTrack *GetTrack(unsigned long long number);
+	//reads all frames of track in file order, progress gets percents and returns true to cancel.
+	//Every cluster is read, cues don't have to point to every subtitle block.
+	//cuedClustersOnly reads only whole clusters cued for track, it's faster but blocks from clusters without cue are lost
+	bool ReadFrames(unsigned long long trackNumber, std::vector<MatroskaFrame> *frames, std::function<bool(int)> progress,
+		bool cuedClustersOnly = false);
+	bool ReadAttachment(size_t i, std::string *data);
+
+private:
+	struct Element
+	{
+		unsigned int id = 0;
+		long long dataStart = 0;
+		//unknown size is changed to the end of segment
+		long long size = 0;
+		bool unknownSize = false;
+		long long End() const { return dataStart + size; }
+	};
+	bool ReadAt(long long pos, void *buffer, size_t length);
+	//blockTrack gets track number of block from the same read, 0 for other elements
+	bool ReadElement(long long pos, Element *element, unsigned long long *blockTrack = nullptr);
+	bool ReadVint(long long *pos, unsigned long long *value, int *length);
+	unsigned long long ReadUInt(const Element &element);
+	std::string ReadData(const Element &element);
+	wxString ReadString(const Element &element);
+	void ParseSeekHead(const Element &seekHead);
+	void ParseLevel1(const Element &element);
+	void ParseInfo(const Element &info);
+	void ParseTracks(const Element &tracksElement);
+	void ParseContentEncodings(const Element &encodings, MatroskaTrack *track);
+	void ParseAttachments(const Element &attachmentsElement);
+	void ParseCues(const Element &cues);
+	//reads whole clusters from cues, returns false when cue doesn't point to cluster
+	bool ReadCuedClusters(const MatroskaTrack &track, std::vector<long long> &clusters, std::vector<MatroskaFrame> *frames,
+		std::function<bool(int)> progress, bool *canceled);
+	//reads block or block group, every frame of laced block is added,
+	//returns false when it's not a block of track
+	bool ReadBlock(const Element &element, long long clusterTime, const MatroskaTrack &track, std::vector<MatroskaFrame> *frames);
+	bool DecodeFrame(const MatroskaTrack &track, std::string *data);
+	//returns position after cluster, for unknown size it's the first element that is not in cluster
+	long long ReadCluster(const Element &cluster, const MatroskaTrack &track, std::vector<MatroskaFrame> *frames);
+	bool IsClusterChild(unsigned int id);
+	int Progress(long long pos);
+
+	wxFile file;
+	long long fileSize = 0;
+	long long segmentStart = 0;
+	long long segmentEnd = 0;
+	long long firstCluster = -1;
+	bool seekHeadFound = false;
+	unsigned long long timecodeScale = 1000000;
+	std::vector<MatroskaTrack> tracks;
+	std::vector<MatroskaAttachment> attachments;
+	//track numbers and positions of cued clusters of all tracks, filtered by track when frames are read
+	std::vector<std::pair<unsigned long long, long long>> cuedClusters;
+	std::vector<long long> parsedElements;
+	//small read window for element headers
+	char readBuffer[4096];
+	long long readBufferStart = -1;
+	size_t readBufferSize = 0;
+};
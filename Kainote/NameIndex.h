@@ -0,0 +1,113 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <wx/thread.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//hashed positions of styles or script infos by name, rebuilt on the first lookup after Invalidate.
+//Changes of names or order made outside of SubsFile have to call Invalidate,
+//found position is checked and rebuilds stale index, names missing in stale index are not checked.
+//Lookups are made also from other threads (GetVisible under editionMutex), so index has its own lock
+template<class T>
+class NameIndex
+{
+public:
+	void Invalidate(){
+		wxCriticalSectionLocker locker(lock);
+		needRebuild = true;
+	}
+	//returns position of the first element with given name or -1
+	size_t Find(const std::vector<T*> &table, const wxString &name){
+		wxCriticalSectionLocker locker(lock);
+		if (needRebuild || table.size() != tableSize)
+			Rebuild(table);
+
+		auto it = positions.find(Key(name));
+		if (it != positions.end() && !IsValid(table, it->second, name)){
+			Rebuild(table);
+			it = positions.find(Key(name));
+		}
+		return (it == positions.end()) ? -1 : it->second.first;
+	}
+	//call after element was added at the end of table
+	void Add(const std::vector<T*> &table){
+		wxCriticalSectionLocker locker(lock);
+		if (needRebuild || table.size() != tableSize + 1){
+			needRebuild = true;
+			return;
+		}
+		Insert(table.back()->Name, table.size() - 1);
+		tableSize = table.size();
+	}
+	//call after element on given position was replaced
+	void Replace(const std::vector<T*> &table, size_t i, const wxString &oldName){
+		wxCriticalSectionLocker locker(lock);
+		if (needRebuild || oldName == table[i]->Name)
+			return;
+		auto it = positions.find(Key(oldName));
+		//positions of other elements with the same name are unknown
+		if (it == positions.end() || it->second.count != 1){
+			needRebuild = true;
+			return;
+		}
+		positions.erase(it);
+		Insert(table[i]->Name, i);
+	}
+private:
+	struct Positions{
+		size_t first;
+		int count;
+	};
+	struct KeyHash{
+		using is_transparent = void;
+		size_t operator()(std::wstring_view key) const{ return std::hash<std::wstring_view>()(key); }
+	};
+	static std::wstring_view Key(const wxString &name){
+		return std::wstring_view(name.wc_str(), name.length());
+	}
+	bool IsValid(const std::vector<T*> &table, const Positions &pos, const wxString &name){
+		return pos.first < table.size() && table[pos.first]->Name == name;
+	}
+	void Insert(const wxString &name, size_t i){
+		auto it = positions.find(Key(name));
+		if (it == positions.end()){
+			positions.emplace(std::wstring(name.wc_str(), name.length()), Positions{ i, 1 });
+			return;
+		}
+		it->second.first = (std::min)(it->second.first, i);
+		it->second.count++;
+	}
+	void Rebuild(const std::vector<T*> &table){
+		positions.clear();
+		positions.reserve(table.size());
+		for (size_t i = 0; i < table.size(); i++){
+			Insert(table[i]->Name, i);
+		}
+		tableSize = table.size();
+		needRebuild = false;
+	}
+	std::unordered_map<std::wstring, Positions, KeyHash, std::equal_to<>> positions;
+	size_t tableSize = 0;
+	bool needRebuild = true;
+	wxCriticalSection lock;
+};
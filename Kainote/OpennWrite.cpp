@@ -16,10 +16,12 @@
 
 #include "OpennWrite.h"
 #include <wx/filename.h>
-#include <wx/ffile.h>
+#include <wx/convauto.h>
 #include <wx/filefn.h>
 #include <wx/log.h>
 #include "LogHandler.h"
+#include <windows.h>
+#include <wx/msw/winundef.h>
 
 OpenWrite::OpenWrite()
 {
@@ -43,45 +45,53 @@ OpenWrite::OpenWrite(const wxString &fileName, bool clear)
 
 OpenWrite::~OpenWrite()
 {
+	//save was not finished by SafeFileClose, temporary file is removed and target stays untouched
+	if (safeWrite){
+		file.Close();
+		if (!appendWrite){ wxRemoveFile(tempName); }
+		safeWrite = false;
+	}
 	CloseFile();
 }
 
 bool OpenWrite::FileOpen(const wxString &filename, wxString *riddenText, bool test)
 {
-
-	bool utf8 = true;
-	wxFile filetest;
 	wxFileName fname;
 	fname.Assign(filename);
 	if (!fname.IsFileReadable()){ return false; }
-	if (test){
-		wchar_t b[4];
-		filetest.Open(filename, wxFile::read, wxS_DEFAULT);
-		filetest.Read(b, 4);
+	//file is read only once, encoding test and conversion use the same buffer
+	wxFile fileo;
+	if (!fileo.Open(filename, wxFile::read, wxS_DEFAULT)){ return false; }
+	wxFileOffset fileSize = fileo.Length();
+	if (fileSize <= 0){ return false; }
+	wxCharBuffer buffer((size_t)fileSize);
+	ssize_t size = fileo.Read(buffer.data(), (size_t)fileSize);
+	fileo.Close();
+	if (size <= 0){ return false; }
+	char *buff = buffer.data();
 
-		utf8 = ((static_cast <int>(b[0]) > 48000)) ? true : false;
+	bool utf8 = true;
+	if (test){
+		//first two bytes as wchar_t, BOM of utf8 and utf16
+		int firstChar = (size > 1) ? (unsigned char)buff[0] | ((unsigned char)buff[1] << 8) : 0;
+		utf8 = (firstChar > 48000) ? true : false;
 		if (!utf8){
-			size_t size = filetest.Length();
-			char *buff = new char[size];
-			filetest.Read(buff, size);
 			utf8 = IsUTF8withoutBOM(buff, size);
-			delete[] buff;
 		}
-		filetest.Close();
 	}
-	wxFFile fileo;
-	fileo.Open(filename, L"r");
-	if (fileo.IsOpened()){
-		if (utf8){
-			fileo.ReadAll(riddenText);
-		}
-		else{ fileo.ReadAll(riddenText, wxConvLocal); }
-		fileo.Close();
-		if (riddenText->empty()) return false;
-		return true;
+	//file was read in text mode before, keep removing \r from line ends
+	size_t newSize = 0;
+	for (ssize_t i = 0; i < size; i++){
+		if (buff[i] == '\r' && i + 1 < size && buff[i + 1] == '\n')
+			continue;
+		buff[newSize++] = buff[i];
 	}
-
-	return false;
+	if (utf8){
+		*riddenText = wxString(buff, wxConvAuto(), newSize);
+	}
+	else{ *riddenText = wxString(buff, wxConvLocal, newSize); }
+	if (riddenText->empty()) return false;
+	return true;
 }
 
 void OpenWrite::FileWrite(const wxString &fileName, const wxString &textfile, bool utf)
@@ -124,6 +134,131 @@ void OpenWrite::PartFileWrite(const wxString &parttext)
 	if (!file.Write(parttext/*,wxConvUTF8*/)){ KaiLog(_("Nie można zapisać do pliku.")); };
 }
 
+bool OpenWrite::SafeFileOpen(const wxString &fileName)
+{
+	wxFileName fname;
+	fname.Assign(fileName);
+	if (!fname.DirExists()){ wxMkdir(fileName.BeforeLast(L'\\')); }
+	if (fname.FileExists() && !fname.IsFileWritable()){
+		KaiLog(_("Nie można zapisać do pliku."));
+		return false;
+	}
+	targetName = fileName;
+	tempName = fileName + L".tmp";
+	if (!file.Create(tempName, true, wxS_DEFAULT)){
+		KaiLog(_("Nie można utworzyć pliku."));
+		return false;
+	}
+	safeWrite = true;
+	writeFailed = false;
+	appendWrite = false;
+	buffer.clear();
+	buffer.reserve(SAFE_WRITE_BUFFER_SIZE + 4096);
+	//utf-8 BOM
+	buffer.append("\xEF\xBB\xBF");
+	return true;
+}
+
+bool OpenWrite::SafeFileAppend(const wxString &fileName)
+{
+	if (!wxFileExists(fileName) || !file.Open(fileName, wxFile::write_append)){
+		KaiLog(_("Nie można zapisać do pliku."));
+		return false;
+	}
+	targetName = fileName;
+	safeWrite = true;
+	writeFailed = false;
+	appendWrite = true;
+	buffer.clear();
+	buffer.reserve(SAFE_WRITE_BUFFER_SIZE + 4096);
+	return true;
+}
+
+void OpenWrite::SafeFileWrite(const wxString &parttext)
+{
+	SafeFileWrite(parttext.wc_str(), parttext.length());
+}
+
+void OpenWrite::SafeFileWrite(const wchar_t *text, size_t length)
+{
+	if (!safeWrite){ return; }
+	//utf-16 code unit gives at most 3 bytes, surrogate pair 4 bytes from two units
+	size_t pos = buffer.size();
+	buffer.resize(pos + length * 3);
+	unsigned char *out = (unsigned char*)&buffer[pos];
+	for (size_t i = 0; i < length; i++){
+		unsigned int ch = (unsigned int)text[i];
+		if (ch < 0x80){
+			*out++ = (unsigned char)ch;
+			continue;
+		}
+		if (ch >= 0xD800 && ch <= 0xDFFF){
+			if (ch <= 0xDBFF && i + 1 < length && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF){
+				ch = 0x10000 + ((ch - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+				i++;
+			}
+			//lone surrogate is not valid in UTF-8, it's written as replacement character
+			else{
+				ch = 0xFFFD;
+			}
+		}
+		if (ch < 0x800){
+			*out++ = (unsigned char)(0xC0 | (ch >> 6));
+			*out++ = (unsigned char)(0x80 | (ch & 0x3F));
+		}
+		else if (ch < 0x10000){
+			*out++ = (unsigned char)(0xE0 | (ch >> 12));
+			*out++ = (unsigned char)(0x80 | ((ch >> 6) & 0x3F));
+			*out++ = (unsigned char)(0x80 | (ch & 0x3F));
+		}
+		else{
+			*out++ = (unsigned char)(0xF0 | (ch >> 18));
+			*out++ = (unsigned char)(0x80 | ((ch >> 12) & 0x3F));
+			*out++ = (unsigned char)(0x80 | ((ch >> 6) & 0x3F));
+			*out++ = (unsigned char)(0x80 | (ch & 0x3F));
+		}
+	}
+	buffer.resize(out - (unsigned char*)buffer.data());
+	if (buffer.size() >= SAFE_WRITE_BUFFER_SIZE){ FlushBuffer(); }
+}
+
+void OpenWrite::FlushBuffer()
+{
+	if (buffer.empty() || writeFailed){ return; }
+	if (file.Write(buffer.data(), buffer.size()) != buffer.size()){
+		KaiLog(_("Nie można zapisać do pliku."));
+		writeFailed = true;
+	}
+	buffer.clear();
+}
+
+bool OpenWrite::SafeFileClose()
+{
+	if (!safeWrite){ return false; }
+	safeWrite = false;
+	FlushBuffer();
+	if (!writeFailed && !file.Flush()){ writeFailed = true; }
+	file.Close();
+	if (appendWrite){
+		appendWrite = false;
+		return !writeFailed;
+	}
+	if (writeFailed){
+		wxRemoveFile(tempName);
+		return false;
+	}
+	//ReplaceFile keeps attributes and permissions of old file
+	BOOL replaced = (wxFileExists(targetName)) ?
+		ReplaceFileW(targetName.wc_str(), tempName.wc_str(), nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr) :
+		MoveFileExW(tempName.wc_str(), targetName.wc_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+	if (!replaced){
+		KaiLog(wxString::Format(_("Nie można zastąpić pliku \"%s\"."), targetName));
+		wxRemoveFile(tempName);
+		return false;
+	}
+	return true;
+}
+
 void OpenWrite::CloseFile()
 {
 	if (file.IsOpened()){ file.Close(); }
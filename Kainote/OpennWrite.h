@@ -17,6 +17,10 @@
 
 #include <wx/file.h>
 #include <wx/thread.h>
+#include <string>
+
+//size of UTF-8 buffer that is written at once to file
+#define SAFE_WRITE_BUFFER_SIZE (1 << 20)
 
 class OpenWrite
 {
@@ -28,11 +32,26 @@ public:
 	bool FileOpen(const wxString &filename, wxString *riddenText, bool test = true);
 	void FileWrite(const wxString &filename, const wxString &alltext, bool utf = true);
 	void PartFileWrite(const wxString &parttext);
+	//writes UTF-8 with BOM to temporary file by big parts,
+	//SafeFileClose replaces file with it, so broken save never truncates old file
+	bool SafeFileOpen(const wxString &filename);
+	//writes UTF-8 to the end of existing file without temporary file, it's closed by SafeFileClose
+	bool SafeFileAppend(const wxString &filename);
+	void SafeFileWrite(const wxString &parttext);
+	void SafeFileWrite(const wchar_t *text, size_t length);
+	bool SafeFileClose();
 	bool IsUTF8withoutBOM(const char* buf, size_t size);
 	wxFile file;
 private:
+	void FlushBuffer();
 
 	bool isfirst;
+	bool safeWrite = false;
+	bool writeFailed = false;
+	bool appendWrite = false;
+	std::string buffer;
+	wxString targetName;
+	wxString tempName;
 };
 
 
@@ -288,7 +288,7 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 
 	//Main
 	{
-		const int optsSize = 18;
+		const int optsSize = 19;
 		wxBoxSizer *MainSizer = new wxBoxSizer(wxVERTICAL);
 		wxString labels[optsSize] = { _("Wczytywanie posortowanych napisów"), _("Włącz sprawdzanie pisowni"),
 			_("Zaznaczaj linijkę z czasem aktywnej\nlinijki poprzedniej zakładki"),
@@ -301,14 +301,15 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 			_("Nie zmieniaj zaznaczeń przy duplikacji linii dialogowych"), 
 			_("Nie wypośrodkowuj aktywnej linii w polu napisów"), _("Używaj skróty klawiszowe numpada w polach tekstowych"),
 			_("Wyłącz ostrzeżenia w narzędziach edycji wizualnej"), _("Nie ostrzegaj o niezgodności rozdzielczości"),
-			_("Kompatybilność ze starymi skryptami Kainote") };
+			_("Kompatybilność ze starymi skryptami Kainote"),
+			_("Autozapis dopisuje tylko zmienione linie\n(dziennik zmian zapisywany w tle)") };
 		CONFIG opts[optsSize] = { GRID_LOAD_SORTED_SUBS, SPELLCHECKER_ON, AUTO_SELECT_LINES_FROM_LAST_TAB,
 			EDITBOX_SUGGESTIONS_ON_DOUBLE_CLICK, OPEN_SUBS_IN_NEW_TAB, EDITBOX_DONT_GO_TO_NEXT_LINE_ON_TIMES_EDIT,
 			DISABLE_LIVE_VIDEO_EDITING, GRID_SET_VISIBLE_LINE_AFTER_FULL_SCREEN, SHIFT_TIMES_CHANGE_VALUES_WITH_TAB,
 			GRID_CHANGE_ACTIVE_ON_SELECTION, TL_MODE_SHOW_ORIGINAL, TL_MODE_HIDE_ORIGINAL_ON_VIDEO, 
 			GRID_DUPLICATION_DONT_CHANGE_SELECTION, GRID_DONT_CENTER_ACTIVE_LINE,
 			TEXT_FIELD_ALLOW_NUMPAD_HOTKEYS, VIDEO_VISUAL_WARNINGS_OFF,
-			DONT_ASK_FOR_BAD_RESOLUTION, AUTOMATION_OLD_SCRIPTS_COMPATIBILITY };
+			DONT_ASK_FOR_BAD_RESOLUTION, AUTOMATION_OLD_SCRIPTS_COMPATIBILITY, AUTOSAVE_JOURNAL };
 		wxString localePath = Options.pathfull + L"\\Locale";
 		wxDir kat(localePath);
 		wxArrayString langs;
@@ -366,6 +367,8 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 			numMaxChars = 40;
 		NumCtrl *maxTabChars = new NumCtrl(EditorAdvanced, ID_NUMBER_CONTROL, std::to_wstring(numMaxChars), 20, 150, true, wxDefaultPosition, wxSize(120, -1), wxTE_PROCESS_ENTER);
 		maxTabChars->SetToolTip(_("Liczbę znaków widocznych na zakładce można ustawić od 20 do 150"));
+		NumCtrl *undoLimit = new NumCtrl(EditorAdvanced, ID_NUMBER_CONTROL, Options.GetString(SUBS_UNDO_MEMORY_LIMIT), 0, 100000, true, wxDefaultPosition, wxSize(120, -1), wxTE_PROCESS_ENTER);
+		undoLimit->SetToolTip(_("Po przekroczeniu limitu usuwane są najstarsze zmiany z historii, zero wyłącza limit"));
 		NumCtrl *ltl = new NumCtrl(EditorAdvanced, ID_NUMBER_CONTROL, Options.GetString(AUTOMATION_TRACE_LEVEL), 0, 5, true, wxDefaultPosition, wxSize(120, -1), wxTE_PROCESS_ENTER);
 		NumCtrl *sc = new NumCtrl(EditorAdvanced, ID_NUMBER_CONTROL, Options.GetString(GRID_INSERT_START_OFFSET), -100000, 100000, true, wxDefaultPosition, wxSize(120, -1), wxTE_PROCESS_ENTER);
 		NumCtrl *sc1 = new NumCtrl(EditorAdvanced, ID_NUMBER_CONTROL, Options.GetString(GRID_INSERT_END_OFFSET), -100000, 100000, true, wxDefaultPosition, wxSize(120, -1), wxTE_PROCESS_ENTER);
@@ -373,6 +376,7 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 		
 		ConOpt(gridSaveAfter, GRID_SAVE_AFTER_CHARACTER_COUNT);
 		ConOpt(autoSaveMax, AUTOSAVE_MAX_FILES);
+		ConOpt(undoLimit, SUBS_UNDO_MEMORY_LIMIT);
 		ConOpt(ltl, AUTOMATION_TRACE_LEVEL);
 		ConOpt(maxTabChars, TAB_TEXT_MAX_CHARS);
 		ConOpt(sc, GRID_INSERT_START_OFFSET);
@@ -399,6 +403,9 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 		wxBoxSizer *MainSizer8 = new wxBoxSizer(wxHORIZONTAL);
 		MainSizer8->Add(new KaiStaticText(EditorAdvanced, -1, _("Poziom śledzenia logów skryptów LUA")), 5, /*wxALIGN_CENTRE_VERTICAL | */wxEXPAND);
 		MainSizer8->Add(ltl, 0, wxEXPAND);
+		wxBoxSizer *MainSizer11 = new wxBoxSizer(wxHORIZONTAL);
+		MainSizer11->Add(new KaiStaticText(EditorAdvanced, -1, _("Limit pamięci historii zmian w MB")), 5, wxEXPAND);
+		MainSizer11->Add(undoLimit, 0, wxEXPAND);
 
 		//MainSizer->Add(MainSizer2,0,wxLEFT|wxTOP,2);
 
@@ -425,6 +432,7 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 
 		Main1Sizer->Add(MainSizer2, 0, wxRIGHT | wxLEFT | wxTOP | wxEXPAND, 5);
 		Main1Sizer->Add(MainSizer3, 0, wxRIGHT | wxLEFT | wxTOP | wxEXPAND, 5);
+		Main1Sizer->Add(MainSizer11, 0, wxRIGHT | wxLEFT | wxTOP | wxEXPAND, 5);
 		Main1Sizer->Add(MainSizer4, 0, wxRIGHT | wxLEFT | wxTOP | wxEXPAND, 5);
 		Main1Sizer->Add(MainSizer5, 0, wxRIGHT | wxLEFT | wxTOP | wxEXPAND, 5);
 		Main1Sizer->Add(MainSizer6, 0, wxRIGHT | wxLEFT | wxTOP | wxEXPAND, 5);
@@ -537,9 +545,10 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 	{
 		wxString voptspl[] = { _("Otwórz wideo z menu kontekstowego na pełnym ekranie"), _("Lewy przycisk myszy pauzuje wideo"),
 			_("Otwieraj wideo z czasem aktywnej linii"), _("Preferowane ścieżki audio (oddzielone średnikiem)"),
-			_("Sposób szukania wideo w FFMS2 (wymaga ponownego wczytania)"), _("Filtr wyświetlania napisów") };
+			_("Sposób szukania wideo w FFMS2 (wymaga ponownego wczytania)"), _("Filtr wyświetlania napisów"),
+			_("Wczytuj do Libass tylko zmienione linie") };
 		CONFIG vopts[] = { VIDEO_FULL_SCREEN_ON_START, VIDEO_PAUSE_ON_CLICK, OPEN_VIDEO_AT_ACTIVE_LINE,
-			ACCEPTED_AUDIO_STREAM, FFMS2_VIDEO_SEEKING, VSFILTER_INSTANCE };
+			ACCEPTED_AUDIO_STREAM, FFMS2_VIDEO_SEEKING, VSFILTER_INSTANCE, LIBASS_INCREMENTAL_UPDATE };
 		wxBoxSizer *MainSizer = new wxBoxSizer(wxVERTICAL);
 		for (int i = 0; i < 3; i++)
 		{
@@ -578,6 +587,19 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 		filtersizer->Add(vsfiltersList, 1, wxALL /*| wxALIGN_CENTER*/ | wxEXPAND, 2);
 		MainSizer->Add(filtersizer, 0, wxRIGHT | wxEXPAND, 5);
 		ConOpt(vsfiltersList, vopts[5]);
+		KaiCheckBox *incremental = new KaiCheckBox(video, -1, voptspl[6]);
+		incremental->SetValue(Options.GetBool(vopts[6]));
+		incremental->SetToolTip(_("Style i informacje o napisach pozostają wczytane, przy zmianie linii Libass parsuje tylko zmienione linie"));
+		ConOpt(incremental, vopts[6]);
+		MainSizer->Add(incremental, 0, wxALL, 2);
+		KaiStaticBoxSizer *frameCacheSizer = new KaiStaticBoxSizer(wxHORIZONTAL, video, 
+			_("Pamięć podręczna klatek wideo w MB (wymaga ponownego wczytania)"));
+		NumCtrl *frameCache = new NumCtrl(video, ID_NUMBER_CONTROL, Options.GetString(VIDEO_FRAME_CACHE_MEMORY), 
+			0, 16384, true, wxDefaultPosition, wxSize(200, -1), wxTE_PROCESS_ENTER);
+		frameCache->SetToolTip(_("Zdekodowane klatki są trzymane w pamięci, a kolejne klatki są dekodowane z wyprzedzeniem,\nzero wyłącza pamięć podręczną"));
+		frameCacheSizer->Add(frameCache, 1, wxALL | wxEXPAND, 2);
+		MainSizer->Add(frameCacheSizer, 0, wxRIGHT | wxEXPAND, 5);
+		ConOpt(frameCache, VIDEO_FRAME_CACHE_MEMORY);
 		video->SetSizerAndFit(MainSizer);
 	}
 	//Hotkeys
@@ -636,16 +658,18 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 
 	{
 		wxBoxSizer *audio = new wxBoxSizer(wxVERTICAL);
-		const int numOfElements = 13;
+		const int numOfElements = 14;
 		wxString names[numOfElements] = { _("Wyświetlaj czas przy kursorze"), _("Wyświetlaj znaczniki sekund"), _("Wyświetlaj tło zaznaczenia"),
 			_("Wyświetlaj pozycję wideo"), _("Wyświetlaj klatki kluczowe"), _("Przewijaj wykres audio przy odtwarzaniu"),
 			_("Aktywuj okno audio po najechaniu"), _("Przyklejaj do klatek kluczowych"), _("Przyklejaj do pozostałych linii"),
 			_("Nie odtwarzaj audio po zmianie linijki"), _("Scalaj wszystkie \"n\" z poprzednią sylabą"), 
-			_("Przenoś linie sylab po kliknięciu"),_("Wczytuj audio do pamięci RAM") };
+			_("Przenoś linie sylab po kliknięciu"),_("Wczytuj audio do pamięci RAM"), 
+			_("Zapisuj szczyty wykresu audio obok audio cache") };
 
 		CONFIG opts[numOfElements] = { AUDIO_DRAW_TIME_CURSOR, AUDIO_DRAW_SECONDARY_LINES, AUDIO_DRAW_SELECTION_BACKGROUND, AUDIO_DRAW_VIDEO_POSITION,
 			AUDIO_DRAW_KEYFRAMES, AUDIO_LOCK_SCROLL_ON_CURSOR, AUDIO_AUTO_FOCUS, AUDIO_SNAP_TO_KEYFRAMES, AUDIO_SNAP_TO_OTHER_LINES,
-			AUDIO_DONT_PLAY_WHEN_LINE_CHANGES, AUDIO_MERGE_EVERY_N_WITH_SYLLABLE, AUDIO_KARAOKE_MOVE_ON_CLICK, AUDIO_RAM_CACHE };
+			AUDIO_DONT_PLAY_WHEN_LINE_CHANGES, AUDIO_MERGE_EVERY_N_WITH_SYLLABLE, AUDIO_KARAOKE_MOVE_ON_CLICK, AUDIO_RAM_CACHE, 
+			AUDIO_PEAKS_CACHE };
 
 		for (int i = 0; i < numOfElements; i++)
 		{
@@ -672,6 +696,10 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 		wxString inact[3] = { _("Brak"), _("Przed i po aktywnej"), _("Wszystkie widoczne") };
 		KaiChoice *displayNonActiveLines = new KaiChoice(AudioSecond, ID_KAI_CHOICE, wxDefaultPosition, wxSize(300, -1), 3, inact);
 		displayNonActiveLines->SetSelection(Options.GetInt(opts1[2]));
+		wxString windows[3] = { _("Brak"), _("Hann"), _("Blackman") };
+		KaiChoice *spectrumWindow = new KaiChoice(AudioSecond, ID_KAI_CHOICE, wxDefaultPosition, wxSize(300, -1), 3, windows);
+		spectrumWindow->SetSelection(Options.GetInt(AUDIO_SPECTRUM_WINDOW));
+		ConOpt(spectrumWindow, AUDIO_SPECTRUM_WINDOW);
 		ConOpt(Delay, opts1[0]);
 		ConOpt(markPlayTime, opts1[1]);
 		ConOpt(lineThickness, opts1[3]);
@@ -686,6 +714,7 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 		KaiStaticBoxSizer *lineThicknessSizer = new KaiStaticBoxSizer(wxVERTICAL, AudioSecond, _("Grubość linii znaczników"));
 		KaiStaticBoxSizer *audioCacheFilesLimitSizer = new KaiStaticBoxSizer(wxVERTICAL, AudioSecond, _("Limit plików audio cache"));
 		KaiStaticBoxSizer *displayNonActiveLinesSizer = new KaiStaticBoxSizer(wxVERTICAL, AudioSecond, _("Sposób wyświetlania nieaktywnych linijek"));
+		KaiStaticBoxSizer *spectrumWindowSizer = new KaiStaticBoxSizer(wxVERTICAL, AudioSecond, _("Funkcja okna spektrum"));
 		DelaySizer->Add(Delay, 1, wxALL | wxEXPAND, 2);
 		markPlayTimeSizer->Add(markPlayTime, 1, wxALL | wxEXPAND, 2);
 		leadInAndOut->Add(leadInTime, 1, wxALL | wxEXPAND, 2);
@@ -693,12 +722,14 @@ OptionsDialog::OptionsDialog(wxWindow *parent)
 		lineThicknessSizer->Add(lineThickness, 1, wxALL | wxEXPAND, 2);
 		audioCacheFilesLimitSizer->Add(audioCacheFilesLimit, 1, wxALL | wxEXPAND, 2);
 		displayNonActiveLinesSizer->Add(displayNonActiveLines, 1, wxALL | wxEXPAND, 2);
+		spectrumWindowSizer->Add(spectrumWindow, 1, wxALL | wxEXPAND, 2);
 		audio2->Add(DelaySizer, 0, wxRIGHT | wxEXPAND, 5);
 		audio2->Add(markPlayTimeSizer, 0, wxRIGHT | wxEXPAND, 5);
 		audio2->Add(leadInAndOut, 0, wxRIGHT | wxEXPAND, 5);
 		audio2->Add(lineThicknessSizer, 0, wxRIGHT | wxEXPAND, 5);
 		audio2->Add(audioCacheFilesLimitSizer, 0, wxRIGHT | wxEXPAND, 5);
 		audio2->Add(displayNonActiveLinesSizer, 0, wxRIGHT | wxEXPAND, 5);
+		audio2->Add(spectrumWindowSizer, 0, wxRIGHT | wxEXPAND, 5);
 
 
 		AudioSecond->SetSizerAndFit(audio2);
@@ -24,6 +24,8 @@
 #include "AudioBox.h"
 #include "VisualDrawingShapes.h"
 #include "Notebook.h"
+#include "FrameTimes.h"
+#include <algorithm>
 
 
 Provider::Provider(const wxString& filename, RendererVideo* renderer)
@@ -78,6 +80,11 @@ long long Provider::GetNumSamples()
 
 void Provider::GetWaveForm(int* min, int* peak, long long start, int w, int h, int samples, float scale) {
 	if (audioNotInitialized) { return; }
+	//with peaks only both ends of pixel are read from audio cache
+	if (m_peaks.IsReady() && samples >= AUDIO_PEAKS_BLOCK * 2) {
+		GetWaveFormFromPeaks(min, peak, start, w, h, samples, scale);
+		return;
+	}
 	int n = w * samples;
 	for (int i = 0; i < w; i++) {
 		peak[i] = 0;
@@ -113,6 +120,56 @@ void Provider::GetWaveForm(int* min, int* peak, long long start, int w, int h, i
 
 }
 
+void Provider::GetWaveFormFromPeaks(int* min, int* peak, long long start, int w, int h, int samples, float scale)
+{
+	int half_h = h / 2;
+	int half_amplitude = int(half_h * scale);
+	//samples after the end of cache are read as silence
+	long long cacheSamples = (std::min)(m_numSamples, m_peaks.GetSampleCount());
+	short edge[AUDIO_PEAKS_BLOCK];
+
+	for (int i = 0; i < w; i++) {
+		long long pixelStart = start + (long long)i * samples;
+		long long pixelEnd = pixelStart + samples;
+		short minSample = 32767, maxSample = -32768;
+		auto addSamples = [&](long long from, long long to) {
+			while (from < to) {
+				int count = (int)(std::min)(to - from, (long long)AUDIO_PEAKS_BLOCK);
+				GetBuffer(edge, from, count);
+				for (int j = 0; j < count; j++) {
+					if (edge[j] < minSample) minSample = edge[j];
+					if (edge[j] > maxSample) maxSample = edge[j];
+				}
+				from += count;
+			}
+		};
+		if (pixelEnd > cacheSamples) {
+			minSample = maxSample = 0;
+			pixelEnd = cacheSamples;
+		}
+		long long firstBlock = (pixelStart + AUDIO_PEAKS_BLOCK - 1) / AUDIO_PEAKS_BLOCK;
+		long long lastBlock = pixelEnd / AUDIO_PEAKS_BLOCK;
+		if (firstBlock < lastBlock) {
+			short blocksMin, blocksMax;
+			m_peaks.GetMinMax(firstBlock, lastBlock, &blocksMin, &blocksMax);
+			if (blocksMin < minSample) minSample = blocksMin;
+			if (blocksMax > maxSample) maxSample = blocksMax;
+			addSamples(pixelStart, firstBlock * AUDIO_PEAKS_BLOCK);
+			addSamples(lastBlock * AUDIO_PEAKS_BLOCK, pixelEnd);
+		}
+		else {
+			addSamples(pixelStart, pixelEnd);
+		}
+		//values are mapped the same way as samples in GetWaveForm
+		int value1 = half_h - (int(minSample) * half_amplitude) / 0x8000;
+		int value2 = half_h - (int(maxSample) * half_amplitude) / 0x8000;
+		value1 = MID(0, value1, h);
+		value2 = MID(0, value2, h);
+		min[i] = (std::min)(value1, value2);
+		peak[i] = (std::max)(value1, value2);
+	}
+}
+
 int Provider::TimefromFrame(int nframe)
 {
 	if (nframe < 0) { nframe = 0; }
@@ -122,24 +179,7 @@ int Provider::TimefromFrame(int nframe)
 
 int Provider::FramefromTime(int time)
 {
-	if (time <= 0) { return 0; }
-	int start = m_lastFrame;
-	if (m_lastTime > time)
-	{
-		start = 0;
-	}
-	int wframe = m_numFrames - 1;
-	for (int i = start; i < m_numFrames - 1; i++)
-	{
-		if (m_timecodes[i] >= time && time < m_timecodes[i + 1])
-		{
-			wframe = i;
-			break;
-		}
-	}
-	m_lastFrame = wframe;
-	m_lastTime = time;
-	return m_lastFrame;
+	return GetFramefromMS(time);
 }
 
 int Provider::GetMSfromFrame(int frame)
@@ -153,15 +193,61 @@ int Provider::GetFramefromMS(int MS, int seekfrom, bool safe)
 {
 	if (MS <= 0) return 0;
 	int result = (safe) ? m_numFrames - 1 : m_numFrames;
-	for (int i = seekfrom; i < m_numFrames; i++)
-	{
-		if (m_timecodes[i] >= MS)
-		{
-			result = i;
-			break;
+	return FindFrameFromMS(m_timecodes, m_numFrames, MS, seekfrom, result, m_timecodesSorted);
+}
+
+void Provider::UpdateTimecodesIndex()
+{
+	m_timecodesSorted = std::is_sorted(m_timecodes.begin(), m_timecodes.end());
+	m_keyframesIndexValid = false;
+}
+
+const std::vector<int>& Provider::GetKeyframesStart()
+{
+	if (m_keyframesIndexValid)
+		return m_keyframesStart;
+
+	m_keyframesStart.clear();
+	m_keyframesStart.reserve(m_keyFrames.size());
+	for (size_t i = 0; i < m_keyFrames.size(); i++) {
+		int keyMS = m_keyFrames[i];
+		int frameTime = 0;
+		if (m_timecodes.size() < 1) {
+			//there is nothing to do when video is not loaded
+			//put half of frame 23.976FPS
+			frameTime = keyMS - 21;
 		}
+		else {
+			int frame = GetFramefromMS(keyMS);
+			int prevFrameTime = GetMSfromFrame(frame - 1);
+			int keyFrameTime = GetMSfromFrame(frame);
+			frameTime = keyFrameTime + ((prevFrameTime - keyFrameTime) / 2);
+		}
+		m_keyframesStart.push_back(ZEROIT(frameTime));
 	}
-	return result;
+	std::sort(m_keyframesStart.begin(), m_keyframesStart.end());
+	m_keyframesIndexValid = true;
+	return m_keyframesStart;
+}
+
+int Provider::GetKeyframeStartBefore(int MS)
+{
+	const std::vector<int>& keyframesStart = GetKeyframesStart();
+	auto it = std::upper_bound(keyframesStart.begin(), keyframesStart.end(), MS);
+	if (it == keyframesStart.begin())
+		return -1;
+
+	return *(--it);
+}
+
+int Provider::GetKeyframeStartAfter(int MS)
+{
+	const std::vector<int>& keyframesStart = GetKeyframesStart();
+	auto it = std::lower_bound(keyframesStart.begin(), keyframesStart.end(), MS);
+	if (it == keyframesStart.end())
+		return -1;
+
+	return *it;
 }
 
 void Provider::OpenKeyframes(const wxString& filename)
@@ -170,6 +256,7 @@ void Provider::OpenKeyframes(const wxString& filename)
 	KeyframeLoader kfl(filename, &keyframes, this);
 	if (keyframes.size()) {
 		m_keyFrames = keyframes;
+		m_keyframesIndexValid = false;
 		TabPanel* tab = (m_renderer) ? (TabPanel*)m_renderer->videoControl->GetParent() : Notebook::GetTab();
 		if (tab->edit->ABox) {
 			tab->edit->ABox->SetKeyframes(keyframes);
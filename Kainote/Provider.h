@@ -21,6 +21,7 @@
 #include "SubsGrid.h"
 #include "Provider.h"
 #include "TabPanel.h"
+#include "AudioPeaks.h"
 #include <vector>
 #include <thread>
 #include "include\ffms.h"
@@ -57,14 +58,22 @@ public:
 	const std::vector<int> GetTimecodes() { return m_timecodes; };
 	void SetKeyframes(const wxArrayInt& keyframes) {
 		m_keyFrames = keyframes;
+		m_keyframesIndexValid = false;
 	}
+	//sorted keyframe times moved half of frame back, used for snapping
+	const std::vector<int>& GetKeyframesStart();
+	//nearest keyframe start time not greater than MS, -1 when there is none
+	int GetKeyframeStartBefore(int MS);
+	//nearest keyframe start time not less than MS, -1 when there is none
+	int GetKeyframeStartAfter(int MS);
 	void SetTimecodes(const std::vector<int>& timecodes) {
 		m_timecodes = timecodes;
+		UpdateTimecodesIndex();
 	}
 	float GetFPS() { return m_FPS; }
-	void SetFPS(float FPS) { m_FPS = FPS; }
+	void SetFPS(float FPS) { m_FPS = FPS; m_keyframesIndexValid = false; }
 	long long GetNumFrames() { return m_numFrames; }
-	void SetNumFrames(long long numFrames) { m_numFrames = numFrames; }
+	void SetNumFrames(long long numFrames) { m_numFrames = numFrames; m_keyframesIndexValid = false; }
 	void OpenKeyframes(const wxString& filename);
 	void SetPosition(int time, bool starttime);
 	bool AudioNotInitialized() {
@@ -75,8 +84,13 @@ public:
 	}
 protected:
 	Provider(const wxString& filename, RendererVideo* renderer);
+	void GetWaveFormFromPeaks(int* min, int* peak, long long start, int w, int h, int samples, float scale);
+	//have to be called after every change of m_timecodes
+	void UpdateTimecodesIndex();
 	volatile bool audioNotInitialized = true;
 	volatile float m_audioProgress = 0;
+	//filled by audio loading thread, used by GetWaveForm when ready
+	AudioPeaks m_peaks;
 	RendererVideo* m_renderer = nullptr;
 	int m_width = -1;
 	int m_height;
@@ -86,7 +100,6 @@ protected:
 	int m_sampleRate = -1;
 	int m_bytesPerSample;
 	int m_channels;
-	int m_lastTime;
 	int m_lastFrame = -1;
 	int m_framePlane = 0;
 	int m_changedTime = 0;
@@ -102,4 +115,9 @@ protected:
 	wxString m_filename;
 	wxArrayInt m_keyFrames;
 	std::vector<int> m_timecodes;
+	//frame lookup uses binary search when timecodes are not decreasing
+	bool m_timecodesSorted = true;
+	//built on first use after change of keyframes, timecodes or frames count
+	std::vector<int> m_keyframesStart;
+	bool m_keyframesIndexValid = false;
 };
\ No newline at end of file
@@ -104,6 +104,7 @@ void ProviderDummy::GenerateTimecodes()
 		timecode += frametime;
 		counter++;
 	}
+	UpdateTimecodesIndex();
 }
 
 void ProviderDummy::GenerateFrame()
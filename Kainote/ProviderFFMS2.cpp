@@ -86,6 +86,7 @@ void ProviderFFMS2::Processing()
 
 	SetEvent(m_eventComplete);
 	if (m_width < 0) { return; }
+	StartFramePrefetch();
 
 	while (1) {
 		DWORD wait_result = WaitForMultipleObjects(sizeof(events_to_wait) / sizeof(HANDLE), events_to_wait, FALSE, INFINITE);
@@ -100,12 +101,9 @@ void ProviderFFMS2::Processing()
 					m_renderer->m_Time = m_timecodes[m_renderer->m_Frame];
 					m_lastFrame = m_renderer->m_Frame;
 				}
-				GetFFMSFrame();
-
-				if (!m_FFMS2frame) {
+				if (!ReadFrame(m_renderer->m_Frame, buff)) {
 					continue;
 				}
-				memcpy(&buff[0], m_FFMS2frame->Data[0], m_framePlane);
 
 				m_renderer->DrawTexture(buff);
 				m_renderer->Render(false);
@@ -440,6 +438,7 @@ done:
 			m_timecodes.push_back(Timestamp);
 
 		}
+		UpdateTimecodesIndex();
 		if (m_renderer && !m_renderer->videoControl->GetKeyFramesFileName().empty()) {
 			OpenKeyframes(m_renderer->videoControl->GetKeyFramesFileName());
 			m_renderer->videoControl->SetKeyFramesFileName(emptyString);
@@ -492,6 +491,13 @@ ProviderFFMS2::~ProviderFFMS2()
 		CloseHandle(m_eventStartPlayback);
 		CloseHandle(m_eventKillSelf);
 	}
+	StopFramePrefetch();
+	if (m_frameCache.IsEnabled()) {
+		size_t hits = 0, misses = 0;
+		GetFrameCacheStats(&hits, &misses);
+		KaiLogDebug(wxString::Format(L"Frame cache: %llu hits, %llu misses", 
+			(unsigned long long)hits, (unsigned long long)misses));
+	}
 
 	if (m_audioLoadThread) {
 		m_stopLoadingAudio = true;
@@ -535,6 +541,7 @@ void ProviderFFMS2::AudioLoad(ProviderFFMS2* vf, bool newIndex, int audiotrack)
 		if (!vf->RAMCache()) { goto done; }
 	}
 	vf->audioNotInitialized = false;
+	vf->BuildAudioPeaks();
 done:
 	if (vf->m_audioSource) { FFMS_DestroyAudioSource(vf->m_audioSource); vf->m_audioSource = nullptr; }
 	vf->m_lockGetFrame = false;
@@ -545,6 +552,11 @@ done:
 
 void ProviderFFMS2::GetFrame(int ttime, unsigned char* buff)
 {
+	//prefetch thread can change decoded frame, it has to be taken from cache
+	if (m_frameCache.IsEnabled()) {
+		ReadFrame(m_renderer->m_Frame, buff);
+		return;
+	}
 	byte* cpy = (byte*)m_FFMS2frame->Data[0];
 	memcpy(&buff[0], cpy, m_framePlane);
 
@@ -556,6 +568,128 @@ void ProviderFFMS2::GetFFMSFrame()
 	m_FFMS2frame = FFMS_GetFrame(m_videoSource, m_renderer->m_Frame, &m_errInfo);
 }
 
+bool ProviderFFMS2::ReadFrame(int frame, unsigned char* buffer)
+{
+	if (!m_frameCache.Get(frame, buffer)) {
+		wxCriticalSectionLocker lock(m_blockFrame);
+		m_FFMS2frame = FFMS_GetFrame(m_videoSource, frame, &m_errInfo);
+		if (!m_FFMS2frame)
+			return false;
+
+		memcpy(buffer, m_FFMS2frame->Data[0], m_framePlane);
+		m_frameCache.Put(frame, buffer);
+	}
+	RequestFramePrefetch(frame);
+	return true;
+}
+
+void ProviderFFMS2::StartFramePrefetch()
+{
+	if (!m_videoSource)
+		return;
+
+	m_frameCache.Init(Options.GetInt(VIDEO_FRAME_CACHE_MEMORY), m_framePlane);
+	//prefetch needs room for frames around current one
+	if (m_frameCache.GetCapacity() < 4)
+		return;
+
+	m_stopPrefetch = false;
+	m_eventPrefetch = CreateEvent(0, FALSE, FALSE, 0);
+	unsigned int threadid = 0;
+	m_prefetchThread = (HANDLE)_beginthreadex(0, 0, PrefetchProc, this, 0, &threadid);
+	SetThreadPriority(m_prefetchThread, THREAD_PRIORITY_BELOW_NORMAL);
+	SetThreadName(threadid, "VideoPrefetch");
+}
+
+void ProviderFFMS2::StopFramePrefetch()
+{
+	if (!m_prefetchThread)
+		return;
+
+	m_stopPrefetch = true;
+	SetEvent(m_eventPrefetch);
+	WaitForSingleObject(m_prefetchThread, INFINITE);
+	CloseHandle(m_prefetchThread);
+	CloseHandle(m_eventPrefetch);
+	m_prefetchThread = nullptr;
+	m_eventPrefetch = nullptr;
+}
+
+void ProviderFFMS2::RequestFramePrefetch(int frame)
+{
+	if (!m_prefetchThread)
+		return;
+
+	//direction of playback or stepping, same frame keeps last direction
+	int lastFrame = m_prefetchFrame.exchange(frame);
+	if (lastFrame == frame)
+		return;
+
+	if (lastFrame >= 0)
+		m_prefetchDirection = (frame < lastFrame) ? -1 : 1;
+
+	SetEvent(m_eventPrefetch);
+}
+
+unsigned int __stdcall ProviderFFMS2::PrefetchProc(void* cls)
+{
+	((ProviderFFMS2*)cls)->Prefetch();
+	return 0;
+}
+
+void ProviderFFMS2::Prefetch()
+{
+	char errmsg[1024];
+	FFMS_ErrorInfo errInfo;
+	errInfo.Buffer = errmsg;
+	errInfo.BufferSize = sizeof(errmsg);
+	errInfo.ErrorType = FFMS_ERROR_SUCCESS;
+	errInfo.SubType = FFMS_ERROR_SUCCESS;
+
+	while (WaitForSingleObject(m_eventPrefetch, INFINITE) == WAIT_OBJECT_0 && !m_stopPrefetch) {
+		int frame = m_prefetchFrame;
+		bool forward = m_prefetchDirection > 0;
+		int count = MIN(VIDEO_PREFETCH_FRAMES, (int)m_frameCache.GetCapacity() / 2);
+		if (forward) {
+			//new request starts prefetch from new position
+			PrefetchFrames(frame + 1, MIN(frame + count, m_numFrames - 1), frame, frame, &errInfo);
+			continue;
+		}
+		//frames are decoded forward from seek, so nearest previous frames are decoded first
+		//in small window and the rest after them. Stepping backward to a frame from this range
+		//doesn't stop prefetch, frames before it are still needed
+		int first = MAX(0, frame - count);
+		int nearest = MAX(first, frame - VIDEO_PREFETCH_BACKWARD_NEAREST);
+		if (PrefetchFrames(nearest, frame - 1, first, frame, &errInfo))
+			PrefetchFrames(first, nearest - 1, first, frame, &errInfo);
+	}
+}
+
+bool ProviderFFMS2::PrefetchFrames(int first, int last, int requestFrom, int requestTo, FFMS_ErrorInfo* errInfo)
+{
+	for (int i = first; i <= last; i++) {
+		int request = m_prefetchFrame;
+		if (m_stopPrefetch || request < requestFrom || request > requestTo)
+			return false;
+
+		if (m_frameCache.Contains(i))
+			continue;
+
+		wxCriticalSectionLocker lock(m_blockFrame);
+		const FFMS_Frame* decoded = FFMS_GetFrame(m_videoSource, i, errInfo);
+		if (!decoded)
+			return false;
+
+		m_frameCache.Put(i, (const unsigned char*)decoded->Data[0]);
+	}
+	return true;
+}
+
+void ProviderFFMS2::GetFrameCacheStats(size_t* hits, size_t* misses)
+{
+	m_frameCache.GetStats(hits, misses);
+}
+
 void ProviderFFMS2::GetAudio(void* buf, long long start, long long count)
 {
 
@@ -673,6 +807,7 @@ bool ProviderFFMS2::RAMCache()
 			GetAudio(m_cache[i], pos, halfsize);
 			pos += halfsize;
 		}
+		m_peaks.AddSamples((short*)m_cache[i], blsize / m_bytesPerSample);
 		m_audioProgress = ((float)i / (float)(m_blockNum - 1));
 		if (m_stopLoadingAudio) {
 			m_blockNum = i + 1;
@@ -717,6 +852,7 @@ bool ProviderFFMS2::DiskCache(bool newIndex)
 	else {
 		if (fileExists) {
 			_wremove(m_diskCacheFilename.wc_str());
+			_wremove(GetAudioPeaksFilename().wc_str());
 		}
 		m_diskCacheFilename << L".part";
 		m_fp = _wfopen(m_diskCacheFilename.wc_str(), L"w+b");
@@ -731,6 +867,7 @@ bool ProviderFFMS2::DiskCache(bool newIndex)
 		char* silence = new char[size];
 		memset(silence, 0, size);
 		fwrite(silence, 1, size, m_fp);
+		m_peaks.AddSamples((short*)silence, size / m_bytesPerSample);
 		delete[] silence;
 	}
 	try {
@@ -742,6 +879,8 @@ bool ProviderFFMS2::DiskCache(bool newIndex)
 			if (block + pos > m_numSamples) block = m_numSamples - pos;
 			GetAudio(data, pos, block);
 			fwrite(data, 1, block * m_bytesPerSample, m_fp);
+			if (block > 0)
+				m_peaks.AddSamples((short*)data, block);
 			pos += block;
 			m_audioProgress = ((float)pos / (float)(m_numSamples));
 			if (m_stopLoadingAudio) break;
@@ -760,6 +899,42 @@ bool ProviderFFMS2::DiskCache(bool newIndex)
 	return good;
 }
 
+wxString ProviderFFMS2::GetAudioPeaksFilename()
+{
+	wxString peaksFilename = m_diskCacheFilename;
+	if (peaksFilename.EndsWith(L".part"))
+		peaksFilename.RemoveLast(5);
+
+	return peaksFilename + L".peaks";
+}
+
+void ProviderFFMS2::BuildAudioPeaks()
+{
+	bool keepPeaks = m_discCache && Options.GetBool(AUDIO_PEAKS_CACHE);
+	//when existing disk cache is used, peaks have to be loaded or read from it
+	if (m_peaks.GetSampleCount() == 0) {
+		if (keepPeaks && m_peaks.Load(GetAudioPeaksFilename(), 
+			wxFileName::GetSize(m_diskCacheFilename).GetValue() / m_bytesPerSample))
+			return;
+
+		const int block = 1 << 18;
+		short* data = new short[block];
+		for (long long pos = 0; pos < m_numSamples; pos += block) {
+			int count = (int)MIN(m_numSamples - pos, block);
+			GetBuffer(data, pos, count);
+			m_peaks.AddSamples(data, count);
+			if (m_stopLoadingAudio) break;
+		}
+		delete[] data;
+	}
+	if (m_stopLoadingAudio)
+		return;
+
+	m_peaks.Finish();
+	if (keepPeaks)
+		m_peaks.Save(GetAudioPeaksFilename());
+}
+
 void ProviderFFMS2::ClearDiskCache()
 {
 	if (m_fp) { fclose(m_fp); m_fp = nullptr; }
@@ -775,7 +950,7 @@ void ProviderFFMS2::DeleteOldAudioCache()
 	wxDir kat(path);
 	wxArrayString audioCaches;
 	if (kat.IsOpened()) {
-		kat.GetAllFiles(path, &audioCaches, emptyString, wxDIR_FILES);
+		kat.GetAllFiles(path, &audioCaches, L"*.w64", wxDIR_FILES);
 	}
 	if (audioCaches.size() <= maxAudio) { return; }
 	FILETIME ft;
@@ -799,6 +974,7 @@ void ProviderFFMS2::DeleteOldAudioCache()
 	for (auto cur = dates.begin(); cur != dates.end(); cur++) {
 		if (count >= diff) { break; }
 		int isgood = _wremove(audioCaches[cur->second].wchar_str());
+		_wremove((audioCaches[cur->second] + L".peaks").wchar_str());
 		count++;
 	}
 
@@ -806,6 +982,11 @@ void ProviderFFMS2::DeleteOldAudioCache()
 
 void ProviderFFMS2::GetFrameBuffer(unsigned char** buffer)
 {
+	if (m_frameCache.IsEnabled()) {
+		ReadFrame(m_renderer->m_Frame, *buffer);
+		m_lastFrame = m_renderer->m_Frame;
+		return;
+	}
 	if (m_renderer->m_Frame != m_lastFrame) {
 		GetFFMSFrame();
 		m_lastFrame = m_renderer->m_Frame;
@@ -841,6 +1022,8 @@ void ProviderFFMS2::SetColorSpace(const wxString& matrix)
 {
 	wxCriticalSectionLocker lock(m_blockFrame);
 	if (matrix == m_colorSpace) return;
+	//frames in cache were converted with previous matrix
+	m_frameCache.Clear();
 	//lockGetFrame = true;
 	if (matrix == m_realColorSpace || (matrix != L"TV.601" && matrix != L"TV.709"))
 		FFMS_SetInputFormatV(m_videoSource, m_CS, m_CR, FFMS_GetPixFmt(""), nullptr);
@@ -16,6 +16,13 @@
 #pragma once
 #include "Provider.h"
 #include "ProgressDialog.h"
+#include "VideoFrameCache.h"
+#include <atomic>
+
+//number of frames decoded ahead by prefetch thread, limited to half of frame cache
+#define VIDEO_PREFETCH_FRAMES 8
+//number of previous frames decoded first when stepping backward
+#define VIDEO_PREFETCH_BACKWARD_NEAREST 2
 
 
 class ProviderFFMS2 : public Provider
@@ -40,10 +47,15 @@ public:
 	void ClearRAMCache();
 	bool DiskCache(bool newIndex);
 	void ClearDiskCache();
+	//builds waveform peaks after audio loading or loads them from file next to disk cache
+	void BuildAudioPeaks();
+	wxString GetAudioPeaksFilename();
 	void DeleteOldAudioCache();
 	wxString ColorMatrixDescription(int cs, int cr);
 	void SetColorSpace(const wxString& matrix);
 	bool HasVideo();
+	//hits and misses of decoded frames cache
+	void GetFrameCacheStats(size_t* hits, size_t* misses);
 
 	bool m_discCache;
 	volatile bool m_success;
@@ -65,8 +77,24 @@ private:
 	int m_blockNum = 0;
 	void GetAudio(void* buf, long long start, long long count);
 	void GetFFMSFrame();
+	//takes frame from cache or decodes it and requests prefetch of next frames
+	bool ReadFrame(int frame, unsigned char* buffer);
+	void StartFramePrefetch();
+	void StopFramePrefetch();
+	void RequestFramePrefetch(int frame);
 	static unsigned int __stdcall FFMS2Proc(void* cls);
+	static unsigned int __stdcall PrefetchProc(void* cls);
 	void Processing();
+	void Prefetch();
+	//decodes frames that are not in cache, returns false when it was stopped
+	//or requested frame is out of given range
+	bool PrefetchFrames(int first, int last, int requestFrom, int requestTo, FFMS_ErrorInfo* errInfo);
+	VideoFrameCache m_frameCache;
+	HANDLE m_prefetchThread = nullptr;
+	HANDLE m_eventPrefetch = nullptr;
+	std::atomic<int> m_prefetchFrame{ -1 };
+	std::atomic<int> m_prefetchDirection{ 1 };
+	std::atomic<bool> m_stopPrefetch{ false };
 	volatile bool m_stopLoadingAudio = false;
 	wxCriticalSection m_blockAudio;
 	wxCriticalSection m_blockFrame;
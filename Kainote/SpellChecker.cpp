@@ -41,6 +41,10 @@
 #include <set>
 
 SpellChecker *SpellChecker::SC = nullptr;
+thread_local bool SpellChecker::useSpellChecker = true;
+std::atomic<int> SpellChecker::dictionaryVersion{ 0 };
+
+wxDEFINE_EVENT(EVT_SPELLCHECK_RESULTS, wxThreadEvent);
 
 SpellChecker::SpellChecker()
 {
@@ -73,6 +77,9 @@ SpellChecker::~SpellChecker()
 
 void SpellChecker::Cleaning()
 {
+	StopBackgroundCheck();
+	checkedWords.Clear();
+	dictionaryVersion++;
 	if (hunspell){ delete hunspell; hunspell = nullptr; }
 	if (conv){ delete conv; conv = nullptr; }
 
@@ -157,10 +164,24 @@ bool SpellChecker::CheckWord(wxString *word) {
 		BIDIReverseConvert(word);
 	}
 
-	wxCharBuffer buf = word->mb_str(*conv);
-	if (buf && strlen(buf)) return (hunspell->spell(buf) == 1);
+	return SpellWord(*word);
+}
 
-	return false;
+bool SpellChecker::SpellWord(const wxString &word)
+{
+	std::wstring_view key(word.wc_str(), word.length());
+	bool correct = false;
+	int version;
+	if (checkedWords.Find(key, &correct, &version))
+		return correct;
+
+	wxCharBuffer buf = word.mb_str(*conv);
+	if (buf && strlen(buf)){
+		wxCriticalSectionLocker lock(hunspellLock);
+		correct = (hunspell->spell(buf) == 1);
+	}
+	checkedWords.Add(key, correct, version);
+	return correct;
 }
 
 void SpellChecker::Suggestions(wxString word, wxArrayString &results)
@@ -172,6 +193,7 @@ void SpellChecker::Suggestions(wxString word, wxArrayString &results)
 	wxCharBuffer buf = word.mb_str(*conv);
 	if (!buf) return;
 
+	wxCriticalSectionLocker lock(hunspellLock);
 	int n = hunspell->suggest(&result, buf);
 
 	for (int i = 0; i < n; ++i)
@@ -188,7 +210,12 @@ bool SpellChecker::AddWord(const wxString& word)
 {
 	if (word.IsEmpty() || word.IsNumber()) return false;
 
-	hunspell->add(word.mb_str(*conv));//.mb_str(*conv))
+	{
+		wxCriticalSectionLocker lock(hunspellLock);
+		hunspell->add(word.mb_str(*conv));
+	}
+	checkedWords.Forget(std::wstring_view(word.wc_str(), word.length()));
+	dictionaryVersion++;
 	//wxString pathhh = Options.pathfull + L"\\Dictionary\\UserDic.udic";
 	OpenWrite ow;
 	wxString txt;
@@ -221,7 +248,12 @@ bool SpellChecker::RemoveWords(const wxArrayString &words)
 			int foundWord = words.Index(curLine);
 			if (foundWord != -1){
 				found = true;
-				succeded = hunspell->remove(words[foundWord].mb_str(*conv));
+				{
+					wxCriticalSectionLocker lock(hunspellLock);
+					succeded = hunspell->remove(words[foundWord].mb_str(*conv));
+				}
+				checkedWords.Forget(std::wstring_view(words[foundWord].wc_str(), words[foundWord].length()));
+				dictionaryVersion++;
 				continue;
 			}
 			newTxt << curLine << L"\r\n";
@@ -234,6 +266,78 @@ bool SpellChecker::RemoveWords(const wxArrayString &words)
 	return succeded > 0;
 }
 
+void SpellChecker::StartBackgroundCheck(std::vector<BackgroundCheckLine> &&lines, int subsFormat, int replaceTagsLen, wxEvtHandler *handler)
+{
+	StopBackgroundCheck();
+	if (!hunspell || !conv || lines.empty())
+		return;
+
+	stopBackgroundCheck = false;
+	backgroundHandler = handler;
+	backgroundThread = std::thread(&SpellChecker::BackgroundCheck, this, std::move(lines), subsFormat, replaceTagsLen, handler);
+	SetThreadPriority(backgroundThread.native_handle(), THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+void SpellChecker::StopBackgroundCheck()
+{
+	if (backgroundThread.joinable()){
+		stopBackgroundCheck = true;
+		backgroundThread.join();
+	}
+	backgroundHandler = nullptr;
+}
+
+void SpellChecker::StopBackgroundCheck(wxEvtHandler *handler)
+{
+	if (SC && SC->backgroundHandler == handler)
+		SC->StopBackgroundCheck();
+}
+
+//counts errors like TextData::Init on grid paint,
+//text for editor gets misspells too when tags are not replaced
+void SpellChecker::BackgroundCheck(std::vector<BackgroundCheckLine> lines, int subsFormat, int replaceTagsLen, wxEvtHandler *handler)
+{
+	int version = dictionaryVersion;
+	std::shared_ptr<BackgroundCheckResults> results;
+	wxString convertedText;
+	for (size_t i = 0; i < lines.size(); i++){
+		if (stopBackgroundCheck)
+			return;
+
+		BackgroundCheckLine &line = lines[i];
+		const wxString &text = line.text;
+		if (text.empty()){
+			line.errors.SetEmpty();
+		}
+		else{
+			bool rtl = CheckRTL(&text);
+			if (rtl){
+				wxString textToConvert = text;
+				ConvertToRTLCharsSpellchecker(&textToConvert, &convertedText);
+			}
+			line.errors.hasMisspells = !rtl && replaceTagsLen < 0;
+			CheckTextAndBrackets(rtl ? convertedText : text, &line.errors, line.spellchecker, subsFormat,
+				line.errors.hasMisspells ? &line.errors.misspells : nullptr, replaceTagsLen);
+			line.errors.spellchecker = line.spellchecker;
+			line.errors.isInit = true;
+		}
+		if (!results){
+			results = std::make_shared<BackgroundCheckResults>();
+			results->subsFormat = subsFormat;
+			results->replaceTagsLen = replaceTagsLen;
+			results->dictionaryVersion = version;
+			results->lines.reserve(SPELLCHECKER_RESULTS_BATCH);
+		}
+		results->lines.push_back(std::move(line));
+		if (results->lines.size() >= SPELLCHECKER_RESULTS_BATCH || i + 1 == lines.size()){
+			wxThreadEvent *evt = new wxThreadEvent(EVT_SPELLCHECK_RESULTS);
+			evt->SetPayload(results);
+			wxQueueEvent(handler, evt);
+			results = nullptr;
+		}
+	}
+}
+
 inline void SpellChecker::Check(std::wstring &checkText, TextData *errs, std::vector<MisspellData> *misspells, std::vector<size_t> &textOffset, const wxString &text, bool repltags, int replaceTagsLen) {
 	using namespace boost::locale;
 	boundary::wssegment_index index(boundary::word, checkText.begin(), checkText.end());
@@ -34,6 +34,44 @@
 #include <hunspell.hxx>
 #include <wx/string.h>
 #include "LineParse.h"
+#include "SubsDialogue.h"
+#include "SpellWordCache.h"
+#include <wx/thread.h>
+#include <wx/event.h>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+//max count of words in cache of checked words, least recently used words are removed
+#define SPELLCHECKER_CACHE_SIZE 200000
+//count of lines sent to grid at once by background check
+#define SPELLCHECKER_RESULTS_BATCH 500
+
+//line of grid checked in background thread,
+//text is shared with dialogue, grid uses errors only when line still has this text
+class BackgroundCheckLine
+{
+public:
+	BackgroundCheckLine(size_t _key, const StoreTextHelper &_text, bool _spellchecker)
+		: key(_key), text(_text), spellchecker(_spellchecker){}
+	size_t key;
+	StoreTextHelper text;
+	bool spellchecker;
+	TextData errors;
+};
+
+//payload of EVT_SPELLCHECK_RESULTS, settings are needed to check if errors are still valid
+class BackgroundCheckResults
+{
+public:
+	std::vector<BackgroundCheckLine> lines;
+	int subsFormat;
+	int replaceTagsLen;
+	int dictionaryVersion;
+};
+
+wxDECLARE_EVENT(EVT_SPELLCHECK_RESULTS, wxThreadEvent);
 
 class SpellChecker
 {
@@ -50,6 +88,14 @@ public:
 	bool AddWord(const wxString &word);
 	bool RemoveWords(const wxArrayString &word);
 	void Suggestions(wxString word, wxArrayString &results);
+	//checks lines in background thread the same way as grid does on paint
+	//and sends them in batches to handler with EVT_SPELLCHECK_RESULTS
+	void StartBackgroundCheck(std::vector<BackgroundCheckLine> &&lines, int subsFormat, int replaceTagsLen, wxEvtHandler *handler);
+	void StopBackgroundCheck();
+	//stops check only when it sends results to this handler, spellchecker is not created
+	static void StopBackgroundCheck(wxEvtHandler *handler);
+	//changed after every change of dictionary, results with other version are not valid
+	static int GetDictionaryVersion(){ return dictionaryVersion; }
 
 	//text for both
 	//errors table for both
@@ -69,8 +115,20 @@ private:
 	static SpellChecker *SC;
 	wxString dictionaryPath;
 	wxString userDictionaryPath;
-	bool useSpellChecker = true;
+	//set on every check, checking is used from main and background thread
+	static thread_local bool useSpellChecker;
 	bool isRTL = false;
+	//guards hunspell only, spelling is used from main and background thread,
+	//cache has its own lock, so main thread do not wait for background spelling on cached words
+	wxCriticalSection hunspellLock;
+	SpellWordCache checkedWords{ SPELLCHECKER_CACHE_SIZE };
+	std::thread backgroundThread;
+	std::atomic<bool> stopBackgroundCheck{ false };
+	wxEvtHandler *backgroundHandler = nullptr;
+	static std::atomic<int> dictionaryVersion;
+	//word after RTL conversion, it uses cache and do not check useSpellChecker
+	bool SpellWord(const wxString &word);
+	void BackgroundCheck(std::vector<BackgroundCheckLine> lines, int subsFormat, int replaceTagsLen, wxEvtHandler *handler);
 	//no const cause of clearing
 	inline void Check(std::wstring &checkText, TextData *errs, std::vector<MisspellData> *misspells, std::vector<size_t> &textOffset, const wxString &text, bool repltags, int replaceTagsLen);
 };
@@ -0,0 +1,125 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wctype.h>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+//cache of checked words shared by main and background thread, least recently used words are removed.
+//Words are found by exact letter case, second index by lowercase word lets Forget remove all letter cases without walking the cache.
+//It has its own lock, words missing in cache are spelled without it, so cache hits never wait for hunspell
+class SpellWordCache
+{
+public:
+	SpellWordCache(size_t _maxWords) : maxWords(_maxWords){}
+	//returns true when word is in cache, version is needed by Add when word was not found
+	bool Find(std::wstring_view word, bool *correct, int *version)
+	{
+		std::lock_guard<std::mutex> lock(cacheLock);
+		auto it = words.find(word);
+		if (it == words.end()){
+			*version = cacheVersion;
+			return false;
+		}
+		order.splice(order.begin(), order, it->second);
+		*correct = it->second->correct;
+		return true;
+	}
+	//word is not added when it was forgotten after Find, verdict could be made with old dictionary
+	void Add(std::wstring_view word, bool correct, int version)
+	{
+		std::wstring lowerWord(word);
+		for (auto &ch : lowerWord){
+			ch = (wchar_t)towlower(ch);
+		}
+		std::lock_guard<std::mutex> lock(cacheLock);
+		//other thread could add it after Find
+		if (version != cacheVersion || words.find(word) != words.end())
+			return;
+
+		if (words.size() >= maxWords && !order.empty()){
+			EraseLetterCase(std::prev(order.end()));
+			words.erase(order.back().word);
+			order.pop_back();
+		}
+		order.push_front(CheckedWord{ std::wstring(word), std::move(lowerWord), correct });
+		words.emplace(order.front().word, order.begin());
+		letterCases.emplace(order.front().lowerWord, order.begin());
+	}
+	//removes word in every letter case, hunspell accepts capitalized forms of added words
+	void Forget(std::wstring_view word)
+	{
+		std::wstring lowerWord(word);
+		for (auto &ch : lowerWord){
+			ch = (wchar_t)towlower(ch);
+		}
+		std::lock_guard<std::mutex> lock(cacheLock);
+		cacheVersion++;
+		auto range = letterCases.equal_range(lowerWord);
+		for (auto it = range.first; it != range.second; it++){
+			words.erase(it->second->word);
+			order.erase(it->second);
+		}
+		letterCases.erase(range.first, range.second);
+	}
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(cacheLock);
+		cacheVersion++;
+		words.clear();
+		letterCases.clear();
+		order.clear();
+	}
+	size_t GetCount()
+	{
+		std::lock_guard<std::mutex> lock(cacheLock);
+		return words.size();
+	}
+
+private:
+	struct CheckedWord
+	{
+		std::wstring word;
+		std::wstring lowerWord;
+		bool correct;
+	};
+	typedef std::list<CheckedWord>::iterator CheckedWordIterator;
+	void EraseLetterCase(CheckedWordIterator checkedWord)
+	{
+		auto range = letterCases.equal_range(checkedWord->lowerWord);
+		for (auto it = range.first; it != range.second; it++){
+			if (it->second == checkedWord){
+				letterCases.erase(it);
+				return;
+			}
+		}
+	}
+	std::mutex cacheLock;
+	//most recently used words are at the front, map keys point to strings of list
+	std::list<CheckedWord> order;
+	std::unordered_map<std::wstring_view, CheckedWordIterator> words;
+	//all letter cases of lowercase word
+	std::unordered_multimap<std::wstring_view, CheckedWordIterator> letterCases;
+	size_t maxWords;
+	//changed by Forget and Clear
+	int cacheVersion = 0;
+};
@@ -0,0 +1,200 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "InternTable.h"
+
+//dialogue strings helper class, copies share one text block until one of them is changed,
+//empty text doesn't allocate anything
+class StoreTextHelper{
+public:
+	StoreTextHelper(){}
+	StoreTextHelper(const StoreTextHelper &sh) : block(sh.block){
+		if (block){ block->references++; }
+	}
+	/*StoreTextHelper(const wxString &txt){
+		StoreText(txt);
+		}
+		StoreTextHelper(const char *txt){
+		StoreText(txt);
+		}
+		StoreTextHelper(const wchar_t *txt){
+		StoreText(txt);
+		}*/
+	~StoreTextHelper(){
+		Release();
+	};
+	void Store(const StoreTextHelper &sh){
+		if (block == sh.block)
+			return;
+		Release();
+		block = sh.block;
+		if (block){ block->references++; }
+	};
+	void StoreText(const wxString &txt){
+		//new block is made first, txt can be text of released block
+		TextBlock *newBlock = (txt.empty()) ? nullptr : new TextBlock(txt);
+		Release();
+		block = newBlock;
+	};
+	StoreTextHelper &operator =(const StoreTextHelper &sh){
+		Store(sh);
+		return *this;
+	}
+
+	StoreTextHelper &operator =(const wxString &newString){
+		StoreText(newString);
+		return *this;
+	}
+	operator const wxString&() const{
+		return (block) ? block->text : emptyText;
+	}
+	bool operator !=(const wxString &comptext) const{ return comptext != Get(); };
+	//bool operator !=(const char *comptext) const{ return comptext != (*stored); };
+	bool operator !=(const wchar_t *comptext) const{ return comptext != Get(); };
+	bool operator ==(const wxString &comptext) const{ return comptext == Get(); };
+	//bool operator ==(const char *comptext) const{ return comptext == (*stored); };
+	bool operator ==(const wchar_t *comptext) const{ return comptext == Get(); };
+	wxString &operator <<(wxString &text){
+		return *Copy() << text;
+	};
+	/*wxString &operator <<(const char *text){
+		return *Copy() << text;
+	};*/
+	wxString &operator <<(const wchar_t *text){
+		return *Copy() << text;
+	};
+	//Operator copy pointer only when it was used elsewere
+	wxString *operator ->(){
+		return Copy();
+	}
+	//only reads, text is not copied and its version is not changed
+	const wxString *operator ->() const{
+		return &Get();
+	}
+	wxString &CheckTlRef(StoreTextHelper &TextTl, bool condition){
+		if (condition) {
+			return *TextTl.Copy();
+		}
+		else {
+			return *Copy();
+		}
+	}
+	wxString CheckTl(const StoreTextHelper &TextTl, bool condition){
+		if (condition) {
+			return TextTl.Get();
+		}
+		else {
+			return Get();
+		}
+	}
+	size_t Len() const{
+		return Get().length();
+	}
+	int CmpNoCase(const StoreTextHelper &TextTl) const{
+		return Get().CmpNoCase(TextTl.Get());
+	}
+	bool empty() const{
+		return !block || block->text.empty();
+	}
+	wxString & Trim(bool fromRight = true){
+		return Copy()->Trim(fromRight);
+	}
+	/*const wxScopedCharBuffer mb_str(const wxMBConv& conv = wxConvLibc) const{
+		return stored->mb_str(conv);
+	}*/
+	//text that can be changed, it's copied when it's used elsewhere.
+	//It always gets new version, text that is only read should be taken by Get
+	wxString *Copy(){
+		if (!block || block->interned || block->references > 1){
+			TextBlock *newBlock = new TextBlock(Get());
+			Release();
+			block = newBlock;
+		}
+		else{
+			//not shared text is changed in place
+			block->version = TextBlock::NewVersion();
+		}
+		return &block->text;
+	}
+	//different for every text and its every change, 0 for empty text without block
+	size_t GetVersion() const{
+		return (block) ? block->version : 0;
+	}
+	const wxString &Get() const{
+		return (block) ? block->text : emptyText;
+	}
+	//changed text always gets new block when old one is shared,
+	//so the same block means the same text
+	bool SharesText(const StoreTextHelper &sh) const{
+		return block == sh.block;
+	}
+protected:
+	//finds equal text in table of interned texts or adds it there
+	void StoreInterned(const wxString &txt){
+		if (block && block->text == txt)
+			return;
+
+		TextBlock *newBlock = (txt.empty()) ? nullptr : InternTable::Intern(txt);
+		Release();
+		block = newBlock;
+	}
+	void Release(){
+		if (!block)
+			return;
+
+		if (block->interned){
+			InternTable::Release(block);
+		}
+		else if (block->references.fetch_sub(1) == 1){
+			delete block;
+		}
+		block = nullptr;
+	}
+	TextBlock *block = nullptr;
+	//text of helper without block
+	inline static const wxString emptyText;
+};
+
+//style, actor and effect have only a few different values in the whole file,
+//equal texts of all dialogues share one interned block
+class InternedTextHelper : public StoreTextHelper{
+public:
+	InternedTextHelper(){}
+	InternedTextHelper(const InternedTextHelper &sh) : StoreTextHelper(sh){}
+	InternedTextHelper &operator =(const InternedTextHelper &sh){
+		Store(sh);
+		return *this;
+	}
+	InternedTextHelper &operator =(const StoreTextHelper &sh){
+		Store(sh);
+		return *this;
+	}
+	InternedTextHelper &operator =(const wxString &newString){
+		StoreInterned(newString);
+		return *this;
+	}
+	//interned text is changed only by assignment, operator only reads even on not const dialogue
+	const wxString *operator ->() const{
+		return &Get();
+	}
+private:
+	//copy would take text out of interned table
+	using StoreTextHelper::Copy;
+	using StoreTextHelper::Trim;
+	using StoreTextHelper::CheckTlRef;
+	using StoreTextHelper::operator <<;
+};
@@ -14,6 +14,7 @@
 //  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SubsDialogue.h"
+#include "DialogueParser.h"
 #include "config.h"
 //#include "Utils.h"
 #include <wx/tokenzr.h>
@@ -22,43 +23,18 @@
 #include <map>
 #include <iostream>
 
-
-TagData::TagData(const wxString &name, unsigned int _startTextPos)
-{
-	tagName = name;
-	startTextPos = _startTextPos;
-}
-
-void TagData::PutValue(const wxString &_value, bool _multiValue)
-{
-	value = _value;
-	multiValue = _multiValue;
-}
-
-
-ParseData::ParseData()
-{
-}
-
-void ParseData::AddData(TagData *data)
-{
-	tags.push_back(data);
-}
-
-ParseData::~ParseData()
-{
-	for (auto it = tags.begin(); it != tags.end(); it++){
-		delete (*it);
-	}
-	tags.clear();
-}
-
 Dialogue::Dialogue()
 {
 	Format = ASS;
 	Layer = 0;
 	End.mstime = 5000;
-	Style = L"Default";
+	//interned once, next dialogues only increase references
+	static const InternedTextHelper defaultStyle = [](){
+		InternedTextHelper style;
+		style = L"Default";
+		return style;
+	}();
+	Style = defaultStyle;
 	MarginL = 0;
 	MarginR = 0;
 	MarginV = 0;
@@ -70,6 +46,7 @@ Dialogue::Dialogue()
 Dialogue::~Dialogue()
 {
 	ClearParse();
+	delete tagIndex;
 }
 
 void Dialogue::ClearParse()
@@ -85,7 +62,7 @@ void Dialogue::AddResetOnMDVDWraps(const wxString & prefix)
 	size_t seekPos = 0;
 	bool needAddPrefix = true;
 	bool addPrefixes = prefix.length() > 0;
-	while (textPos < Text->length()){
+	while (textPos < Text.Len()){
 		textPos = copyText.find(L"|");
 		if (needAddPrefix && addPrefixes){
 			Text->insert(diff, L"{" + prefix + L"}");
@@ -117,7 +94,7 @@ void Dialogue::ReplaceSlashesToItalics()
 	wxString copyText = Text;
 	size_t diff = 0;
 	size_t slashPos = 0;
-	while (textPos < Text->length()){
+	while (textPos < Text.Len()){
 		textPos = copyText.find(L"|");
 		if (textPos == -1)
 			textPos = copyText.length();
@@ -223,7 +200,7 @@ void Dialogue::GetTextElement(int replaceColumn, wxString *elementText, bool app
 {
 	if (replaceColumn == TXT){ 
 		*elementText = Text; 
-		if (appendTextTL && !TextTl->empty())
+		if (appendTextTL && !TextTl.empty())
 			*elementText << L"\n" << TextTl;
 	}
 	else if (replaceColumn == TXTTL){ *elementText = TextTl; }
@@ -254,6 +231,12 @@ Dialogue::Dialogue(const wxString &ldial, const wxString &txttl)
 	SetRaw(ldial);
 }
 
+Dialogue::Dialogue(const wchar_t *ldial, size_t length)
+{
+	parseData = nullptr;
+	SetRaw(ldial, length);
+}
+
 static wxRegEx expresion1(L"^\\{([0-9-]+)\\}{([0-9-]*)\\}([^\r\n]*)", wxRE_ADVANCED);
 static wxRegEx expresion2(L"^\\[([0-9-]+)\\]\\[([0-9-]*)\\]([^\r\n]*)", wxRE_ADVANCED);
 static wxRegEx expresion(L"^([0-9]+)[:;]([0-9]+)[:;]([0-9]+)[:;, ]([^\r\n]*)", wxRE_ADVANCED);
@@ -281,54 +264,98 @@ void Dialogue::ChangeDialogueState(char state)
 	State |= state;
 }
 
+//the same as wxString(begin, end).Trim(false).Trim(true) without copying
+static inline wxString TrimmedString(const wchar_t *begin, const wchar_t *end)
+{
+	while (begin < end && IsTrimSpace(*begin))
+		begin++;
+	while (end > begin && IsTrimSpace(end[-1]))
+		end--;
+	return wxString(begin, end - begin);
+}
+
+bool Dialogue::SetRawASS(const wchar_t *ldial, size_t length)
+{
+	if (!HasPrefix(ldial, length, L"Dialogue", 8) && !HasPrefix(ldial, length, L"Comment", 7))
+		return false;
+
+	//Layer, Start, End, Style, Actor, MarginL, MarginR, MarginV, Effect, Text
+	const wchar_t *lineEnd = ldial + length;
+	const wchar_t *commas[9];
+	int numCommas = 0;
+	for (const wchar_t *ch = ldial; ch < lineEnd && numCommas < 9; ch++) {
+		if (*ch == L',')
+			commas[numCommas++] = ch;
+	}
+	if (numCommas < 8)
+		return false;
+
+	auto fieldBegin = [&](int field) { return (field) ? commas[field - 1] + 1 : ldial; };
+	auto fieldEnd = [&](int field) { return (field < numCommas) ? commas[field] : lineEnd; };
+	auto fieldInt = [&](int field) { return ParseInt(fieldBegin(field), fieldEnd(field) - fieldBegin(field)); };
+
+	NonDialogue = false;
+	IsComment = ldial[0] == L'C';
+	const wchar_t *layerEnd = fieldEnd(0);
+	const wchar_t *layer = nullptr;
+	const wchar_t *marked = std::search(ldial, layerEnd, L"arked=", L"arked=" + 6);
+	if (marked == layerEnd) {
+		layer = std::find(ldial, layerEnd, L' ');
+	}
+	else {
+		layer = layerEnd;
+		while (*--layer != L'=');
+	}
+	Layer = (layer < layerEnd) ? ParseInt(layer + 1, layerEnd - layer - 1) : 0;
+	Format = ASS;
+	Start.SetRaw(fieldBegin(1), fieldEnd(1) - fieldBegin(1), Format);
+	End.SetRaw(fieldBegin(2), fieldEnd(2) - fieldBegin(2), Format);
+	Style = wxString(fieldBegin(3), fieldEnd(3) - fieldBegin(3));
+	if (fieldBegin(4) < fieldEnd(4) && *fieldBegin(4) == L'[') {
+		//actor is changed before it's interned
+		wxString actor(fieldBegin(4), fieldEnd(4) - fieldBegin(4));
+		if (actor.Replace(L"[bookmark]", emptyString)){
+			State |= 8;
+		}
+		else if (actor.Replace(L"[tree_closed]", emptyString)){
+			treeState = TREE_CLOSED;
+			isVisible = NOT_VISIBLE;
+		}
+		else if (actor.Replace(L"[tree_opened]", emptyString)){
+			treeState = TREE_OPENED;
+		}
+		else if (actor.Replace(L"[tree_description]", emptyString)){
+			treeState = TREE_DESCRIPTION;
+		}
+		actor.Trim(false);
+		actor.Trim(true);
+		Actor = actor;
+	}
+	else {
+		Actor = TrimmedString(fieldBegin(4), fieldEnd(4));
+	}
+	MarginL = fieldInt(5);
+	MarginR = fieldInt(6);
+	MarginV = fieldInt(7);
+	Effect = TrimmedString(fieldBegin(8), fieldEnd(8));
+	Text = TrimmedString((numCommas > 8) ? commas[8] + 1 : lineEnd, lineEnd);
+	return true;
+}
+
+void Dialogue::SetRaw(const wchar_t *ldial, size_t length)
+{
+	State = 0;
+	if (!SetRawASS(ldial, length))
+		SetRaw(wxString(ldial, length));
+}
+
 void Dialogue::SetRaw(const wxString &ldial)
 {
 	State = 0;
 	//ldial.Trim(false);
 
-	if (ldial.StartsWith(L"Dialogue") || ldial.StartsWith(L"Comment")){
-		wxStringTokenizer assdal(ldial, L",", wxTOKEN_RET_EMPTY_ALL);
-		if (assdal.CountTokens() >= 9){
-			NonDialogue = false;
-			wxString token = assdal.GetNextToken();
-			if (token.StartsWith(L"Dialogue")){ IsComment = false; }
-			else{ IsComment = true; }
-			if (token.Find(L"arked=") == -1){ Layer = wxAtoi(token.AfterFirst(L' ')); }
-			else{ Layer = wxAtoi(token.AfterLast(L'=')); }
-			Format = ASS;
-			Start.SetRaw(assdal.GetNextToken(), Format);
-			End.SetRaw(assdal.GetNextToken(), Format);
-			Style = assdal.GetNextToken();
-			Actor = assdal.GetNextToken();
-			if (Actor->StartsWith(L"[")){
-				if (Actor->Replace(L"[bookmark]", emptyString)){
-					State |= 8;
-				}
-				else if (Actor->Replace(L"[tree_closed]", emptyString)){
-					treeState = TREE_CLOSED;
-					isVisible = NOT_VISIBLE;
-				}
-				else if (Actor->Replace(L"[tree_opened]", emptyString)){
-					treeState = TREE_OPENED;
-				}
-				else if (Actor->Replace(L"[tree_description]", emptyString)){
-					treeState = TREE_DESCRIPTION;
-				}
-			}
-			Actor.Trim(false);
-			Actor.Trim(true);
-			MarginL = wxAtoi(assdal.GetNextToken());
-			MarginR = wxAtoi(assdal.GetNextToken());
-			MarginV = wxAtoi(assdal.GetNextToken());
-			Effect = assdal.GetNextToken();
-			Effect.Trim(false);
-			Effect.Trim(true);
-			Text = ldial.Mid(assdal.GetPosition());
-			Text.Trim(false);
-			Text.Trim(true);
-			return;
-		}
-	}
+	if (SetRawASS(ldial.wc_str(), ldial.length()))
+		return;
 
 	Layer = 0;
 	MarginL = 0;
@@ -405,26 +432,27 @@ void Dialogue::SetRaw(const wxString &ldial)
 
 void Dialogue::GetRaw(wxString *txt, bool tl/*=false*/, const wxString &style/*=""*/, bool hideOriginalOnVideo /*= false*/)
 {
-	wxString line;
+	//appended directly without temporary line
+	wxString &line = *txt;
 	if (Format < SRT){
-		if (NonDialogue){ (*txt) << Text << L"\r\n"; return; }
-		if (IsComment || hideOriginalOnVideo){ line = L"Comment: "; }
-		else{ line = L"Dialogue: "; }
+		if (NonDialogue){ line << Text << L"\r\n"; return; }
+		if (IsComment || hideOriginalOnVideo){ line << L"Comment: "; }
+		else{ line << L"Dialogue: "; }
 		bool styleTl = style != emptyString;
 		const wxString &Styletl = (styleTl) ? style : Style;
 		const wxString &EffectTl = (State & 4 && styleTl) ? wxString(L"\fD") : Effect;
-		// state 8 - bookmarks
-		wxString ActorWithStates = (State & 8) ? L"[bookmark]" + Actor : Actor;
-		if (treeState){
-			ActorWithStates.Prepend((treeState == TREE_DESCRIPTION) ? wxString(L"[tree_description]") :
-				(treeState == TREE_OPENED) ? wxString(L"[tree_opened]") :
-				(treeState == TREE_CLOSED) ? wxString(L"[tree_closed]") : emptyString);
-		}
 		line << Layer << L","
 			<< Start.raw(Format) << L","
 			<< End.raw(Format) << L","
-			<< Styletl << L","
-			<< ActorWithStates << L","
+			<< Styletl << L",";
+		if (treeState){
+			line << ((treeState == TREE_DESCRIPTION) ? L"[tree_description]" :
+				(treeState == TREE_OPENED) ? L"[tree_opened]" :
+				(treeState == TREE_CLOSED) ? L"[tree_closed]" : L"");
+		}
+		// state 8 - bookmarks
+		if (State & 8){ line << L"[bookmark]"; }
+		line << Actor << L","
 			<< MarginL << L","
 			<< MarginR << L","
 			<< MarginV << L","
@@ -448,7 +476,6 @@ void Dialogue::GetRaw(wxString *txt, bool tl/*=false*/, const wxString &style/*=
 		line << Start.raw(Format) << L" --> " << End.raw(Format) << L"\r\n" << txt << L"\r\n";
 	}
 	line << L"\r\n";
-	(*txt) << line;
 }
 
 wxString Dialogue::GetCols(int cols, bool tl, const wxString &style)
@@ -653,6 +680,7 @@ Dialogue *Dialogue::Copy(bool keepstate, bool copyIsVisible)
 	dial->treeState = treeState;
 	dial->isVisible.Store(isVisible, copyIsVisible);
 	dial->parseData = nullptr;
+	dial->tagIndex = nullptr;
 	return dial;
 }
 
@@ -660,83 +688,40 @@ Dialogue *Dialogue::Copy(bool keepstate, bool copyIsVisible)
 //Remember string position is start of the value, position of tag -=tagname.len+1
 ParseData* Dialogue::ParseTags(wxString *tags, size_t ntags, bool plainText)
 {
-	if (parseData) {
-		delete parseData; 
-		parseData = nullptr;
-	}
-	wxString txt = (TextTl != emptyString) ? TextTl : Text;
-	size_t pos = 0;
-	size_t plainStart = 0;
-	bool hasDrawing = false;
-	size_t len = txt.length();
-	bool tagsBlock = false;
-	parseData = new ParseData();
-	double tmpValue;
-	if (len < 1){ return parseData; }
-	while (pos < len){
-		wxUniChar ch = txt[pos];
-		if (ch == L'}'){ tagsBlock = false; plainStart = pos + 1; }
-		else if (ch == L'{' || pos >= len - 1){
-			tagsBlock = true;
-			if (pos >= len - 1){ pos++; }
-			//to not crash the program when subtract from unsigned 0 just add 1 to plain start
-			if ((plainText || hasDrawing) && plainStart + 1 <= pos){
-				TagData *newTag = new TagData((hasDrawing) ? L"pvector" : L"plain", plainStart);
-				newTag->PutValue(txt.SubString(plainStart, pos - 1));
-				parseData->AddData(newTag);
-			}
-		}
-		else if (tagsBlock && ch == L'\\'){
-			pos++;
-			//wxString tag;
-			int slashPos = txt.find(L'\\', pos);
-			int bracketPos = txt.find(L'}', pos);
-			int tagEnd = (slashPos == -1 && bracketPos == -1) ? len :
-				(slashPos == -1) ? bracketPos : (bracketPos == -1) ? slashPos :
-				(bracketPos < slashPos) ? bracketPos : slashPos;
-			wxString tag = txt.SubString(pos, tagEnd - 1);
-			if (tag.EndsWith(L')')){ tag.RemoveLast(); }
-			for (size_t i = 0; i < ntags; i++){
-				wxString tagName = tags[i];
-				int tagLen = tagName.length();
-				if (tag.StartsWith(tagName)){
-					wxUniChar firstValueChar = tag[tagLen];
-					if (firstValueChar == L'(' || wxIsdigit(firstValueChar) || tagName == L"fn" ||
-						firstValueChar == L'.' || firstValueChar == L'-' || firstValueChar == L'+'){
-
-						TagData *newTag = new TagData(tagName, pos + tagLen);
-						wxString tagValue = tag.Mid(tagLen);
-						if (tagName == L"p"){
-							hasDrawing = (tagValue.Trim().Trim(false) == L"0") ? false : true;
-							newTag->PutValue(tagValue);
-						}
-						else if (tag[tagLen] == L'('){
-							newTag->startTextPos++;
-							newTag->PutValue(tagValue.After(L'(').BeforeFirst(L')'), true);
-						}
-						else{
-							if (tagName != L"fn" && !tagValue.ToCDouble(&tmpValue)){
-								wxString newTagValue;
-								for (const auto & ch : tagValue){
-									if (!wxIsdigit(ch) && ch != L'.' && ch != L'-' && ch != L'+')
-										break;
-									newTagValue += ch;
-								}
-								tagValue = newTagValue;
-							}
-							newTag->PutValue(tagValue);
-						}
-						parseData->AddData(newTag);
-						pos = tagEnd - 1;
-						break;
-					}
-				}
-			}
-		}
-		pos++;
-	}
+	//tags of the last parse are reused, visuals parse the same line on every mouse move
+	if (parseData)
+		parseData->Clear();
+	else
+		parseData = new ParseData();
+	const StoreTextHelper &txt = (TextTl != emptyString) ? TextTl : Text;
+	if (txt.empty()){ return parseData; }
+
+	ParseTextTags(txt.Get(), GetTagIndex(), tags, ntags, plainText, parseData);
 	return parseData;
 }
+
+void Dialogue::ParseTagsCopy(ParseData *data, wxString *tags, size_t ntags, bool plainText) const
+{
+	//copy shares text block which is never changed while it's shared
+	StoreTextHelper txt = (!TextTl.empty()) ? TextTl : Text;
+	if (txt.empty())
+		return;
+
+	TagIndex index;
+	index.Build(txt.Get());
+	ParseTextTags(txt.Get(), index, tags, ntags, plainText, data);
+}
+
+const TagIndex &Dialogue::GetTagIndex()
+{
+	const StoreTextHelper &txt = (TextTl != emptyString) ? TextTl : Text;
+	if (!tagIndex)
+		tagIndex = new TagIndex();
+	if (!tagIndex->IsBuiltFor(txt.GetVersion()))
+		tagIndex->Build(txt.Get(), txt.GetVersion());
+
+	return *tagIndex;
+}
 //adding this time
 void Dialogue::ChangeTimes(int start, int end)
 {
@@ -21,40 +21,33 @@
 
 #include "config.h"
 #include "SubsTime.h"
+#include "StoreTextHelper.h"
+#include "TagParser.h"
 #include <wx/colour.h>
 #include <vector>
+#include <atomic>
 
-//isVisible helper class
+//isVisible helper class, value and number of owners are in one allocation
 class StoreHelper {
 public:
 	StoreHelper(){}
-	StoreHelper(const StoreHelper &sh){
-		Store(sh, false);
+	StoreHelper(const StoreHelper &sh) : stored(sh.stored){
+		stored->references++;
 	}
 	~StoreHelper(){
-		if (*deleteReference < 1 && stored){
-			delete stored; stored = nullptr; delete deleteReference; deleteReference = nullptr;
-		}
-		else{
-			(*deleteReference)--;
-		}
+		Release();
 	};
 	void Store(const StoreHelper &sh, bool copy){
 		//assert(sh.stored);
-		if (*deleteReference < 1 && stored != sh.stored){
-			delete stored; stored = nullptr;
-			delete deleteReference; deleteReference = nullptr;
-		}
 		if (copy){
-			stored = new unsigned char(*sh.stored);
-			if (*stored < 1){ *stored = 1; }
-			deleteReference = new size_t(0);
+			unsigned char value = sh.stored->value;
+			Release();
+			stored = new Block{ (value < 1) ? (unsigned char)1 : value, 1 };
 		}
-		else{
+		else if (stored != sh.stored){
+			Release();
 			stored = sh.stored;
-			//if (deleteReference){ delete deleteReference; }
-			deleteReference = sh.deleteReference;
-			(*deleteReference)++;
+			stored->references++;
 		}
 	};
 	StoreHelper &operator =(const StoreHelper &sh){
@@ -63,187 +56,42 @@ public:
 	}
 	void operator =(const unsigned char value){
 		//assert(stored);
-		*stored = value;
+		stored->value = value;
 	}
 	bool operator ==(const unsigned char value){
 		//assert(stored);
-		return *stored == value;
+		return stored->value == value;
 	}
 	bool operator !=(const unsigned char value){
-		return *stored != value;
+		return stored->value != value;
 	}
 	bool operator >(const unsigned char value){
 		//assert(stored);
-		return *stored > value;
+		return stored->value > value;
 	}
 	bool operator <(const unsigned char value){
 		//assert(stored);
-		return *stored < value;
+		return stored->value < value;
 	}
 	bool operator !(){
 		//assert(stored);
-		return !(*stored);
+		return !stored->value;
 	}
 	unsigned char &operator *(){
 		//assert(stored);
-		return *stored;
+		return stored->value;
 	};
 private:
-	unsigned char *stored = new unsigned char(1);
-	size_t *deleteReference = new size_t(0);
-};
-
-//dialogue strings helper class
-class StoreTextHelper{
-public:
-	StoreTextHelper(){}
-	StoreTextHelper(const StoreTextHelper &sh){
-		Store(sh);
-	}
-	/*StoreTextHelper(const wxString &txt){
-		StoreText(txt);
-		}
-		StoreTextHelper(const char *txt){
-		StoreText(txt);
-		}
-		StoreTextHelper(const wchar_t *txt){
-		StoreText(txt);
-		}*/
-	~StoreTextHelper(){
-		if (*deleteReference < 1){
-			delete stored; stored = nullptr;
-			delete deleteReference; deleteReference = nullptr;
-		}
-		else{
-			(*deleteReference)--;
-		}
-	};
-	void Store(const StoreTextHelper &sh){
-		if (*deleteReference < 1){
-			delete stored; stored = nullptr;
-			delete deleteReference; deleteReference = nullptr;
-		}
-		else{
-			(*deleteReference)--;
-		}
-		stored = sh.stored;
-		deleteReference = sh.deleteReference;
-		(*deleteReference)++;
-
-	};
-	void StoreText(const wxString &txt){
-		if (*deleteReference < 1){
-			delete stored; stored = nullptr;
-			delete deleteReference; deleteReference = nullptr;
-		}
-		else{
-			(*deleteReference)--;
-		}
-		deleteReference = new size_t(0);
-		stored = new wxString(txt);
-	};
-	StoreTextHelper &operator =(const StoreTextHelper &sh){
-		Store(sh);
-		return *this;
-	}
-
-	StoreTextHelper &operator =(const wxString &newString){
-		StoreText(newString);
-		return *this;
-	}
-	operator const wxString&(){
-		return *stored;
-	}
-	bool operator !=(const wxString &comptext) const{ return comptext != (*stored); };
-	//bool operator !=(const char *comptext) const{ return comptext != (*stored); };
-	bool operator !=(const wchar_t *comptext) const{ return comptext != (*stored); };
-	bool operator ==(const wxString &comptext) const{ return comptext == (*stored); };
-	//bool operator ==(const char *comptext) const{ return comptext == (*stored); };
-	bool operator ==(const wchar_t *comptext) const{ return comptext == (*stored); };
-	wxString &operator <<(wxString &text){
-		if ((*deleteReference) > 0){
-			StoreText(*stored + text);
-		}
-		else{ *stored << text; }
-		return *stored;
+	struct Block{
+		unsigned char value;
+		//copies of dialogues are released also on other threads
+		std::atomic<size_t> references;
 	};
-	/*wxString &operator <<(const char *text){
-		if ((*deleteReference) > 0){
-			StoreText(*stored + text);
-		}
-		else{ *stored << text; }
-		return *stored;
-	};*/
-	wxString &operator <<(const wchar_t *text){
-		if ((*deleteReference) > 0){
-			StoreText(*stored + text);
-		}
-		else{ *stored << text; }
-		return *stored;
-	};
-	//Operator copy pointer only when it was used elsewere
-	wxString *operator ->(){
-		if ((*deleteReference) > 0){ StoreText(*stored); }
-		return stored;
-	}
-	wxString &CheckTlRef(StoreTextHelper &TextTl, bool condition){
-		if (condition) {
-			return *TextTl.Copy();
-		}
-		else {
-			return *Copy();
-		}
-	}
-	wxString CheckTl(const StoreTextHelper &TextTl, bool condition){
-		if (condition) {
-			return *TextTl.stored;
-		}
-		else {
-			return *stored;
-		}
-	}
-	size_t Len() const{
-		return stored->length();
-	}
-	int CmpNoCase(const StoreTextHelper &TextTl) const{
-		return stored->CmpNoCase(*TextTl.stored);
+	void Release(){
+		if (stored->references.fetch_sub(1) == 1){ delete stored; }
+		stored = nullptr;
 	}
-	bool empty() const{
-		return stored->empty();
-	}
-	wxString & Trim(bool fromRight = true){
-		return stored->Trim(fromRight);
-	}
-	/*const wxScopedCharBuffer mb_str(const wxMBConv& conv = wxConvLibc) const{
-		return stored->mb_str(conv);
-	}*/
-	wxString *Copy(){
-		if ((*deleteReference) > 0){ StoreText(*stored); }
-		return stored;
-	}
-private:
-	wxString *stored = new wxString();
-	size_t *deleteReference = new size_t(0);
-};
-
-class TagData
-{
-public:
-	TagData(const wxString &name, unsigned int startTextPos);
-	void PutValue(const wxString &name, bool multiValue = false);
-	wxString tagName;
-	wxString value;
-	bool multiValue;
-	unsigned int startTextPos;
-};
-
-class ParseData
-{
-public:
-	ParseData();
-	~ParseData();
-	void AddData(TagData *data);
-	std::vector<TagData*> tags;
+	Block *stored = new Block{ 1, 1 };
 };
 
 //states 0-2 editstate, 4 doubtful, 8 bookmark
@@ -258,8 +106,10 @@ private:
 	bool EndsWith(const wxString &text, wxUniChar ch, size_t *pos);
 	//StoreTextHelper Text, TextTl;
 	ParseData* parseData = nullptr;
+	TagIndex* tagIndex = nullptr;
 public:
-	StoreTextHelper Style, Actor, Effect, Text, TextTl;
+	InternedTextHelper Style, Actor, Effect;
+	StoreTextHelper Text, TextTl;
 	SubsTime Start, End;
 	int Layer;
 	short MarginL, MarginR, MarginV;
@@ -275,6 +125,10 @@ public:
 	void ChangeDialogueState(char state);
 	bool IsDoubtful(){ return (State & 4) > 0; };
 	void SetRaw(const wxString &ldial);
+	void SetRaw(const wchar_t *ldial, size_t length);
+	//parses Dialogue / Comment line without copying it, returns false when line is not ASS
+	//it doesn't use any shared data and can be called from threads
+	bool SetRawASS(const wchar_t *ldial, size_t length);
 	void GetRaw(wxString *txt, bool tl = false, const wxString &style = emptyString, bool hideOriginalOnVideo = false);
 	wxString GetCols(int cols, bool tl = false, const wxString &style = emptyString);
 	void Convert(char type, const wxString &pref = emptyString);
@@ -283,8 +137,13 @@ public:
 	//Remember string position is start of the value, position of tag -=tagname.len+1
 	//vector value has tagName "pvector" to make easier to find and avoid bugs
 	ParseData* ParseTags(wxString *tags, size_t n, bool plainText = false);
+	//parses copy of text to given data, parse data and tag index of dialogue are not changed,
+	//so it can be used on other threads when UI parses the same dialogue
+	void ParseTagsCopy(ParseData *data, wxString *tags, size_t n, bool plainText = false) const;
 	void ChangeTimes(int start, int end);
 	void ClearParse();
+	//index of tags in TextTl or Text when TextTl is empty, ParseTags uses it too
+	const TagIndex &GetTagIndex();
 	void GetTextElement(int element, wxString *elementText, bool appendTextTL = false);
 	void SetTextElement(int element, const wxString &elementText, bool appendTextTL = false);
 	const wxString & GetTextNoCopy();
@@ -293,6 +152,7 @@ public:
 	void SetText(const wxString &text);
 	Dialogue();
 	Dialogue(const wxString &ldial, const wxString &txttl = emptyString);
+	Dialogue(const wchar_t *ldial, size_t length);
 	~Dialogue();
 };
 
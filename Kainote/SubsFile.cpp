@@ -18,6 +18,7 @@
 #include "KaiListCtrl.h"
 #include "MappedButton.h"
 #include "Config.h"
+#include <unordered_set>
 
 
 HistoryDialog::HistoryDialog(wxWindow *parent, SubsFile *file, std::function<void(int)> func)
@@ -106,6 +107,18 @@ File *File::Copy(bool copySelections)
 	return file;
 }
 
+size_t File::GetMemoryUsage()
+{
+	size_t usage = sizeof(File) + dialogues.GetMemoryUsage();
+	usage += (styles.capacity() + sinfo.capacity()) * sizeof(void*);
+	usage += Selections.size() * (sizeof(int) + 4 * sizeof(void*));
+	for (Dialogue *dial : deleteDialogues){
+		usage += sizeof(Dialogue) + (dial->Text.Len() + dial->TextTl.Len()) * sizeof(wxChar);
+	}
+	usage += deleteStyles.size() * sizeof(Styles) + deleteSinfo.size() * sizeof(SInfo);
+	return usage;
+}
+
 SubsFile::SubsFile(wxMutex * editionGuard)
 {
 	historyNames = new wxString[AUTOMATION_SCRIPT + 1]{
@@ -203,10 +216,36 @@ void SubsFile::SaveUndo(unsigned char editionType, int activeLine, int markerLin
 	subs->activeLine = activeLine;
 	//subs->markerLine = markerLine;
 	subs->editionType = editionType;
+	subs->memoryUsage = subs->GetMemoryUsage();
 	undo.push_back(subs);
 	subs = subs->Copy();
 	iter++;
 	edited = false;
+	InvalidateIndexes();
+	CheckUndoMemoryLimit();
+}
+
+void SubsFile::CheckUndoMemoryLimit()
+{
+	int limit = Options.GetInt(SUBS_UNDO_MEMORY_LIMIT);
+	if (limit <= 0)
+		return;
+
+	size_t maxUsage = (size_t)limit * 1024 * 1024;
+	size_t usage = 0;
+	for (File *file : undo){
+		usage += file->memoryUsage;
+	}
+	if (usage <= maxUsage)
+		return;
+	//first element is subtitles after loading and last is current step, both have to stay
+	int num = 1;
+	while (usage > maxUsage && num < iter){
+		usage -= undo[num]->memoryUsage;
+		num++;
+	}
+	if (num > 1)
+		RemoveFirst(num);
 }
 
 
@@ -218,6 +257,7 @@ bool SubsFile::Redo()
 		subs->Clear();
 		delete subs;
 		subs = undo[iter]->Copy();
+		InvalidateIndexes();
 		return false;
 	}
 	return true;
@@ -231,6 +271,7 @@ bool SubsFile::Undo()
 		subs->Clear();
 		delete subs;
 		subs = undo[iter]->Copy();
+		InvalidateIndexes();
 		return false;
 	}
 	return true;
@@ -244,6 +285,7 @@ bool SubsFile::SetHistory(int _iter)
 		subs->Clear();
 		delete subs;
 		subs = undo[iter]->Copy();
+		InvalidateIndexes();
 		return false;
 	}
 	return true;
@@ -255,6 +297,7 @@ void SubsFile::DummyUndo()
 	subs->Clear();
 	delete subs;
 	subs = undo[iter]->Copy();
+	InvalidateIndexes();
 }
 
 void SubsFile::DummyUndo(int newIter)
@@ -264,6 +307,7 @@ void SubsFile::DummyUndo(int newIter)
 	subs->Clear();
 	delete subs;
 	subs = undo[newIter]->Copy();
+	InvalidateIndexes();
 	iter = newIter;
 	if (iter < undo.size() - 1){
 		for (std::vector<File*>::iterator it = undo.begin() + iter + 1; it != undo.end(); it++)
@@ -303,19 +347,28 @@ size_t SubsFile::GetCount()
 
 size_t SubsFile::GetIdCount()
 {
-	size_t idCount = 0;
-	for (Dialogue * dial : subs->dialogues){
-		if (*dial->isVisible)
-			idCount++;
-	}
+	CheckVisibleIndex();
+	return visibleIndex.GetVisibleCount();
+}
 
-	return idCount;
+void SubsFile::InvalidateIndexes()
+{
+	visibleIndex.Invalidate();
+	styleIndex.Invalidate();
+	sinfoIndex.Invalidate();
+}
+
+void SubsFile::CheckVisibleIndex()
+{
+	if (visibleIndex.NeedRebuild(subs->dialogues.size()))
+		visibleIndex.Rebuild(subs->dialogues, [](Dialogue *dial){ return *dial->isVisible != 0; });
 }
 
 void SubsFile::AppendDialogue(Dialogue *dial)
 {
 	subs->deleteDialogues.push_back(dial);
 	subs->dialogues.push_back(dial);
+	visibleIndex.Invalidate();
 }
 
 Dialogue * SubsFile::CopyVisibleDialogue(size_t i, bool push /*= true*/, bool keepstate/*=false*/)
@@ -332,6 +385,8 @@ Dialogue * SubsFile::CopyDialogue(size_t i, bool push /*= true*/, bool keepstate
 	subs->deleteDialogues.push_back(dial);
 	if (push){ 
 		subs->dialogues[i] = dial;
+		//visibility of copy can be changed by caller
+		visibleIndex.Invalidate();
 	}
 	return dial;
 }
@@ -361,6 +416,8 @@ void SubsFile::SetDialogue(size_t i, Dialogue *dial, bool addToDestroyer)
 
 	if (addToDestroyer)
 		subs->deleteDialogues.push_back(dial);
+
+	visibleIndex.Invalidate();
 }
 
 void SubsFile::DeleteDialogues(size_t from, size_t to)
@@ -372,6 +429,7 @@ void SubsFile::DeleteDialogues(size_t from, size_t to)
 		to = subs->dialogues.size();
 
 	subs->dialogues.erase(subs->dialogues.begin() + from, subs->dialogues.begin() + to);
+	visibleIndex.Invalidate();
 }
 
 
@@ -383,12 +441,17 @@ void SubsFile::DeleteSelectedDialogues()
 	}
 	if (subs->Selections.size() > 0){ 
 		edited = true; 
+		visibleIndex.Invalidate();
 	}
 }
 
 void SubsFile::SortAll(bool func(Dialogue *i, Dialogue *j))
 {
-	std::stable_sort(subs->dialogues.begin(), subs->dialogues.end(), func);
+	std::vector<Dialogue*> sorted;
+	subs->dialogues.ToVector(&sorted);
+	std::stable_sort(sorted.begin(), sorted.end(), func);
+	subs->dialogues.Assign(sorted);
+	visibleIndex.Invalidate();
 }
 
 void SubsFile::SortSelected(bool func(Dialogue *i, Dialogue *j))
@@ -405,6 +468,7 @@ void SubsFile::SortSelected(bool func(Dialogue *i, Dialogue *j))
 		subs->dialogues[*cur] = selected[ii++];
 	}
 	selected.clear();
+	visibleIndex.Invalidate();
 }
 
 void SubsFile::GetSelections(wxArrayInt &selections, bool deselect/*=false*/, bool checkVisible /*= true*/)
@@ -447,21 +511,18 @@ size_t SubsFile::FindVisibleKey(size_t key, int *corrected)
 	key = MID(0, key, GetCount() - 1);
 	Dialogue *dial = subs->dialogues[key];
 	if (!dial->isVisible){
-		size_t i = key - 1;
-		while (i + 1 > 0){
-			if (subs->dialogues[i]->isVisible != NOT_VISIBLE){
-				if (corrected){ *corrected = i; }
-				return i;
-			}
-			i--;
-		}
-		i = key + 1;
-		while (i < subs->dialogues.size()){
-			if (subs->dialogues[i]->isVisible != NOT_VISIBLE){
-				if (corrected){ *corrected = i; }
-				return i;
-			}
-			i++;
+		CheckVisibleIndex();
+		//previous visible line first, next when there is nothing before
+		size_t visibleBefore = visibleIndex.CountBefore(key);
+		size_t found = -1;
+		if (visibleBefore > 0)
+			found = visibleIndex.FindKey(visibleBefore - 1);
+		else if (visibleBefore < visibleIndex.GetVisibleCount())
+			found = visibleIndex.FindKey(visibleBefore);
+
+		if (found != -1){
+			if (corrected){ *corrected = found; }
+			return found;
 		}
 	}else
 		return key;
@@ -486,18 +547,9 @@ void SubsFile::ClearSelections()
 
 size_t SubsFile::GetElementById(size_t id)
 {
-	size_t countid = -1;
-	for (size_t i = 0; i < subs->dialogues.size(); i++){
-		if (*subs->dialogues[i]->isVisible)
-			countid++;
-
-		if (countid == id){
-			return i;
-		}
-	}
-
-	// it's possible when id >= size
-	return -1;
+	CheckVisibleIndex();
+	// it returns -1 when id >= size
+	return visibleIndex.FindKey(id);
 }
 
 size_t SubsFile::GetElementByKey(size_t key)
@@ -505,16 +557,8 @@ size_t SubsFile::GetElementByKey(size_t key)
 	if (key >= subs->dialogues.size())
 		return -1;
 
-	size_t countid = 0;
-	for (size_t i = 0; i < subs->dialogues.size(); i++){
-		if (i == key){
-			return countid;
-		}
-		if (*subs->dialogues[i]->isVisible)
-			countid++;
-	}
-	//it's possible to get here?
-	return -1;
+	CheckVisibleIndex();
+	return visibleIndex.CountBefore(key);
 }
 
 Styles *SubsFile::CopyStyle(size_t i, bool push)
@@ -523,6 +567,8 @@ Styles *SubsFile::CopyStyle(size_t i, bool push)
 	subs->deleteStyles.push_back(styl);
 	if (push){
 		subs->styles[i] = styl;
+		//copy is changed outside, its name too
+		styleIndex.Invalidate();
 	}
 	return styl;
 }
@@ -533,6 +579,7 @@ SInfo *SubsFile::CopySinfo(size_t i, bool push)
 	subs->deleteSinfo.push_back(sinf);
 	if (push){
 		subs->sinfo[i] = sinf;
+		sinfoIndex.Invalidate();
 	}
 	return sinf;
 }
@@ -545,20 +592,51 @@ void SubsFile::EndLoad(unsigned char editionType, int activeLine, bool initialSa
 		lastSave = -1;
 
 	subs->editionType = editionType;
+	subs->memoryUsage = subs->GetMemoryUsage();
 	undo.push_back(subs);
 	subs = subs->Copy();
+	InvalidateIndexes();
 }
 
 void SubsFile::RemoveFirst(int num)
 {
 	//Warning first element of table is subtitles after loading cannot delete it
+	if (num < 2 || num > iter)
+		return;
+
+	//elements created in removed steps can be still used by next steps,
+	//every element lives in continuous range of steps, then it's enough to check first step that stays
+	File *nextFile = undo[num];
+	std::unordered_set<Dialogue*> usedDialogues(nextFile->dialogues.begin(), nextFile->dialogues.end());
+	std::unordered_set<Styles*> usedStyles(nextFile->styles.begin(), nextFile->styles.end());
+	std::unordered_set<SInfo*> usedSinfo(nextFile->sinfo.begin(), nextFile->sinfo.end());
 	for (std::vector<File*>::iterator it = undo.begin() + 1; it != undo.begin() + num; it++)
 	{
-		(*it)->Clear();
-		delete (*it);
+		File *file = (*it);
+		for (Dialogue *dial : file->deleteDialogues){
+			if (usedDialogues.find(dial) != usedDialogues.end())
+				nextFile->deleteDialogues.push_back(dial);
+			else
+				delete dial;
+		}
+		for (Styles *style : file->deleteStyles){
+			if (usedStyles.find(style) != usedStyles.end())
+				nextFile->deleteStyles.push_back(style);
+			else
+				delete style;
+		}
+		for (SInfo *info : file->deleteSinfo){
+			if (usedSinfo.find(info) != usedSinfo.end())
+				nextFile->deleteSinfo.push_back(info);
+			else
+				delete info;
+		}
+		delete file;
 	}
 	undo.erase(undo.begin() + 1, undo.begin() + num);
-	if (lastSave > iter){ lastSave -= (num - 1); }
+	nextFile->memoryUsage = nextFile->GetMemoryUsage();
+	if (lastSave >= num){ lastSave -= (num - 1); }
+	else if (lastSave > 0){ lastSave = -1; }
 	iter -= (num - 1);
 }
 
@@ -614,16 +692,20 @@ unsigned char SubsFile::CheckIfHasHiddenBlock(int i, bool firstLine /*= false*/)
 
 size_t SubsFile::GetKeyFromPos(size_t position, size_t numOfLines)
 {
-	size_t visibleLines = 0;
-	for (size_t i = position; i < subs->dialogues.size(); i++){
-		if (numOfLines == visibleLines)
-			return i;
+	if (position >= subs->dialogues.size())
+		return -1;
 
-		if (*subs->dialogues[i]->isVisible)
-			visibleLines++;
-	}
+	if (!numOfLines)
+		return position;
 
-	return -1;
+	CheckVisibleIndex();
+	//key after numOfLines visible lines counting from position
+	size_t lastVisibleId = visibleIndex.CountBefore(position) + numOfLines - 1;
+	size_t lastVisibleKey = visibleIndex.FindKey(lastVisibleId);
+	if (lastVisibleKey == -1 || lastVisibleKey + 1 >= subs->dialogues.size())
+		return -1;
+
+	return lastVisibleKey + 1;
 }
 
 bool SubsFile::CheckIfIsTree(size_t i){
@@ -664,6 +746,7 @@ int SubsFile::OpenCloseTree(size_t i){
 			dial->isVisible = visibility;
 			dial->treeState = TREE_CLOSED;
 		}
+		visibleIndex.Update(k, visibility != NOT_VISIBLE);
 	}
 	if (endOfTree < 0){
 		endOfTree = subs->dialogues.size() - 1;
@@ -721,12 +804,15 @@ void SubsFile::AddStyle(Styles *nstyl)
 {
 	subs->deleteStyles.push_back(nstyl);
 	subs->styles.push_back(nstyl);
+	styleIndex.Add(subs->styles);
 }
 
 void SubsFile::ChangeStyle(Styles *nstyl, size_t i)
 {
 	subs->deleteStyles.push_back(nstyl);
+	wxString oldName = subs->styles[i]->Name;
 	subs->styles[i] = nstyl;
+	styleIndex.Replace(subs->styles, i, oldName);
 }
 
 size_t SubsFile::StylesSize()
@@ -737,10 +823,8 @@ size_t SubsFile::StylesSize()
 Styles *SubsFile::GetStyle(size_t i, const wxString &name/* = emptyString*/)
 {
 	if (name != emptyString){
-		for (size_t j = 0; j < subs->styles.size(); j++)
-		{
-			if (name == subs->styles[j]->Name){ return subs->styles[j]; }
-		}
+		size_t j = styleIndex.Find(subs->styles, name);
+		if (j != -1){ return subs->styles[j]; }
 	}
 	if (!subs->styles.size()) {
 		AddStyle(new Styles());
@@ -756,15 +840,16 @@ std::vector<Styles*> *SubsFile::GetStyleTable()
 //multiplication musi być ustawione na zero, wtedy zwróci ilość multiplikacji
 size_t SubsFile::FindStyle(const wxString &name, int *multiplication)
 {
+	if (!multiplication)
+		return styleIndex.Find(subs->styles, name);
+
+	//counts all styles with this name and returns the last one, used only by style manager
 	size_t isfound = -1;
 	for (size_t j = 0; j < subs->styles.size(); j++)
 	{
 		if (name == subs->styles[j]->Name){
 			isfound = j;
-			if (multiplication){
-				(*multiplication)++;
-			}
-			else{ break; }
+			(*multiplication)++;
 		}
 	}
 	return isfound;
@@ -786,34 +871,30 @@ void SubsFile::DeleleStyle(size_t i)
 {
 	edited = true;
 	subs->styles.erase(subs->styles.begin() + i);
+	styleIndex.Invalidate();
 }
 
 const wxString & SubsFile::GetSInfo(const wxString &key, int *ii/* = 0*/)
 {
-	int i = 0;
-	for (std::vector<SInfo*>::iterator it = subs->sinfo.begin(); it != subs->sinfo.end(); it++)
-	{
-		if (key == (*it)->Name) { if (ii){ *ii = i; } return (*it)->Val; }
-		i++;
-	}
-	return emptyString;
+	size_t i = sinfoIndex.Find(subs->sinfo, key);
+	if (i == -1)
+		return emptyString;
+
+	if (ii){ *ii = (int)i; }
+	return subs->sinfo[i]->Val;
 }
 
 SInfo *SubsFile::GetSInfoP(const wxString &key, int *ii)
 {
-	int i = 0;
-	for (std::vector<SInfo*>::iterator it = subs->sinfo.begin(); it != subs->sinfo.end(); it++)
-	{
-		if (key == (*it)->Name) { if (ii){ *ii = i; }; return (*it); }
-		i++;
-	}
-	*ii = -1;
-	return nullptr;
+	size_t i = sinfoIndex.Find(subs->sinfo, key);
+	if (ii){ *ii = (int)i; }
+	return (i == -1) ? nullptr : subs->sinfo[i];
 }
 
 void SubsFile::DeleteSInfo(size_t i)
 {
 	subs->sinfo.erase(subs->sinfo.begin() + i);
+	sinfoIndex.Invalidate();
 	edited = true;
 }
 
@@ -863,6 +944,7 @@ void SubsFile::InsertRows(int Row,
 	if (convertedRow >= subs->dialogues.size()){ convertedRow = subs->dialogues.size(); }
 	subs->dialogues.insert(subs->dialogues.begin() + convertedRow, RowsTable.begin(), RowsTable.end());
 	if (AddToDestroy){ subs->deleteDialogues.insert(subs->deleteDialogues.end(), RowsTable.begin(), RowsTable.end()); }
+	visibleIndex.Invalidate();
 }
 
 void SubsFile::InsertRows(int Row, int NumRows, Dialogue *Dialog, bool AddToDestroy, bool Save)
@@ -871,6 +953,7 @@ void SubsFile::InsertRows(int Row, int NumRows, Dialogue *Dialog, bool AddToDest
 	if (convertedRow >= subs->dialogues.size()){ convertedRow = subs->dialogues.size(); }
 	subs->dialogues.insert(subs->dialogues.begin() + convertedRow, NumRows, Dialog);
 	if (AddToDestroy){ subs->deleteDialogues.push_back(Dialog); }
+	visibleIndex.Invalidate();
 }
 
 void SubsFile::SwapRows(int frst, int scnd)
@@ -881,6 +964,7 @@ void SubsFile::SwapRows(int frst, int scnd)
 	subs->dialogues[scnd] = tmp;
 	subs->dialogues[frst]->ChangeDialogueState(1);
 	tmp->ChangeDialogueState(1);
+	visibleIndex.Invalidate();
 }
 
 void SubsFile::AddSInfo(const wxString &SI, wxString val, bool save)
@@ -903,6 +987,7 @@ void SubsFile::AddSInfo(const wxString &SI, wxString val, bool save)
 		oldinfo = new SInfo(key, val);
 		if (ii < 0){
 			subs->sinfo.push_back(oldinfo);
+			sinfoIndex.Add(subs->sinfo);
 		}
 		else{
 			subs->sinfo[ii] = oldinfo;
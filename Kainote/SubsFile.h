@@ -18,6 +18,9 @@
 #include "Styles.h"
 #include "SubsDialogue.h"
 #include "KaiDialog.h"
+#include "ChunkedArray.h"
+#include "NameIndex.h"
+#include "VisibleLinesIndex.h"
 #include <vector>
 #include <set>
 #include <functional>
@@ -86,7 +89,8 @@ enum{
 class File
 {
 public:
-	std::vector<Dialogue*> dialogues;
+	//chunks of dialogues are shared between history steps, copy of File copies only chunk pointers
+	ChunkedArray<Dialogue*> dialogues;
 	std::vector<Styles*> styles;
 	std::vector<SInfo*> sinfo;
 	std::vector<Dialogue*> deleteDialogues;
@@ -98,10 +102,13 @@ public:
 	int activeLine;
 	int markerLine = 0;
 	int scrollPosition = 0;
+	//estimated memory in bytes, counted when file is added to history
+	size_t memoryUsage = 0;
 	File();
 	~File();
 	void Clear();
 	File *Copy(bool copySelections = true);
+	size_t GetMemoryUsage();
 };
 
 class SubsFile
@@ -111,6 +118,12 @@ private:
 	int iter;
 	File *subs;
 	int lastSave = 0;
+	VisibleLinesIndex visibleIndex;
+	NameIndex<Styles> styleIndex;
+	NameIndex<SInfo> sinfoIndex;
+	//removes oldest history steps when history exceeds SUBS_UNDO_MEMORY_LIMIT
+	void CheckUndoMemoryLimit();
+	void CheckVisibleIndex();
 
 public:
 	SubsFile(wxMutex * editionGuard);
@@ -149,6 +162,8 @@ public:
 	size_t StylesSize();
 	Styles *GetStyle(size_t i, const wxString &name = emptyString);
 	std::vector<Styles*> *GetStyleTable();
+	//call it after changing order or names of styles from GetStyleTable
+	void InvalidateStyleIndex(){ styleIndex.Invalidate(); }
 
 	//multiplication must be set to 0
 	size_t FindStyle(const wxString &name, int *multip);
@@ -162,7 +177,12 @@ public:
 	size_t SInfoSize();
 	void SaveSelections(bool clear, int currentLine, int markedLine, int scrollPos);
 	size_t FirstSelection(size_t *id = nullptr);
+	//after changes of File made outside call InvalidateIndexes
 	File *GetSubs(){ return subs; }
+	//current file was changed to other history step or outside of SubsFile
+	void InvalidateIndexes();
+	//call it after changing visibility of dialogues outside of SubsFile
+	void InvalidateVisibleIndex(){ visibleIndex.Invalidate(); }
 	void GetSelections(wxArrayInt &selections, bool deselect=false, bool checkVisible = true);
 	const std::set<int> & GetSelectionsAsKeys(){ return subs->Selections; };
 	void InsertSelection(size_t i);
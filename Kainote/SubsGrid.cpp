@@ -1620,6 +1620,7 @@ void SubsGrid::TreeSelect(int treeLine)
 		}
 		file->InsertSelection(i);
 	}
+	file->InvalidateVisibleIndex();
 	Refresh(false);
 }
 
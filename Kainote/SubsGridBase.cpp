@@ -22,6 +22,7 @@
 #include "SubsGridFiltering.h"
 #include "config.h"
 #include "OpennWrite.h"
+#include "AutoSaveWriter.h"
 #include "OptionsDialog.h"
 #include "AudioBox.h"
 #include "KaiMessageBox.h"
@@ -33,7 +34,13 @@
 #include "VisualClips.h"
 #include "Visuals.h"
 #include "SubtitlesProviderManager.h"
+#include "SpellChecker.h"
+#include "TextCompare.h"
+#include "FrameTimes.h"
 #include <algorithm>
+#include <map>
+#include <tuple>
+#include <thread>
 #include <wx/tokenzr.h>
 #include <wx/event.h>
 #include <wx/regex.h>
@@ -99,6 +106,7 @@ SubsGridBase::SubsGridBase(wxWindow *parent, const long int id, const wxPoint& p
 	: KaiScrolledWindow(parent, id, pos, size, style | wxVERTICAL)
 {
 	file = new SubsFile(&editionMutex);
+	autoSave = new AutoSaveWriter();
 	makebackup = true;
 	ismenushown = false;
 	showFrames = false;
@@ -112,12 +120,16 @@ SubsGridBase::SubsGridBase(wxWindow *parent, const long int id, const wxPoint& p
 	Bind(wxEVT_TIMER, [=](wxTimerEvent &evt){
 		Kai->SetStatusText(emptyString, 0);
 	}, 27890);
+	Bind(EVT_SPELLCHECK_RESULTS, &SubsGridBase::OnSpellCheckResults, this);
 }
 
 
 SubsGridBase::~SubsGridBase()
 {
+	//background check sends results to this grid
+	SpellChecker::StopBackgroundCheck(this);
 	Clearing();
+	delete autoSave;
 }
 
 
@@ -125,6 +137,8 @@ SubsGridBase::~SubsGridBase()
 void SubsGridBase::Clearing()
 {
 	SAFE_DELETE(Comparison);
+	//autosave thread can still read history of file
+	autoSave->Stop();
 	SAFE_DELETE(file);
 	SpellErrors.clear();
 	isFiltered = false;
@@ -335,40 +349,19 @@ void SubsGridBase::SaveFile(const wxString &filename, bool normalSave, bool load
 	bool translated = tlmode == L"Translated";
 	bool tlmodeOn = tlmode != emptyString;
 
-	OpenWrite ow(filename, true);
+	//lines are written to big buffer and temporary file replaces old one at the end
+	OpenWrite ow;
+	if (!ow.SafeFileOpen(filename))
+		return;
 
 	if (subsFormat < SRT){
-		//if (cstat){
-			//AddSInfo(L"Last Style Storage", Options.actualStyleDir, false);
-			AddSInfo(L"Active Line", std::to_wstring(currentLine), false);
-			wxString subsPath = tab->SubsPath.BeforeLast(L'\\');
-			if (edit->ABox){
-				wxString path = (edit->ABox->audioName.StartsWith(subsPath) && normalSave) ?
-					edit->ABox->audioName.AfterLast(L'\\') : edit->ABox->audioName;
-				AddSInfo(L"Audio File", path, false);
-			}
-			if (!tab->VideoPath.empty()){
-				wxString path = (tab->VideoPath.StartsWith(subsPath) && normalSave) ?
-					tab->VideoPath.AfterLast(L'\\') : tab->VideoPath;
-				AddSInfo(L"Video File", path, false);
-			}
-			if (!tab->KeyframesPath.empty()){
-				wxString path = (tab->KeyframesPath.StartsWith(subsPath) && normalSave) ?
-					tab->KeyframesPath.AfterLast(L'\\') : tab->KeyframesPath;
-				AddSInfo(L"Keyframes File", path, false);
-			}
-		//}
-
-		txt << L"[Script Info]\r\n;Script generated by " << Options.progname << L"\r\n";
-		GetSInfos(txt, translated);
-		txt << L"\r\n[V4+ Styles]\r\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding \r\n";
-		GetStyles(txt, translated);
-		txt << L" \r\n[Events]\r\nFormat: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+		GetSaveHeader(txt, normalSave, translated);
 	}
-	ow.PartFileWrite(txt);
+	ow.SafeFileWrite(txt);
 
 	txt = GetSInfo(L"TLMode Style");
 	wxString raw;
+	raw.reserve(1024);
 	if (loadFromEditbox){
 		for (size_t i = 0; i < file->GetCount(); i++)
 		{
@@ -397,7 +390,7 @@ void SubsGridBase::SaveFile(const wxString &filename, bool normalSave, bool load
 				dial->GetRaw(&raw);
 			}
 
-			ow.PartFileWrite(raw);
+			ow.SafeFileWrite(raw);
 			raw.Empty();
 
 		}
@@ -425,21 +418,55 @@ void SubsGridBase::SaveFile(const wxString &filename, bool normalSave, bool load
 				dial->GetRaw(&raw);
 			}
 
-			ow.PartFileWrite(raw);
+			ow.SafeFileWrite(raw);
 			raw.Empty();
 
-			if (normalSave && dial->GetState() & 1){ dial->ChangeDialogueState(2); }
-
 		}
 	}
 
-	ow.CloseFile();
+	if (!ow.SafeFileClose())
+		return;
 	if (normalSave){
+		//lines are marked as saved only when file was really replaced
+		if (!loadFromEditbox){
+			for (size_t i = 0; i < file->GetCount(); i++){
+				Dialogue *dial = file->GetDialogue(i);
+				if (dial->GetState() & 1){ dial->ChangeDialogueState(2); }
+			}
+		}
 		file->SetLastSave();
 		Refresh(false);
 	}
 }
 
+void SubsGridBase::GetSaveHeader(wxString &txt, bool normalSave, bool translated)
+{
+	//AddSInfo(L"Last Style Storage", Options.actualStyleDir, false);
+	AddSInfo(L"Active Line", std::to_wstring(currentLine), false);
+	wxString subsPath = tab->SubsPath.BeforeLast(L'\\');
+	if (edit->ABox){
+		wxString path = (edit->ABox->audioName.StartsWith(subsPath) && normalSave) ?
+			edit->ABox->audioName.AfterLast(L'\\') : edit->ABox->audioName;
+		AddSInfo(L"Audio File", path, false);
+	}
+	if (!tab->VideoPath.empty()){
+		wxString path = (tab->VideoPath.StartsWith(subsPath) && normalSave) ?
+			tab->VideoPath.AfterLast(L'\\') : tab->VideoPath;
+		AddSInfo(L"Video File", path, false);
+	}
+	if (!tab->KeyframesPath.empty()){
+		wxString path = (tab->KeyframesPath.StartsWith(subsPath) && normalSave) ?
+			tab->KeyframesPath.AfterLast(L'\\') : tab->KeyframesPath;
+		AddSInfo(L"Keyframes File", path, false);
+	}
+
+	txt << L"[Script Info]\r\n;Script generated by " << Options.progname << L"\r\n";
+	GetSInfos(txt, translated);
+	txt << L"\r\n[V4+ Styles]\r\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding \r\n";
+	GetStyles(txt, translated);
+	txt << L" \r\n[Events]\r\nFormat: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+}
+
 void SubsGridBase::AddStyle(Styles *nstyl)
 {
 	file->AddStyle(nstyl);
@@ -661,12 +688,7 @@ void SubsGridBase::ChangeTimes(bool byFrame)
 			return;
 		}
 
-		const wxArrayInt& keyFrames = FFMS2->GetKeyframes();
-		wxArrayInt keyFramesStart;
-		for (size_t g = 0; g < keyFrames.Count(); g++) {
-			int keyMS = keyFrames[g];
-			keyFramesStart.Add(ZEROIT(tab->video->GetFrameTimeFromTime(keyMS)));
-		}
+		const std::vector<int>& keyFramesStart = FFMS2->GetKeyframesStart();
 		for (auto cur = tmpmap.begin(); cur != tmpmap.end(); cur++){
 			auto it = cur;
 			dialc = cur->first;
@@ -729,34 +751,19 @@ void SubsGridBase::ChangeTimes(bool byFrame)
 					bool costam = false;
 				}
 				
-				int startResult = INT_MAX;
-				int endResult = -1;
 				//it uses only keyframes move to start time (- fpstime / 2)
-				for (size_t g = 0; g < keyFramesStart.Count(); g++) {
-					int keyMSS = keyFramesStart[g];
-					if (keyMSS >= startRange && keyMSS <= startRange1) {
-						if (oldStart == keyMSS) {
-							startRange = -1; startRange1 = -1; startResult = INT_MAX;
-							dialc->Start.NewTime(oldStart);
-							numOfStartModifications--;
-						}
-						if (startResult > keyMSS/* && keyMS != dialc->Start.mstime*/){
-							if (startResult == INT_MAX || abs(startResult - dialc->Start.mstime) > abs(keyMSS - dialc->Start.mstime))
-								startResult = keyMSS;
-						}
-					}
-					if (keyMSS >= endRange && keyMSS <= endRange1) {
-						if (oldEnd == keyMSS) {
-							endRange = -1; endRange1 = -1; endResult = -1;
-							dialc->End.NewTime(oldEnd);
-							numOfEndModifications--;
-						}
-						if (endResult < keyMSS && keyMSS > dialc->Start.mstime) {
-							if (endResult == -1 || abs(endResult - dialc->End.mstime) > abs(keyMSS - dialc->End.mstime))
-								endResult = keyMSS;
-						}
-					}
+				KeyframeSnap snap = FindKeyframeSnap(keyFramesStart, dialc->Start.mstime, dialc->End.mstime,
+					oldStart, oldEnd, startRange, startRange1, endRange, endRange1);
+				if (snap.startRestored) {
+					dialc->Start.NewTime(oldStart);
+					numOfStartModifications--;
 				}
+				if (snap.endRestored) {
+					dialc->End.NewTime(oldEnd);
+					numOfEndModifications--;
+				}
+				int startResult = snap.startResult;
+				int endResult = snap.endResult;
 				//here is main problem we do not know if next start will be changed
 				//and it makes mess here but changing only start should be enough
 				//startResult >= compareStart and endResult <= compareEnd should be changed or even remove
@@ -1343,6 +1350,24 @@ void SubsGridBase::LoadSubtitles(const wxString &str, wxString &ext)
 		edit->RebuildActorEffectLists();
 	}
 	((SubsGridWindow*)this)->ScrollTo(active, false, -4);
+	if (Options.GetBool(SPELLCHECKER_ON)){
+		//the same texts as on paint, comments are not checked
+		//lines from scroll position are checked first
+		std::vector<BackgroundCheckLine> lines;
+		lines.reserve(GetCount());
+		size_t firstVisible = 0;
+		for (size_t i = 0; i < GetCount(); i++){
+			Dialogue *dial = file->GetDialogue(i);
+			if (dial->IsComment)
+				continue;
+			if (i < (size_t)scrollPosition)
+				firstVisible = lines.size() + 1;
+			bool isTl = hasTLMode && dial->TextTl != emptyString;
+			lines.push_back(BackgroundCheckLine(i, isTl ? dial->TextTl : dial->Text, !hasTLMode || isTl));
+		}
+		std::rotate(lines.begin(), lines.begin() + firstVisible, lines.end());
+		SpellChecker::Get()->StartBackgroundCheck(std::move(lines), subsFormat, GetReplaceTagsLen(), this);
+	}
 }
 
 void SubsGridBase::SetStartTime(int stime)
@@ -1643,6 +1668,44 @@ wxString *SubsGridBase::GetVisible(bool *visible, wxPoint *point, wxArrayInt *se
 	return txt;
 }
 
+//this function is called from another thread
+//addLine is called under editionMutex, it must not use grid
+void SubsGridBase::GetVisibleLines(wxString *header, 
+	const std::function<void(Dialogue *dial, bool tl, const wxString &style, bool edited)> &addLine)
+{
+	wxMutexLocker lock(editionMutex);
+	bool showOriginalOnVideo = !Options.GetBool(TL_MODE_HIDE_ORIGINAL_ON_VIDEO);
+	wchar_t bom = 0xFEFF;
+	*header << wxString(bom) << L"[Script Info]\r\n";
+	GetSInfos(*header, false);
+	(*header) << L"\r\n[V4+ Styles]\r\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding \r\n";
+	GetStyles(*header, false);
+	(*header) << L" \r\n[Events]\r\nFormat: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+
+	edit->Send(EDITBOX_LINE_EDITION, false, true);
+	bool isTlmode = GetSInfo(L"TLMode") == L"Yes";
+	const wxString &tlStyle = GetSInfo(L"TLMode Style");
+
+	for (size_t i = 0; i < file->GetCount(); i++)
+	{
+		Dialogue *dial = file->GetDialogue(i);
+		if (!ignoreFiltered && !dial->isVisible || dial->NonDialogue){ continue; }
+		bool edited = i == currentLine;
+		if (edited){
+			dial = edit->line;
+		}
+		if (isTlmode && dial->TextTl != emptyString){
+			if (showOriginalOnVideo)
+				addLine(dial, false, tlStyle, edited);
+
+			addLine(dial, true, emptyString, edited);
+		}
+		else if (dial->Text != emptyString){
+			addLine(dial, false, emptyString, edited);
+		}
+	}
+}
+
 bool SubsGridBase::IsLineVisible()
 {
 	int _time = tab->video->Tell();
@@ -1651,19 +1714,75 @@ bool SubsGridBase::IsLineVisible()
 }
 
 
+void SubsGridBase::OnSpellCheckResults(wxThreadEvent &event)
+{
+	std::shared_ptr<BackgroundCheckResults> results = event.GetPayload<std::shared_ptr<BackgroundCheckResults>>();
+	if (!file || !Options.GetBool(SPELLCHECKER_ON) || results->subsFormat != subsFormat ||
+		results->replaceTagsLen != GetReplaceTagsLen() ||
+		results->dictionaryVersion != SpellChecker::GetDictionaryVersion())
+		return;
+
+	size_t count = GetCount();
+	if (SpellErrors.size() < count)
+		SpellErrors.resize(count);
+
+	for (BackgroundCheckLine &line : results->lines){
+		if (line.key >= count || SpellErrors[line.key].isInit)
+			continue;
+		Dialogue *dial = file->GetDialogue(line.key);
+		bool isTl = hasTLMode && dial->TextTl != emptyString;
+		const StoreTextHelper &text = isTl ? dial->TextTl : dial->Text;
+		//line was edited or TL mode changed
+		if (!text.SharesText(line.text) || line.spellchecker != (!hasTLMode || isTl))
+			continue;
+		SpellErrors[line.key] = std::move(line.errors);
+	}
+}
+
+int SubsGridBase::GetReplaceTagsLen()
+{
+	return hideOverrideTags ? (int)Options.GetString(GRID_TAGS_SWAP_CHARACTER).length() : -1;
+}
+
 void SubsGridBase::OnBackupTimer(wxTimerEvent &event)
 {
+	//previous autosave is still written, try again a bit later
+	if (autoSave->IsWorking()){
+		timer.Start(1000, true);
+		return;
+	}
 	Kai->SetStatusText(_("Autozapis"), 0);
-	wxString path;
+	if (Options.GetInt(GRID_SAVE_AFTER_CHARACTER_COUNT) > 1){
+		edit->Send(EDITBOX_LINE_EDITION, false, false, true);
+	}
 	wxString ext = (subsFormat < SRT) ? L"ass" : (subsFormat == SRT) ? L"srt" : L"txt";
-
-	path << Options.pathfull << L"\\Subs\\" << tab->SubsName.BeforeLast(L'.')
-		<< L"_" << Notebook::GetTabs()->FindPanel(tab) << L"_" << numsave << L"." << ext;
-
-	SaveFile(path, false);
-	int maxFiles = Options.GetInt(AUTOSAVE_MAX_FILES);
-	if (maxFiles > 1 && numsave >= maxFiles){ numsave = 0; }
-	numsave++;
+	//header and raw lines are made here, autosave thread only writes them
+	AutoSaveData *data = new AutoSaveData();
+	data->baseName << Options.pathfull << L"\\Subs\\" << tab->SubsName.BeforeLast(L'.')
+		<< L"_" << Notebook::GetTabs()->FindPanel(tab) << L"_";
+	data->subsFormat = subsFormat;
+	data->showOriginalOnVideo = !Options.GetBool(TL_MODE_HIDE_ORIGINAL_ON_VIDEO);
+	{
+		wxMutexLocker lock(editionMutex);
+		const wxString &tlmode = GetSInfo(L"TLMode");
+		data->translated = tlmode == L"Translated";
+		data->tlmodeOn = tlmode != emptyString;
+		data->tlStyle = GetSInfo(L"TLMode Style");
+		if (subsFormat < SRT){
+			GetSaveHeader(data->header, false, data->translated);
+		}
+		autoSave->GetLines(file->GetSubs(), data);
+	}
+	//journal depends on dialogue indices, srt needs numbers of all lines
+	bool journal = Options.GetBool(AUTOSAVE_JOURNAL) && subsFormat < SRT;
+	if (!journal || autoSave->NeedsNewJournal(file, *data)){
+		data->path << data->baseName << numsave << L"." << ext;
+		if (journal){ data->path << L".journal"; }
+		int maxFiles = Options.GetInt(AUTOSAVE_MAX_FILES);
+		if (maxFiles > 1 && numsave >= maxFiles){ numsave = 0; }
+		numsave++;
+	}
+	autoSave->Start(file, data, journal);
 	makebackup = true;
 	nullifyTimer.Start(5000, true);
 }
@@ -1716,6 +1835,17 @@ void SubsGridBase::GetCommonStyles(SubsGridBase *_grid, wxArrayString &styleTabl
 	}
 }
 
+//below this number of compared lines threads are not used
+#define COMPARE_PARALLEL_MIN_LINES 256
+
+struct ComparedLines
+{
+	int first;
+	int second;
+	const wxString *firstText;
+	const wxString *secondText;
+};
+
 void SubsGridBase::SubsComparison()
 {
 	int comparisonType = Options.GetInt(SUBS_COMPARISON_TYPE);
@@ -1725,8 +1855,6 @@ void SubsGridBase::SubsComparison()
 	bool compareByStyles = (comparisonType & COMPARE_BY_STYLES) != 0;
 	bool compareByChosenStyles = compareStyles.size() > 0;
 	bool compareBySelections = (comparisonType & COMPARE_BY_SELECTIONS) != 0;
-	SubsGridBase* CCG1 = CG1;
-	SubsGridBase* CCG2 = CG2;
 
 	int firstSize = CG1->file->GetCount(), 
 		secondSize = CG2->file->GetCount();
@@ -1737,45 +1865,73 @@ void SubsGridBase::SubsComparison()
 	CG1->Comparison->resize(firstSize, compareData());
 	CG2->Comparison->resize(secondSize, compareData());
 
+	//lines of second grid grouped by values that have to be the same in both lines
+	//every line is paired with the first free line of its group, in the same way as it was done by scanning all lines
+	typedef std::tuple<int, int, wxString> CompareKey;
+	auto makeKey = [=](Dialogue *dial) {
+		return CompareKey((compareByTimes) ? dial->Start.mstime : 0, (compareByTimes) ? dial->End.mstime : 0,
+			(compareByStyles || compareByChosenStyles) ? (const wxString &)dial->Style : emptyString);
+	};
+	auto compareText = [](SubsGridBase *grid, Dialogue *dial) -> const wxString & {
+		if (grid->hasTLMode && dial->TextTl != emptyString)
+			return dial->TextTl;
+		return dial->Text;
+	};
+	std::map<CompareKey, std::vector<int>> secondLines;
+	for (int j = 0; j < secondSize; j++){
+		Dialogue *dial2 = CG2->file->GetDialogue(j);
+		if (compareByVisible && !dial2->isVisible){ continue; }
+		if (compareBySelections && !CG2->file->IsSelected(j)){ continue; }
+		secondLines[makeKey(dial2)].push_back(j);
+	}
+
+	std::vector<ComparedLines> pairs;
 	int lastJ = 0;
-
 	for (int i = 0; i < firstSize; i++){
-
-		int j = lastJ;
 		Dialogue *dial1 = CG1->file->GetDialogue(i);
 		if (compareByVisible && !dial1->isVisible){ continue; }
-		while (j < secondSize){
-
-			Dialogue *dial2 = CG2->file->GetDialogue(j);
-			if (compareByVisible && !dial2->isVisible){ j++; continue; }
-
-			if (compareByTimes && (dial1->Start != dial2->Start || dial1->End != dial2->End)){ j++; continue; }
-
-			if (compareByStyles && dial1->Style != dial2->Style){ j++; continue; }
-
-			if (compareByChosenStyles && (compareStyles.Index(dial1->Style) == -1 || dial1->Style != dial2->Style)){ j++; continue; }
-
-			if (compareBySelections && (!CG1->file->IsSelected(i) || !CG2->file->IsSelected(j))){ j++; continue; }
-
-			compareData & firstCompare = CCG1->Comparison->at(i);
-			compareData & secondCompare = CCG2->Comparison->at(j);
-			CompareTexts(firstCompare, secondCompare, 
-				(CCG1->hasTLMode && dial1->TextTl != emptyString) ? dial1->TextTl : dial1->Text,
-				(CCG2->hasTLMode && dial2->TextTl != emptyString) ? dial2->TextTl : dial2->Text);
-			firstCompare.secondComparedLine = j;
-			secondCompare.secondComparedLine = i;
-			lastJ = j + 1;
-			break;
-			j++;
+		if (compareBySelections && !CG1->file->IsSelected(i)){ continue; }
+		if (compareByChosenStyles && compareStyles.Index(dial1->Style) == -1){ continue; }
+
+		auto group = secondLines.find(makeKey(dial1));
+		if (group == secondLines.end()){ continue; }
+		auto it = std::lower_bound(group->second.begin(), group->second.end(), lastJ);
+		if (it == group->second.end()){ continue; }
+
+		int j = *it;
+		Dialogue *dial2 = CG2->file->GetDialogue(j);
+		pairs.push_back(ComparedLines{ i, j, &compareText(CG1, dial1), &compareText(CG2, dial2) });
+		CG1->Comparison->at(i).secondComparedLine = j;
+		CG2->Comparison->at(j).secondComparedLine = i;
+		lastJ = j + 1;
+	}
+
+	//every pair writes only to its own compare data
+	auto compareLines = [](ComparedLines *lines, size_t count) {
+		for (size_t k = 0; k < count; k++){
+			CompareTexts(CG1->Comparison->at(lines[k].first), CG2->Comparison->at(lines[k].second),
+				*lines[k].firstText, *lines[k].secondText);
+		}
+	};
+	size_t numThreads = std::thread::hardware_concurrency();
+	if (numThreads < 2 || pairs.size() < COMPARE_PARALLEL_MIN_LINES){
+		compareLines(pairs.data(), pairs.size());
+	}
+	else{
+		size_t chunkSize = (pairs.size() + numThreads - 1) / numThreads;
+		std::vector<std::thread> threads;
+		for (size_t start = 0; start < pairs.size(); start += chunkSize){
+			threads.emplace_back(compareLines, pairs.data() + start, (std::min)(chunkSize, pairs.size() - start));
+		}
+		for (auto &thread : threads){
+			thread.join();
 		}
-
 	}
 
 	CG1->Refresh(false);
 	CG2->Refresh(false);
 }
 
-
 void SubsGridBase::CompareTexts(compareData &firstCompare, compareData &secondCompare, const wxString &first, const wxString &second)
 {
 	if (first == second){
@@ -1786,79 +1942,7 @@ void SubsGridBase::CompareTexts(compareData &firstCompare, compareData &secondCo
 	firstCompare.push_back(1);
 	secondCompare.push_back(1);
 
-
-	size_t l1 = first.length(), l2 = second.length();
-	size_t sz = (l1 + 1) * (l2 + 1) * sizeof(size_t);
-	size_t w = l2 + 1;
-	size_t* dpt;
-	size_t i1, i2;
-	dpt = new size_t[sz];
-
-	if (dpt == nullptr)
-	{
-		KaiLog(L"memory allocation failed");
-		return;
-	}
-
-	memset(dpt, 0, sz);
-
-	for (i1 = 1; i1 <= l1; i1++){
-		for (i2 = 1; i2 <= l2; i2++)
-		{
-			if (first[l1 - i1] == second[l2 - i2])
-			{
-				dpt[w * i1 + i2] = dpt[w * (i1 - 1) + (i2 - 1)] + 1;
-			}
-			else if (dpt[w * (i1 - 1) + i2] > dpt[w * i1 + (i2 - 1)])
-			{
-				dpt[w * i1 + i2] = dpt[w * (i1 - 1) + i2];
-			}
-			else
-			{
-				dpt[w * i1 + i2] = dpt[w * i1 + (i2 - 1)];
-			}
-		}
-	}
-
-	int sfirst = -1, ssecond = -1;
-	i1 = l1; i2 = l2;
-	for (;;){
-		if ((i1 > 0) && (i2 > 0) && (first[l1 - i1] == second[l2 - i2])){
-			if (sfirst >= 0){
-				firstCompare.push_back(sfirst);
-				firstCompare.push_back((l1 - i1) - 1);
-				sfirst = -1;
-			}
-			if (ssecond >= 0){
-				secondCompare.push_back(ssecond);
-				secondCompare.push_back((l2 - i2) - 1);
-				ssecond = -1;
-			}
-			i1--; i2--; continue;
-		}
-		else{
-			if (i1 > 0 && (i2 == 0 || dpt[w * (i1 - 1) + i2] >= dpt[w * i1 + (i2 - 1)])){
-				if (sfirst == -1){ sfirst = l1 - i1; }
-				i1--; continue;
-			}
-			else if (i2 > 0 && (i1 == 0 || dpt[w * (i1 - 1) + i2] < dpt[w * i1 + (i2 - 1)])){
-				if (ssecond == -1){ ssecond = l2 - i2; }
-				i2--; continue;
-			}
-		}
-
-		break;
-	}
-	if (sfirst >= 0){
-		firstCompare.push_back(sfirst);
-		firstCompare.push_back((l1 - i1) - 1);
-	}
-	if (ssecond >= 0){
-		secondCompare.push_back(ssecond);
-		secondCompare.push_back((l2 - i2) - 1);
-	}
-
-	delete dpt;
+	CompareTextRanges(first.wc_str(), first.length(), second.wc_str(), second.length(), firstCompare, secondCompare);
 }
 
 void SubsGridBase::RemoveComparison()
@@ -29,11 +29,13 @@
 //#include "TabPanel.h"
 #include <vector>
 #include <set>
+#include <functional>
 
 
 
 class EditBox;
 class KainoteFrame;
+class AutoSaveWriter;
 class TabPanel;
 //class SubsGridPreview;
 //class SubsGridWindow;
@@ -120,6 +122,10 @@ public:
 	Dialogue *GetDialogueWithOffset(size_t i, int offset);
 	// returns visible lines as string for Vsfilter
 	wxString *GetVisible(bool *visible = 0, wxPoint *point = nullptr, wxArrayInt *selected = nullptr, bool allSubs = false);
+	// works like GetVisible with allSubs but gives every line to addLine instead of serializing it,
+	// header is filled before first line, edited means editbox line that can change without changing pointer
+	void GetVisibleLines(wxString *header, 
+		const std::function<void(Dialogue *dial, bool tl, const wxString &style, bool edited)> &addLine);
 	bool IsLineVisible();
 	//Get line key from scrollPosition.
 	//Every value will be stored as key.
@@ -186,6 +192,13 @@ protected:
 	wxTimer timer;
 	wxTimer nullifyTimer;
 	void OnBackupTimer(wxTimerEvent &event);
+	//fills SpellErrors of lines that still have the same text as checked in background
+	void OnSpellCheckResults(wxThreadEvent &event);
+	//length of tags replacement used by grid for spellchecking or -1 when tags are shown
+	int GetReplaceTagsLen();
+	//script info and styles of ASS file, call it under editionMutex
+	void GetSaveHeader(wxString &txt, bool normalSave, bool translated);
+	AutoSaveWriter *autoSave = nullptr;
 	TabPanel *tab;
 	wxMutex editionMutex;
 };
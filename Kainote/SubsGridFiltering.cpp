@@ -120,6 +120,7 @@ void SubsGridFiltering::FilterPartial(int from)
 		keyTo = grid->file->GetCount() - 1;
 		//KaiLogDebug("Something went wrong with partially hiding it is better to check it for potencial bugs.");
 	}
+	grid->file->InvalidateVisibleIndex();
 	grid->RefreshSubsOnVideo(activeLine, false);
 	grid->RefreshColumns();
 }
@@ -206,6 +207,7 @@ void SubsGridFiltering::TurnOffFiltering()
 
 void SubsGridFiltering::FilteringFinalize()
 {
+	grid->file->InvalidateVisibleIndex();
 	grid->RefreshSubsOnVideo(activeLine);
 	grid->RefreshColumns();
 }
@@ -20,7 +20,7 @@
 #include "SubsGrid.h"
 #include "KaiMessageBox.h"
 #include "config.h"
-#include <wx/tokenzr.h>
+#include <thread>
 
 
 SubsLoader::SubsLoader(SubsGrid *_grid, const wxString &text, wxString &ext)
@@ -97,24 +97,43 @@ bool SubsLoader::LoadASS(const wxString &text)
 {
 	short section = 0;
 	char format = ASS;
-	wxStringTokenizer tokenizer(text, L"\n", wxTOKEN_STRTOK);
+	//lines are only found here, parsing and adding to grid is in the same order as in file
+	std::vector<LoadedLine> loaded;
+	GetLoadedLines(text, &loaded);
+	size_t numThreads = std::thread::hardware_concurrency();
+	if (text.length() >= PARALLEL_LOAD_MIN_SIZE && numThreads > 1)
+		ParseDialoguesParallel(loaded, numThreads);
+
+	//dialogues parsed in threads are used only when the same line would be parsed here
+	auto takeDialogue = [](LoadedLine &loadedLine, bool trimmed) {
+		Dialogue *dialogue = loadedLine.dialogue;
+		if (dialogue && (trimmed || !loadedLine.trimmed)){
+			loadedLine.dialogue = nullptr;
+			return dialogue;
+		}
+		if (trimmed)
+			return new Dialogue(loadedLine.line + loadedLine.trimmed, loadedLine.length - loadedLine.trimmed);
+
+		return new Dialogue(loadedLine.line, loadedLine.length);
+	};
 
 	bool tlmode = false;
 	wxString tlstyle;
 
 
-	while (tokenizer.HasMoreTokens())
+	for (size_t i = 0; i < loaded.size(); i++)
 	{
-		wxString token = tokenizer.GetNextToken().Trim(false);
-		if (token.empty()){ continue; }
-		if ((token.StartsWith(L"Dial") || token.StartsWith(L"Comm") || (token[0] == L';' && section > 2))){
-			Dialogue *dl = new Dialogue(token);
+		const wchar_t *line = loaded[i].line + loaded[i].trimmed;
+		size_t length = loaded[i].length - loaded[i].trimmed;
+		if (!length){ continue; }
+		if (HasPrefix(line, length, L"Dial", 4) || HasPrefix(line, length, L"Comm", 4) || (line[0] == L';' && section > 2)){
+			Dialogue *dl = takeDialogue(loaded[i], true);
 			if (!tlmode){
 				grid->AddLine(dl);
 			}
 			else if (tlmode && dl->Style == tlstyle){
-				wxString ntoken = tokenizer.GetNextToken();
-				Dialogue *tl = new Dialogue(ntoken);
+				//translation is always in the next line, even when it's not a dialogue
+				Dialogue *tl = (++i < loaded.size()) ? takeDialogue(loaded[i], false) : new Dialogue(emptyString);
 				tl->TextTl = tl->Text;
 				tl->Text = dl->Text;
 				if (dl->Effect == L"\fD"){
@@ -126,8 +145,10 @@ bool SubsLoader::LoadASS(const wxString &text)
 			else{
 				grid->AddLine(dl);
 			}
+			continue;
 		}
-		else if (token.StartsWith(L"Style:"))
+		wxString token(line, length);
+		if (token.StartsWith(L"Style:"))
 		{
 			//1 = ASS, 2 = SSA, needs only for subtitles loading.
 			grid->AddStyle(new Styles(token, format));
@@ -151,6 +172,10 @@ bool SubsLoader::LoadASS(const wxString &text)
 			section = 3;
 		}
 	}
+	//lines that were parsed in threads but were not dialogues
+	for (auto &loadedLine : loaded){
+		delete loadedLine.dialogue;
+	}
 	grid->hasTLMode = tlmode;
 	const wxString &matrix = grid->GetSInfo(L"YCbCr Matrix");
 	if (matrix == emptyString || matrix == L"None"){ grid->AddSInfo(L"YCbCr Matrix", L"TV.601"); }
@@ -159,19 +184,21 @@ bool SubsLoader::LoadASS(const wxString &text)
 
 bool SubsLoader::LoadSRT(const wxString &text)
 {
-	wxStringTokenizer tokenizer(text, L"\n", wxTOKEN_STRTOK);
-	tokenizer.GetNextToken();
+	TextLines lines(text);
+	const wchar_t *line;
+	size_t length;
+	lines.GetNextLine(&line, &length);
 
 	wxString text1;
-	while (tokenizer.HasMoreTokens()){
-		wxString text = tokenizer.GetNextToken().Trim();
-		if (IsNumber(text)){
+	while (lines.GetNextLine(&line, &length)){
+		while (length && IsTrimSpace(line[length - 1])){ length--; }
+		if (std::all_of(line, line + length, [](wchar_t ch){ return ch >= L'0' && ch <= L'9'; })){
 			if (text1 != emptyString){
 				grid->AddLine(new Dialogue(text1.Trim()));
 				text1 = emptyString;
 			}
 		}
-		else{ text1 << text << L"\r\n"; }
+		else{ text1.append(line, length) << L"\r\n"; }
 	}
 
 	if (text1 != emptyString){
@@ -183,10 +210,12 @@ bool SubsLoader::LoadSRT(const wxString &text)
 
 bool SubsLoader::LoadTXT(const wxString &text)
 {
-	wxStringTokenizer tokenizer(text, L"\n", wxTOKEN_STRTOK);
-	while (tokenizer.HasMoreTokens()){
-		wxString text = tokenizer.GetNextToken().Trim();
-		grid->AddLine(new Dialogue(text.Trim()));
+	TextLines lines(text);
+	const wchar_t *line;
+	size_t length;
+	while (lines.GetNextLine(&line, &length)){
+		while (length && IsTrimSpace(line[length - 1])){ length--; }
+		grid->AddLine(new Dialogue(line, length));
 	}
 	return grid->GetCount() > 0;
 }
@@ -14,7 +14,12 @@
 //  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SubsGrid.h"
+#include "DialogueParser.h"
 #include <wx/string.h>
+#include <vector>
+
+//ASS files with more characters than this have dialogues parsed in threads
+#define PARALLEL_LOAD_MIN_SIZE (2 * 1024 * 1024)
 
 //class SubsGrid;
 
@@ -39,6 +39,32 @@ void SubsTime::SetRaw(wxString rawtime, char format)
 	ParseMS(rawtime);
 }
 
+void SubsTime::SetRaw(const wchar_t *rawtime, size_t length, char format)
+{
+	form = format;
+	//the same as raw.Trim() in ParseMS
+	while (length && rawtime[length - 1] < 127 && wxIsspace(rawtime[length - 1]))
+		length--;
+
+	const wchar_t *colon = (length && form < SRT) ? wmemchr(rawtime, L':', length) : nullptr;
+	if (!colon) {
+		ParseMS(wxString(rawtime, length));
+		return;
+	}
+	//parts are taken from the same positions as in ParseMS
+	auto timePart = [rawtime, length](size_t from, size_t count) {
+		if (from >= length)
+			return 0;
+		return ParseInt(rawtime + from, (std::min)(count, length - from));
+	};
+	size_t godz11 = colon - rawtime;
+	int godz1 = ParseInt(rawtime, godz11);
+	int min1 = timePart(godz11 + 1, 2);
+	int sec1 = timePart(godz11 + 4, 2);
+	int csec1 = timePart(godz11 + 7, 2) * 10;
+	mstime = (godz1 * 3600000) + (min1 * 60000) + (sec1 * 1000) + csec1;
+}
+
 void SubsTime::ParseMS(wxString raw)
 {
 
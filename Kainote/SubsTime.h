@@ -34,6 +34,8 @@ public:
 	SubsTime(int ms, int orgFrame = 0);
 	~SubsTime();
 	void SetRaw(wxString rawtime, char format);
+	//parses ASS time straight from loaded line, other formats go to ParseMS
+	void SetRaw(const wchar_t *rawtime, size_t length, char format);
 	void NewTime(int ms);
 	void NewFrame(int frame);
 	void ParseMS(wxString time);
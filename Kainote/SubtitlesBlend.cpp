@@ -0,0 +1,157 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SubtitlesBlend.h"
+#include "CpuFeatures.h"
+#include <string.h>
+
+//every channel is (color * aa + dst * (255 * 255 - aa)) / (255 * 255), numerator is below 2^24
+//division is replaced by multiply with magic and shift by 41, it's exact for every numerator below 2^24
+#define BLEND_FULL (255 * 255)
+#define BLEND_DIV_MAGIC 33818121
+#define BLEND_DIV_SHIFT 41
+
+void BlendRowScalar(uint32_t *dst, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b)
+{
+	for (int x = 0; x < width; x++) {
+		const unsigned int v = src[x];
+		int rr = (r * a * v);
+		int gg = (g * a * v);
+		int bb = (b * a * v);
+		int aa = a * v;
+		uint32_t dstpix = dst[x];
+		unsigned int dstb = dstpix & 0xFF;
+		unsigned int dstg = (dstpix >> 8) & 0xFF;
+		unsigned int dstr = (dstpix >> 16) & 0xFF;
+		unsigned int dsta = (dstpix >> 24) & 0xFF;
+		dstb = (bb + dstb * (BLEND_FULL - aa)) / BLEND_FULL;
+		dstg = (gg + dstg * (BLEND_FULL - aa)) / BLEND_FULL;
+		dstr = (rr + dstr * (BLEND_FULL - aa)) / BLEND_FULL;
+		dsta = (aa * 255 + dsta * (BLEND_FULL - aa)) / BLEND_FULL;
+		dst[x] = dstb | (dstg << 8) | (dstr << 16) | (dsta << 24);
+	}
+}
+
+//SSE2 has no 32 bit mullo, values are multiplied as 64 bit even and odd lanes
+CPU_TARGET_SSE2 static inline __m128i MulLo32SSE2(__m128i x, __m128i y)
+{
+	__m128i even = _mm_mul_epu32(x, y);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+		_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+CPU_TARGET_SSE2 static inline __m128i DivFullSSE2(__m128i n, __m128i magic)
+{
+	__m128i even = _mm_srli_epi64(_mm_mul_epu32(n, magic), BLEND_DIV_SHIFT);
+	__m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(n, 32), magic), BLEND_DIV_SHIFT);
+	return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+template<int shift>
+CPU_TARGET_SSE2 static inline __m128i BlendChannelSSE2(__m128i pixels, __m128i aa, __m128i inv, __m128i color, __m128i magic)
+{
+	__m128i channel = _mm_and_si128(_mm_srli_epi32(pixels, shift), _mm_set1_epi32(0xFF));
+	__m128i n = _mm_add_epi32(MulLo32SSE2(color, aa), MulLo32SSE2(channel, inv));
+	return _mm_slli_epi32(DivFullSSE2(n, magic), shift);
+}
+
+CPU_TARGET_SSE2 void BlendRowSSE2(uint32_t *dst, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi32(BLEND_FULL);
+	const __m128i magic = _mm_set1_epi32(BLEND_DIV_MAGIC);
+	const __m128i alpha = _mm_set1_epi32(a);
+	const __m128i blue = _mm_set1_epi32(b);
+	const __m128i green = _mm_set1_epi32(g);
+	const __m128i red = _mm_set1_epi32(r);
+	const __m128i white = _mm_set1_epi32(255);
+	int x = 0;
+	for (; x + 4 <= width; x += 4) {
+		int mask;
+		memcpy(&mask, src + x, 4);
+		//transparent part of bitmap does not change frame
+		if (!mask)
+			continue;
+
+		__m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(mask), zero), zero);
+		__m128i aa = MulLo32SSE2(v, alpha);
+		__m128i inv = _mm_sub_epi32(full, aa);
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(dst + x));
+		__m128i result = BlendChannelSSE2<0>(pixels, aa, inv, blue, magic);
+		result = _mm_or_si128(result, BlendChannelSSE2<8>(pixels, aa, inv, green, magic));
+		result = _mm_or_si128(result, BlendChannelSSE2<16>(pixels, aa, inv, red, magic));
+		result = _mm_or_si128(result, BlendChannelSSE2<24>(pixels, aa, inv, white, magic));
+		_mm_storeu_si128((__m128i *)(dst + x), result);
+	}
+	if (x < width)
+		BlendRowScalar(dst + x, src + x, width - x, a, r, g, b);
+}
+
+CPU_TARGET_AVX2 static inline __m256i DivFullAVX2(__m256i n, __m256i magic)
+{
+	__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(n, magic), BLEND_DIV_SHIFT);
+	__m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(n, 32), magic), BLEND_DIV_SHIFT);
+	return _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+}
+
+template<int shift>
+CPU_TARGET_AVX2 static inline __m256i BlendChannelAVX2(__m256i pixels, __m256i aa, __m256i inv, __m256i color, __m256i magic)
+{
+	__m256i channel = _mm256_and_si256(_mm256_srli_epi32(pixels, shift), _mm256_set1_epi32(0xFF));
+	__m256i n = _mm256_add_epi32(_mm256_mullo_epi32(color, aa), _mm256_mullo_epi32(channel, inv));
+	return _mm256_slli_epi32(DivFullAVX2(n, magic), shift);
+}
+
+CPU_TARGET_AVX2 void BlendRowAVX2(uint32_t *dst, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b)
+{
+	const __m256i full = _mm256_set1_epi32(BLEND_FULL);
+	const __m256i magic = _mm256_set1_epi32(BLEND_DIV_MAGIC);
+	const __m256i alpha = _mm256_set1_epi32(a);
+	const __m256i blue = _mm256_set1_epi32(b);
+	const __m256i green = _mm256_set1_epi32(g);
+	const __m256i red = _mm256_set1_epi32(r);
+	const __m256i white = _mm256_set1_epi32(255);
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		long long mask;
+		memcpy(&mask, src + x, 8);
+		//transparent part of bitmap does not change frame
+		if (!mask)
+			continue;
+
+		__m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + x)));
+		__m256i aa = _mm256_mullo_epi32(v, alpha);
+		__m256i inv = _mm256_sub_epi32(full, aa);
+		__m256i pixels = _mm256_loadu_si256((const __m256i *)(dst + x));
+		__m256i result = BlendChannelAVX2<0>(pixels, aa, inv, blue, magic);
+		result = _mm256_or_si256(result, BlendChannelAVX2<8>(pixels, aa, inv, green, magic));
+		result = _mm256_or_si256(result, BlendChannelAVX2<16>(pixels, aa, inv, red, magic));
+		result = _mm256_or_si256(result, BlendChannelAVX2<24>(pixels, aa, inv, white, magic));
+		_mm256_storeu_si256((__m256i *)(dst + x), result);
+	}
+	if (x < width)
+		BlendRowSSE2(dst + x, src + x, width - x, a, r, g, b);
+}
+
+BlendRowFunction GetBlendRowFunction()
+{
+	static const BlendRowFunction blendRow = CpuHasAVX2() ? BlendRowAVX2 :
+		CpuHasSSE2() ? BlendRowSSE2 : BlendRowScalar;
+	return blendRow;
+}
@@ -0,0 +1,33 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+
+//blends one row of libass alpha mask with color into BGRA frame row
+//a is inverted alpha of color (255 - alpha), all versions give the same result
+typedef void(*BlendRowFunction)(uint32_t *dst, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b);
+
+void BlendRowScalar(uint32_t *dst, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b);
+void BlendRowSSE2(uint32_t *dst, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b);
+void BlendRowAVX2(uint32_t *dst, const unsigned char *src, int width,
+	unsigned int a, unsigned int r, unsigned int g, unsigned int b);
+
+//chooses the fastest version supported by processor, checked only once
+BlendRowFunction GetBlendRowFunction();
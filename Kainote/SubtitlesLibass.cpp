@@ -16,6 +16,7 @@
 
 
 #include "SubtitlesProvider.h"
+#include "SubtitlesBlend.h"
 #include "RendererVideo.h"
 #include "OpennWrite.h"
 #include "kainoteFrame.h"
@@ -29,6 +30,7 @@
 #include "VisualDrawingShapes.h"
 #include "VisualClips.h"
 #include "Visuals.h"
+#include <vector>
 
 std::atomic<bool> SubtitlesLibass::m_IsReady{ false };
 wxMutex SubtitlesLibass::openMutex;
@@ -96,6 +98,8 @@ void SubtitlesLibass::Draw(unsigned char* buffer, int time)
 		ass_set_frame_size(m_Libass, m_VideoSize.GetWidth(), m_VideoSize.GetHeight());
 
 		ASS_Image* img = ass_render_frame(m_Libass, m_AssTrack, time, nullptr);
+		//SSE2 / AVX2 version chosen by processor, gives the same result as scalar one
+		BlendRowFunction blendRow = GetBlendRowFunction();
 		int videoPitch = m_VideoSize.GetWidth() * m_BytesPerColor;
 		// libass actually returns several alpha-masked monochrome images.
 		// Here, we loop through their linked list, get the colour of the current, and blend into the frame.
@@ -116,24 +120,7 @@ void SubtitlesLibass::Draw(unsigned char* buffer, int time)
 			byte *dst = buffer + (img->dst_y * videoPitch) + (img->dst_x * 4);
 			
 			for (int y = 0; y < img->h; y++, dst += videoPitch, src += img->stride) {
-				uint32_t *dstrow = (uint32_t *)dst;
-				for (int x = 0; x < img->w; x++) {
-					const unsigned int v = src[x];
-					int rr = (r * a * v);
-					int gg = (g * a * v);
-					int bb = (b * a * v);
-					int aa = a * v;
-					uint32_t dstpix = dstrow[x];
-					unsigned int dstb = dstpix & 0xFF;
-					unsigned int dstg = (dstpix >> 8) & 0xFF;
-					unsigned int dstr = (dstpix >> 16) & 0xFF;
-					unsigned int dsta = (dstpix >> 24) & 0xFF;
-					dstb = (bb + dstb * (255 * 255 - aa)) / (255 * 255);
-					dstg = (gg + dstg * (255 * 255 - aa)) / (255 * 255);
-					dstr = (rr + dstr * (255 * 255 - aa)) / (255 * 255);
-					dsta = (aa * 255 + dsta * (255 * 255 - aa)) / (255 * 255);
-					dstrow[x] = dstb | (dstg << 8) | (dstr << 16) | (dsta << 24);
-				}
+				blendRow((uint32_t *)dst, src, img->w, a, r, g, b);
 			}
 		}
 	}
@@ -156,9 +143,15 @@ bool SubtitlesLibass::Open(TabPanel *tab, int flag, wxString *text)
 		return false;
 	}
 
-	if (m_AssTrack){
-		ass_free_track(m_AssTrack);
-		m_AssTrack = nullptr;
+	bool incremental = (flag == OPEN_DUMMY || flag == OPEN_WHOLE_SUBTITLES) &&
+		tab->grid->subsFormat == ASS && Options.GetBool(LIBASS_INCREMENTAL_UPDATE);
+
+	if (!incremental){
+		m_IncrementalTrack.Reset();
+		if (m_AssTrack){
+			ass_free_track(m_AssTrack);
+			m_AssTrack = nullptr;
+		}
 	}
 
 	RendererVideo* renderer = tab->video->GetRenderer();
@@ -167,6 +160,10 @@ bool SubtitlesLibass::Open(TabPanel *tab, int flag, wxString *text)
 		return false;
 	}
 
+	if (incremental){
+		renderer->m_HasDummySubs = flag == OPEN_DUMMY;
+		return OpenIncremental(tab, renderer);
+	}
 	wxString *textsubs = text;
 	switch (flag){
 	case OPEN_DUMMY:
@@ -214,6 +211,90 @@ bool SubtitlesLibass::Open(TabPanel *tab, int flag, wxString *text)
 	return true;
 }
 
+static inline void HashString(unsigned long long &seed, const wxString &str)
+{
+	LibassHashString(seed, str.wc_str(), str.length());
+}
+
+//hash of all values that GetRaw puts in line
+static unsigned long long GetLineFingerprint(Dialogue *dial, bool tl, const wxString &style)
+{
+	unsigned long long seed = 0;
+	LibassHashCombine(seed, dial->Layer);
+	LibassHashCombine(seed, dial->Start.mstime);
+	LibassHashCombine(seed, dial->End.mstime);
+	LibassHashCombine(seed, dial->MarginL);
+	LibassHashCombine(seed, dial->MarginR);
+	LibassHashCombine(seed, dial->MarginV);
+	LibassHashCombine(seed, (unsigned long long)dial->IsComment | ((unsigned long long)(dial->GetState() & 12) << 1) |
+		((unsigned long long)dial->treeState << 8) | ((unsigned long long)dial->Format << 16));
+	HashString(seed, style.empty() ? static_cast<const wxString &>(dial->Style) : style);
+	HashString(seed, dial->Actor);
+	HashString(seed, dial->Effect);
+	HashString(seed, tl ? static_cast<const wxString &>(dial->TextTl) : static_cast<const wxString &>(dial->Text));
+	return seed;
+}
+
+bool SubtitlesLibass::OpenIncremental(TabPanel *tab, RendererVideo *renderer)
+{
+	struct PendingLine
+	{
+		LibassEventKey key;
+		unsigned long long fingerprint;
+		int readOrder;
+		wxString raw;
+	};
+	std::vector<PendingLine> pending;
+	wxString header;
+	bool reload = !m_AssTrack;
+	bool headerChecked = false;
+	int readOrder = 0;
+	m_IncrementalTrack.BeginUpdate();
+
+	tab->grid->GetVisibleLines(&header, [&](Dialogue *dial, bool tl, const wxString &style, bool edited) {
+		//header is filled before first line
+		if (!headerChecked){
+			reload = reload || m_IncrementalTrack.NeedsReload(tab, header);
+			headerChecked = true;
+		}
+		LibassEventKey key{ dial, tl };
+		unsigned long long fingerprint = GetLineFingerprint(dial, tl, style);
+		if (!reload && !edited && m_IncrementalTrack.KeepEvent(&key, fingerprint, readOrder)){
+			readOrder++;
+			return;
+		}
+		pending.push_back(PendingLine{ key, fingerprint, readOrder++ });
+		dial->GetRaw(&pending.back().raw, tl, style);
+	});
+
+	if (!headerChecked){
+		reload = reload || m_IncrementalTrack.NeedsReload(tab, header);
+	}
+
+	if (reload){
+		m_AssTrack = m_IncrementalTrack.Reload(m_Library, m_AssTrack, header, tab);
+		if (!m_AssTrack){
+			KaiLog(_("Libass otwiera tylko napisy ASS i SSA"));
+			return false;
+		}
+	}
+	else{
+		m_IncrementalTrack.RemoveUnusedEvents(m_AssTrack);
+	}
+
+	for (auto &line : pending){
+		m_IncrementalTrack.AddEvent(m_AssTrack, line.key, line.fingerprint, line.raw, line.readOrder);
+	}
+
+	if (renderer->m_Visual && renderer->m_Visual->Visual == VECTORCLIP) {
+		wxString mask;
+		renderer->m_Visual->AppendClipMask(&mask);
+		if (!mask.empty())
+			m_IncrementalTrack.AddMask(m_AssTrack, mask, readOrder);
+	}
+	return true;
+}
+
 bool SubtitlesLibass::OpenString(wxString *text)
 {
 	wxMutexLocker lock(openMutex);
@@ -222,6 +303,7 @@ bool SubtitlesLibass::OpenString(wxString *text)
 		return false;
 	}
 
+	m_IncrementalTrack.Reset();
 	if (m_AssTrack){
 		ass_free_track(m_AssTrack);
 		m_AssTrack = nullptr;
@@ -254,6 +336,7 @@ void SubtitlesLibass::ReloadLibraries(bool destroyExisted)
 	if (destroyExisted) {
 		//KaiLog("Libass release");
 		m_IsReady.store(false);
+		m_IncrementalTrack.Reset();
 		if (m_Libass) {
 			ass_renderer_done(m_Libass);
 			m_Libass = nullptr;
@@ -20,6 +20,7 @@
 #include <wx/window.h>
 #include <wx/arrstr.h>
 #include <atomic>
+#include "LibassTrack.h"
 
 extern "C" {
 #include <libass/ass.h>
@@ -72,6 +73,9 @@ private:
 	csri_rend *GetVSFilter();
 };
 
+class Dialogue;
+class RendererVideo;
+
 class SubtitlesLibass : public SubtitlesProvider
 {
 public:
@@ -89,5 +93,9 @@ public:
 	wxSize m_VideoSize;
 	volatile bool m_SubsSkipped = false;
 	static wxMutex openMutex;
+private:
+	//keeps header and styles in track and parses only changed lines
+	bool OpenIncremental(TabPanel *tab, RendererVideo *renderer);
+	LibassIncrementalTrack m_IncrementalTrack;
 };
 
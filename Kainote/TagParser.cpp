@@ -0,0 +1,259 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TagParser.h"
+#include <wchar.h>
+
+TagData::TagData(const wxString &name, unsigned int _startTextPos)
+{
+	tagName = name;
+	startTextPos = _startTextPos;
+}
+
+void TagData::PutValue(const wxString &_value, bool _multiValue)
+{
+	value = _value;
+	multiValue = _multiValue;
+}
+
+
+void ParseData::Clear()
+{
+	tags.clear();
+	storage.clear();
+}
+
+void ParseData::Reserve(size_t count)
+{
+	if (storage.capacity() >= count)
+		return;
+
+	storage.reserve(count);
+	tags.reserve(count);
+	//tags were moved
+	for (size_t i = 0; i < storage.size(); i++){
+		tags[i] = &storage[i];
+	}
+}
+
+TagData *ParseData::AddTag(const wxString &name, unsigned int startTextPos)
+{
+	if (storage.size() == storage.capacity())
+		Reserve((storage.size() < 8) ? 16 : storage.size() * 2);
+
+	storage.emplace_back(name, startTextPos);
+	tags.push_back(&storage.back());
+	return &storage.back();
+}
+
+static const wchar_t *assTags[] = {
+	L"1a", L"2a", L"3a", L"4a", L"1c", L"2c", L"3c", L"4c", L"a", L"alpha", L"an", L"b", L"be",
+	L"blur", L"bord", L"c", L"clip", L"fad", L"fade", L"fax", L"fay", L"fe", L"fn", L"fr", L"frx",
+	L"fry", L"frz", L"fs", L"fscx", L"fscy", L"fsp", L"i", L"iclip", L"k", L"K", L"kf", L"ko", L"move",
+	L"org", L"p", L"pbo", L"pos", L"q", L"r", L"s", L"shad", L"t", L"u", L"xbord", L"xshad", L"ybord",
+	L"yshad"
+};
+#define TAG_FN 22
+
+//table of assTags indexes for every hash, seed was found to have no collisions
+static const signed char assTagsTable[128] = {
+	-1, -1, 11, 44, 3, 19, -1, 23, 21, 40, 26, -1, -1, 16, -1, -1, 12, -1, 32, 27, -1, 4, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 5, 33, 10, 28, -1, 2, -1, 14, 8, -1, 49, -1, -1, -1,
+	-1, 38, 25, 9, 1, -1, 0, 46, 31, -1, 15, -1, 51, -1, 24, -1, -1, -1, -1, -1, 22, 39, -1, -1,
+	-1, -1, -1, -1, -1, 29, -1, -1, -1, 47, -1, 37, -1, 17, -1, 36, -1, -1, -1, -1, -1, 6, -1, 45,
+	30, -1, -1, -1, -1, -1, 42, -1, -1, -1, 13, -1, 50, 35, 48, -1, -1, -1, -1, 18, -1, 20, -1, 7,
+	43, -1, -1, -1, -1, 41, -1, 34
+};
+
+static inline unsigned int TagHash(const wchar_t *name, size_t length)
+{
+	unsigned int hash = 16056;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+	hash ^= hash >> 15;
+	hash *= 0x2c1b3c6dU;
+	hash ^= hash >> 12;
+	return hash & 127;
+}
+
+int GetTagId(const wchar_t *name, size_t length)
+{
+	if (!length || length > 5)
+		return -1;
+
+	int id = assTagsTable[TagHash(name, length)];
+	if (id < 0 || wcslen(assTags[id]) != length || wmemcmp(assTags[id], name, length))
+		return -1;
+
+	return id;
+}
+
+const wchar_t *GetTagName(int id)
+{
+	return (id >= 0 && id < (int)(sizeof(assTags) / sizeof(assTags[0]))) ? assTags[id] : L"";
+}
+
+static inline bool IsTagValueStart(wchar_t ch)
+{
+	return ch == L'(' || wxIsdigit(ch) || ch == L'.' || ch == L'-' || ch == L'+';
+}
+
+//tag is text after backslash without last ')', it is recognized the same way like in ParseTags
+//name of known tag can be followed only by value, other letters make a different tag
+static int GetTagIdFromTag(const wchar_t *tag, size_t length)
+{
+	if (length >= 2 && tag[0] == L'f' && tag[1] == L'n')
+		return TAG_FN;
+
+	size_t nameLength = (length && tag[0] >= L'1' && tag[0] <= L'4') ? 1 : 0;
+	while (nameLength < length && ((tag[nameLength] >= L'a' && tag[nameLength] <= L'z') ||
+		(tag[nameLength] >= L'A' && tag[nameLength] <= L'Z')))
+		nameLength++;
+
+	if (nameLength >= length || !IsTagValueStart(tag[nameLength]))
+		return -1;
+
+	return GetTagId(tag, nameLength);
+}
+
+//visits backslashes exactly like ParseTags when none of tags was found,
+//found tags only skip characters that cannot be backslashes
+void TagIndex::Build(const wxString &text, size_t version)
+{
+	tags.clear();
+	blocks = 0;
+	const wchar_t *txt = text.wc_str();
+	size_t len = text.length();
+	bool tagsBlock = false;
+	for (size_t pos = 0; pos < len; pos++){
+		wchar_t ch = txt[pos];
+		if (ch == L'}'){ tagsBlock = false; }
+		else if (ch == L'{' || pos >= len - 1){
+			tagsBlock = true;
+			blocks++;
+			if (pos >= len - 1){ pos++; }
+		}
+		else if (tagsBlock && ch == L'\\'){
+			size_t slashPos = pos++;
+			size_t tagEnd = pos;
+			while (tagEnd < len && txt[tagEnd] != L'\\' && txt[tagEnd] != L'}')
+				tagEnd++;
+			size_t tagLength = tagEnd - pos;
+			if (tagLength && txt[tagEnd - 1] == L')')
+				tagLength--;
+			tags.push_back(Tag{ (unsigned int)slashPos, (unsigned int)tagEnd, GetTagIdFromTag(txt + pos, tagLength) });
+		}
+	}
+	builtVersion = version;
+	built = true;
+}
+
+void ParseTextTags(const wxString &txt, const TagIndex &index, wxString *tags, size_t ntags, 
+	bool plainText, ParseData *parseData)
+{
+	size_t pos = 0;
+	size_t plainStart = 0;
+	bool hasDrawing = false;
+	size_t len = txt.length();
+	bool tagsBlock = false;
+	double tmpValue;
+	if (len < 1){ return; }
+	//known tags are compared by id from index, only unknown names are compared as text
+	unsigned long long requestedIds = 0;
+	size_t requestedTags[64];
+	bool hasUnknownTags = false;
+	for (size_t i = 0; i < ntags; i++){
+		int id = GetTagId(tags[i].wc_str(), tags[i].length());
+		if (id < 0){ hasUnknownTags = true; continue; }
+		if (!(requestedIds & (1ULL << id))){
+			requestedIds |= 1ULL << id;
+			requestedTags[id] = i;
+		}
+	}
+	//every found tag and plain text has its place before the first one is added
+	parseData->Reserve(parseData->tags.size() + index.tags.size() + index.blocks + 1);
+	const wchar_t *text = txt.wc_str();
+	size_t indexPos = 0;
+	while (pos < len){
+		wxUniChar ch = txt[pos];
+		if (ch == L'}'){ tagsBlock = false; plainStart = pos + 1; }
+		else if (ch == L'{' || pos >= len - 1){
+			tagsBlock = true;
+			if (pos >= len - 1){ pos++; }
+			//to not crash the program when subtract from unsigned 0 just add 1 to plain start
+			if ((plainText || hasDrawing) && plainStart + 1 <= pos){
+				TagData *newTag = parseData->AddTag((hasDrawing) ? L"pvector" : L"plain", plainStart);
+				newTag->value.assign(text + plainStart, pos - plainStart);
+			}
+		}
+		else if (tagsBlock && ch == L'\\'){
+			while (indexPos < index.tags.size() && index.tags[indexPos].slashPos < pos)
+				indexPos++;
+			pos++;
+			size_t found = ntags;
+			size_t tagEnd = pos;
+			size_t tagLength = 0;
+			const wchar_t *tag = text + pos;
+			if (indexPos < index.tags.size() && index.tags[indexPos].slashPos == pos - 1){
+				const TagIndex::Tag &indexedTag = index.tags[indexPos];
+				tagEnd = indexedTag.tagEnd;
+				tagLength = tagEnd - pos;
+				if (tagLength && text[tagEnd - 1] == L')'){ tagLength--; }
+				if (indexedTag.id >= 0 && (requestedIds & (1ULL << indexedTag.id))){
+					found = requestedTags[indexedTag.id];
+				}
+				else if (hasUnknownTags){
+					for (size_t i = 0; i < ntags; i++){
+						const wxString &tagName = tags[i];
+						size_t tagNameLen = tagName.length();
+						if (tagNameLen <= tagLength && !wmemcmp(tag, tagName.wc_str(), tagNameLen) &&
+							(tagName == L"fn" || (tagNameLen < tagLength && IsTagValueStart(tag[tagNameLen])))){
+							found = i;
+							break;
+						}
+					}
+				}
+			}
+			if (found < ntags){
+				const wxString &tagName = tags[found];
+				size_t tagLen = tagName.length();
+				TagData *newTag = parseData->AddTag(tagName, pos + tagLen);
+				wxString tagValue = (tagLen < tagLength) ? wxString(tag + tagLen, tagLength - tagLen) : wxString();
+				if (tagName == L"p"){
+					hasDrawing = (tagValue.Trim().Trim(false) == L"0") ? false : true;
+					newTag->PutValue(tagValue);
+				}
+				else if (tagLen < tagLength && tag[tagLen] == L'('){
+					newTag->startTextPos++;
+					newTag->PutValue(tagValue.After(L'(').BeforeFirst(L')'), true);
+				}
+				else{
+					if (tagName != L"fn" && !tagValue.ToCDouble(&tmpValue)){
+						wxString newTagValue;
+						for (const auto & ch : tagValue){
+							if (!wxIsdigit(ch) && ch != L'.' && ch != L'-' && ch != L'+')
+								break;
+							newTagValue += ch;
+						}
+						tagValue = newTagValue;
+					}
+					newTag->PutValue(tagValue);
+				}
+				pos = tagEnd - 1;
+			}
+		}
+		pos++;
+	}
+}
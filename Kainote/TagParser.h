@@ -0,0 +1,84 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <vector>
+
+class TagData
+{
+public:
+	TagData(const wxString &name, unsigned int startTextPos);
+	void PutValue(const wxString &name, bool multiValue = false);
+	wxString tagName;
+	wxString value;
+	bool multiValue = false;
+	unsigned int startTextPos;
+};
+
+//tags of one parse are kept in one array, clear keeps it allocated for the next parse,
+//so parsing of the same line again doesn't allocate tags
+class ParseData
+{
+public:
+	ParseData(){}
+	ParseData(const ParseData &) = delete;
+	ParseData &operator =(const ParseData &) = delete;
+	void Clear();
+	//makes place for count tags without moving them later
+	void Reserve(size_t count);
+	//returned tag is valid until the next AddTag, pointers in tags are always valid
+	TagData *AddTag(const wxString &name, unsigned int startTextPos);
+	std::vector<TagData*> tags;
+private:
+	std::vector<TagData> storage;
+};
+
+//id of ASS tag name from perfect hash, -1 when it's not known tag
+int GetTagId(const wchar_t *name, size_t length);
+const wchar_t *GetTagName(int id);
+
+//positions of all tags in dialogue text, it's built once and rebuilt only when text was changed.
+//Index keeps only version of text (StoreTextHelper::GetVersion), so it doesn't force copy of text on the next change
+class TagIndex
+{
+public:
+	struct Tag
+	{
+		//position of backslash
+		unsigned int slashPos;
+		//position of next backslash, bracket or text end
+		unsigned int tagEnd;
+		//tag name id when tag has value, -1 for unknown tags
+		int id;
+	};
+	//text without version, like text of editor, is never treated as built
+	static const size_t NO_VERSION = (size_t)-1;
+	void Build(const wxString &text, size_t version = NO_VERSION);
+	bool IsBuiltFor(size_t version) const{ return built && builtVersion == version; }
+	std::vector<Tag> tags;
+	//number of tag blocks, plain text parts are only between them
+	size_t blocks = 0;
+private:
+	size_t builtVersion = NO_VERSION;
+	bool built = false;
+};
+
+//parses text with index built for it to parse data, parse data is not cleared.
+//Remember parse patterns need "tag1|tag2|..." without slashes.
+//Remember string position is start of the value, position of tag -=tagname.len+1
+void ParseTextTags(const wxString &txt, const TagIndex &index, wxString *tags, size_t ntags,
+	bool plainText, ParseData *parseData);
@@ -0,0 +1,132 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <bit>
+#include <unordered_map>
+#include <vector>
+
+//LCS of suffixes counted bit-parallel (Hyyrö), every row of DP table is kept as bits of differences
+//between next cells, zero bit means that LCS grows on this char of second text
+class LCSRows
+{
+public:
+	LCSRows(const wchar_t *first, size_t firstLen, const wchar_t *second, size_t secondLen)
+		: m_words((secondLen + 63) / 64)
+		, m_rows((firstLen + 1) * m_words, ~0ULL)
+	{
+		std::unordered_map<wchar_t, size_t> maskIndex;
+		std::vector<uint64_t> masks;
+		//texts are compared from the end
+		for (size_t i = 0; i < secondLen; i++){
+			wchar_t ch = second[secondLen - 1 - i];
+			auto it = maskIndex.find(ch);
+			if (it == maskIndex.end()){
+				it = maskIndex.emplace(ch, masks.size()).first;
+				masks.resize(masks.size() + m_words, 0);
+			}
+			masks[it->second + (i >> 6)] |= 1ULL << (i & 63);
+		}
+		if (!m_words)
+			return;
+
+		for (size_t i = 1; i <= firstLen; i++){
+			const uint64_t *prev = m_rows.data() + (i - 1) * m_words;
+			uint64_t *row = m_rows.data() + i * m_words;
+			auto it = maskIndex.find(first[firstLen - i]);
+			if (it == maskIndex.end()){
+				memcpy(row, prev, m_words * sizeof(uint64_t));
+				continue;
+			}
+			const uint64_t *mask = &masks[it->second];
+			uint64_t carry = 0, borrow = 0;
+			for (size_t k = 0; k < m_words; k++){
+				uint64_t v = prev[k];
+				uint64_t u = v & mask[k];
+				uint64_t sum = v + u;
+				uint64_t newCarry = sum < v;
+				sum += carry;
+				newCarry |= sum < carry;
+				uint64_t diff = v - u - borrow;
+				borrow = (v < u) || (v - u < borrow);
+				carry = newCarry;
+				row[k] = sum | diff;
+			}
+		}
+	}
+	//LCS of last i1 chars of first text and last i2 chars of second text
+	size_t Get(size_t i1, size_t i2) const
+	{
+		const uint64_t *row = m_rows.data() + i1 * m_words;
+		size_t ones = 0;
+		size_t full = i2 >> 6;
+		for (size_t k = 0; k < full; k++)
+			ones += std::popcount(row[k]);
+		if (i2 & 63)
+			ones += std::popcount(row[full] & ((1ULL << (i2 & 63)) - 1));
+		return i2 - ones;
+	}
+private:
+	size_t m_words;
+	std::vector<uint64_t> m_rows;
+};
+
+//pushes ranges of chars that are not in LCS of both texts as pairs of start and end,
+//output needs only push_back(int), it is compareData in grid
+template<class Ranges>
+void CompareTextRanges(const wchar_t *firstText, size_t l1, const wchar_t *secondText, size_t l2,
+	Ranges &firstCompare, Ranges &secondCompare)
+{
+	LCSRows lcs(firstText, l1, secondText, l2);
+
+	int sfirst = -1, ssecond = -1;
+	size_t i1 = l1, i2 = l2;
+	for (;;){
+		if ((i1 > 0) && (i2 > 0) && (firstText[l1 - i1] == secondText[l2 - i2])){
+			if (sfirst >= 0){
+				firstCompare.push_back(sfirst);
+				firstCompare.push_back((l1 - i1) - 1);
+				sfirst = -1;
+			}
+			if (ssecond >= 0){
+				secondCompare.push_back(ssecond);
+				secondCompare.push_back((l2 - i2) - 1);
+				ssecond = -1;
+			}
+			i1--; i2--; continue;
+		}
+		else if (i1 > 0 && (i2 == 0 || lcs.Get(i1 - 1, i2) >= lcs.Get(i1, i2 - 1))){
+			if (sfirst == -1){ sfirst = l1 - i1; }
+			i1--; continue;
+		}
+		else if (i2 > 0){
+			if (ssecond == -1){ ssecond = l2 - i2; }
+			i2--; continue;
+		}
+
+		break;
+	}
+	if (sfirst >= 0){
+		firstCompare.push_back(sfirst);
+		firstCompare.push_back((l1 - i1) - 1);
+	}
+	if (ssecond >= 0){
+		secondCompare.push_back(ssecond);
+		secondCompare.push_back((l2 - i2) - 1);
+	}
+}
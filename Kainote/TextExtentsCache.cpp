@@ -0,0 +1,146 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "TextExtentsCache.h"
+#include "Styles.h"
+#include <tchar.h>
+
+TextExtentsCache::~TextExtentsCache()
+{
+	Clear();
+}
+
+void TextExtentsCache::Clear()
+{
+	for (auto &font : fonts) {
+		DeleteFont(font);
+	}
+	fonts.clear();
+	fontsIndex.clear();
+}
+
+void TextExtentsCache::DeleteFont(CachedFont &font)
+{
+	if (font.dc) {
+		if (font.oldFont)
+			SelectObject(font.dc, font.oldFont);
+		DeleteDC(font.dc);
+	}
+	if (font.font)
+		DeleteObject(font.font);
+}
+
+TextExtentsCache::CachedFont *TextExtentsCache::GetFont(Styles *style)
+{
+	LONG fontHeight = (LONG)(style->GetFontSizeDouble() * 32);
+	int charset = wxAtoi(style->Encoding);
+	std::wstring key = style->Fontname.ToStdWstring();
+	key += L'|';
+	key += std::to_wstring(fontHeight);
+	key += L'|';
+	key += std::to_wstring(charset);
+	key += L'|';
+	key += style->Bold ? L'b' : L'-';
+	key += style->Italic ? L'i' : L'-';
+	key += style->Underline ? L'u' : L'-';
+	key += style->StrikeOut ? L's' : L'-';
+
+	auto it = fontsIndex.find(key);
+	if (it != fontsIndex.end()) {
+		fonts.splice(fonts.begin(), fonts, it->second);
+		return &fonts.front();
+	}
+
+	CachedFont font;
+	font.key = key;
+	font.dc = CreateCompatibleDC(0);
+	if (!font.dc)
+		return nullptr;
+	SetMapMode(font.dc, MM_TEXT);
+
+	LOGFONTW lf;
+	ZeroMemory(&lf, sizeof(lf));
+	lf.lfHeight = fontHeight;
+	lf.lfWeight = style->Bold ? FW_BOLD : FW_NORMAL;
+	lf.lfItalic = style->Italic;
+	lf.lfUnderline = style->Underline;
+	lf.lfStrikeOut = style->StrikeOut;
+	lf.lfCharSet = charset;
+	lf.lfOutPrecision = OUT_TT_PRECIS;
+	lf.lfClipPrecision = CLIP_DEFAULT_PRECIS;
+	lf.lfQuality = ANTIALIASED_QUALITY;
+	lf.lfPitchAndFamily = DEFAULT_PITCH | FF_DONTCARE;
+	_tcsncpy(lf.lfFaceName, style->Fontname.wc_str(), 32);
+
+	font.font = CreateFontIndirect(&lf);
+	if (!font.font) {
+		DeleteFont(font);
+		return nullptr;
+	}
+	font.oldFont = SelectObject(font.dc, font.font);
+	GetTextMetrics(font.dc, &font.metrics);
+
+	if (fonts.size() >= TEXT_EXTENTS_CACHE_FONTS) {
+		DeleteFont(fonts.back());
+		fontsIndex.erase(fonts.back().key);
+		fonts.pop_back();
+	}
+	fonts.push_front(std::move(font));
+	fontsIndex[key] = fonts.begin();
+	return &fonts.front();
+}
+
+bool TextExtentsCache::GetTextExtents(const wxString &text, Styles *style, float spacing,
+	float *width, float *height, float *descent, float *extlead)
+{
+	CachedFont *font = GetFont(style);
+	if (!font)
+		return false;
+
+	const wchar_t *thetext = text.wc_str();
+	size_t thetextlen = text.length();
+	SIZE sz;
+	if (spacing != 0) {
+		//spacing is added after every character, it needs only advances
+		*width = 0;
+		*height = 0;
+		for (size_t i = 0; i < thetextlen; i++) {
+			auto it = font->advances.find(thetext[i]);
+			if (it == font->advances.end()) {
+				GetTextExtentPoint32(font->dc, &thetext[i], 1, &sz);
+				it = font->advances.insert(std::make_pair(thetext[i], sz)).first;
+			}
+			*width += it->second.cx + spacing;
+			*height = it->second.cy;
+		}
+	}
+	else {
+		//whole string is measured to keep kerning
+		std::wstring key(thetext, thetextlen);
+		auto it = font->extents.find(key);
+		if (it == font->extents.end()) {
+			GetTextExtentPoint32(font->dc, thetext, (int)thetextlen, &sz);
+			if (font->extents.size() >= TEXT_EXTENTS_CACHE_STRINGS)
+				font->extents.clear();
+			it = font->extents.insert(std::make_pair(key, sz)).first;
+		}
+		*width = it->second.cx;
+		*height = it->second.cy;
+	}
+	*descent = font->metrics.tmDescent;
+	*extlead = font->metrics.tmExternalLeading;
+	return true;
+}
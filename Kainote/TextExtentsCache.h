@@ -0,0 +1,57 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/string.h>
+#include <windows.h>
+#include <list>
+#include <unordered_map>
+#include <string>
+
+class Styles;
+
+#define TEXT_EXTENTS_CACHE_FONTS 16
+#define TEXT_EXTENTS_CACHE_STRINGS 1024
+
+//GDI fonts with device context created once per font name, size, bold, italic and encoding
+//keeps advances of characters, metrics and sizes of measured strings
+//used by visuals on every mouse move, only from main thread
+class TextExtentsCache
+{
+public:
+	TextExtentsCache() {};
+	~TextExtentsCache();
+	//sizes are in 1/32 of pixel like font created with size * 32
+	bool GetTextExtents(const wxString &text, Styles *style, float spacing, 
+		float *width, float *height, float *descent, float *extlead);
+	void Clear();
+private:
+	struct CachedFont
+	{
+		std::wstring key;
+		HDC dc = nullptr;
+		HFONT font = nullptr;
+		HGDIOBJ oldFont = nullptr;
+		TEXTMETRIC metrics;
+		std::unordered_map<wchar_t, SIZE> advances;
+		std::unordered_map<std::wstring, SIZE> extents;
+	};
+	CachedFont *GetFont(Styles *style);
+	void DeleteFont(CachedFont &font);
+	//front is the most recently used font
+	std::list<CachedFont> fonts;
+	std::unordered_map<std::wstring, std::list<CachedFont>::iterator> fontsIndex;
+};
@@ -0,0 +1,90 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "VideoFrameCache.h"
+#include <string.h>
+
+void VideoFrameCache::Init(size_t memoryLimit, size_t frameSize)
+{
+	wxCriticalSectionLocker lock(m_lock);
+	m_frames.clear();
+	m_index.clear();
+	m_frameSize = frameSize;
+	m_maxFrames = (frameSize) ? (memoryLimit * 1024 * 1024) / frameSize : 0;
+	m_hits = m_misses = 0;
+}
+
+bool VideoFrameCache::Get(int frame, unsigned char* buffer)
+{
+	if (!m_maxFrames)
+		return false;
+
+	wxCriticalSectionLocker lock(m_lock);
+	auto it = m_index.find(frame);
+	if (it == m_index.end()) {
+		m_misses++;
+		return false;
+	}
+	m_hits++;
+	m_frames.splice(m_frames.begin(), m_frames, it->second);
+	memcpy(buffer, it->second->data.get(), m_frameSize);
+	return true;
+}
+
+bool VideoFrameCache::Contains(int frame)
+{
+	wxCriticalSectionLocker lock(m_lock);
+	return m_index.find(frame) != m_index.end();
+}
+
+void VideoFrameCache::Put(int frame, const unsigned char* buffer)
+{
+	if (!m_maxFrames)
+		return;
+
+	wxCriticalSectionLocker lock(m_lock);
+	auto it = m_index.find(frame);
+	if (it != m_index.end()) {
+		m_frames.splice(m_frames.begin(), m_frames, it->second);
+		memcpy(it->second->data.get(), buffer, m_frameSize);
+		return;
+	}
+	if (m_frames.size() >= m_maxFrames) {
+		//reuse buffer of the least recently used frame
+		m_frames.splice(m_frames.begin(), m_frames, std::prev(m_frames.end()));
+		m_index.erase(m_frames.front().frame);
+	}
+	else {
+		m_frames.push_front(CachedFrame{ 0, std::unique_ptr<unsigned char[]>(new unsigned char[m_frameSize]) });
+	}
+	CachedFrame& cached = m_frames.front();
+	cached.frame = frame;
+	memcpy(cached.data.get(), buffer, m_frameSize);
+	m_index[frame] = m_frames.begin();
+}
+
+void VideoFrameCache::Clear()
+{
+	wxCriticalSectionLocker lock(m_lock);
+	m_frames.clear();
+	m_index.clear();
+}
+
+void VideoFrameCache::GetStats(size_t* hits, size_t* misses)
+{
+	wxCriticalSectionLocker lock(m_lock);
+	*hits = m_hits;
+	*misses = m_misses;
+}
@@ -0,0 +1,54 @@
+//  Copyright (c) 2021, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <wx/thread.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+//LRU cache of decoded and converted video frames, keyed by frame number
+//it's used from video thread, main thread and prefetch thread
+class VideoFrameCache
+{
+public:
+	VideoFrameCache() {};
+	//memoryLimit in MB, when it's smaller than one frame cache is disabled
+	void Init(size_t memoryLimit, size_t frameSize);
+	bool IsEnabled() const { return m_maxFrames > 0; }
+	size_t GetCapacity() const { return m_maxFrames; }
+	//copies frame to buffer, counts hits and misses
+	bool Get(int frame, unsigned char* buffer);
+	bool Contains(int frame);
+	void Put(int frame, const unsigned char* buffer);
+	void Clear();
+	void GetStats(size_t* hits, size_t* misses);
+private:
+	struct CachedFrame
+	{
+		int frame;
+		std::unique_ptr<unsigned char[]> data;
+	};
+	//front is the most recently used frame
+	std::list<CachedFrame> m_frames;
+	std::unordered_map<int, std::list<CachedFrame>::iterator> m_index;
+	size_t m_maxFrames = 0;
+	size_t m_frameSize = 0;
+	size_t m_hits = 0;
+	size_t m_misses = 0;
+	wxCriticalSection m_lock;
+};
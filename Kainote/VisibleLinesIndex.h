@@ -0,0 +1,104 @@
+//  Copyright (c) 2020, Marcin Drob
+
+//  Kainote is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  Kainote is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with Kainote.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+//Fenwick tree of visible lines, makes conversions between keys and ids O(log n)
+//every change of visibility or order of lines has to call Invalidate or Update
+class VisibleLinesIndex
+{
+public:
+	void Invalidate(){ needRebuild = true; }
+	bool NeedRebuild(size_t numOfLines) const{ return needRebuild || numOfLines != visibility.size(); }
+	//isVisible gets element of lines and returns its visibility
+	template<typename Lines, typename IsVisible>
+	void Rebuild(const Lines &lines, IsVisible isVisible)
+	{
+		size_t size = lines.size();
+		tree.assign(size + 1, 0);
+		visibility.assign(size, false);
+		visibleCount = 0;
+		size_t i = 0;
+		for (const auto &line : lines){
+			if (isVisible(line)){
+				visibility[i] = true;
+				tree[i + 1] = 1;
+				visibleCount++;
+			}
+			i++;
+		}
+		for (size_t j = 1; j <= size; j++){
+			size_t parent = j + (j & (~j + 1));
+			if (parent <= size)
+				tree[parent] += tree[j];
+		}
+		highestBit = 1;
+		while (highestBit * 2 <= size)
+			highestBit *= 2;
+
+		needRebuild = false;
+	}
+	//changes visibility of one line when index is up to date
+	void Update(size_t key, bool visible)
+	{
+		if (needRebuild || key >= visibility.size() || visibility[key] == visible)
+			return;
+
+		visibility[key] = visible;
+		int diff = visible ? 1 : -1;
+		visibleCount += diff;
+		for (size_t i = key + 1; i < tree.size(); i += (i & (~i + 1)))
+			tree[i] += diff;
+	}
+	//number of visible lines before key
+	size_t CountBefore(size_t key) const
+	{
+		if (key > visibility.size())
+			key = visibility.size();
+
+		int count = 0;
+		for (size_t i = key; i > 0; i -= (i & (~i + 1)))
+			count += tree[i];
+
+		return count;
+	}
+	//returns key of visible line with given id or -1 when id exceeds number of visible lines
+	size_t FindKey(size_t id) const
+	{
+		if (id >= visibleCount)
+			return -1;
+
+		size_t pos = 0;
+		int rest = id + 1;
+		size_t size = visibility.size();
+		for (size_t step = highestBit; step > 0; step >>= 1){
+			if (pos + step <= size && tree[pos + step] < rest){
+				pos += step;
+				rest -= tree[pos];
+			}
+		}
+		return pos;
+	}
+	size_t GetVisibleCount() const{ return visibleCount; }
+private:
+	std::vector<int> tree;
+	std::vector<bool> visibility;
+	size_t visibleCount = 0;
+	size_t highestBit = 0;
+	bool needRebuild = true;
+};
@@ -25,6 +25,7 @@
 #include "Editbox.h"
 #include "RendererVideo.h"
 #include "SubtitlesProviderManager.h"
+#include "TextExtentsCache.h"
 #include <wx/regex.h>
 #include "config.h"
 
@@ -764,7 +765,7 @@ D3DXVECTOR2 Visuals::GetPosition(Dialogue *Dial, bool *putinBracket, wxPoint *Te
 	*putinBracket = false;
 	D3DXVECTOR2 result;
 	Styles *currentStyle = tab->grid->GetStyle(0, Dial->Style);
-	const wxString &txt = Dial->GetText();
+	const wxString &txt = Dial->GetTextNoCopy();
 	bool foundpos = false;
 	wxRegEx pos(L"\\\\(pos|move)\\(([^\\)]+)\\)", wxRE_ADVANCED);
 	if (pos.Matches(txt)){
@@ -852,10 +853,12 @@ void Visuals::SetModified(int action, bool dummy)
 	tab->grid->Refresh();
 }
 
+//fonts are shared by all visuals of all tabs
+static TextExtentsCache textExtentsCache;
+
 bool Visuals::GetTextExtents(const wxString & text, Styles *style, float* width, float* height, float* descent, float* extlead)
 {
 	float fwidth = 0, fheight = 0, fdescent = 0, fextlead = 0;
-	float fontsize = style->GetFontSizeDouble() * 32;
 	float spacing = wxAtof(style->Spacing) * 32;
 
 	
@@ -870,54 +873,9 @@ bool Visuals::GetTextExtents(const wxString & text, Styles *style, float* width,
 		return true;
 	}
 
-	const wchar_t* thetext = text.wc_str();
-
-	
-	SIZE sz;
-	HDC thedc = CreateCompatibleDC(0);
-	if (!thedc) return false;
-	SetMapMode(thedc, MM_TEXT);
-
-	LOGFONTW lf;
-	ZeroMemory(&lf, sizeof(lf));
-	lf.lfHeight = (LONG)fontsize;
-	lf.lfWeight = style->Bold ? FW_BOLD : FW_NORMAL;
-	lf.lfItalic = style->Italic;
-	lf.lfUnderline = style->Underline;
-	lf.lfStrikeOut = style->StrikeOut;
-	lf.lfCharSet = wxAtoi(style->Encoding);
-	lf.lfOutPrecision = OUT_TT_PRECIS;
-	lf.lfClipPrecision = CLIP_DEFAULT_PRECIS;
-	lf.lfQuality = ANTIALIASED_QUALITY;
-	lf.lfPitchAndFamily = DEFAULT_PITCH | FF_DONTCARE;
-	_tcsncpy(lf.lfFaceName, style->Fontname.wc_str(), 32);
-
-	HFONT thefont = CreateFontIndirect(&lf);
-	if (!thefont) return false;
-	SelectObject(thedc, thefont);
-
-	if (spacing != 0) {
-		fwidth = 0;
-		for (size_t i = 0; i < thetextlen; i++) {
-			GetTextExtentPoint32(thedc, &thetext[i], 1, &sz);
-			fwidth += sz.cx + spacing;
-			fheight = sz.cy;
-		}
-	}
-	else {
-		GetTextExtentPoint32(thedc, thetext, (int)thetextlen, &sz);
-		fwidth = sz.cx;
-		fheight = sz.cy;
-	}
-
-
-	TEXTMETRIC tm;
-	GetTextMetrics(thedc, &tm);
-	fdescent = tm.tmDescent;
-	fextlead = tm.tmExternalLeading;
+	if (!textExtentsCache.GetTextExtents(text, style, spacing, &fwidth, &fheight, &fdescent, &fextlead))
+		return false;
 
-	DeleteObject(thedc);
-	DeleteObject(thefont);
 	float scalex = wxAtof(style->ScaleX) / 100.f;
 	float scaley = wxAtof(style->ScaleY) / 100.f;
 
@@ -143,15 +143,6 @@ const wxString & config::GetString(CONFIG opt)
 }
 
 
-bool config::GetBool(CONFIG opt)
-{
-	if (opt >= 0 && opt < configSize){
-		wxString ropt = stringConfig[opt];
-		if (ropt == L"true"){ return true; }
-	}
-	return false;
-}
-
 const wxColour &config::GetColour(COLOR opt)
 {
 	if (opt >= 0 && opt < colorsSize)
@@ -168,35 +159,60 @@ AssColor config::GetColor(COLOR opt)
 	return AssColor();
 }
 
-int config::GetInt(CONFIG opt)
+void config::SetRawOption(int opt, const wxString &value)
 {
-	if (opt >= 0 && opt < configSize)
-		return wxAtoi(stringConfig[opt]);
+	if (stringConfig[opt] == value)
+		return;
 
-	return 0;
+	stringConfig[opt] = value;
+	UpdateTypedOption(opt);
+	//listener can add or remove listeners, so callbacks are copied first
+	std::vector<OptionListener> listeners;
+	for (auto &listener : optionListeners){
+		if (listener.option == opt)
+			listeners.push_back(listener);
+	}
+	for (auto &listener : listeners){
+		//owner removed by previous callback can be already destroyed
+		void *owner = listener.owner;
+		if (std::any_of(optionListeners.begin(), optionListeners.end(),
+			[owner, opt](const OptionListener &other) { return other.owner == owner && other.option == opt; }))
+			listener.onChange();
+	}
 }
-float config::GetFloat(CONFIG opt)
+
+void config::UpdateTypedOption(int opt)
 {
-	if (opt >= 0 && opt < configSize){
-		double fl;
-		wxString rawfloat = stringConfig[opt];
-		if (!rawfloat.ToDouble(&fl)){ return 0.0; }
-		return fl;
-	}
-	return 0.0;
+	const wxString &value = stringConfig[opt];
+	boolConfig[opt] = value == L"true";
+	intConfig[opt] = wxAtoi(value);
+	//options are always saved with dot, it can be loaded before locale is set to "C"
+	double fl;
+	floatConfig[opt] = (value.ToCDouble(&fl)) ? fl : 0.f;
+}
+
+void config::AddOptionListener(CONFIG opt, void *owner, std::function<void()> onChange)
+{
+	optionListeners.push_back(OptionListener{ opt, owner, onChange });
+}
+
+void config::RemoveOptionListeners(void *owner)
+{
+	optionListeners.erase(std::remove_if(optionListeners.begin(), optionListeners.end(), 
+		[owner](const OptionListener &listener) { return listener.owner == owner; }), optionListeners.end());
 }
 
 void config::SetString(CONFIG opt, const wxString &sopt)
 {
 	if (opt >= 0 && opt < configSize)
-		stringConfig[opt] = sopt;
+		SetRawOption(opt, sopt);
 }
 
 void config::SetBool(CONFIG opt, bool bopt)
 {
 	if (opt >= 0 && opt < configSize){
 		wxString bopt1 = (bopt) ? L"true" : L"false";
-		stringConfig[opt] = bopt1;
+		SetRawOption(opt, bopt1);
 	}
 }
 
@@ -216,7 +232,7 @@ void config::SetInt(CONFIG opt, int iopt)
 {
 	if (opt >= 0 && opt < configSize){
 		wxString iopt1 = emptyString;
-		stringConfig[opt] = iopt1 << iopt;
+		SetRawOption(opt, iopt1 << iopt);
 	}
 }
 
@@ -226,7 +242,7 @@ void config::SetFloat(CONFIG opt, float fopt)
 		wxString fopt1 = emptyString;
 		fopt1 << fopt;
 		fopt1.Replace(L",", L".");
-		stringConfig[opt] = fopt1;
+		SetRawOption(opt, fopt1);
 	}
 }
 
@@ -250,7 +266,7 @@ void config::CatchValsLabs(const wxString &line)
 	wxString Labels = line.BeforeFirst(L'=');
 	//Labels.Trim(false);
 	Labels.Trim(true);
-	stringConfig[GetCONFIGValue(Labels)] = Values;
+	SetRawOption(GetCONFIGValue(Labels), Values);
 }
 void config::AddStyle(Styles *styl)
 {
@@ -370,6 +386,13 @@ void config::LoadDefaultConfig(wxString * defaultOptions)
 	configTable[AUTOMATION_TRACE_LEVEL] = L"3";
 	configTable[AUTOSAVE_MAX_FILES] = L"3";
 	configTable[GRID_CHANGE_ACTIVE_ON_SELECTION] = L"true";
+	configTable[SUBS_UNDO_MEMORY_LIMIT] = L"0";
+	configTable[LIBASS_INCREMENTAL_UPDATE] = L"true";
+	configTable[VIDEO_FRAME_CACHE_MEMORY] = L"256";
+	if (!defaultOptions){
+		for (int i = AUDIO_WHEEL_DEFAULT_TO_ZOOM + 1; i < configSize; i++)
+			UpdateTypedOption(i);
+	}
 }
 
 //remember, create table[colorsSize] without this size it will crash
@@ -658,7 +681,7 @@ void config::clearstyles()
 void config::SetCoords(CONFIG opt, int coordx, int coordy)
 {
 	wxString iopt1 = emptyString;
-	stringConfig[opt] = iopt1 << coordx << L"," << coordy;
+	SetRawOption(opt, iopt1 << coordx << L"," << coordy);
 }
 
 void config::GetCoords(CONFIG opt, int *coordx, int *coordy)
@@ -677,7 +700,7 @@ void config::SetTable(CONFIG opt, wxArrayString &asopt)
 		//wxString endchar = (i == asopt.size() - 1) ? ES : split;
 		sresult << L"\t" << asopt[i] << L"\n";
 	}
-	stringConfig[opt] = sresult + L"}";
+	SetRawOption(opt, sresult + L"}");
 }
 
 void config::SetStringTable(CONFIG opt, wxArrayString &asopt, wxString split)
@@ -688,7 +711,7 @@ void config::SetStringTable(CONFIG opt, wxArrayString &asopt, wxString split)
 	{
 		wxString endchar = (i == asopt.size() - 1) ? ES : split;
 	}
-	stringConfig[opt] = sresult;
+	SetRawOption(opt, sresult);
 }
 
 void config::SetIntTable(CONFIG opt, wxArrayInt &asopt)
@@ -698,7 +721,7 @@ void config::SetIntTable(CONFIG opt, wxArrayInt &asopt)
 	{
 		sresult << L"\t" << asopt[i] << L"\n";
 	}
-	stringConfig[opt] = sresult + L"}";
+	SetRawOption(opt, sresult + L"}");
 }
 
 void config::GetTable(CONFIG opt, wxArrayString &tbl, int mode)
@@ -777,14 +800,20 @@ void config::LoadDefaultAudioConfig(wxString * defaultOptions)
 	configTable[AUDIO_LOCK_SCROLL_ON_CURSOR] = L"false";
 	configTable[AUDIO_MARK_PLAY_TIME] = L"1000";
 	configTable[AUDIO_NEXT_LINE_ON_COMMIT] = L"true";
+	configTable[AUDIO_PEAKS_CACHE] = L"true";
 	configTable[AUDIO_RAM_CACHE] = L"false";
 	configTable[AUDIO_SNAP_TO_KEYFRAMES] = L"false";
 	configTable[AUDIO_SNAP_TO_OTHER_LINES] = L"false";
 	configTable[AUDIO_SPECTRUM_ON] = L"false";
+	configTable[AUDIO_SPECTRUM_WINDOW] = L"0";
 	configTable[AUDIO_START_DRAG_SENSITIVITY] = L"6";
 	configTable[AUDIO_VERTICAL_ZOOM] = L"50";
 	configTable[AUDIO_VOLUME] = L"50";
 	configTable[AUDIO_WHEEL_DEFAULT_TO_ZOOM] = L"false";
+	if (!defaultOptions){
+		for (int i = 0; i <= AUDIO_WHEEL_DEFAULT_TO_ZOOM; i++)
+			UpdateTypedOption(i);
+	}
 
 }
 
@@ -794,7 +823,7 @@ void config::ResetDefault()
 	Options.LoadDefaultAudioConfig(options);
 	Options.LoadDefaultConfig(options);
 	for (size_t i = 0; i < configSize; i++){
-		stringConfig[i] = options[i];
+		SetRawOption(i, options[i]);
 	}
 }
 
@@ -1094,6 +1123,17 @@ bool IsNumber(const wxString& test) {
 	return isnumber;
 }
 
+int ParseInt(const wchar_t* text, size_t length)
+{
+	//numbers in subtitles are short, longer text is cut like it was too big for int
+	wchar_t number[32];
+	if (length > 31)
+		length = 31;
+	wmemcpy(number, text, length);
+	number[length] = 0;
+	return wxAtoi(number);
+}
+
 void DrawDashedLine(wxDC* dc, wxPoint* vector, size_t vectorSize, int dashLen, const wxColour& color)
 {
 
@@ -30,6 +30,7 @@
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <functional>
 
 #
 
@@ -66,11 +67,13 @@ const wxString emptyString;
 	CG(AUDIO_MARK_PLAY_TIME,)\
 	CG(AUDIO_MERGE_EVERY_N_WITH_SYLLABLE,)\
 	CG(AUDIO_NEXT_LINE_ON_COMMIT,)\
+	CG(AUDIO_PEAKS_CACHE,)\
 	CG(AUDIO_RAM_CACHE,)\
 	CG(AUDIO_SNAP_TO_KEYFRAMES,)\
 	CG(AUDIO_SNAP_TO_OTHER_LINES,)\
 	CG(AUDIO_SPECTRUM_ON,)\
 	CG(AUDIO_SPECTRUM_NON_LINEAR_ON,)\
+	CG(AUDIO_SPECTRUM_WINDOW,)\
 	CG(AUDIO_START_DRAG_SENSITIVITY,)\
 	CG(AUDIO_VERTICAL_ZOOM,)\
 	CG(AUDIO_VOLUME,)\
@@ -242,6 +245,10 @@ const wxString emptyString;
 	CG(EDITBOX_TAG_BUTTON_VALUE18,)\
 	CG(EDITBOX_TAG_BUTTON_VALUE19,)\
 	CG(EDITBOX_TAG_BUTTON_VALUE20,)\
+	CG(SUBS_UNDO_MEMORY_LIMIT,)\
+	CG(LIBASS_INCREMENTAL_UPDATE,)\
+	CG(VIDEO_FRAME_CACHE_MEMORY,)\
+	CG(AUTOSAVE_JOURNAL,)\
 	//if you write here a new enum then change configSize below after colors
 
 DECLARE_ENUM(CONFIG, CFG)
@@ -395,8 +402,22 @@ class config
 {
 private:
 	//int to silence warnings
-	static const int configSize = EDITBOX_TAG_BUTTON_VALUE20 + 1;
+	static const int configSize = AUTOSAVE_JOURNAL + 1;
 	wxString stringConfig[configSize];
+	//values of stringConfig parsed once when they are set, getters are used in paint loops
+	bool boolConfig[configSize] = {};
+	int intConfig[configSize] = {};
+	float floatConfig[configSize] = {};
+	struct OptionListener
+	{
+		CONFIG option;
+		void *owner;
+		std::function<void()> onChange;
+	};
+	std::vector<OptionListener> optionListeners;
+	//sets string value, parses typed values and notifies listeners when value changed
+	void SetRawOption(int opt, const wxString &value);
+	void UpdateTypedOption(int opt);
 	static const int colorsSize = STYLE_PREVIEW_COLOR2 + 1;
 	wxColour colors[colorsSize];
 	bool isClosing = false;
@@ -421,11 +442,11 @@ public:
 	bool GetClosing(){ return isClosing; }
 
 	const wxString &GetString(CONFIG opt);
-	bool GetBool(CONFIG opt);
+	bool GetBool(CONFIG opt){ return (opt >= 0 && opt < configSize) ? boolConfig[opt] : false; }
 	const wxColour &GetColour(COLOR opt);
 	AssColor GetColor(COLOR opt);
-	int GetInt(CONFIG opt);
-	float GetFloat(CONFIG opt);
+	int GetInt(CONFIG opt){ return (opt >= 0 && opt < configSize) ? intConfig[opt] : 0; }
+	float GetFloat(CONFIG opt){ return (opt >= 0 && opt < configSize) ? floatConfig[opt] : 0.f; }
 	void GetTable(CONFIG opt, wxArrayString &tbl, int mode = 4);
 	void GetIntTable(CONFIG opt, wxArrayInt &tbl, int mode = 4);
 	void GetTableFromString(CONFIG opt, wxArrayString &tbl, wxString split, int mode = 4);
@@ -441,6 +462,10 @@ public:
 	void SetStringTable(CONFIG opt, wxArrayString &iopt, wxString split = L"|");
 	void SetIntTable(CONFIG opt, wxArrayInt &iopt);
 	void SetCoords(CONFIG opt, int coordx, int coordy);
+	//onChange is called in thread that changed option, after its value was changed
+	//values can be cached by owner, owner have to remove its listeners before it is destroyed
+	void AddOptionListener(CONFIG opt, void *owner, std::function<void()> onChange);
+	void RemoveOptionListeners(void *owner);
 	void GetRawOptions(wxString &options, bool Audio = false);
 	void AddStyle(Styles *styl);
 	void ChangeStyle(Styles *styl, int i);
@@ -573,6 +598,8 @@ wxString MakePolishPlural(int num, const wxString& normal, const wxString& plura
 
 
 bool IsNumber(const wxString& txt);
+//wxAtoi of text part that doesn't end with null
+int ParseInt(const wchar_t* text, size_t length);
 void DrawDashedLine(wxDC* dc, wxPoint* vector, size_t vectorSize, int dashLen, const wxColour& color);
 size_t FindFromEnd(const wxString& text, const wxString& whatToFind, bool ignoreCase = false);
 
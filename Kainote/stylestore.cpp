@@ -236,6 +236,8 @@ StyleStore::~StyleStore()
 
 void StyleStore::OnSwitchLines(wxCommandEvent& event)
 {
+	//style list reorders styles table directly
+	Notebook::GetTab()->grid->file->InvalidateStyleIndex();
 	Notebook::GetTab()->edit->RefreshStyle();
 }
 
@@ -579,6 +581,7 @@ void StyleStore::OnAssSort(wxCommandEvent& event)
 {
 	SubsGrid* grid = Notebook::GetTab()->grid;
 	std::sort(grid->GetStyleTable()->begin(), grid->GetStyleTable()->end(), sortfunc);
+	grid->file->InvalidateStyleIndex();
 	ASSList->SetSelection(0, true);
 	grid->file->edited = true;
 	SetModified();
@@ -1007,6 +1010,7 @@ void StyleStore::OnStyleMove(wxCommandEvent& event)
 		else{ i--; lastDownSelection--; }
 	}
 	if (action < 4){ 
+		Notebook::GetTab()->grid->file->InvalidateStyleIndex();
 		ASSList->SetSelections(sels); 
 		Notebook::GetTab()->grid->file->edited = true; 
 		SetModified(); 